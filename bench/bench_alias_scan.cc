@@ -0,0 +1,88 @@
+// Alias resolution over a store full of Conch::Alias-shaped payloads: full
+// nlohmann::json::from_cbor decode versus CBOR path projection.
+//
+//   bench_alias_scan [aliases] [lookups]
+
+#include "referee/cbor_path.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace referee;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t arg_or(int argc, char** argv, int index, std::uint64_t fallback) {
+  if (argc <= index) return fallback;
+  return std::strtoull(argv[index], nullptr, 10);
+}
+
+double ms_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::uint64_t aliases = arg_or(argc, argv, 1, 50000);
+  const std::uint64_t lookups = arg_or(argc, argv, 2, 20);
+  const TypeID alias_type{0xA11A5ULL};
+
+  SqliteStore store(SqliteConfig{ .filename=":memory:" });
+  if (!store.open()) return 1;
+  for (std::uint64_t i = 0; i < aliases; ++i) {
+    nlohmann::json payload;
+    payload["object_id"] = ObjectID::random().to_hex();
+    payload["note"] = "alias created by bench_alias_scan for load testing";
+    payload["tags"] = {"bench", "alias", std::to_string(i % 10)};
+    payload["name"] = "alias_" + std::to_string(i);
+    store.create_object(alias_type, ObjectID{}, nlohmann::json::to_cbor(payload));
+  }
+  auto listR = store.list_by_type(alias_type);
+  if (!listR) return 1;
+  const auto& records = listR.value.value();
+
+  std::uint64_t found_full = 0;
+  auto start = Clock::now();
+  for (std::uint64_t l = 0; l < lookups; ++l) {
+    const std::string want = "alias_" + std::to_string(aliases - 1 - l);
+    for (const auto& rec : records) {
+      auto json = nlohmann::json::from_cbor(rec.payload_cbor);
+      if (json.value("name", "") == want) {
+        found_full += !json.value("object_id", "").empty();
+        break;
+      }
+    }
+  }
+  const double full_ms = ms_since(start);
+
+  std::uint64_t found_path = 0;
+  start = Clock::now();
+  for (std::uint64_t l = 0; l < lookups; ++l) {
+    const std::string want = "alias_" + std::to_string(aliases - 1 - l);
+    for (const auto& rec : records) {
+      if (cbor_find_text(rec.payload_cbor, {"name"}) == std::string_view(want)) {
+        found_path += cbor_find_text(rec.payload_cbor, {"object_id"}).has_value();
+        break;
+      }
+    }
+  }
+  const double path_ms = ms_since(start);
+
+  const double scanned = static_cast<double>(records.size()) * static_cast<double>(lookups);
+  std::printf("aliases=%zu lookups=%llu found=%llu/%llu\n", records.size(),
+              (unsigned long long)lookups, (unsigned long long)found_full,
+              (unsigned long long)found_path);
+  std::printf("from_cbor   total_ms=%.1f ns/record=%.1f\n", full_ms, full_ms * 1e6 / scanned);
+  std::printf("cbor_path   total_ms=%.1f ns/record=%.1f speedup=%.1fx\n", path_ms,
+              path_ms * 1e6 / scanned, path_ms > 0 ? full_ms / path_ms : 0.0);
+  return found_full == found_path ? 0 : 1;
+}
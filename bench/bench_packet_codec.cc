@@ -0,0 +1,122 @@
+// Packet codec throughput for representative layouts: packet-at-a-time decode
+// versus batch encode/decode into field-major columns.
+//
+//   bench_packet_codec [packets] [rounds]
+
+#include "refract/packet_codec.h"
+#include "refract/schema_registry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace iris::refract;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Layout {
+  const char* label;
+  const char* byte_order;
+  std::vector<std::uint32_t> widths;
+};
+
+std::uint64_t arg_or(int argc, char** argv, int index, std::uint64_t fallback) {
+  if (argc <= index) return fallback;
+  return std::strtoull(argv[index], nullptr, 10);
+}
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+TypeDefinition packet_definition(const Layout& layout) {
+  TypeDefinition def{};
+  def.type_id = referee::TypeID{0xBE7C0DEULL};
+  def.name = layout.label;
+  def.namespace_name = "Bench";
+  def.kind = "packet";
+  def.packet_byte_order = layout.byte_order;
+  for (std::size_t i = 0; i < layout.widths.size(); ++i) {
+    def.packet_fields.push_back(PacketFieldDefinition{ "f" + std::to_string(i), referee::TypeID{0x1002ULL},
+                                                       layout.widths[i] });
+  }
+  return def;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::uint64_t packets = arg_or(argc, argv, 1, 1 << 20);
+  const std::uint64_t rounds = arg_or(argc, argv, 2, 10);
+  const std::vector<Layout> layouts = {
+    { "header32_be", "be", { 4, 4, 8, 16 } },
+    { "telemetry64_le", "le", { 12, 20, 1, 1, 6, 24 } },
+    { "sample64_be", "be", { 16, 16, 16, 16 } },
+    { "record104_be", "be", { 3, 64, 37 } },
+  };
+
+  std::uint64_t checksum = 0;
+  for (const auto& layout : layouts) {
+    auto codecR = PacketCodec::compile(packet_definition(layout));
+    if (!codecR) {
+      std::fprintf(stderr, "%s: %s\n", layout.label, codecR.error->message.c_str());
+      return 1;
+    }
+    const auto& codec = codecR.value.value();
+    const std::size_t nf = codec.fields().size();
+
+    std::vector<std::uint64_t> columns(nf * packets);
+    std::uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (std::size_t f = 0; f < nf; ++f) {
+      for (std::uint64_t i = 0; i < packets; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        columns[f * packets + i] = seed & codec.fields()[f].mask;
+      }
+    }
+    std::vector<std::uint8_t> packed(packets * codec.packet_bytes());
+    std::vector<std::uint64_t> decoded(nf * packets);
+    std::vector<std::uint64_t> values(nf);
+
+    auto start = Clock::now();
+    for (std::uint64_t r = 0; r < rounds; ++r) {
+      if (!codec.encode_batch(columns.data(), packets, packed.data())) return 1;
+    }
+    const double encode_s = seconds_since(start);
+
+    start = Clock::now();
+    for (std::uint64_t r = 0; r < rounds; ++r) {
+      for (std::uint64_t i = 0; i < packets; ++i) {
+        codec.decode(packed.data() + i * codec.packet_bytes(), values.data());
+        checksum += values[0];
+      }
+    }
+    const double single_s = seconds_since(start);
+
+    start = Clock::now();
+    for (std::uint64_t r = 0; r < rounds; ++r) {
+      codec.decode_batch(packed.data(), packets, decoded.data());
+      checksum += decoded[r % decoded.size()];
+    }
+    const double batch_s = seconds_since(start);
+    if (decoded != columns) {
+      std::fprintf(stderr, "%s: decode mismatch\n", layout.label);
+      return 1;
+    }
+
+    const double total = static_cast<double>(packets) * static_cast<double>(rounds);
+    std::printf("%-15s bytes=%zu fields=%zu simd=%s\n", layout.label, codec.packet_bytes(), nf,
+                codec.vectorized() ? "yes" : "no");
+    std::printf("  encode_batch  Mpkt/s=%.1f\n", total / encode_s / 1e6);
+    std::printf("  decode        Mpkt/s=%.1f\n", total / single_s / 1e6);
+    std::printf("  decode_batch  Mpkt/s=%.1f speedup=%.1fx\n", total / batch_s / 1e6,
+                batch_s > 0 ? single_s / batch_s : 0.0);
+  }
+  std::printf("checksum=%llu\n", (unsigned long long)checksum);
+  return 0;
+}
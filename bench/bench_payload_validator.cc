@@ -0,0 +1,77 @@
+// Cost of the create_object payload check for a typical eight-field payload, from
+// a warm PayloadValidator.
+//
+//   bench_payload_validator [iterations]
+
+#include "refract/payload_validator.h"
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace referee;
+using namespace iris::refract;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t arg_or(int argc, char** argv, int index, std::uint64_t fallback) {
+  if (argc <= index) return fallback;
+  return std::strtoull(argv[index], nullptr, 10);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::uint64_t iterations = arg_or(argc, argv, 1, 2000000);
+
+  SqliteStore store(SqliteConfig{ .filename=":memory:" });
+  if (!store.open()) return 1;
+  SchemaRegistry registry(store);
+
+  TypeDefinition mode{};
+  mode.type_id = TypeID{0xB0DE1ULL};
+  mode.name = "Mode";
+  mode.namespace_name = "Bench";
+  mode.enum_values = { EnumValueDefinition{ "Idle", "0" }, EnumValueDefinition{ "Run", "1" } };
+  TypeDefinition def{};
+  def.type_id = TypeID{0xB0DE2ULL};
+  def.name = "Reading";
+  def.namespace_name = "Bench";
+  def.fields = {
+    FieldDefinition{ "name", TypeID{0x1001ULL}, true, std::nullopt },
+    FieldDefinition{ "sequence", TypeID{0x1002ULL}, true, std::nullopt },
+    FieldDefinition{ "value", TypeID{0x1008ULL}, true, std::nullopt },
+    FieldDefinition{ "valid", TypeID{0x1003ULL}, false, std::nullopt },
+    FieldDefinition{ "source", TypeID{0x1004ULL}, false, std::nullopt },
+    FieldDefinition{ "mode", mode.type_id, false, std::nullopt },
+    FieldDefinition{ "units", TypeID{0x1001ULL}, false, std::string("\"\"") },
+    FieldDefinition{ "notes", TypeID{0x1007ULL}, false, std::nullopt },
+  };
+  if (!registry.register_definition(mode)) return 1;
+  auto regR = registry.register_definition(def);
+  if (!regR) return 1;
+
+  const Bytes payload = cbor_from_json_string(
+      R"({"mode":"Run","name":"thermocouple-04","notes":{"site":"bay 3"},"sequence":18233,)"
+      R"("source":"00112233445566778899aabbccddeeff","units":"K","valid":true,"value":291.5})");
+
+  PayloadValidator validator(registry);
+  if (!validator.validate(def.type_id, regR.value->ref.id, payload)) return 1;
+
+  std::uint64_t passed = 0;
+  const auto start = Clock::now();
+  for (std::uint64_t i = 0; i < iterations; ++i) {
+    passed += static_cast<bool>(validator.validate(def.type_id, regR.value->ref.id, payload));
+  }
+  const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+  std::printf("payload_bytes=%zu iterations=%llu passed=%llu\n", payload.size(),
+              (unsigned long long)iterations, (unsigned long long)passed);
+  std::printf("validate    ns/payload=%.1f\n", ns / static_cast<double>(iterations));
+  return passed == iterations ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// Measures ShardedStore write throughput as the shard count grows.
+//
+//   bench_sharded_writes [objects] [batch] [payload_bytes] [max_shards]
+
+#include "referee/referee.h"
+#include "referee_sqlite/sharded_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace referee;
+
+namespace {
+
+std::uint64_t arg_or(int argc, char** argv, int index, std::uint64_t fallback) {
+  if (argc <= index) return fallback;
+  return std::strtoull(argv[index], nullptr, 10);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::uint64_t objects = arg_or(argc, argv, 1, 200000);
+  const std::uint64_t batch_size = std::max<std::uint64_t>(1, arg_or(argc, argv, 2, 1024));
+  const std::uint64_t payload_bytes = arg_or(argc, argv, 3, 96);
+  const std::uint64_t max_shards = arg_or(argc, argv, 4, 8);
+
+  const auto dir = std::filesystem::temp_directory_path()
+                   / ("iris_bench_sharded_" + std::to_string(::getpid()));
+  std::filesystem::create_directories(dir);
+
+  std::vector<NewObject> batch(batch_size);
+  for (std::uint64_t i = 0; i < batch_size; ++i) {
+    batch[i] = NewObject{TypeID{1000 + (i % 16)}, ObjectID::random(), Bytes(payload_bytes, 0xA5)};
+  }
+
+  std::printf("cores=%u objects=%llu batch=%llu payload=%llu\n",
+              std::thread::hardware_concurrency(), (unsigned long long)objects,
+              (unsigned long long)batch_size, (unsigned long long)payload_bytes);
+  double base_rate = 0;
+  for (std::uint64_t shards = 1; shards <= max_shards; shards *= 2) {
+    const std::string filename = (dir / ("store" + std::to_string(shards) + ".db")).string();
+    ShardedStore store(ShardedConfig{ .filename=filename, .shards=shards });
+    if (!store.open()) {
+      std::fprintf(stderr, "open failed\n");
+      return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t written = 0; written < objects; written += batch_size) {
+      auto r = store.create_objects(batch);
+      if (!r) {
+        std::fprintf(stderr, "create_objects failed: %s\n", r.error->message.c_str());
+        return 1;
+      }
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double rate = objects / secs;
+    if (shards == 1) base_rate = rate;
+    std::printf("shards=%llu objects/s=%.0f MiB/s=%.1f speedup=%.2fx\n",
+                (unsigned long long)shards, rate,
+                rate * (payload_bytes + 64) / (1024.0 * 1024.0), rate / base_rate);
+    store.close();
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+  return 0;
+}
@@ -0,0 +1,92 @@
+// Measures SqliteStore::open() on a populated segment store.
+//
+//   bench_store_open [objects] [edges_per_object] [payload_bytes]
+
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace referee;
+
+namespace {
+
+std::uint64_t arg_or(int argc, char** argv, int index, std::uint64_t fallback) {
+  if (argc <= index) return fallback;
+  return std::strtoull(argv[index], nullptr, 10);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::uint64_t objects = arg_or(argc, argv, 1, 200000);
+  const std::uint64_t edges_per_object = arg_or(argc, argv, 2, 2);
+  const std::uint64_t payload_bytes = arg_or(argc, argv, 3, 96);
+
+  const auto dir = std::filesystem::temp_directory_path()
+                   / ("iris_bench_open_" + std::to_string(::getpid()));
+  const std::string filename = (dir / "store.db").string();
+  std::filesystem::create_directories(dir);
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=filename });
+    if (!store.open()) {
+      std::fprintf(stderr, "open failed\n");
+      return 1;
+    }
+    Bytes payload(payload_bytes, 0xA5);
+    std::vector<ObjectRef> refs;
+    refs.reserve(objects);
+    store.begin();
+    for (std::uint64_t i = 0; i < objects; ++i) {
+      auto r = store.create_object(TypeID{1000 + (i % 16)}, ObjectID::random(), payload);
+      if (!r) {
+        std::fprintf(stderr, "create failed: %s\n", r.error->message.c_str());
+        return 1;
+      }
+      refs.push_back(r.value->ref);
+    }
+    for (std::uint64_t i = 0; i < objects; ++i) {
+      for (std::uint64_t e = 1; e <= edges_per_object; ++e) {
+        store.add_edge(refs[i], refs[(i + e) % objects], "link", "bench", Bytes{});
+      }
+    }
+    store.commit();
+    store.close();
+  }
+
+  SqliteStore store(SqliteConfig{ .filename=filename });
+  if (!store.open()) {
+    std::fprintf(stderr, "reopen failed\n");
+    return 1;
+  }
+  auto statsR = store.stats();
+  if (!statsR) {
+    std::fprintf(stderr, "stats failed\n");
+    return 1;
+  }
+  const auto& stats = statsR.value.value();
+  std::uint64_t seg_bytes = 0;
+  for (const auto& seg : stats.segments) seg_bytes += seg.bytes;
+
+  std::printf("objects=%llu edges=%llu segment_bytes=%llu\n",
+              (unsigned long long)stats.object_count, (unsigned long long)stats.edge_count,
+              (unsigned long long)seg_bytes);
+  std::printf("open_ms=%.2f load_ms=%.2f rebuild_ms=%.2f\n",
+              stats.timings.open_us / 1000.0, stats.timings.load_us / 1000.0,
+              stats.timings.rebuild_us / 1000.0);
+  if (stats.timings.open_us > 0) {
+    std::printf("throughput=%.1f MiB/s\n",
+                (seg_bytes / (1024.0 * 1024.0)) / (stats.timings.open_us / 1e6));
+  }
+
+  store.close();
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Caliper unit conversion throughput: looking the conversion up per value versus
+// converting batches with the precomputed scale/offset kernels.
+//
+//   bench_unit_convert [values] [batch]
+
+#include "refract/bootstrap.h"
+#include "refract/schema_registry.h"
+#include "refract/unit_converter.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace iris::refract;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Pair {
+  const char* label;
+  const char* from;
+  const char* to;
+};
+
+std::uint64_t arg_or(int argc, char** argv, int index, std::uint64_t fallback) {
+  if (argc <= index) return fallback;
+  return std::strtoull(argv[index], nullptr, 10);
+}
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::uint64_t values = arg_or(argc, argv, 1, 100'000'000);
+  const std::size_t batch = static_cast<std::size_t>(arg_or(argc, argv, 2, 1 << 16));
+  if (batch == 0) return 1;
+
+  referee::SqliteStore store(referee::SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  if (!store.open() || !store.ensure_schema()) return 1;
+  SchemaRegistry registry(store);
+  if (!bootstrap_core_schema(registry) || !bootstrap_core_catalog(registry, store)) return 1;
+
+  auto start = Clock::now();
+  auto convR = UnitConverter::load(registry, store);
+  if (!convR) {
+    std::fprintf(stderr, "load: %s\n", convR.error->message.c_str());
+    return 1;
+  }
+  const auto& conv = convR.value.value();
+  std::printf("load units=%zu ms=%.2f values=%llu batch=%zu\n", conv.size(), seconds_since(start) * 1e3,
+              (unsigned long long)values, batch);
+
+  std::vector<double> in(batch);
+  for (std::size_t i = 0; i < batch; ++i) in[i] = static_cast<double>(i % 1000) * 0.25 - 40.0;
+  std::vector<double> out(batch);
+
+  const std::vector<Pair> pairs = {
+    { "scale mi->km", "mi", "km" },
+    { "affine F->C", "F", "C" },
+    { "offset C->K", "C", "K" },
+  };
+  double checksum = 0;
+  for (const auto& pair : pairs) {
+    // Per value: resolve the pair by symbol, then convert one number.
+    const std::uint64_t single_values = values / 10;
+    start = Clock::now();
+    for (std::uint64_t i = 0; i < single_values; ++i) {
+      auto c = conv.conversion(pair.from, pair.to);
+      if (!c) return 1;
+      checksum += c.value->apply(in[i % batch]);
+    }
+    const double single_s = seconds_since(start);
+
+    start = Clock::now();
+    for (std::uint64_t done = 0; done < values; done += batch) {
+      const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(batch, values - done));
+      if (!conv.convert(pair.from, pair.to, in.data(), out.data(), n)) return 1;
+      checksum += out[done % n];
+    }
+    const double batch_s = seconds_since(start);
+
+    const double single_rate = static_cast<double>(single_values) / single_s;
+    const double batch_rate = static_cast<double>(values) / batch_s;
+    std::printf("%-14s per-value Mval/s=%.1f  batch Mval/s=%.1f speedup=%.1fx  batch s=%.3f\n", pair.label,
+                single_rate / 1e6, batch_rate / 1e6, single_rate > 0 ? batch_rate / single_rate : 0.0, batch_s);
+  }
+  std::printf("checksum=%.3f\n", checksum);
+  return 0;
+}
@@ -2,6 +2,7 @@
 
 #include "refract/dispatch.h"
 
+#include <algorithm>
 #include <string>
 
 namespace iris::ceo {
@@ -58,6 +59,9 @@ struct ExpectedParam {
   bool optional{false};
 };
 
+// Distinct bindings an executor sees are a handful per registry generation.
+constexpr std::size_t kMaxValidatedBindings = 64;
+
 bool params_match(const std::vector<refract::ParameterDefinition>& params,
                   std::initializer_list<ExpectedParam> expected,
                   std::string* err) {
@@ -159,13 +163,27 @@ IoExecutor::IoExecutor(ceo::TaskRegistry& registry,
     reactor_(reactor),
     handles_(handles) {}
 
-referee::Result<IoHandlePair> IoExecutor::open_channel(const refract::DispatchMatch& match,
+bool IoExecutor::validated(const refract::BoundOperation& op, Call call) const {
+  return std::any_of(validated_.begin(), validated_.end(), [&](const ValidatedBinding& seen) {
+    return seen.call == call && seen.table == op.table && seen.slot == op.slot;
+  });
+}
+
+void IoExecutor::remember(const refract::BoundOperation& op, Call call) {
+  if (validated_.size() >= kMaxValidatedBindings) validated_.clear();
+  validated_.push_back(ValidatedBinding{ op.table, op.slot, call });
+}
+
+referee::Result<IoHandlePair> IoExecutor::open_channel(const refract::BoundOperation& op,
                                                        ceo::TaskID a,
                                                        ceo::TaskID b) {
-  auto valid = validate_operation(match.operation, "open_channel", refract::OperationScope::Class,
-                                  { {kTypeU64, false}, {kTypeU64, false} },
-                                  { {kTypeKernelIoChannel, false}, {kTypeKernelIoChannel, false} });
-  if (!valid) return referee::Result<IoHandlePair>::err(valid.error->message);
+  if (!validated(op, Call::OpenChannel)) {
+    auto valid = validate_operation(op.operation(), "open_channel", refract::OperationScope::Class,
+                                    { {kTypeU64, false}, {kTypeU64, false} },
+                                    { {kTypeKernelIoChannel, false}, {kTypeKernelIoChannel, false} });
+    if (!valid) return referee::Result<IoHandlePair>::err(valid.error->message);
+    remember(op, Call::OpenChannel);
+  }
 
   auto openR = comms_.open_channel(a, b);
   if (!openR) return referee::Result<IoHandlePair>::err(openR.error->message);
@@ -175,13 +193,16 @@ referee::Result<IoHandlePair> IoExecutor::open_channel(const refract::DispatchMa
   return referee::Result<IoHandlePair>::ok(out);
 }
 
-referee::Result<IoHandlePair> IoExecutor::open_datagram(const refract::DispatchMatch& match,
+referee::Result<IoHandlePair> IoExecutor::open_datagram(const refract::BoundOperation& op,
                                                         ceo::TaskID a,
                                                         ceo::TaskID b) {
-  auto valid = validate_operation(match.operation, "open_datagram", refract::OperationScope::Class,
-                                  { {kTypeU64, false}, {kTypeU64, false} },
-                                  { {kTypeKernelIoDatagram, false}, {kTypeKernelIoDatagram, false} });
-  if (!valid) return referee::Result<IoHandlePair>::err(valid.error->message);
+  if (!validated(op, Call::OpenDatagram)) {
+    auto valid = validate_operation(op.operation(), "open_datagram", refract::OperationScope::Class,
+                                    { {kTypeU64, false}, {kTypeU64, false} },
+                                    { {kTypeKernelIoDatagram, false}, {kTypeKernelIoDatagram, false} });
+    if (!valid) return referee::Result<IoHandlePair>::err(valid.error->message);
+    remember(op, Call::OpenDatagram);
+  }
 
   auto openR = comms_.open_datagram(a, b);
   if (!openR) return referee::Result<IoHandlePair>::err(openR.error->message);
@@ -191,15 +212,18 @@ referee::Result<IoHandlePair> IoExecutor::open_datagram(const refract::DispatchM
   return referee::Result<IoHandlePair>::ok(out);
 }
 
-referee::Result<IoSendResult> IoExecutor::send_channel(const refract::DispatchMatch& match,
+referee::Result<IoSendResult> IoExecutor::send_channel(const refract::BoundOperation& op,
                                                        const IoHandle& handle,
                                                        const comms::Bytes& data) {
-  auto valid = validate_operation(match.operation, "send", refract::OperationScope::Object,
-                                  { {kTypeBytes, false} },
-                                  { {kTypeBool, false} });
-  if (!valid) return referee::Result<IoSendResult>::err(valid.error->message);
-  if (match.owner_type.v != kTypeKernelIoChannel.v) {
-    return referee::Result<IoSendResult>::err("unexpected owner type for channel send");
+  if (!validated(op, Call::SendChannel)) {
+    auto valid = validate_operation(op.operation(), "send", refract::OperationScope::Object,
+                                    { {kTypeBytes, false} },
+                                    { {kTypeBool, false} });
+    if (!valid) return referee::Result<IoSendResult>::err(valid.error->message);
+    if (op.match().owner_type.v != kTypeKernelIoChannel.v) {
+      return referee::Result<IoSendResult>::err("unexpected owner type for channel send");
+    }
+    remember(op, Call::SendChannel);
   }
 
   auto* channel = handles_.find_channel(handle);
@@ -211,15 +235,18 @@ referee::Result<IoSendResult> IoExecutor::send_channel(const refract::DispatchMa
   return referee::Result<IoSendResult>::ok(out);
 }
 
-referee::Result<IoSendResult> IoExecutor::send_datagram(const refract::DispatchMatch& match,
+referee::Result<IoSendResult> IoExecutor::send_datagram(const refract::BoundOperation& op,
                                                         const IoHandle& handle,
                                                         const comms::Bytes& data) {
-  auto valid = validate_operation(match.operation, "send", refract::OperationScope::Object,
-                                  { {kTypeBytes, false} },
-                                  { {kTypeBool, false} });
-  if (!valid) return referee::Result<IoSendResult>::err(valid.error->message);
-  if (match.owner_type.v != kTypeKernelIoDatagram.v) {
-    return referee::Result<IoSendResult>::err("unexpected owner type for datagram send");
+  if (!validated(op, Call::SendDatagram)) {
+    auto valid = validate_operation(op.operation(), "send", refract::OperationScope::Object,
+                                    { {kTypeBytes, false} },
+                                    { {kTypeBool, false} });
+    if (!valid) return referee::Result<IoSendResult>::err(valid.error->message);
+    if (op.match().owner_type.v != kTypeKernelIoDatagram.v) {
+      return referee::Result<IoSendResult>::err("unexpected owner type for datagram send");
+    }
+    remember(op, Call::SendDatagram);
   }
 
   auto* port = handles_.find_datagram(handle);
@@ -231,15 +258,18 @@ referee::Result<IoSendResult> IoExecutor::send_datagram(const refract::DispatchM
   return referee::Result<IoSendResult>::ok(out);
 }
 
-referee::Result<IoAwaitResult> IoExecutor::await_channel(const refract::DispatchMatch& match,
+referee::Result<IoAwaitResult> IoExecutor::await_channel(const refract::BoundOperation& op,
                                                          const IoHandle& handle,
                                                          ceo::TaskID task) {
-  auto valid = validate_operation(match.operation, "await_readable", refract::OperationScope::Object,
-                                  { {kTypeU64, false} },
-                                  { {kTypeBool, false} });
-  if (!valid) return referee::Result<IoAwaitResult>::err(valid.error->message);
-  if (match.owner_type.v != kTypeKernelIoChannel.v) {
-    return referee::Result<IoAwaitResult>::err("unexpected owner type for channel await");
+  if (!validated(op, Call::AwaitChannel)) {
+    auto valid = validate_operation(op.operation(), "await_readable", refract::OperationScope::Object,
+                                    { {kTypeU64, false} },
+                                    { {kTypeBool, false} });
+    if (!valid) return referee::Result<IoAwaitResult>::err(valid.error->message);
+    if (op.match().owner_type.v != kTypeKernelIoChannel.v) {
+      return referee::Result<IoAwaitResult>::err("unexpected owner type for channel await");
+    }
+    remember(op, Call::AwaitChannel);
   }
 
   auto* channel = handles_.find_channel(handle);
@@ -252,15 +282,18 @@ referee::Result<IoAwaitResult> IoExecutor::await_channel(const refract::Dispatch
   return referee::Result<IoAwaitResult>::ok(out);
 }
 
-referee::Result<IoAwaitResult> IoExecutor::await_datagram(const refract::DispatchMatch& match,
+referee::Result<IoAwaitResult> IoExecutor::await_datagram(const refract::BoundOperation& op,
                                                           const IoHandle& handle,
                                                           ceo::TaskID task) {
-  auto valid = validate_operation(match.operation, "await_readable", refract::OperationScope::Object,
-                                  { {kTypeU64, false} },
-                                  { {kTypeBool, false} });
-  if (!valid) return referee::Result<IoAwaitResult>::err(valid.error->message);
-  if (match.owner_type.v != kTypeKernelIoDatagram.v) {
-    return referee::Result<IoAwaitResult>::err("unexpected owner type for datagram await");
+  if (!validated(op, Call::AwaitDatagram)) {
+    auto valid = validate_operation(op.operation(), "await_readable", refract::OperationScope::Object,
+                                    { {kTypeU64, false} },
+                                    { {kTypeBool, false} });
+    if (!valid) return referee::Result<IoAwaitResult>::err(valid.error->message);
+    if (op.match().owner_type.v != kTypeKernelIoDatagram.v) {
+      return referee::Result<IoAwaitResult>::err("unexpected owner type for datagram await");
+    }
+    remember(op, Call::AwaitDatagram);
   }
 
   auto* port = handles_.find_datagram(handle);
@@ -273,15 +306,18 @@ referee::Result<IoAwaitResult> IoExecutor::await_datagram(const refract::Dispatc
   return referee::Result<IoAwaitResult>::ok(out);
 }
 
-referee::Result<comms::Bytes> IoExecutor::recv_channel(const refract::DispatchMatch& match,
+referee::Result<comms::Bytes> IoExecutor::recv_channel(const refract::BoundOperation& op,
                                                        const IoHandle& handle,
                                                        std::size_t max_bytes) {
-  auto valid = validate_operation(match.operation, "recv", refract::OperationScope::Object,
-                                  { {kTypeU64, false} },
-                                  { {kTypeBytes, false} });
-  if (!valid) return referee::Result<comms::Bytes>::err(valid.error->message);
-  if (match.owner_type.v != kTypeKernelIoChannel.v) {
-    return referee::Result<comms::Bytes>::err("unexpected owner type for channel recv");
+  if (!validated(op, Call::RecvChannel)) {
+    auto valid = validate_operation(op.operation(), "recv", refract::OperationScope::Object,
+                                    { {kTypeU64, false} },
+                                    { {kTypeBytes, false} });
+    if (!valid) return referee::Result<comms::Bytes>::err(valid.error->message);
+    if (op.match().owner_type.v != kTypeKernelIoChannel.v) {
+      return referee::Result<comms::Bytes>::err("unexpected owner type for channel recv");
+    }
+    remember(op, Call::RecvChannel);
   }
 
   auto* channel = handles_.find_channel(handle);
@@ -290,14 +326,17 @@ referee::Result<comms::Bytes> IoExecutor::recv_channel(const refract::DispatchMa
 }
 
 referee::Result<std::optional<comms::Bytes>> IoExecutor::recv_datagram(
-    const refract::DispatchMatch& match,
+    const refract::BoundOperation& op,
     const IoHandle& handle) {
-  auto valid = validate_operation(match.operation, "recv", refract::OperationScope::Object,
-                                  {},
-                                  { {kTypeBytes, true} });
-  if (!valid) return referee::Result<std::optional<comms::Bytes>>::err(valid.error->message);
-  if (match.owner_type.v != kTypeKernelIoDatagram.v) {
-    return referee::Result<std::optional<comms::Bytes>>::err("unexpected owner type for datagram recv");
+  if (!validated(op, Call::RecvDatagram)) {
+    auto valid = validate_operation(op.operation(), "recv", refract::OperationScope::Object,
+                                    {},
+                                    { {kTypeBytes, true} });
+    if (!valid) return referee::Result<std::optional<comms::Bytes>>::err(valid.error->message);
+    if (op.match().owner_type.v != kTypeKernelIoDatagram.v) {
+      return referee::Result<std::optional<comms::Bytes>>::err("unexpected owner type for datagram recv");
+    }
+    remember(op, Call::RecvDatagram);
   }
 
   auto* port = handles_.find_datagram(handle);
@@ -305,14 +344,17 @@ referee::Result<std::optional<comms::Bytes>> IoExecutor::recv_datagram(
   return referee::Result<std::optional<comms::Bytes>>::ok(port->recv());
 }
 
-referee::Result<void> IoExecutor::close_channel(const refract::DispatchMatch& match,
+referee::Result<void> IoExecutor::close_channel(const refract::BoundOperation& op,
                                                 const IoHandle& handle) {
-  auto valid = validate_operation(match.operation, "close", refract::OperationScope::Object,
-                                  {},
-                                  {});
-  if (!valid) return valid;
-  if (match.owner_type.v != kTypeKernelIoChannel.v) {
-    return referee::Result<void>::err("unexpected owner type for channel close");
+  if (!validated(op, Call::CloseChannel)) {
+    auto valid = validate_operation(op.operation(), "close", refract::OperationScope::Object,
+                                    {},
+                                    {});
+    if (!valid) return valid;
+    if (op.match().owner_type.v != kTypeKernelIoChannel.v) {
+      return referee::Result<void>::err("unexpected owner type for channel close");
+    }
+    remember(op, Call::CloseChannel);
   }
 
   auto* channel = handles_.find_channel(handle);
@@ -322,14 +364,17 @@ referee::Result<void> IoExecutor::close_channel(const refract::DispatchMatch& ma
   return referee::Result<void>::ok();
 }
 
-referee::Result<void> IoExecutor::close_datagram(const refract::DispatchMatch& match,
+referee::Result<void> IoExecutor::close_datagram(const refract::BoundOperation& op,
                                                  const IoHandle& handle) {
-  auto valid = validate_operation(match.operation, "close", refract::OperationScope::Object,
-                                  {},
-                                  {});
-  if (!valid) return valid;
-  if (match.owner_type.v != kTypeKernelIoDatagram.v) {
-    return referee::Result<void>::err("unexpected owner type for datagram close");
+  if (!validated(op, Call::CloseDatagram)) {
+    auto valid = validate_operation(op.operation(), "close", refract::OperationScope::Object,
+                                    {},
+                                    {});
+    if (!valid) return valid;
+    if (op.match().owner_type.v != kTypeKernelIoDatagram.v) {
+      return referee::Result<void>::err("unexpected owner type for datagram close");
+    }
+    remember(op, Call::CloseDatagram);
   }
 
   auto* port = handles_.find_datagram(handle);
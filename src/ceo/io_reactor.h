@@ -4,9 +4,12 @@
 #include "comms/primitives.h"
 #include "exec/await.h"
 
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 namespace iris::ceo {
 
@@ -31,7 +34,8 @@ private:
 } // namespace iris::ceo
 
 namespace iris::refract {
-struct DispatchMatch;
+struct BoundOperation;
+class OperationTable;
 } // namespace iris::refract
 
 namespace iris::conduit {
@@ -93,43 +97,68 @@ public:
              ceo::IoReactor& reactor,
              IoHandleStore& handles);
 
-  referee::Result<IoHandlePair> open_channel(const refract::DispatchMatch& match,
+  referee::Result<IoHandlePair> open_channel(const refract::BoundOperation& op,
                                              ceo::TaskID a,
                                              ceo::TaskID b);
-  referee::Result<IoHandlePair> open_datagram(const refract::DispatchMatch& match,
+  referee::Result<IoHandlePair> open_datagram(const refract::BoundOperation& op,
                                               ceo::TaskID a,
                                               ceo::TaskID b);
 
-  referee::Result<IoSendResult> send_channel(const refract::DispatchMatch& match,
+  referee::Result<IoSendResult> send_channel(const refract::BoundOperation& op,
                                              const IoHandle& handle,
                                              const comms::Bytes& data);
-  referee::Result<IoSendResult> send_datagram(const refract::DispatchMatch& match,
+  referee::Result<IoSendResult> send_datagram(const refract::BoundOperation& op,
                                               const IoHandle& handle,
                                               const comms::Bytes& data);
 
-  referee::Result<IoAwaitResult> await_channel(const refract::DispatchMatch& match,
+  referee::Result<IoAwaitResult> await_channel(const refract::BoundOperation& op,
                                                const IoHandle& handle,
                                                ceo::TaskID task);
-  referee::Result<IoAwaitResult> await_datagram(const refract::DispatchMatch& match,
+  referee::Result<IoAwaitResult> await_datagram(const refract::BoundOperation& op,
                                                 const IoHandle& handle,
                                                 ceo::TaskID task);
 
-  referee::Result<comms::Bytes> recv_channel(const refract::DispatchMatch& match,
+  referee::Result<comms::Bytes> recv_channel(const refract::BoundOperation& op,
                                              const IoHandle& handle,
                                              std::size_t max_bytes);
-  referee::Result<std::optional<comms::Bytes>> recv_datagram(const refract::DispatchMatch& match,
+  referee::Result<std::optional<comms::Bytes>> recv_datagram(const refract::BoundOperation& op,
                                                              const IoHandle& handle);
 
-  referee::Result<void> close_channel(const refract::DispatchMatch& match,
+  referee::Result<void> close_channel(const refract::BoundOperation& op,
                                       const IoHandle& handle);
-  referee::Result<void> close_datagram(const refract::DispatchMatch& match,
+  referee::Result<void> close_datagram(const refract::BoundOperation& op,
                                        const IoHandle& handle);
 
 private:
+  enum class Call : std::uint8_t {
+    OpenChannel,
+    OpenDatagram,
+    SendChannel,
+    SendDatagram,
+    AwaitChannel,
+    AwaitDatagram,
+    RecvChannel,
+    RecvDatagram,
+    CloseChannel,
+    CloseDatagram,
+  };
+
+  bool validated(const refract::BoundOperation& op, Call call) const;
+  void remember(const refract::BoundOperation& op, Call call);
+
   ceo::TaskRegistry& registry_;
   ceo::TaskComms& comms_;
   ceo::IoReactor& reactor_;
   IoHandleStore& handles_;
+  // A binding that already passed the signature check of `call`, so callers that
+  // keep a BoundOperation pay for the check once. Holding the table keeps its
+  // address from being reused by a different table.
+  struct ValidatedBinding {
+    std::shared_ptr<const refract::OperationTable> table;
+    std::uint32_t slot{0};
+    Call call{};
+  };
+  std::vector<ValidatedBinding> validated_;
 };
 
 } // namespace iris::conduit
@@ -188,6 +188,13 @@ referee::Result<void> TaskRegistry::fail_task(TaskID id, std::string reason) {
   return referee::Result<void>::ok();
 }
 
+referee::Result<void> TaskRegistry::set_capabilities(TaskID id, const refract::CapabilitySet& granted) {
+  auto* rec = find_task(id);
+  if (!rec) return referee::Result<void>::err("task not found");
+  rec->capabilities.assign(granted);
+  return referee::Result<void>::ok();
+}
+
 referee::Result<std::optional<TaskRecord>> TaskRegistry::get_task(TaskID id) const {
   const auto* rec = find_task(id);
   if (!rec) return referee::Result<std::optional<TaskRecord>>::ok(std::nullopt);
@@ -241,6 +248,7 @@ referee::Result<TaskRecord> TaskRegistry::insert_task(const referee::ObjectID& o
   rec.state = initial_state;
   rec.mode = mode;
   rec.name = std::move(name);
+  if (parent.has_value()) rec.capabilities.assign(find_task(*parent)->capabilities.granted());
 
   auto insert = tasks_.emplace(rec.id, rec);
   if (!insert.second) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "refract/capabilities.h"
 #include "referee/referee.h"
 #include <cstdint>
 #include <optional>
@@ -50,6 +51,8 @@ struct TaskRecord {
   TaskState state{TaskState::Created};
   TaskMode mode{TaskMode::Inline};
   std::string name;
+  // Starts as a copy of the parent's grants; none for a root task.
+  refract::CapabilityPrincipal capabilities;
 };
 
 class TaskRegistry {
@@ -90,6 +93,7 @@ public:
   referee::Result<void> kill_task(TaskID id);
   referee::Result<void> complete_task(TaskID id);
   referee::Result<void> fail_task(TaskID id, std::string reason);
+  referee::Result<void> set_capabilities(TaskID id, const refract::CapabilitySet& granted);
 
   referee::Result<std::optional<TaskRecord>> get_task(TaskID id) const;
   referee::Result<std::vector<TaskRecord>> list_tasks() const;
@@ -5,12 +5,18 @@
 #include "ceo/io_reactor.h"
 #include "ceo/task_registry.h"
 #include "comms/primitives.h"
+#include "refract/astra.h"
 #include "refract/bootstrap.h"
+#include "refract/capability_policy.h"
 #include "refract/dispatch.h"
+#include "refract/payload_codec.h"
+#include "refract/payload_validator.h"
 #include "refract/schema_registry.h"
+#include "referee/cbor_path.h"
 #include "referee/referee.h"
 #include "referee_sqlite/sqlite_store.h"
 #include "viz/artifacts.h"
+#include "viz/store_stats.h"
 #include "vizier/routing.h"
 
 #include <algorithm>
@@ -46,8 +52,10 @@
 
 using iris::refract::SchemaRegistry;
 using iris::refract::TypeSummary;
+using iris::refract::TypeNameIndex;
 using iris::refract::DispatchEngine;
 using iris::refract::OperationScope;
+using iris::refract::PayloadValidator;
 using referee::ObjectID;
 using referee::ObjectRef;
 using referee::SqliteConfig;
@@ -152,7 +160,10 @@ std::string trim_copy(std::string value) {
   return value;
 }
 
-bool parse_kv_payload(const std::string& text, nlohmann::json* payload, std::string* err_out) {
+// field:=value pairs, unconverted; the type's payload codec gives them their types.
+using KvFields = std::vector<std::pair<std::string, std::string>>;
+
+bool parse_kv_payload(const std::string& text, KvFields* fields, std::string* err_out) {
   size_t i = 0;
   auto fail = [&](const std::string& msg) {
     if (err_out) *err_out = msg;
@@ -208,15 +219,7 @@ bool parse_kv_payload(const std::string& text, nlohmann::json* payload, std::str
       value = text.substr(value_start, i - value_start);
     }
 
-    bool b = false;
-    std::int64_t n = 0;
-    if (parse_bool(std::string_view(value), &b)) {
-      (*payload)[field] = b;
-    } else if (parse_int(std::string_view(value), &n)) {
-      (*payload)[field] = n;
-    } else {
-      (*payload)[field] = value;
-    }
+    fields->emplace_back(std::move(field), std::move(value));
   }
   return true;
 }
@@ -271,9 +274,13 @@ bool value_to_json(const iris::parser::ValueNode& node, nlohmann::json* out,
   return fail("unsupported json value");
 }
 
-referee::Result<void> parse_new_expr(const std::string& expr,
-                                     std::string* type_name_out,
-                                     nlohmann::json* payload_out) {
+struct NewExpr {
+  std::string type_name;
+  std::optional<nlohmann::json> json_payload; // new --json {...}
+  KvFields fields;                            // new <TypeName> field:=value ...
+};
+
+referee::Result<void> parse_new_expr(const std::string& expr, NewExpr* out) {
   std::string err;
   auto s = trim_copy(expr);
   if (s.rfind("new", 0) != 0) {
@@ -306,26 +313,21 @@ referee::Result<void> parse_new_expr(const std::string& expr,
     if (type_name.empty()) {
       return referee::Result<void>::err("json missing type");
     }
-    *type_name_out = type_name;
-    if (j.contains("payload")) {
-      *payload_out = j.at("payload");
-    } else {
-      *payload_out = nlohmann::json::object();
-    }
+    out->type_name = type_name;
+    out->json_payload = j.contains("payload") ? j.at("payload") : nlohmann::json::object();
     return referee::Result<void>::ok();
   }
 
   size_t i = 0;
   while (i < s.size() && !std::isspace(static_cast<unsigned char>(s[i]))) ++i;
-  *type_name_out = s.substr(0, i);
-  if (type_name_out->empty()) {
+  out->type_name = s.substr(0, i);
+  if (out->type_name.empty()) {
     return referee::Result<void>::err("usage: new <TypeName> field:=value ...");
   }
   auto rest = trim_copy(s.substr(i));
-  *payload_out = nlohmann::json::object();
   if (rest.empty()) return referee::Result<void>::ok();
 
-  if (!parse_kv_payload(rest, payload_out, &err)) {
+  if (!parse_kv_payload(rest, &out->fields, &err)) {
     return referee::Result<void>::err(err);
   }
   return referee::Result<void>::ok();
@@ -369,22 +371,19 @@ bool match_pattern(std::string_view value, std::string_view pattern, bool regex_
   }
 }
 
-std::optional<TypeSummary> find_type_summary(const std::vector<TypeSummary>& types,
+std::optional<TypeSummary> find_type_summary(const TypeNameIndex& types,
                                              const std::string& name,
                                              std::string* err_out) {
-  std::optional<TypeSummary> match;
-  for (const auto& t : types) {
-    auto full = type_display_name(t);
-    if (t.name == name || full == name) {
-      if (match.has_value()) {
-        if (err_out) *err_out = "ambiguous type name";
-        return std::nullopt;
-      }
-      match = t;
-    }
+  auto matches = types.lookup(name);
+  if (matches.size() > 1) {
+    if (err_out) *err_out = "ambiguous type name";
+    return std::nullopt;
+  }
+  if (matches.empty()) {
+    if (err_out) *err_out = "type not found";
+    return std::nullopt;
   }
-  if (!match.has_value() && err_out) *err_out = "type not found";
-  return match;
+  return *matches.front();
 }
 
 std::optional<ObjectID> parse_object_id(const std::string& token, std::string* err_out) {
@@ -429,18 +428,12 @@ std::optional<ObjectID> parse_object_id_or_alias(
   auto it = session_aliases.find(name);
   if (it != session_aliases.end()) return it->second;
 
-  auto typesR = registry.list_types();
-  if (!typesR) {
-    if (err_out) *err_out = typesR.error->message;
+  auto alias_typeR = registry.find_type("Conch", "Alias");
+  if (!alias_typeR) {
+    if (err_out) *err_out = alias_typeR.error->message;
     return std::nullopt;
   }
-  std::optional<TypeSummary> alias_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "Alias") {
-      alias_type = summary;
-      break;
-    }
-  }
+  const auto& alias_type = alias_typeR.value.value();
   if (!alias_type.has_value()) {
     if (err_out) *err_out = "alias type not registered";
     return std::nullopt;
@@ -452,16 +445,10 @@ std::optional<ObjectID> parse_object_id_or_alias(
     return std::nullopt;
   }
   for (const auto& rec : listR.value.value()) {
-    try {
-      auto json = nlohmann::json::from_cbor(rec.payload_cbor);
-      if (json.value("name", "") == name) {
-        auto oid_text = json.value("object_id", "");
-        if (oid_text.empty()) continue;
-        return parse_object_id(oid_text, err_out);
-      }
-    } catch (const std::exception&) {
-      continue;
-    }
+    if (referee::cbor_find_text(rec.payload_cbor, {"name"}) != std::string_view(name)) continue;
+    auto oid_text = referee::cbor_find_text(rec.payload_cbor, {"object_id"});
+    if (!oid_text.has_value() || oid_text->empty()) continue;
+    return parse_object_id(std::string(*oid_text), err_out);
   }
 
   if (name.size() >= 4 && name.size() < 32 && name.front() != '@') {
@@ -475,7 +462,12 @@ std::optional<ObjectID> parse_object_id_or_alias(
     if (hex_only) {
       std::optional<ObjectID> match;
       bool ambiguous = false;
-      for (const auto& summary : typesR.value.value()) {
+      auto namesR = registry.type_names();
+      if (!namesR) {
+        if (err_out) *err_out = namesR.error->message;
+        return std::nullopt;
+      }
+      for (const auto& summary : namesR.value.value()->types()) {
         auto objsR = store.list_by_type(summary.type_id);
         if (!objsR) {
           if (err_out) *err_out = objsR.error->message;
@@ -539,12 +531,12 @@ std::uint64_t fnv1a_64(std::string_view input) {
 std::optional<TypeSummary> resolve_type(SchemaRegistry& registry,
                                         const std::string& name,
                                         std::string* err_out) {
-  auto typesR = registry.list_types();
+  auto typesR = registry.type_names();
   if (!typesR) {
     if (err_out) *err_out = typesR.error->message;
     return std::nullopt;
   }
-  return find_type_summary(typesR.value.value(), name, err_out);
+  return find_type_summary(*typesR.value.value(), name, err_out);
 }
 
 struct OperationListing {
@@ -553,37 +545,20 @@ struct OperationListing {
   std::size_t depth{0};
 };
 
-bool is_base_role(std::string_view role) {
-  return role == "base" || role == "extends";
-}
-
-std::vector<TypeID> resolve_base_types(const iris::refract::TypeDefinition& def,
-                                       const std::vector<TypeSummary>& types) {
-  std::vector<TypeID> out;
-  for (const auto& rel : def.relationships) {
-    if (!is_base_role(rel.role)) continue;
-    auto base = find_type_summary(types, rel.target, nullptr);
-    if (base.has_value()) out.push_back(base->type_id);
-  }
-  return out;
-}
-
 referee::Result<std::vector<OperationListing>> list_operations_with_inheritance(
     SchemaRegistry& registry,
-    const std::vector<TypeSummary>& types,
     TypeID root_type,
     bool include_inherited) {
   std::vector<OperationListing> out;
-  std::deque<std::pair<TypeID, std::size_t>> queue;
-  std::unordered_set<std::uint64_t> visited;
-
-  queue.push_back({ root_type, 0 });
-  visited.insert(root_type.v);
-
-  while (!queue.empty()) {
-    auto [current, depth] = queue.front();
-    queue.pop_front();
+  auto subtypesR = registry.subtypes();
+  if (!subtypesR) {
+    return referee::Result<std::vector<OperationListing>>::err(subtypesR.error->message);
+  }
+  const auto order = include_inherited
+      ? subtypesR.value.value()->linearization(root_type)
+      : std::vector<iris::refract::TypeAncestor>{ { root_type, 0 } };
 
+  for (const auto& [current, depth] : order) {
     auto defR = registry.get_latest_definition_by_type(current);
     if (!defR) {
       return referee::Result<std::vector<OperationListing>>::err(defR.error->message);
@@ -600,23 +575,13 @@ referee::Result<std::vector<OperationListing>> list_operations_with_inheritance(
       entry.depth = depth;
       out.push_back(std::move(entry));
     }
-
-    if (include_inherited) {
-      for (const auto& base : resolve_base_types(def, types)) {
-        if (visited.insert(base.v).second) {
-          queue.push_back({ base, depth + 1 });
-        }
-      }
-    }
   }
 
   return referee::Result<std::vector<OperationListing>>::ok(std::move(out));
 }
 
-std::string type_display_name_for(const std::vector<TypeSummary>& types, TypeID type_id) {
-  for (const auto& t : types) {
-    if (t.type_id.v == type_id.v) return type_display_name(t);
-  }
+std::string type_display_name_for(const TypeNameIndex& types, TypeID type_id) {
+  if (const auto* t = types.by_type(type_id)) return type_display_name(*t);
   std::ostringstream os;
   os << "0x" << std::hex << type_id.v << std::dec;
   return os.str();
@@ -706,58 +671,66 @@ bool parse_task_mode(const std::string& token, iris::ceo::TaskMode* out) {
   return false;
 }
 
-bool has_required_capabilities(const iris::refract::OperationDefinition& op,
-                               const std::set<std::string>& granted,
+bool has_required_capabilities(iris::refract::CapabilityPolicy& policy,
+                               const iris::refract::BoundOperation& op,
+                               const iris::refract::CapabilityPrincipal& principal,
                                std::string* err_out) {
-  if (op.required_capabilities.empty()) return true;
-  for (const auto& required : op.required_capabilities) {
-    if (granted.find(required) == granted.end()) {
-      if (err_out) *err_out = "missing capability: " + required;
-      return false;
-    }
-  }
-  return true;
+  const auto decision = policy.check(op, principal);
+  if (!decision.allowed && err_out) *err_out = decision.message();
+  return decision.allowed;
 }
 
-void cmd_caps_list(const std::set<std::string>& caps) {
+void cmd_caps_list(const iris::refract::CapabilityTable& table,
+                   const iris::refract::CapabilityPrincipal& session) {
+  std::vector<std::string> caps;
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    const auto id = static_cast<iris::refract::CapabilityID>(i);
+    if (session.has(id)) caps.push_back(table.name(id));
+  }
   if (caps.empty()) {
     std::cout << "caps: (none)\n";
     return;
   }
+  std::sort(caps.begin(), caps.end());
   std::cout << "caps\n";
   for (const auto& cap : caps) {
     std::cout << "  " << cap << "\n";
   }
 }
 
-bool cmd_caps_grant(std::set<std::string>& caps, const std::vector<std::string>& args) {
+bool cmd_caps_grant(iris::refract::CapabilityPolicy& policy, iris::refract::CapabilityPrincipal& session,
+                    const std::vector<std::string>& args) {
   if (args.size() < 2) {
     std::cout << "error: usage: caps grant <cap> [cap...]\n";
     return false;
   }
   for (size_t i = 1; i < args.size(); ++i) {
-    caps.insert(args[i]);
+    if (!policy.grant(session, args[i])) {
+      std::cout << "error: too many capability names\n";
+      return false;
+    }
   }
   return true;
 }
 
-bool cmd_caps_revoke(std::set<std::string>& caps, const std::vector<std::string>& args) {
+bool cmd_caps_revoke(iris::refract::CapabilityPolicy& policy, iris::refract::CapabilityPrincipal& session,
+                     const std::vector<std::string>& args) {
   if (args.size() < 2) {
     std::cout << "error: usage: caps revoke <cap> [cap...]\n";
     return false;
   }
   for (size_t i = 1; i < args.size(); ++i) {
-    caps.erase(args[i]);
+    policy.revoke(session, args[i]);
   }
   return true;
 }
 
-bool cmd_caps_clear(std::set<std::string>& caps, const std::vector<std::string>& args) {
+bool cmd_caps_clear(iris::refract::CapabilityPrincipal& session, const std::vector<std::string>& args) {
   if (args.size() != 1) {
     std::cout << "error: usage: caps clear\n";
     return false;
   }
-  caps.clear();
+  session.clear();
   return true;
 }
 
@@ -864,24 +837,33 @@ void print_io_outcome(const iris::exec::AwaitOutcome& outcome) {
 }
 
 std::optional<IoAliasRecord> parse_io_alias_record(const referee::ObjectRecord& rec) {
-  try {
-    auto json = nlohmann::json::from_cbor(rec.payload_cbor);
-    auto name = json.value("name", "");
-    auto kind_text = json.value("kind", "");
-    auto handle_id = json.value("handle_id", 0ULL);
-    auto active = json.value("active", false);
-    auto kind = io_kind_from_string(kind_text);
-    if (name.empty() || !kind.has_value()) return std::nullopt;
-    IoAliasRecord out;
-    out.name = name;
-    out.kind = kind.value();
-    out.handle_id = handle_id;
-    out.active = active;
-    out.created_at = rec.created_at_unix_ms;
-    return out;
-  } catch (const std::exception&) {
-    return std::nullopt;
-  }
+  const auto& cbor = rec.payload_cbor;
+  auto name = referee::cbor_find_text(cbor, {"name"});
+  auto kind_text = referee::cbor_find_text(cbor, {"kind"});
+  if (!name.has_value() || name->empty() || !kind_text.has_value()) return std::nullopt;
+  auto kind = io_kind_from_string(std::string(*kind_text));
+  if (!kind.has_value()) return std::nullopt;
+
+  std::uint64_t handle_id = 0;
+  if (auto item = referee::cbor_find(cbor, {"handle_id"})) {
+    auto v = referee::cbor_uint(*item);
+    if (!v.has_value()) return std::nullopt;
+    handle_id = *v;
+  }
+  bool active = false;
+  if (auto item = referee::cbor_find(cbor, {"active"})) {
+    auto v = referee::cbor_bool(*item);
+    if (!v.has_value()) return std::nullopt;
+    active = *v;
+  }
+
+  IoAliasRecord out;
+  out.name = std::string(*name);
+  out.kind = kind.value();
+  out.handle_id = handle_id;
+  out.active = active;
+  out.created_at = rec.created_at_unix_ms;
+  return out;
 }
 
 referee::Result<void> persist_io_alias(SqliteStore& store,
@@ -889,15 +871,9 @@ referee::Result<void> persist_io_alias(SqliteStore& store,
                                        const std::string& name,
                                        const iris::conduit::IoHandle& handle,
                                        bool active) {
-  auto typesR = registry.list_types();
-  if (!typesR) return referee::Result<void>::err(typesR.error->message);
-  std::optional<TypeSummary> alias_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "IoHandleAlias") {
-      alias_type = summary;
-      break;
-    }
-  }
+  auto alias_typeR = registry.find_type("Conch", "IoHandleAlias");
+  if (!alias_typeR) return referee::Result<void>::err(alias_typeR.error->message);
+  const auto& alias_type = alias_typeR.value.value();
   if (!alias_type.has_value()) {
     return referee::Result<void>::err("io handle alias type not registered");
   }
@@ -916,15 +892,9 @@ referee::Result<void> persist_io_alias(SqliteStore& store,
 void load_io_aliases(SqliteStore& store,
                      SchemaRegistry& registry,
                      std::unordered_map<std::string, iris::conduit::IoHandle>& aliases) {
-  auto typesR = registry.list_types();
-  if (!typesR) return;
-  std::optional<TypeSummary> alias_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "IoHandleAlias") {
-      alias_type = summary;
-      break;
-    }
-  }
+  auto alias_typeR = registry.find_type("Conch", "IoHandleAlias");
+  if (!alias_typeR) return;
+  const auto& alias_type = alias_typeR.value.value();
   if (!alias_type.has_value()) return;
 
   auto listR = store.list_by_type(alias_type->type_id);
@@ -952,18 +922,12 @@ void list_io_aliases(SqliteStore& store,
                      SchemaRegistry& registry,
                      const std::unordered_map<std::string, iris::conduit::IoHandle>& aliases,
                      iris::conduit::IoHandleStore& handle_store) {
-  auto typesR = registry.list_types();
-  if (!typesR) {
-    std::cout << "error: " << typesR.error->message << "\n";
+  auto alias_typeR = registry.find_type("Conch", "IoHandleAlias");
+  if (!alias_typeR) {
+    std::cout << "error: " << alias_typeR.error->message << "\n";
     return;
   }
-  std::optional<TypeSummary> alias_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "IoHandleAlias") {
-      alias_type = summary;
-      break;
-    }
-  }
+  const auto& alias_type = alias_typeR.value.value();
   if (!alias_type.has_value()) {
     std::cout << "error: io handle alias type not registered\n";
     return;
@@ -996,20 +960,91 @@ void list_io_aliases(SqliteStore& store,
   }
 }
 
+enum class IoOp : std::size_t {
+  OpenChannel,
+  OpenDatagram,
+  ChannelSend,
+  DatagramSend,
+  ChannelAwaitReadable,
+  DatagramAwaitReadable,
+  ChannelRecv,
+  DatagramRecv,
+  ChannelClose,
+  DatagramClose,
+  Count,
+};
+
+struct IoOpSpec {
+  TypeID type;
+  const char* name;
+  OperationScope scope;
+  std::vector<TypeID> arg_types;
+  std::size_t arg_count;
+};
+
+// The io operations bound once per session; a registry change rebinds them.
+struct IoBindings {
+  std::uint64_t generation{0};
+  std::array<std::optional<iris::refract::BoundOperation>, static_cast<std::size_t>(IoOp::Count)> ops;
+};
+
+const iris::refract::BoundOperation* bind_io(IoBindings& bindings,
+                                             SchemaRegistry& registry,
+                                             DispatchEngine& engine,
+                                             iris::refract::CapabilityPolicy& policy,
+                                             const iris::refract::CapabilityPrincipal& session,
+                                             IoOp op) {
+  static const std::array<IoOpSpec, static_cast<std::size_t>(IoOp::Count)> kSpecs = {{
+    { kTypeKernelIo, "open_channel", OperationScope::Class, {kTypeU64, kTypeU64}, 2 },
+    { kTypeKernelIo, "open_datagram", OperationScope::Class, {kTypeU64, kTypeU64}, 2 },
+    { kTypeKernelIoChannel, "send", OperationScope::Object, {kTypeBytes}, 1 },
+    { kTypeKernelIoDatagram, "send", OperationScope::Object, {kTypeBytes}, 1 },
+    { kTypeKernelIoChannel, "await_readable", OperationScope::Object, {kTypeU64}, 1 },
+    { kTypeKernelIoDatagram, "await_readable", OperationScope::Object, {kTypeU64}, 1 },
+    { kTypeKernelIoChannel, "recv", OperationScope::Object, {kTypeU64}, 1 },
+    { kTypeKernelIoDatagram, "recv", OperationScope::Object, {}, 0 },
+    { kTypeKernelIoChannel, "close", OperationScope::Object, {}, 0 },
+    { kTypeKernelIoDatagram, "close", OperationScope::Object, {}, 0 },
+  }};
+  const auto generation = registry.generation();
+  if (generation != bindings.generation) {
+    for (auto& bound : bindings.ops) bound.reset();
+    bindings.generation = generation;
+  }
+  auto& bound = bindings.ops[static_cast<std::size_t>(op)];
+  if (!bound) {
+    const auto& spec = kSpecs[static_cast<std::size_t>(op)];
+    auto boundR = engine.bind(spec.type, spec.name, spec.scope, spec.arg_types, spec.arg_count);
+    if (!boundR) {
+      std::cout << "error: " << boundR.error->message << "\n";
+      return nullptr;
+    }
+    bound = std::move(boundR.value.value());
+  }
+  std::string cap_err;
+  if (!has_required_capabilities(policy, *bound, session, &cap_err)) {
+    std::cout << "error: " << cap_err << "\n";
+    return nullptr;
+  }
+  return &*bound;
+}
+
 bool cmd_io(iris::conduit::IoExecutor& executor,
+            IoBindings& bindings,
             iris::conduit::IoHandleStore& handle_store,
             std::unordered_map<std::string, iris::conduit::IoHandle>& handles,
             std::unordered_map<std::string, iris::conduit::IoHandle>& aliases,
             std::uint64_t& next_handle_id,
             SchemaRegistry& registry,
+            DispatchEngine& engine,
             SqliteStore& store,
-            const std::set<std::string>& session_caps,
+            iris::refract::CapabilityPolicy& policy,
+            const iris::refract::CapabilityPrincipal& session,
             const std::vector<std::string>& args) {
   if (args.empty()) {
     std::cout << "error: usage: io <open|send|recv|await|close|handles|aliases|alias|unalias>\n";
     return false;
   }
-  DispatchEngine engine(registry);
 
   if (args[0] == "handles") {
     if (handles.empty()) {
@@ -1040,18 +1075,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return false;
     }
     if (args[1] == "channel") {
-      auto matchR = engine.resolve(kTypeKernelIo, "open_channel", OperationScope::Class,
-                                   {kTypeU64, kTypeU64}, 2, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto openR = executor.open_channel(matchR.value.value(), a, b);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::OpenChannel);
+      if (!op) return false;
+      auto openR = executor.open_channel(*op, a, b);
       if (!openR) {
         std::cout << "error: " << openR.error->message << "\n";
         return false;
@@ -1064,18 +1090,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return true;
     }
     if (args[1] == "datagram") {
-      auto matchR = engine.resolve(kTypeKernelIo, "open_datagram", OperationScope::Class,
-                                   {kTypeU64, kTypeU64}, 2, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto openR = executor.open_datagram(matchR.value.value(), a, b);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::OpenDatagram);
+      if (!op) return false;
+      auto openR = executor.open_datagram(*op, a, b);
       if (!openR) {
         std::cout << "error: " << openR.error->message << "\n";
         return false;
@@ -1108,18 +1125,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return false;
     }
     if (handle.kind == iris::conduit::IoHandleKind::Channel) {
-      auto matchR = engine.resolve(kTypeKernelIoChannel, "send", OperationScope::Object,
-                                   {kTypeBytes}, 1, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto sendR = executor.send_channel(matchR.value.value(), handle, bytes);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::ChannelSend);
+      if (!op) return false;
+      auto sendR = executor.send_channel(*op, handle, bytes);
       if (!sendR) {
         std::cout << "error: " << sendR.error->message << "\n";
         return false;
@@ -1129,18 +1137,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return true;
     }
     if (handle.kind == iris::conduit::IoHandleKind::Datagram) {
-      auto matchR = engine.resolve(kTypeKernelIoDatagram, "send", OperationScope::Object,
-                                   {kTypeBytes}, 1, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto sendR = executor.send_datagram(matchR.value.value(), handle, bytes);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::DatagramSend);
+      if (!op) return false;
+      auto sendR = executor.send_datagram(*op, handle, bytes);
       if (!sendR) {
         std::cout << "error: " << sendR.error->message << "\n";
         return false;
@@ -1170,18 +1169,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return false;
     }
     if (handle.kind == iris::conduit::IoHandleKind::Channel) {
-      auto matchR = engine.resolve(kTypeKernelIoChannel, "await_readable", OperationScope::Object,
-                                   {kTypeU64}, 1, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto waitR = executor.await_channel(matchR.value.value(), handle, task_id);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::ChannelAwaitReadable);
+      if (!op) return false;
+      auto waitR = executor.await_channel(*op, handle, task_id);
       if (!waitR) {
         std::cout << "error: " << waitR.error->message << "\n";
         return false;
@@ -1191,18 +1181,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return true;
     }
     if (handle.kind == iris::conduit::IoHandleKind::Datagram) {
-      auto matchR = engine.resolve(kTypeKernelIoDatagram, "await_readable", OperationScope::Object,
-                                   {kTypeU64}, 1, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto waitR = executor.await_datagram(matchR.value.value(), handle, task_id);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::DatagramAwaitReadable);
+      if (!op) return false;
+      auto waitR = executor.await_datagram(*op, handle, task_id);
       if (!waitR) {
         std::cout << "error: " << waitR.error->message << "\n";
         return false;
@@ -1236,18 +1217,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
         std::cout << "error: invalid max_bytes\n";
         return false;
       }
-      auto matchR = engine.resolve(kTypeKernelIoChannel, "recv", OperationScope::Object,
-                                   {kTypeU64}, 1, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto recvR = executor.recv_channel(matchR.value.value(), handle, max_bytes);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::ChannelRecv);
+      if (!op) return false;
+      auto recvR = executor.recv_channel(*op, handle, max_bytes);
       if (!recvR) {
         std::cout << "error: " << recvR.error->message << "\n";
         return false;
@@ -1260,17 +1232,9 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
         std::cout << "error: usage: io recv <handle>\n";
         return false;
       }
-      auto matchR = engine.resolve(kTypeKernelIoDatagram, "recv", OperationScope::Object, {}, 0, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto recvR = executor.recv_datagram(matchR.value.value(), handle);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::DatagramRecv);
+      if (!op) return false;
+      auto recvR = executor.recv_datagram(*op, handle);
       if (!recvR) {
         std::cout << "error: " << recvR.error->message << "\n";
         return false;
@@ -1298,33 +1262,17 @@ bool cmd_io(iris::conduit::IoExecutor& executor,
       return false;
     }
     if (handle.kind == iris::conduit::IoHandleKind::Channel) {
-      auto matchR = engine.resolve(kTypeKernelIoChannel, "close", OperationScope::Object, {}, 0, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto closeR = executor.close_channel(matchR.value.value(), handle);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::ChannelClose);
+      if (!op) return false;
+      auto closeR = executor.close_channel(*op, handle);
       if (!closeR) {
         std::cout << "error: " << closeR.error->message << "\n";
         return false;
       }
     } else if (handle.kind == iris::conduit::IoHandleKind::Datagram) {
-      auto matchR = engine.resolve(kTypeKernelIoDatagram, "close", OperationScope::Object, {}, 0, true);
-      if (!matchR) {
-        std::cout << "error: " << matchR.error->message << "\n";
-        return false;
-      }
-      std::string cap_err;
-      if (!has_required_capabilities(matchR.value->operation, session_caps, &cap_err)) {
-        std::cout << "error: " << cap_err << "\n";
-        return false;
-      }
-      auto closeR = executor.close_datagram(matchR.value.value(), handle);
+      const auto* op = bind_io(bindings, registry, engine, policy, session, IoOp::DatagramClose);
+      if (!op) return false;
+      auto closeR = executor.close_datagram(*op, handle);
       if (!closeR) {
         std::cout << "error: " << closeR.error->message << "\n";
         return false;
@@ -1393,11 +1341,11 @@ const char* scope_label(OperationScope scope) {
 }
 
 void print_operations(SchemaRegistry& registry,
-                      const std::vector<TypeSummary>& types,
+                      const TypeNameIndex& types,
                       TypeID type_id,
                       std::optional<OperationScope> scope_filter,
                       bool include_inherited) {
-  auto listR = list_operations_with_inheritance(registry, types, type_id, include_inherited);
+  auto listR = list_operations_with_inheritance(registry, type_id, include_inherited);
   if (!listR) {
     std::cout << "error: " << listR.error->message << "\n";
     return;
@@ -1537,107 +1485,112 @@ bool parse_hex_bytes(std::string_view v, std::vector<std::uint8_t>* out, std::st
   return true;
 }
 
-const nlohmann::json* payload_value(const nlohmann::json& payload) {
-  if (payload.is_object()) {
-    auto it = payload.find("value");
-    if (it != payload.end()) return &(*it);
+// Object payloads are CBOR, except type definitions, which are stored in their
+// binary layout and shown through their JSON export.
+nlohmann::json payload_json(const referee::ObjectRecord& rec) {
+  if (rec.type.v == iris::refract::kTypeDefinitionType.v) {
+    auto defR = iris::refract::decode_definition_payload(rec.payload_cbor);
+    if (!defR) throw std::runtime_error(defR.error->message);
+    return nlohmann::json::parse(iris::refract::definition_to_json(defR.value.value()));
   }
-  return &payload;
+  return nlohmann::json::from_cbor(rec.payload_cbor);
+}
+
+// A core value payload is either {"value": x} or x itself.
+referee::CborSlice payload_value(const referee::Bytes& payload) {
+  if (auto value = referee::cbor_find(payload, {"value"})) return *value;
+  return referee::CborSlice{payload.data(), payload.size()};
 }
 
-bool read_string_value(const nlohmann::json& payload, std::string* out, std::string* err_out) {
-  const auto* value = payload_value(payload);
-  if (value->is_string()) {
-    *out = value->get<std::string>();
+bool read_string_value(const referee::Bytes& payload, std::string* out, std::string* err_out) {
+  if (auto text = referee::cbor_text(payload_value(payload))) {
+    *out = std::string(*text);
     return true;
   }
   if (err_out) *err_out = "expected string value";
   return false;
 }
 
-bool read_bool_value(const nlohmann::json& payload, bool* out, std::string* err_out) {
-  const auto* value = payload_value(payload);
-  if (value->is_boolean()) {
-    *out = value->get<bool>();
+bool read_bool_value(const referee::Bytes& payload, bool* out, std::string* err_out) {
+  const auto value = payload_value(payload);
+  if (auto b = referee::cbor_bool(value)) {
+    *out = *b;
     return true;
   }
-  if (value->is_number_integer()) {
-    *out = value->get<int>() != 0;
+  if (auto n = referee::cbor_int(value)) {
+    *out = *n != 0;
     return true;
   }
   if (err_out) *err_out = "expected bool value";
   return false;
 }
 
-bool read_u64_value(const nlohmann::json& payload, std::uint64_t* out, std::string* err_out) {
-  const auto* value = payload_value(payload);
-  if (value->is_number_unsigned()) {
-    *out = value->get<std::uint64_t>();
+bool read_u64_value(const referee::Bytes& payload, std::uint64_t* out, std::string* err_out) {
+  const auto value = payload_value(payload);
+  if (auto v = referee::cbor_uint(value)) {
+    *out = *v;
     return true;
   }
-  if (value->is_number_integer()) {
-    auto v = value->get<std::int64_t>();
-    if (v < 0) {
-      if (err_out) *err_out = "expected unsigned value";
-      return false;
-    }
-    *out = static_cast<std::uint64_t>(v);
-    return true;
+  if (referee::cbor_int(value)) {
+    if (err_out) *err_out = "expected unsigned value";
+    return false;
   }
-  if (value->is_string()) {
-    return parse_u64(value->get<std::string>(), out);
+  if (auto text = referee::cbor_text(value)) {
+    return parse_u64(*text, out);
   }
   if (err_out) *err_out = "expected u64 value";
   return false;
 }
 
-bool read_double_value(const nlohmann::json& payload, double* out, std::string* err_out) {
-  const auto* value = payload_value(payload);
-  if (value->is_number()) {
-    *out = value->get<double>();
+bool read_double_value(const referee::Bytes& payload, double* out, std::string* err_out) {
+  const auto value = payload_value(payload);
+  if (auto v = referee::cbor_double(value)) {
+    *out = *v;
     return true;
   }
-  if (value->is_string()) {
-    return parse_double(value->get<std::string>(), out);
+  if (auto text = referee::cbor_text(value)) {
+    return parse_double(*text, out);
   }
   if (err_out) *err_out = "expected f64 value";
   return false;
 }
 
-bool read_object_id_value(const nlohmann::json& payload, referee::ObjectID* out,
+bool read_object_id_value(const referee::Bytes& payload, referee::ObjectID* out,
                           std::string* err_out) {
-  const auto* value = payload_value(payload);
-  if (value->is_string()) {
-    auto hex = value->get<std::string>();
-    if (hex.size() == 32) {
-      *out = referee::ObjectID::from_hex(hex);
-      return true;
-    }
+  auto hex = referee::cbor_text(payload_value(payload));
+  if (hex && hex->size() == 32) {
+    *out = referee::ObjectID::from_hex(*hex);
+    return true;
   }
   if (err_out) *err_out = "expected object id hex value";
   return false;
 }
 
-bool read_bytes_value(const nlohmann::json& payload, std::string* out, std::string* err_out) {
-  const auto* value = payload_value(payload);
-  if (value->is_string()) {
-    *out = value->get<std::string>();
+bool read_bytes_value(const referee::Bytes& payload, std::string* out, std::string* err_out) {
+  const auto value = payload_value(payload);
+  if (auto text = referee::cbor_text(value)) {
+    *out = std::string(*text);
     return true;
   }
-  if (value->is_array()) {
+  auto items = referee::CborContainer::open(value);
+  if (items && !items->is_map()) {
     std::vector<std::uint8_t> bytes;
-    bytes.reserve(value->size());
-    for (const auto& item : *value) {
-      if (!item.is_number_integer() && !item.is_number_unsigned()) {
+    referee::CborSlice item;
+    while (items->next(&item)) {
+      auto v = referee::cbor_int(item);
+      if (!v) {
         if (err_out) *err_out = "invalid byte array";
         return false;
       }
-      auto v = item.get<int>();
-      if (v < 0 || v > 255) {
+      if (*v < 0 || *v > 255) {
         if (err_out) *err_out = "invalid byte value";
         return false;
       }
-      bytes.push_back(static_cast<std::uint8_t>(v));
+      bytes.push_back(static_cast<std::uint8_t>(*v));
+    }
+    if (items->malformed()) {
+      if (err_out) *err_out = "invalid byte array";
+      return false;
     }
     *out = bytes_to_hex(bytes);
     return true;
@@ -1693,6 +1646,7 @@ void print_help() {
   std::cout << "  demo v1\n";
   std::cout << "  route <ObjectID>\n";
   std::cout << "  route type <TypeName>\n";
+  std::cout << "  stats [emit]\n";
   std::cout << "  note: ObjectID prefixes (>=4 hex chars) resolve when unambiguous\n";
   std::cout << "  help\n";
   std::cout << "  exit\n";
@@ -1702,21 +1656,19 @@ void cmd_ls(SchemaRegistry& registry, SqliteStore& store,
             const std::optional<std::string>& filter,
             bool regex_mode,
             bool namespaces_only) {
-  auto typesR = registry.list_types();
+  auto typesR = registry.type_names();
   if (!typesR) {
     std::cout << "error: " << typesR.error->message << "\n";
     return;
   }
-  if (typesR.value->empty()) {
+  const auto& types = *typesR.value.value();
+  if (types.size() == 0) {
     std::cout << "no types registered\n";
     return;
   }
 
   if (namespaces_only) {
-    std::set<std::string> namespaces;
-    for (const auto& summary : typesR.value.value()) {
-      if (!summary.namespace_name.empty()) namespaces.insert(summary.namespace_name);
-    }
+    auto namespaces = types.namespaces();
     if (namespaces.empty()) {
       std::cout << "no namespaces\n";
       return;
@@ -1737,18 +1689,28 @@ void cmd_ls(SchemaRegistry& registry, SqliteStore& store,
     return;
   }
 
-  for (const auto& summary : typesR.value.value()) {
-    auto display = type_display_name(summary);
-    if (filter.has_value()) {
-      std::string err;
-      if (!match_pattern(display, *filter, regex_mode, &err)) {
-        if (!err.empty()) {
-          std::cout << "error: " << err << "\n";
-          return;
+  // Globs are answered by the index; regexes still test every name.
+  std::vector<const TypeSummary*> listed;
+  if (filter.has_value() && !regex_mode) {
+    listed = types.matching(*filter);
+  } else {
+    for (const auto& summary : types.types()) {
+      if (filter.has_value()) {
+        std::string err;
+        if (!match_pattern(type_display_name(summary), *filter, regex_mode, &err)) {
+          if (!err.empty()) {
+            std::cout << "error: " << err << "\n";
+            return;
+          }
+          continue;
         }
-        continue;
       }
+      listed.push_back(&summary);
     }
+  }
+
+  for (const auto* entry : listed) {
+    const auto& summary = *entry;
     std::cout << "type " << type_display_name(summary) << " (0x" << std::hex << summary.type_id.v
               << std::dec << ")\n";
     auto listR = store.list_by_type(summary.type_id);
@@ -1767,13 +1729,13 @@ void cmd_ls(SchemaRegistry& registry, SqliteStore& store,
 }
 
 void cmd_objects(SchemaRegistry& registry, SqliteStore& store) {
-  auto typesR = registry.list_types();
+  auto typesR = registry.type_names();
   if (!typesR) {
     std::cout << "error: " << typesR.error->message << "\n";
     return;
   }
   bool any = false;
-  for (const auto& summary : typesR.value.value()) {
+  for (const auto& summary : typesR.value.value()->types()) {
     auto listR = store.list_by_type(summary.type_id);
     if (!listR) {
       std::cout << "error: " << listR.error->message << "\n";
@@ -2075,13 +2037,13 @@ void cmd_new_object(SchemaRegistry& registry, SqliteStore& store, const std::str
 }
 
 void cmd_find_type(SchemaRegistry& registry, const std::string& name) {
-  auto typesR = registry.list_types();
+  auto typesR = registry.type_names();
   if (!typesR) {
     std::cout << "error: " << typesR.error->message << "\n";
     return;
   }
   std::string err;
-  auto match = find_type_summary(typesR.value.value(), name, &err);
+  auto match = find_type_summary(*typesR.value.value(), name, &err);
   if (!match.has_value()) {
     std::cout << "error: " << err << "\n";
     return;
@@ -2091,13 +2053,13 @@ void cmd_find_type(SchemaRegistry& registry, const std::string& name) {
 }
 
 void cmd_show_type(SchemaRegistry& registry, const std::string& name) {
-  auto typesR = registry.list_types();
+  auto typesR = registry.type_names();
   if (!typesR) {
     std::cout << "error: " << typesR.error->message << "\n";
     return;
   }
   std::string err;
-  auto match = find_type_summary(typesR.value.value(), name, &err);
+  auto match = find_type_summary(*typesR.value.value(), name, &err);
   if (!match.has_value()) {
     std::cout << "error: " << err << "\n";
     return;
@@ -2162,7 +2124,7 @@ void cmd_show_type(SchemaRegistry& registry, const std::string& name) {
       std::cout << "\n";
     }
   }
-  print_operations(registry, typesR.value.value(), match->type_id, std::nullopt, true);
+  print_operations(registry, *typesR.value.value(), match->type_id, std::nullopt, true);
 }
 
 void cmd_ops(SchemaRegistry& registry, const std::vector<std::string>& args) {
@@ -2171,14 +2133,14 @@ void cmd_ops(SchemaRegistry& registry, const std::vector<std::string>& args) {
     return;
   }
 
-  auto typesR = registry.list_types();
+  auto typesR = registry.type_names();
   if (!typesR) {
     std::cout << "error: " << typesR.error->message << "\n";
     return;
   }
 
   std::string err;
-  auto match = find_type_summary(typesR.value.value(), args[0], &err);
+  auto match = find_type_summary(*typesR.value.value(), args[0], &err);
   if (!match.has_value()) {
     std::cout << "error: " << err << "\n";
     return;
@@ -2205,7 +2167,7 @@ void cmd_ops(SchemaRegistry& registry, const std::vector<std::string>& args) {
     return;
   }
 
-  print_operations(registry, typesR.value.value(), match->type_id, scope_filter, include_inherited);
+  print_operations(registry, *typesR.value.value(), match->type_id, scope_filter, include_inherited);
 }
 
 void cmd_show(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id) {
@@ -2226,8 +2188,7 @@ void cmd_show(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id)
   std::cout << "created_at_ms " << rec.created_at_unix_ms << "\n";
 
   try {
-    auto json = referee::json_string_from_cbor(rec.payload_cbor);
-    std::cout << "payload " << json << "\n";
+    std::cout << "payload " << payload_json(rec).dump() << "\n";
   } catch (const std::exception& ex) {
     std::cout << "payload <unparseable> (" << ex.what() << ")\n";
   }
@@ -2323,9 +2284,82 @@ void cmd_edges(SqliteStore& store, const ObjectID& id) {
   }
 }
 
-bool cmd_call(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id,
+// Runs a native Astra operation: array arguments are object ids of packed payloads,
+// F64 ones numbers. Array results are stored as new objects.
+bool call_astra_native(SchemaRegistry& registry, SqliteStore& store, const referee::ObjectRecord& self,
+                       const iris::refract::OperationDefinition& op, iris::refract::AstraNative native,
+                       const std::vector<std::string>& args) {
+  constexpr referee::TypeID kTypeF64{0x1008ULL};
+  auto selfR = iris::refract::unpack_astra(self.payload_cbor);
+  if (!selfR) {
+    std::cout << "error: " << selfR.error->message << "\n";
+    return false;
+  }
+  const auto& params = op.signature.params;
+  if (args.size() != params.size()) {
+    std::cout << "error: " << op.name << " expects " << params.size() << " args\n";
+    return false;
+  }
+  std::vector<iris::refract::AstraValue> values(args.size());
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    if (params[i].type == kTypeF64) {
+      if (!parse_double(args[i], &values[i].scalar)) {
+        std::cout << "error: invalid f64 arg\n";
+        return false;
+      }
+      continue;
+    }
+    std::string err;
+    auto arg_id = parse_object_id(args[i], &err);
+    if (!arg_id.has_value()) {
+      std::cout << "error: " << err << "\n";
+      return false;
+    }
+    auto argR = store.get_latest(arg_id.value());
+    if (!argR || !argR.value->has_value()) {
+      std::cout << "error: " << (argR ? std::string("object not found") : argR.error->message) << "\n";
+      return false;
+    }
+    auto arrayR = iris::refract::unpack_astra(argR.value->value().payload_cbor);
+    if (!arrayR) {
+      std::cout << "error: " << params[i].name << ": " << arrayR.error->message << "\n";
+      return false;
+    }
+    values[i].array = std::move(arrayR.value.value());
+  }
+
+  auto resultR = native(selfR.value.value(), values);
+  if (!resultR) {
+    std::cout << "error: " << resultR.error->message << "\n";
+    return false;
+  }
+  if (!resultR.value->array.has_value()) {
+    std::cout << "result " << resultR.value->scalar << "\n";
+    std::cout << "call ok\n";
+    return true;
+  }
+  const auto result_type = op.signature.outputs.empty() ? self.type : op.signature.outputs.front().type;
+  auto defR = registry.get_latest_definition_by_type(result_type);
+  if (!defR || !defR.value->has_value()) {
+    std::cout << "error: " << (defR ? std::string("result definition not found") : defR.error->message) << "\n";
+    return false;
+  }
+  auto createR = store.create_object(result_type, defR.value->value().ref.id,
+                                     iris::refract::pack_astra(resultR.value->array.value()));
+  if (!createR) {
+    std::cout << "error: " << createR.error->message << "\n";
+    return false;
+  }
+  std::cout << "result " << createR.value->ref.id.to_hex() << "\n";
+  std::cout << "call ok\n";
+  return true;
+}
+
+bool cmd_call(SchemaRegistry& registry, DispatchEngine& engine, SqliteStore& store,
+              const ObjectID& id,
               const std::string& op_name, const std::vector<std::string>& args,
-              const std::set<std::string>& granted_caps) {
+              iris::refract::CapabilityPolicy& policy,
+              const iris::refract::CapabilityPrincipal& session) {
   auto recR = store.get_latest(id);
   if (!recR) {
     std::cout << "error: " << recR.error->message << "\n";
@@ -2345,14 +2379,13 @@ bool cmd_call(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id,
     return false;
   }
   const auto& def = defR.value->value().definition;
-  DispatchEngine engine(registry);
-  auto matchR = engine.resolve(def.type_id, op_name, OperationScope::Object, {}, args.size(), true);
+  auto matchR = engine.bind(def.type_id, op_name, OperationScope::Object, {}, args.size());
   if (!matchR) {
     std::cout << "error: " << matchR.error->message << "\n";
     return false;
   }
   std::string cap_err;
-  if (!has_required_capabilities(matchR.value->operation, granted_caps, &cap_err)) {
+  if (!has_required_capabilities(policy, matchR.value.value(), session, &cap_err)) {
     std::cout << "error: " << cap_err << "\n";
     return false;
   }
@@ -2371,16 +2404,21 @@ bool cmd_call(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id,
       return false;
     }
 
-    nlohmann::json payload;
-    try {
-      payload = nlohmann::json::from_cbor(recR.value->value().payload_cbor);
-    } catch (const std::exception& ex) {
-      std::cout << "error: payload decode failed: " << ex.what() << "\n";
+    auto type_id = recR.value->value().type;
+    const bool core_value = type_id.v == kTypeString.v || type_id.v == kTypeU64.v
+                            || type_id.v == kTypeVersion.v || type_id.v == kTypeBool.v
+                            || type_id.v == kTypeObjectID.v || type_id.v == kTypeTypeID.v
+                            || type_id.v == kTypeF64.v || type_id.v == kTypeBytes.v;
+    if (!core_value) return false;
+
+    const auto& payload = recR.value->value().payload_cbor;
+    if (referee::cbor_lookup(payload.data(), payload.size(), {}, nullptr)
+        != referee::CborLookup::Found) {
+      std::cout << "error: payload decode failed: malformed CBOR\n";
       return true;
     }
 
     std::string err;
-    auto type_id = recR.value->value().type;
     std::string text;
 
     if (type_id.v == kTypeString.v) {
@@ -2493,6 +2531,9 @@ bool cmd_call(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id,
   };
 
   if (try_core_op()) return true;
+  if (auto native = iris::refract::astra_native(matchR.value.value())) {
+    return call_astra_native(registry, store, recR.value->value(), matchR.value->operation(), native, args);
+  }
 
   if (def.namespace_name == "Demo" && def.name == "PropulsionSynth" && op_name == "start") {
     auto demoR = demo_start(registry, store, id);
@@ -2524,18 +2565,32 @@ bool cmd_call(SchemaRegistry& registry, SqliteStore& store, const ObjectID& id,
 
 referee::Result<ObjectID> create_object(SchemaRegistry& registry, SqliteStore& store,
                                         const std::string& expr) {
-  std::string type_name;
-  nlohmann::json payload = nlohmann::json::object();
-  auto parseR = parse_new_expr(expr, &type_name, &payload);
+  NewExpr parsed;
+  auto parseR = parse_new_expr(expr, &parsed);
   if (!parseR) return referee::Result<ObjectID>::err(parseR.error->message);
 
   std::string err;
-  auto type_summary = resolve_type(registry, type_name, &err);
+  auto type_summary = resolve_type(registry, parsed.type_name, &err);
   if (!type_summary.has_value()) {
     return referee::Result<ObjectID>::err(err);
   }
+  auto defR = registry.get_definition_by_id(type_summary->definition_id);
+  if (!defR) return referee::Result<ObjectID>::err(defR.error->message);
+  if (!defR.value->has_value()) return referee::Result<ObjectID>::err("definition not found");
+  const auto codec = iris::refract::PayloadCodec::compile(defR.value->value().definition);
 
-  auto cbor = nlohmann::json::to_cbor(payload);
+  referee::Bytes cbor;
+  if (parsed.json_payload.has_value()) {
+    cbor = nlohmann::json::to_cbor(parsed.json_payload.value());
+    auto checkR = codec.decode(cbor);
+    if (!checkR) return referee::Result<ObjectID>::err(checkR.error->message);
+  } else {
+    auto encoder = codec.encoder();
+    for (const auto& [field, value] : parsed.fields) encoder.parse(field, value);
+    auto encodedR = encoder.finish();
+    if (!encodedR) return referee::Result<ObjectID>::err(encodedR.error->message);
+    cbor = std::move(encodedR.value.value());
+  }
   auto createR = store.create_object(type_summary->type_id, type_summary->definition_id, cbor);
   if (!createR) {
     return referee::Result<ObjectID>::err(createR.error->message);
@@ -2545,15 +2600,9 @@ referee::Result<ObjectID> create_object(SchemaRegistry& registry, SqliteStore& s
 
 referee::Result<void> persist_alias(SqliteStore& store, SchemaRegistry& registry,
                                     const std::string& name, const ObjectID& object_id) {
-  auto typesR = registry.list_types();
-  if (!typesR) return referee::Result<void>::err(typesR.error->message);
-  std::optional<TypeSummary> alias_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "Alias") {
-      alias_type = summary;
-      break;
-    }
-  }
+  auto alias_typeR = registry.find_type("Conch", "Alias");
+  if (!alias_typeR) return referee::Result<void>::err(alias_typeR.error->message);
+  const auto& alias_type = alias_typeR.value.value();
   if (!alias_type.has_value()) return referee::Result<void>::err("alias type not registered");
 
   nlohmann::json payload;
@@ -2579,18 +2628,12 @@ void cmd_list_aliases(SqliteStore& store, SchemaRegistry& registry,
     return;
   }
 
-  auto typesR = registry.list_types();
-  if (!typesR) {
-    std::cout << "error: " << typesR.error->message << "\n";
+  auto alias_typeR = registry.find_type("Conch", "Alias");
+  if (!alias_typeR) {
+    std::cout << "error: " << alias_typeR.error->message << "\n";
     return;
   }
-  std::optional<TypeSummary> alias_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "Alias") {
-      alias_type = summary;
-      break;
-    }
-  }
+  const auto& alias_type = alias_typeR.value.value();
   if (!alias_type.has_value()) {
     std::cout << "error: alias type not registered\n";
     return;
@@ -2605,15 +2648,10 @@ void cmd_list_aliases(SqliteStore& store, SchemaRegistry& registry,
     return;
   }
   for (const auto& rec : listR.value.value()) {
-    try {
-      auto json = nlohmann::json::from_cbor(rec.payload_cbor);
-      auto name = json.value("name", "");
-      auto oid = json.value("object_id", "");
-      if (!name.empty() && !oid.empty()) {
-        std::cout << name << " = " << oid << "\n";
-      }
-    } catch (const std::exception&) {
-      continue;
+    auto name = referee::cbor_find_text(rec.payload_cbor, {"name"});
+    auto oid = referee::cbor_find_text(rec.payload_cbor, {"object_id"});
+    if (name.has_value() && oid.has_value() && !name->empty() && !oid->empty()) {
+      std::cout << *name << " = " << *oid << "\n";
     }
   }
 }
@@ -3264,10 +3302,93 @@ void cmd_route_object(SchemaRegistry& registry, SqliteStore& store,
   std::cout << "route: " << route->concho << "\n";
 }
 
+void cmd_stats(SchemaRegistry& registry, const DispatchEngine& dispatch, SqliteStore& store,
+               const std::vector<std::string>& args) {
+  bool emit = false;
+  if (args.size() == 1 && args[0] == "emit") {
+    emit = true;
+  } else if (!args.empty()) {
+    std::cout << "error: usage: stats [emit]\n";
+    return;
+  }
+
+  auto statsR = store.stats();
+  if (!statsR) {
+    std::cout << "error: " << statsR.error->message << "\n";
+    return;
+  }
+  const auto& stats = statsR.value.value();
+
+  if (emit) {
+    auto artifactsR = iris::viz::create_store_stats_artifacts(registry, store, stats);
+    if (!artifactsR) {
+      std::cout << "error: " << artifactsR.error->message << "\n";
+      return;
+    }
+    for (const auto& id : artifactsR.value->tables) {
+      std::cout << "created Viz::Table " << id.to_hex() << "\n";
+    }
+    for (const auto& id : artifactsR.value->metrics) {
+      std::cout << "created Viz::Metric " << id.to_hex() << "\n";
+    }
+    return;
+  }
+
+  TypeNameIndex no_types;
+  auto typesR = registry.type_names();
+  const auto& types = typesR ? *typesR.value.value() : no_types;
+
+  std::cout << "objects " << stats.object_count << " edges " << stats.edge_count << "\n";
+  std::cout << "segments\n";
+  for (const auto& seg : stats.segments) {
+    std::cout << "  " << seg.name << " records=" << seg.records << " bytes=" << seg.bytes << "\n";
+  }
+  std::cout << "types\n";
+  for (const auto& usage : stats.objects_by_type) {
+    std::cout << "  " << type_display_name_for(types, usage.type) << " objects=" << usage.objects
+              << " payload_bytes=" << usage.payload_bytes << "\n";
+  }
+  std::cout << "edges\n";
+  for (const auto& usage : stats.edges_by_name) {
+    std::cout << "  " << (usage.name.empty() ? "(unnamed)" : usage.name) << " edges=" << usage.edges
+              << " props_bytes=" << usage.props_bytes << "\n";
+  }
+  std::cout << "indexes\n";
+  for (const auto& index : stats.indexes) {
+    std::cout << "  " << index.name << " entries=" << index.entries << " bytes=" << index.bytes
+              << " bytes/record=" << std::fixed << std::setprecision(1) << index.bytes_per_record()
+              << std::defaultfloat << "\n";
+  }
+  std::cout << "timings open_us=" << stats.timings.open_us << " load_us=" << stats.timings.load_us
+            << " rebuild_us=" << stats.timings.rebuild_us << "\n";
+  std::cout << "checkpoint loaded=" << (stats.checkpoint.loaded ? "yes" : "no")
+            << " covered_bytes=" << stats.checkpoint.covered_bytes
+            << " replayed_bytes=" << stats.checkpoint.replayed_bytes
+            << " written=" << stats.checkpoint.written << "\n";
+  auto print_latency = [](const char* name, const referee::LatencyHistogram& h) {
+    std::cout << "  " << name << " count=" << h.count << " p50_ns=" << h.percentile_ns(0.50)
+              << " p99_ns=" << h.percentile_ns(0.99) << " max_ns=" << h.max_ns << "\n";
+  };
+  std::cout << "append latency\n";
+  print_latency("object", stats.object_appends);
+  print_latency("edge", stats.edge_appends);
+  std::cout << "lookups\n";
+  std::cout << "  get_object hits=" << stats.object_lookups.hits << " misses="
+            << stats.object_lookups.misses << "\n";
+  std::cout << "  get_latest hits=" << stats.latest_lookups.hits << " misses="
+            << stats.latest_lookups.misses << "\n";
+  const auto dispatch_stats = dispatch.cache_stats();
+  std::cout << "  dispatch hits=" << dispatch_stats.hits << " misses=" << dispatch_stats.misses
+            << " entries=" << dispatch_stats.entries
+            << " invalidations=" << dispatch_stats.invalidations << " hit_rate=" << std::fixed
+            << std::setprecision(2) << dispatch_stats.hit_rate() << std::defaultfloat << "\n";
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
   std::string db_path = "referee.db";
+  bool read_only = false;
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
@@ -3275,17 +3396,22 @@ int main(int argc, char** argv) {
       db_path = argv[++i];
       continue;
     }
+    if (arg == "--read-only") {
+      read_only = true;
+      continue;
+    }
     if (arg == "--help" || arg == "-h") {
-      std::cout << "Usage: conch [--db <path>]\n";
+      std::cout << "Usage: conch [--db <path>] [--read-only]\n";
       return 0;
     }
     std::cout << "unknown argument: " << arg << "\n";
     return 1;
   }
 
-  SqliteStore store(SqliteConfig{ .filename=db_path });
-  if (!store.open()) {
-    std::cout << "error: failed to open db\n";
+  SqliteStore store(SqliteConfig{ .filename=db_path, .read_only=read_only });
+  auto openR = store.open();
+  if (!openR) {
+    std::cout << "error: failed to open db: " << openR.error->message << "\n";
     return 1;
   }
   if (!store.ensure_schema()) {
@@ -3294,16 +3420,22 @@ int main(int argc, char** argv) {
   }
 
   SchemaRegistry registry(store);
+  DispatchEngine dispatch(registry);
   auto bootstrapR = iris::refract::bootstrap_core_schema(registry);
   if (!bootstrapR) {
     std::cout << "error: bootstrap failed: " << bootstrapR.error->message << "\n";
     return 1;
   }
-  auto catalogR = iris::refract::bootstrap_core_catalog(registry, store);
-  if (!catalogR) {
-    std::cout << "error: bootstrap catalog failed: " << catalogR.error->message << "\n";
-    return 1;
+  // A shared reader cannot seed; it sees whatever catalog the writer has stored.
+  if (!store.read_only()) {
+    auto catalogR = iris::refract::bootstrap_core_catalog(registry, store);
+    if (!catalogR) {
+      std::cout << "error: bootstrap catalog failed: " << catalogR.error->message << "\n";
+      return 1;
+    }
   }
+  PayloadValidator payload_validator(registry);
+  if (!read_only) payload_validator.install(store);
 #if !defined(HAVE_READLINE)
   if (::isatty(STDIN_FILENO)) {
     std::cout << "note: readline not available; history disabled\n";
@@ -3315,11 +3447,13 @@ int main(int argc, char** argv) {
   iris::ceo::IoReactor ceo_reactor(ceo_registry);
   iris::conduit::IoHandleStore io_handle_store;
   iris::conduit::IoExecutor io_executor(ceo_registry, ceo_comms, ceo_reactor, io_handle_store);
+  IoBindings io_bindings;
   std::unordered_map<std::string, iris::conduit::IoHandle> io_handles;
   std::unordered_map<std::string, iris::conduit::IoHandle> io_handle_aliases;
   std::uint64_t next_io_handle_id = 1;
   std::unordered_map<std::string, ObjectID> session_aliases;
-  std::set<std::string> session_caps;
+  iris::refract::CapabilityPolicy policy(registry);
+  iris::refract::CapabilityPrincipal session;
   std::uint64_t next_task_id = 1;
 
   load_io_aliases(store, registry, io_handle_aliases);
@@ -3344,6 +3478,11 @@ int main(int argc, char** argv) {
     }
     if (parsed.name.empty()) continue;
 
+    if (store.read_only()) {
+      auto refreshR = store.refresh();
+      if (!refreshR) std::cout << "warning: refresh failed: " << refreshR.error->message << "\n";
+    }
+
     const auto& cmd = parsed.name;
     if (cmd == "let") {
       cmd_alias_assignment(line, "let", false, registry, store, session_aliases);
@@ -3423,20 +3562,20 @@ int main(int argc, char** argv) {
     }
     if (cmd == "caps") {
       if (parsed.args.empty()) {
-        cmd_caps_list(session_caps);
+        cmd_caps_list(registry.capabilities(), session);
         continue;
       }
       const auto& action = parsed.args[0];
       if (action == "grant") {
-        cmd_caps_grant(session_caps, parsed.args);
+        cmd_caps_grant(policy, session, parsed.args);
         continue;
       }
       if (action == "revoke") {
-        cmd_caps_revoke(session_caps, parsed.args);
+        cmd_caps_revoke(policy, session, parsed.args);
         continue;
       }
       if (action == "clear") {
-        cmd_caps_clear(session_caps, parsed.args);
+        cmd_caps_clear(session, parsed.args);
         continue;
       }
       std::cout << "error: usage: caps [grant|revoke|clear]\n";
@@ -3473,7 +3612,7 @@ int main(int argc, char** argv) {
       if (parsed.args.size() > 2) {
         args.assign(parsed.args.begin() + 2, parsed.args.end());
       }
-      cmd_call(registry, store, id.value(), parsed.args[1], args, session_caps);
+      cmd_call(registry, dispatch, store, id.value(), parsed.args[1], args, policy, session);
       continue;
     }
     if (cmd == "start" && parsed.args.size() == 1) {
@@ -3483,7 +3622,7 @@ int main(int argc, char** argv) {
         std::cout << "error: " << err << "\n";
         continue;
       }
-      bool ok = cmd_call(registry, store, id.value(), "start", {}, session_caps);
+      bool ok = cmd_call(registry, dispatch, store, id.value(), "start", {}, policy, session);
       if (ok) {
         std::ostringstream os;
         os << "task-" << std::setw(4) << std::setfill('0') << next_task_id++;
@@ -3534,8 +3673,8 @@ int main(int argc, char** argv) {
       continue;
     }
     if (cmd == "io") {
-      cmd_io(io_executor, io_handle_store, io_handles, io_handle_aliases,
-             next_io_handle_id, registry, store, session_caps, parsed.args);
+      cmd_io(io_executor, io_bindings, io_handle_store, io_handles, io_handle_aliases,
+             next_io_handle_id, registry, dispatch, store, policy, session, parsed.args);
       continue;
     }
     if (cmd == "edge") {
@@ -3570,6 +3709,10 @@ int main(int argc, char** argv) {
       std::cout << "error: usage: route <ObjectID> | route type <TypeName>\n";
       continue;
     }
+    if (cmd == "stats") {
+      cmd_stats(registry, dispatch, store, parsed.args);
+      continue;
+    }
 
     std::cout << "error: unknown command\n";
   }
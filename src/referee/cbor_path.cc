@@ -0,0 +1,342 @@
+#include "referee/cbor_path.h"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace referee {
+namespace {
+
+constexpr std::uint8_t kIndefinite = 31;
+constexpr std::uint8_t kBreak = 0xFF;
+constexpr int kMaxDepth = 256;
+
+struct Head {
+  std::uint8_t major{0};
+  std::uint8_t info{0};
+  std::uint64_t arg{0};   // length, count or value; unused when indefinite
+};
+
+// Decodes the initial byte and argument at `p`; returns the position after them.
+const std::uint8_t* read_head(const std::uint8_t* p, const std::uint8_t* end, Head* out) {
+  if (p >= end) return nullptr;
+  out->major = static_cast<std::uint8_t>(*p >> 5);
+  out->info = static_cast<std::uint8_t>(*p & 0x1F);
+  ++p;
+  std::size_t extra = 0;
+  if (out->info < 24) {
+    out->arg = out->info;
+    return p;
+  }
+  switch (out->info) {
+    case 24: extra = 1; break;
+    case 25: extra = 2; break;
+    case 26: extra = 4; break;
+    case 27: extra = 8; break;
+    case kIndefinite:
+      if (out->major == 0 || out->major == 1 || out->major == 6) return nullptr;
+      out->arg = 0;
+      return p;
+    default:
+      return nullptr;
+  }
+  if (static_cast<std::size_t>(end - p) < extra) return nullptr;
+  std::uint64_t v = 0;
+  for (std::size_t i = 0; i < extra; ++i) v = (v << 8) | p[i];
+  out->arg = v;
+  return p + extra;
+}
+
+const std::uint8_t* skip_item(const std::uint8_t* p, const std::uint8_t* end, int depth);
+
+const std::uint8_t* skip_bytes(const std::uint8_t* p, const std::uint8_t* end, std::uint64_t n) {
+  if (static_cast<std::uint64_t>(end - p) < n) return nullptr;
+  return p + n;
+}
+
+// Skips items until the break byte of an indefinite container.
+const std::uint8_t* skip_until_break(const std::uint8_t* p, const std::uint8_t* end, int depth,
+                                     int items_per_entry) {
+  for (;;) {
+    if (p >= end) return nullptr;
+    if (*p == kBreak) return p + 1;
+    for (int i = 0; i < items_per_entry; ++i) {
+      p = skip_item(p, end, depth);
+      if (!p) return nullptr;
+    }
+  }
+}
+
+const std::uint8_t* skip_item(const std::uint8_t* p, const std::uint8_t* end, int depth) {
+  if (depth > kMaxDepth) return nullptr;
+  // Most payload items are small ints, simple values and short strings.
+  if (p < end && (*p & 0x1F) < 24) {
+    const auto major = *p >> 5;
+    if (major <= 1 || major == 7) return p + 1;
+    if (major == 2 || major == 3) return skip_bytes(p + 1, end, *p & 0x1F);
+  }
+  Head h;
+  p = read_head(p, end, &h);
+  if (!p) return nullptr;
+  const bool indefinite = (h.info == kIndefinite);
+  switch (h.major) {
+    case 0:
+    case 1:
+      return p;
+    case 2:
+    case 3:
+      if (!indefinite) return skip_bytes(p, end, h.arg);
+      // Chunks must be definite strings of the same major type.
+      for (;;) {
+        if (p >= end) return nullptr;
+        if (*p == kBreak) return p + 1;
+        Head chunk;
+        p = read_head(p, end, &chunk);
+        if (!p || chunk.major != h.major || chunk.info == kIndefinite) return nullptr;
+        p = skip_bytes(p, end, chunk.arg);
+        if (!p) return nullptr;
+      }
+    case 4:
+      if (indefinite) return skip_until_break(p, end, depth + 1, 1);
+      for (std::uint64_t i = 0; i < h.arg; ++i) {
+        p = skip_item(p, end, depth + 1);
+        if (!p) return nullptr;
+      }
+      return p;
+    case 5:
+      if (indefinite) return skip_until_break(p, end, depth + 1, 2);
+      for (std::uint64_t i = 0; i < h.arg; ++i) {
+        p = skip_item(p, end, depth + 1);
+        if (!p) return nullptr;
+        p = skip_item(p, end, depth + 1);
+        if (!p) return nullptr;
+      }
+      return p;
+    case 6:
+      return skip_item(p, end, depth + 1);
+    default: // 7: simple values and floats, fully described by the head
+      return indefinite ? nullptr : p;
+  }
+}
+
+// Skips any tags in front of an item.
+const std::uint8_t* strip_tags(const std::uint8_t* p, const std::uint8_t* end) {
+  while (p && p < end && (*p >> 5) == 6) {
+    Head h;
+    p = read_head(p, end, &h);
+  }
+  return p;
+}
+
+bool parse_index(std::string_view segment, std::uint64_t* out) {
+  if (segment.empty() || segment.size() > 19) return false;
+  std::uint64_t v = 0;
+  for (char c : segment) {
+    if (c < '0' || c > '9') return false;
+    v = v * 10 + static_cast<std::uint64_t>(c - '0');
+  }
+  *out = v;
+  return true;
+}
+
+// Compares a map key against `key` without copying; non-text keys never match.
+const std::uint8_t* match_key(const std::uint8_t* p, const std::uint8_t* end,
+                              std::string_view key, bool* matched) {
+  *matched = false;
+  const std::uint8_t* item = strip_tags(p, end);
+  if (!item) return nullptr;
+  Head h;
+  const std::uint8_t* body = read_head(item, end, &h);
+  if (body && h.major == 3 && h.info != kIndefinite) {
+    if (static_cast<std::uint64_t>(end - body) < h.arg) return nullptr;
+    *matched = h.arg == key.size() && std::memcmp(body, key.data(), key.size()) == 0;
+    return body + h.arg;
+  }
+  return skip_item(p, end, 1);
+}
+
+// Positions `*p` at the value for `segment` inside the container at `*p`.
+CborLookup step(const std::uint8_t** p, const std::uint8_t* end, std::string_view segment) {
+  const std::uint8_t* q = strip_tags(*p, end);
+  if (!q) return CborLookup::Malformed;
+  Head h;
+  q = read_head(q, end, &h);
+  if (!q) return CborLookup::Malformed;
+  const bool indefinite = (h.info == kIndefinite);
+
+  if (h.major == 5) {
+    for (std::uint64_t i = 0; indefinite || i < h.arg; ++i) {
+      if (indefinite) {
+        if (q >= end) return CborLookup::Malformed;
+        if (*q == kBreak) return CborLookup::Missing;
+      }
+      bool matched = false;
+      q = match_key(q, end, segment, &matched);
+      if (!q) return CborLookup::Malformed;
+      if (matched) {
+        *p = q;
+        return CborLookup::Found;
+      }
+      q = skip_item(q, end, 1);
+      if (!q) return CborLookup::Malformed;
+    }
+    return CborLookup::Missing;
+  }
+
+  std::uint64_t index = 0;
+  if (h.major == 4 && parse_index(segment, &index)) {
+    for (std::uint64_t i = 0; indefinite || i < h.arg; ++i) {
+      if (indefinite) {
+        if (q >= end) return CborLookup::Malformed;
+        if (*q == kBreak) return CborLookup::Missing;
+      }
+      if (i == index) {
+        *p = q;
+        return CborLookup::Found;
+      }
+      q = skip_item(q, end, 1);
+      if (!q) return CborLookup::Malformed;
+    }
+  }
+  return CborLookup::Missing;
+}
+
+// Head of a found item with tags stripped, or nullopt if it does not parse.
+std::optional<Head> item_head(CborSlice item, const std::uint8_t** body) {
+  const auto* end = item.data + item.size;
+  const auto* p = strip_tags(item.data, end);
+  if (!p) return std::nullopt;
+  Head h;
+  p = read_head(p, end, &h);
+  if (!p) return std::nullopt;
+  if (body) *body = p;
+  return h;
+}
+
+double half_to_double(std::uint16_t half) {
+  const int exp = (half >> 10) & 0x1F;
+  const int mant = half & 0x3FF;
+  double v = 0.0;
+  if (exp == 0) {
+    v = std::ldexp(mant, -24);
+  } else if (exp != 31) {
+    v = std::ldexp(mant + 1024, exp - 25);
+  } else {
+    v = mant == 0 ? INFINITY : NAN;
+  }
+  return (half & 0x8000) ? -v : v;
+}
+
+} // namespace
+
+CborLookup cbor_lookup(const std::uint8_t* data, std::size_t size,
+                       std::span<const std::string_view> path, CborSlice* out) {
+  const std::uint8_t* end = data + size;
+  const std::uint8_t* p = data;
+  for (auto segment : path) {
+    auto r = step(&p, end, segment);
+    if (r != CborLookup::Found) return r;
+  }
+  const std::uint8_t* item_end = skip_item(p, end, 0);
+  if (!item_end) return CborLookup::Malformed;
+  if (out) *out = CborSlice{p, static_cast<std::size_t>(item_end - p)};
+  return CborLookup::Found;
+}
+
+std::optional<CborSlice> cbor_find(const Bytes& cbor, std::initializer_list<std::string_view> path) {
+  CborSlice out;
+  if (cbor_lookup(cbor.data(), cbor.size(), std::span<const std::string_view>(path.begin(), path.size()),
+                  &out) != CborLookup::Found) {
+    return std::nullopt;
+  }
+  return out;
+}
+
+std::optional<std::string_view> cbor_text(CborSlice item) {
+  const std::uint8_t* body = nullptr;
+  auto h = item_head(item, &body);
+  if (!h || h->major != 3 || h->info == kIndefinite) return std::nullopt;
+  return std::string_view(reinterpret_cast<const char*>(body), static_cast<std::size_t>(h->arg));
+}
+
+std::optional<std::uint64_t> cbor_uint(CborSlice item) {
+  auto h = item_head(item, nullptr);
+  if (!h || h->major != 0) return std::nullopt;
+  return h->arg;
+}
+
+std::optional<std::int64_t> cbor_int(CborSlice item) {
+  auto h = item_head(item, nullptr);
+  if (!h || h->arg > static_cast<std::uint64_t>(INT64_MAX)) return std::nullopt;
+  if (h->major == 0) return static_cast<std::int64_t>(h->arg);
+  if (h->major == 1) return -1 - static_cast<std::int64_t>(h->arg);
+  return std::nullopt;
+}
+
+std::optional<bool> cbor_bool(CborSlice item) {
+  auto h = item_head(item, nullptr);
+  if (!h || h->major != 7) return std::nullopt;
+  if (h->info == 20) return false;
+  if (h->info == 21) return true;
+  return std::nullopt;
+}
+
+std::optional<double> cbor_double(CborSlice item) {
+  auto h = item_head(item, nullptr);
+  if (!h) return std::nullopt;
+  if (h->major == 0) return static_cast<double>(h->arg);
+  if (h->major == 1) return -1.0 - static_cast<double>(h->arg);
+  if (h->major != 7) return std::nullopt;
+  switch (h->info) {
+    case 25: return half_to_double(static_cast<std::uint16_t>(h->arg));
+    case 26: return static_cast<double>(std::bit_cast<float>(static_cast<std::uint32_t>(h->arg)));
+    case 27: return std::bit_cast<double>(h->arg);
+    default: return std::nullopt;
+  }
+}
+
+std::optional<CborContainer> CborContainer::open(CborSlice item) {
+  const std::uint8_t* body = nullptr;
+  auto h = item_head(item, &body);
+  if (!h || (h->major != 4 && h->major != 5)) return std::nullopt;
+  CborContainer c;
+  c.p_ = body;
+  c.end_ = item.data + item.size;
+  c.map_ = h->major == 5;
+  c.indefinite_ = h->info == kIndefinite;
+  c.remaining_ = c.map_ ? h->arg * 2 : h->arg;
+  if (c.map_ && h->arg > UINT64_MAX / 2) c.malformed_ = true;
+  return c;
+}
+
+bool CborContainer::next(CborSlice* out) {
+  if (malformed_) return false;
+  if (indefinite_) {
+    if (p_ >= end_) {
+      malformed_ = true;
+      return false;
+    }
+    if (*p_ == kBreak) return false;
+  } else if (remaining_ == 0) {
+    return false;
+  } else {
+    --remaining_;
+  }
+  const auto* item_end = skip_item(p_, end_, 1);
+  if (!item_end) {
+    malformed_ = true;
+    return false;
+  }
+  *out = CborSlice{p_, static_cast<std::size_t>(item_end - p_)};
+  p_ = item_end;
+  return true;
+}
+
+std::optional<std::string_view> cbor_find_text(const Bytes& cbor,
+                                               std::initializer_list<std::string_view> path) {
+  auto item = cbor_find(cbor, path);
+  if (!item) return std::nullopt;
+  return cbor_text(*item);
+}
+
+} // namespace referee
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace referee {
+
+// -----------------------------
+// CBOR path projection
+// -----------------------------
+// Streams over an encoded payload to a single item, skipping unrelated map entries
+// without building a DOM. Path segments are map keys (text); a segment made of
+// digits indexes into an array.
+
+// One encoded CBOR item inside a payload; valid as long as the payload is.
+struct CborSlice {
+  const std::uint8_t* data{nullptr};
+  std::size_t size{0};
+};
+
+enum class CborLookup {
+  Found,
+  Missing,    // a key or index on the path is absent, or a segment is not a container
+  Malformed   // the bytes walked before the answer was found are not valid CBOR
+};
+
+CborLookup cbor_lookup(const std::uint8_t* data, std::size_t size,
+                       std::span<const std::string_view> path, CborSlice* out);
+
+std::optional<CborSlice> cbor_find(const Bytes& cbor, std::initializer_list<std::string_view> path);
+
+// Scalar views of a found item; nullopt if the item has a different type.
+std::optional<std::string_view> cbor_text(CborSlice item);   // definite-length text only
+std::optional<std::uint64_t> cbor_uint(CborSlice item);      // unsigned integers only
+std::optional<std::int64_t> cbor_int(CborSlice item);
+std::optional<bool> cbor_bool(CborSlice item);
+std::optional<double> cbor_double(CborSlice item);           // half, single, double or integer
+
+// Sequential walk over the items of one map or array, without decoding them. A map
+// yields its keys and values alternately.
+class CborContainer {
+public:
+  // nullopt if `item` is not a map or array.
+  static std::optional<CborContainer> open(CborSlice item);
+
+  bool is_map() const { return map_; }
+  // The next item, or false at the end or on malformed input; see malformed().
+  bool next(CborSlice* out);
+  bool malformed() const { return malformed_; }
+
+private:
+  CborContainer() = default;
+
+  const std::uint8_t* p_{nullptr};
+  const std::uint8_t* end_{nullptr};
+  std::uint64_t remaining_{0};
+  bool indefinite_{false};
+  bool map_{false};
+  bool malformed_{false};
+};
+
+// Convenience: the text at `path`, or nullopt if absent, malformed or not text.
+std::optional<std::string_view> cbor_find_text(const Bytes& cbor,
+                                               std::initializer_list<std::string_view> path);
+
+} // namespace referee
@@ -0,0 +1,85 @@
+#include "referee/cbor_writer.h"
+
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace referee {
+
+void CborWriter::head(std::uint8_t major, std::uint64_t arg) {
+  const auto initial = static_cast<std::uint8_t>(major << 5);
+  int width = 0;
+  if (arg < 24) {
+    out_.push_back(static_cast<std::uint8_t>(initial | arg));
+    return;
+  }
+  if (arg <= 0xFF) {
+    out_.push_back(initial | 24);
+    width = 1;
+  } else if (arg <= 0xFFFF) {
+    out_.push_back(initial | 25);
+    width = 2;
+  } else if (arg <= 0xFFFFFFFFULL) {
+    out_.push_back(initial | 26);
+    width = 4;
+  } else {
+    out_.push_back(initial | 27);
+    width = 8;
+  }
+  for (int i = width - 1; i >= 0; --i) out_.push_back(static_cast<std::uint8_t>(arg >> (8 * i)));
+}
+
+void CborWriter::map(std::size_t entries) { head(5, entries); }
+void CborWriter::array(std::size_t items) { head(4, items); }
+
+void CborWriter::text(std::string_view v) {
+  head(3, v.size());
+  out_.insert(out_.end(), v.begin(), v.end());
+}
+
+void CborWriter::bytes(const std::uint8_t* data, std::size_t size) {
+  head(2, size);
+  out_.insert(out_.end(), data, data + size);
+}
+
+void CborWriter::uint(std::uint64_t v) { head(0, v); }
+
+void CborWriter::integer(std::int64_t v) {
+  if (v >= 0) {
+    head(0, static_cast<std::uint64_t>(v));
+  } else {
+    head(1, static_cast<std::uint64_t>(-1 - v));
+  }
+}
+
+void CborWriter::number(double v) {
+  if (std::isnan(v)) {
+    out_.insert(out_.end(), {0xF9, 0x7E, 0x00});
+    return;
+  }
+  if (std::isinf(v)) {
+    out_.insert(out_.end(), {0xF9, static_cast<std::uint8_t>(v > 0 ? 0x7C : 0xFC), 0x00});
+    return;
+  }
+  const auto narrow = static_cast<float>(v);
+  if (v >= static_cast<double>(std::numeric_limits<float>::lowest())
+      && v <= static_cast<double>(std::numeric_limits<float>::max())
+      && std::bit_cast<std::uint64_t>(static_cast<double>(narrow)) == std::bit_cast<std::uint64_t>(v)) {
+    out_.push_back(0xFA);
+    const auto bits = std::bit_cast<std::uint32_t>(narrow);
+    for (int i = 3; i >= 0; --i) out_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+    return;
+  }
+  out_.push_back(0xFB);
+  const auto bits = std::bit_cast<std::uint64_t>(v);
+  for (int i = 7; i >= 0; --i) out_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+}
+
+void CborWriter::boolean(bool v) { out_.push_back(v ? 0xF5 : 0xF4); }
+void CborWriter::null() { out_.push_back(0xF6); }
+
+void CborWriter::raw(const std::uint8_t* data, std::size_t size) {
+  out_.insert(out_.end(), data, data + size);
+}
+
+} // namespace referee
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <string_view>
+
+namespace referee {
+
+// -----------------------------
+// CBOR writer
+// -----------------------------
+// Appends definite-length items with the shortest argument encoding and floats in
+// the narrowest width that keeps the value, as nlohmann::json::to_cbor does, so a
+// payload written here is byte-identical to one built through the DOM.
+class CborWriter {
+public:
+  void map(std::size_t entries);
+  void array(std::size_t items);
+  void text(std::string_view v);
+  void bytes(const std::uint8_t* data, std::size_t size);
+  void uint(std::uint64_t v);
+  void integer(std::int64_t v);
+  void number(double v);
+  void boolean(bool v);
+  void null();
+  // One already-encoded item, copied as-is.
+  void raw(const std::uint8_t* data, std::size_t size);
+
+  const Bytes& buffer() const { return out_; }
+  Bytes take() { return std::move(out_); }
+
+private:
+  void head(std::uint8_t major, std::uint64_t arg);
+
+  Bytes out_;
+};
+
+} // namespace referee
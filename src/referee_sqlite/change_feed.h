@@ -0,0 +1,55 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace referee {
+
+// Position in a store's change history: the lengths of its two segments. Durable, so a
+// subscriber that persists the cursor of the last Commit it handled can catch up with
+// SqliteStore::read_changes() after a restart.
+struct ChangeCursor {
+  std::uint64_t object_bytes{0};
+  std::uint64_t edge_bytes{0};
+
+  friend bool operator==(const ChangeCursor& a, const ChangeCursor& b) noexcept {
+    return a.object_bytes == b.object_bytes && a.edge_bytes == b.edge_bytes;
+  }
+};
+
+enum class ChangeKind : std::uint8_t {
+  ObjectCreated,
+  EdgeAdded,
+  // Everything before `cursor` has been delivered: after each transaction, each write
+  // outside one, each refresh() or apply_replicated() batch, and each read_changes().
+  Commit
+};
+
+struct ChangeEvent {
+  ChangeKind kind{ChangeKind::Commit};
+  const ObjectRecord* object{nullptr}; // ObjectCreated
+  const EdgeRecord* edge{nullptr};     // EdgeAdded
+  ChangeCursor cursor{};               // Commit
+};
+
+struct ChangeFilter {
+  bool objects{true};
+  bool edges{true};
+  bool commits{true};
+  std::optional<TypeID> type;           // objects of this type only
+  std::optional<std::string> edge_name; // edges with this name only
+
+  bool accepts(const ChangeEvent& event) const;
+};
+
+// Called synchronously on the writing thread once records are committed and indexed;
+// it may read the store but must not write to it. Pointers in the event are only valid
+// for the call.
+using ChangeListener = std::function<void(const ChangeEvent&)>;
+using SubscriptionID = std::uint64_t;
+
+} // namespace referee
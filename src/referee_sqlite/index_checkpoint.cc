@@ -0,0 +1,235 @@
+#include "referee_sqlite/index_checkpoint.h"
+
+#include "referee_sqlite/segment_loader.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace referee::index_checkpoint {
+namespace {
+
+constexpr std::uint32_t kCheckpointTag = 0x314b4349; // "ICK1"
+constexpr std::uint32_t kCheckpointVersion = 3;
+constexpr std::uint64_t kFnvBasis = 1469598103934665603ULL;
+constexpr std::size_t kHeaderBytes = 4 + 4 + 8 * (2 + kIndexFileCount + 2 + 2) + 8;
+constexpr std::uint64_t kObjectKeyBytes = 8 + segment_format::kObjHeaderBytes;
+constexpr std::uint64_t kEdgeKeyBytes = 8 + segment_format::kEdgeHeaderBytes;
+
+std::uint64_t fnv1a(const std::uint8_t* data, std::size_t size, std::uint64_t h = kFnvBasis) {
+  for (std::size_t i = 0; i < size; ++i) {
+    h ^= data[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+void put_u32(Bytes* out, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+
+void put_u64(Bytes* out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out->push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+
+std::uint64_t load_u64(const std::uint8_t* p) {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+  return v;
+}
+
+std::uint32_t load_u32(const std::uint8_t* p) {
+  return (std::uint32_t)p[0]
+       | (std::uint32_t(p[1]) << 8)
+       | (std::uint32_t(p[2]) << 16)
+       | (std::uint32_t(p[3]) << 24);
+}
+
+// The fixed-size part of a checkpoint; the keys live in the .keys files.
+struct Header {
+  CheckpointMark mark;
+  std::uint64_t object_count{0};
+  std::uint64_t edge_count{0};
+  std::uint64_t object_hash{kFnvBasis};
+  std::uint64_t edge_hash{kFnvBasis};
+};
+
+std::filesystem::path keys_path(const std::filesystem::path& store_dir, bool objects) {
+  return store_dir / "checkpoints" / (objects ? "objects.keys" : "edges.keys");
+}
+
+Bytes encode(const Header& header) {
+  Bytes out;
+  out.reserve(kHeaderBytes);
+  put_u32(&out, kCheckpointTag);
+  put_u32(&out, kCheckpointVersion);
+  put_u64(&out, header.mark.object_bytes);
+  put_u64(&out, header.mark.edge_bytes);
+  for (auto bytes : header.mark.index_bytes) put_u64(&out, bytes);
+  put_u64(&out, header.object_count);
+  put_u64(&out, header.edge_count);
+  put_u64(&out, header.object_hash);
+  put_u64(&out, header.edge_hash);
+  put_u64(&out, fnv1a(out.data(), out.size()));
+  return out;
+}
+
+std::optional<Header> read_header(const std::filesystem::path& store_dir) {
+  std::ifstream in(checkpoint_path(store_dir), std::ios::binary);
+  if (!in) return std::nullopt;
+  Bytes data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (data.size() != kHeaderBytes) return std::nullopt;
+  const auto body = data.size() - 8;
+  if (fnv1a(data.data(), body) != load_u64(data.data() + body)) return std::nullopt;
+  const auto* p = data.data();
+  if (load_u32(p) != kCheckpointTag || load_u32(p + 4) != kCheckpointVersion) return std::nullopt;
+  p += 8;
+
+  Header out;
+  out.mark.object_bytes = load_u64(p); p += 8;
+  out.mark.edge_bytes = load_u64(p); p += 8;
+  for (auto& bytes : out.mark.index_bytes) {
+    bytes = load_u64(p);
+    p += 8;
+  }
+  out.object_count = load_u64(p); p += 8;
+  out.edge_count = load_u64(p); p += 8;
+  out.object_hash = load_u64(p); p += 8;
+  out.edge_hash = load_u64(p);
+  return out;
+}
+
+// The first `count` key records of a keys file, if they hash to `hash`.
+template <typename Key, typename Decode>
+std::optional<std::vector<KeyAt<Key>>> read_keys(const std::filesystem::path& path, std::uint64_t count,
+                                                 std::uint64_t record_bytes, std::uint64_t hash,
+                                                 Decode decode) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in && count != 0) return std::nullopt;
+  Bytes data(count * record_bytes);
+  if (count != 0 && !in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+    return std::nullopt;
+  }
+  if (fnv1a(data.data(), data.size()) != hash) return std::nullopt;
+  std::vector<KeyAt<Key>> out(count);
+  for (std::uint64_t i = 0; i < count; ++i) {
+    const auto* record = data.data() + i * record_bytes;
+    out[i].offset = load_u64(record);
+    decode(record + 8, &out[i].key);
+  }
+  return out;
+}
+
+// Cuts the keys file back to `count` records and appends one for each frame in
+// [start, end) of the segment, extending `*count` and `*hash`. Only frame headers
+// are read.
+Result<void> extend_keys(const segment_loader::MappedFile& map, const std::filesystem::path& path,
+                         std::uint64_t start, std::uint64_t end, bool objects, std::uint64_t* count,
+                         std::uint64_t* hash) {
+  if (end > map.size()) return Result<void>::err("checkpoint mark past end of segment");
+  const auto header_bytes = objects ? segment_format::kObjHeaderBytes : segment_format::kEdgeHeaderBytes;
+  const auto record_bytes = 8 + header_bytes;
+
+  Bytes bytes;
+  std::uint64_t added = 0;
+  for (std::uint64_t pos = start; pos < end; ++added) {
+    std::uint64_t frame = 0;
+    const auto status = objects ? segment_format::object_frame_size(map.data() + pos, end - pos, &frame)
+                                : segment_format::edge_frame_size(map.data() + pos, end - pos, &frame);
+    if (status != segment_format::FrameStatus::Ok) {
+      return Result<void>::err(objects ? "objects.seg prefix does not end on a frame"
+                                       : "edges.seg prefix does not end on a frame");
+    }
+    put_u64(&bytes, pos);
+    bytes.insert(bytes.end(), map.data() + pos, map.data() + pos + header_bytes);
+    pos += frame;
+  }
+
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) std::ofstream(path, std::ios::binary).close();
+  std::filesystem::resize_file(path, *count * record_bytes, ec);
+  if (ec) return Result<void>::err("failed to trim " + path.filename().string());
+  std::ofstream out(path, std::ios::binary | std::ios::app);
+  out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  out.flush();
+  if (!out) return Result<void>::err("failed to append to " + path.filename().string());
+  *count += added;
+  *hash = fnv1a(bytes.data(), bytes.size(), *hash);
+  return Result<void>::ok();
+}
+
+} // namespace
+
+std::filesystem::path checkpoint_path(const std::filesystem::path& store_dir) {
+  return store_dir / "checkpoints" / "index.ckpt";
+}
+
+std::optional<IndexCheckpoint> read(const std::filesystem::path& store_dir) {
+  auto header = read_header(store_dir);
+  if (!header) return std::nullopt;
+  auto objects = read_keys<segment_format::ObjectKey>(keys_path(store_dir, true), header->object_count,
+                                                      kObjectKeyBytes, header->object_hash,
+                                                      &segment_format::decode_object_key);
+  if (!objects) return std::nullopt;
+  auto edges = read_keys<segment_format::EdgeKey>(keys_path(store_dir, false), header->edge_count,
+                                                  kEdgeKeyBytes, header->edge_hash,
+                                                  &segment_format::decode_edge_key);
+  if (!edges) return std::nullopt;
+  return IndexCheckpoint{ header->mark, std::move(*objects), std::move(*edges) };
+}
+
+Result<void> write(const std::filesystem::path& store_dir, const CheckpointMark& mark) {
+  const auto segments_dir = store_dir / "segments";
+  auto objMapR = segment_loader::MappedFile::open(segments_dir / "objects.seg");
+  if (!objMapR) return Result<void>::err(objMapR.error->message);
+  auto edgeMapR = segment_loader::MappedFile::open(segments_dir / "edges.seg");
+  if (!edgeMapR) return Result<void>::err(edgeMapR.error->message);
+
+  std::error_code ec;
+  const auto path = checkpoint_path(store_dir);
+  std::filesystem::create_directories(path.parent_path(), ec);
+  if (ec) return Result<void>::err("failed to create checkpoints directory");
+
+  // Resume after the previous checkpoint when it still describes a prefix of `mark`;
+  // the header is trusted here because open() verified the keys it counts.
+  Header header;
+  header.mark = mark;
+  std::uint64_t object_start = 0;
+  std::uint64_t edge_start = 0;
+  const auto holds = [&](bool objects, std::uint64_t count) {
+    std::error_code size_ec;
+    const auto size = std::filesystem::file_size(keys_path(store_dir, objects), size_ec);
+    return !size_ec && size >= count * (objects ? kObjectKeyBytes : kEdgeKeyBytes);
+  };
+  if (auto previous = read_header(store_dir);
+      previous && previous->mark.object_bytes <= mark.object_bytes && previous->mark.edge_bytes <= mark.edge_bytes &&
+      holds(true, previous->object_count) && holds(false, previous->edge_count)) {
+    object_start = previous->mark.object_bytes;
+    edge_start = previous->mark.edge_bytes;
+    header.object_count = previous->object_count;
+    header.edge_count = previous->edge_count;
+    header.object_hash = previous->object_hash;
+    header.edge_hash = previous->edge_hash;
+  }
+
+  auto r = extend_keys(objMapR.value.value(), keys_path(store_dir, true), object_start, mark.object_bytes, true,
+                       &header.object_count, &header.object_hash);
+  if (!r) return r;
+  r = extend_keys(edgeMapR.value.value(), keys_path(store_dir, false), edge_start, mark.edge_bytes, false,
+                  &header.edge_count, &header.edge_hash);
+  if (!r) return r;
+
+  const auto bytes = encode(header);
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    out.flush();
+    if (!out) return Result<void>::err("failed to write index checkpoint");
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) return Result<void>::err("failed to publish index checkpoint");
+  return Result<void>::ok();
+}
+
+} // namespace referee::index_checkpoint
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "referee/referee.h"
+#include "referee_sqlite/segment_format.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// Key checkpoints let open() rebuild the in-memory indexes for the segment prefix
+// they cover without reading a single covered frame: each covered record is stored
+// as its segment offset plus a copy of its fixed frame header, which holds every
+// field the indexes key on. Payloads stay in the segment and are read on lookup.
+// Only the tail past the mark is scanned frame by frame and re-indexed on disk.
+//
+// checkpoints/index.ckpt (rewritten on each checkpoint; fixed size):
+//   u32 tag "ICK1" | u32 version | u64 objects.seg bytes | u64 edges.seg bytes
+//   | u64 idx bytes x4 | u64 object count | u64 edge count
+//   | u64 FNV-1a of the object keys | u64 FNV-1a of the edge keys
+//   | u64 FNV-1a of all prior bytes
+// checkpoints/objects.keys, checkpoints/edges.keys (append-only):
+//   u64 frame offset | frame header, in segment order; entries past the header's
+//   count are ignored.
+namespace referee::index_checkpoint {
+
+constexpr std::size_t kIndexFileCount = 4;
+constexpr std::array<const char*, kIndexFileCount> kIndexFiles = {
+    "objects_by_id.idx", "objects_by_type.idx", "edges_from.idx", "edges_to.idx"};
+
+// Segment and index file lengths covered by a checkpoint. Everything before these
+// offsets is immutable, so it can be read while the writer keeps appending.
+struct CheckpointMark {
+  std::uint64_t object_bytes{0};
+  std::uint64_t edge_bytes{0};
+  std::array<std::uint64_t, kIndexFileCount> index_bytes{};
+
+  std::uint64_t segment_bytes() const { return object_bytes + edge_bytes; }
+};
+
+template <typename Key>
+struct KeyAt {
+  std::uint64_t offset{0};
+  Key key{};
+};
+
+struct IndexCheckpoint {
+  CheckpointMark mark;
+  std::vector<KeyAt<segment_format::ObjectKey>> objects;  // segment order
+  std::vector<KeyAt<segment_format::EdgeKey>> edges;      // segment order
+};
+
+std::filesystem::path checkpoint_path(const std::filesystem::path& store_dir);
+
+// Latest checkpoint, or nullopt if there is none or it fails validation.
+std::optional<IndexCheckpoint> read(const std::filesystem::path& store_dir);
+
+// Append the keys of the frames between the previous checkpoint and `mark`, then atomically
+// replace the header. Only the region past the previous checkpoint is walked or
+// written, so the cost follows the growth since then, not the store size.
+Result<void> write(const std::filesystem::path& store_dir, const CheckpointMark& mark);
+
+} // namespace referee::index_checkpoint
@@ -0,0 +1,138 @@
+#include "referee_sqlite/replication.h"
+
+#include "referee_sqlite/segment_format.h"
+#include "referee_sqlite/segment_loader.h"
+
+#include <algorithm>
+
+namespace referee {
+namespace {
+
+void write_lines(std::ofstream& out, const std::string& lines) {
+  if (!out.is_open() || lines.empty()) return;
+  out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+}
+
+template <typename Chunk>
+std::uint64_t newest_created(const segment_loader::SegmentLoad<Chunk>& load) {
+  std::uint64_t newest = 0;
+  for (const auto& chunk : load.chunks) {
+    for (const auto& rec : chunk.records) newest = std::max(newest, rec.created_at_unix_ms);
+  }
+  return newest;
+}
+
+} // namespace
+
+Result<AppliedFrames> SqliteStore::apply_replicated(const std::uint8_t* objects,
+                                                    std::uint64_t object_bytes,
+                                                    const std::uint8_t* edges,
+                                                    std::uint64_t edge_bytes) {
+  if (!open_) return Result<AppliedFrames>::err("store not open");
+  if (!cfg_.replica || memory_only_ || read_only()) {
+    return Result<AppliedFrames>::err("store is not a writable replica");
+  }
+  if (in_txn_) return Result<AppliedFrames>::err("cannot apply replicated frames inside a transaction");
+
+  auto objR = segment_loader::load_objects(objects, object_bytes, object_seg_bytes_, 1);
+  if (!objR) return Result<AppliedFrames>::err(objR.error->message);
+  auto edgeR = segment_loader::load_edges(edges, edge_bytes, edge_seg_bytes_, 1);
+  if (!edgeR) return Result<AppliedFrames>::err(edgeR.error->message);
+  const auto& obj_load = objR.value.value();
+  const auto& edge_load = edgeR.value.value();
+
+  // Objects first, so an edge never lands before the objects it was written after.
+  if (obj_load.valid_bytes > 0) {
+    object_seg_.write(reinterpret_cast<const char*>(objects),
+                      static_cast<std::streamsize>(obj_load.valid_bytes));
+    object_seg_.flush();
+    if (!object_seg_) return Result<AppliedFrames>::err("failed to append to objects.seg");
+    object_seg_bytes_ += obj_load.valid_bytes;
+    for (const auto& chunk : obj_load.chunks) {
+      index_objects(chunk);
+      write_lines(idx_objects_by_id_, chunk.by_id_lines);
+      write_lines(idx_objects_by_type_, chunk.by_type_lines);
+    }
+  }
+  if (edge_load.valid_bytes > 0) {
+    edge_seg_.write(reinterpret_cast<const char*>(edges),
+                    static_cast<std::streamsize>(edge_load.valid_bytes));
+    edge_seg_.flush();
+    if (!edge_seg_) return Result<AppliedFrames>::err("failed to append to edges.seg");
+    edge_seg_bytes_ += edge_load.valid_bytes;
+    for (const auto& chunk : edge_load.chunks) {
+      index_edges(chunk);
+      write_lines(idx_edges_from_, chunk.from_lines);
+      write_lines(idx_edges_to_, chunk.to_lines);
+    }
+  }
+
+  if (!subscribers_.empty() && obj_load.records + edge_load.records > 0) {
+    for (const auto& chunk : obj_load.chunks) {
+      for (const auto& rec : chunk.records) notify(ChangeEvent{ChangeKind::ObjectCreated, &rec, nullptr, {}});
+    }
+    for (const auto& chunk : edge_load.chunks) {
+      for (const auto& rec : chunk.records) notify(ChangeEvent{ChangeKind::EdgeAdded, nullptr, &rec, {}});
+    }
+    notify_commit();
+  }
+
+  maybe_checkpoint();
+  AppliedFrames out;
+  out.records = obj_load.records + edge_load.records;
+  out.newest_created_unix_ms = std::max(newest_created(obj_load), newest_created(edge_load));
+  return Result<AppliedFrames>::ok(out);
+}
+
+SegmentFollower::SegmentFollower(SqliteStore& replica, std::string leader_filename)
+    : replica_(replica),
+      leader_segments_(std::filesystem::path(SqliteStore::store_dir_from_filename(leader_filename))
+                       / "segments") {}
+
+Result<ReplicationStatus> SegmentFollower::poll(std::uint64_t max_bytes) {
+  auto objMapR = segment_loader::MappedFile::open(leader_segments_ / "objects.seg");
+  if (!objMapR) return Result<ReplicationStatus>::err(objMapR.error->message);
+  auto edgeMapR = segment_loader::MappedFile::open(leader_segments_ / "edges.seg");
+  if (!edgeMapR) return Result<ReplicationStatus>::err(edgeMapR.error->message);
+  const auto& obj_map = objMapR.value.value();
+  const auto& edge_map = edgeMapR.value.value();
+
+  const auto obj_from = replica_.object_segment_bytes();
+  const auto edge_from = replica_.edge_segment_bytes();
+  if (obj_map.size() < obj_from || edge_map.size() < edge_from) {
+    return Result<ReplicationStatus>::err("leader segments are shorter than the replica; resync required");
+  }
+  // A frame larger than `max_bytes` is still taken whole, or the follower could
+  // never get past it.
+  auto span = [max_bytes](const segment_loader::MappedFile& map, std::uint64_t from, auto frame_size) {
+    const auto avail = map.size() - from;
+    if (max_bytes == 0 || avail <= max_bytes) return avail;
+    std::uint64_t first = 0;
+    if (frame_size(map.data() + from, avail, &first) == segment_format::FrameStatus::Ok) {
+      return std::max(first, max_bytes);
+    }
+    return max_bytes;
+  };
+
+  auto appliedR = replica_.apply_replicated(
+      obj_map.data() + obj_from, span(obj_map, obj_from, segment_format::object_frame_size),
+      edge_map.data() + edge_from, span(edge_map, edge_from, segment_format::edge_frame_size));
+  if (!appliedR) return Result<ReplicationStatus>::err(appliedR.error->message);
+  const auto& applied = appliedR.value.value();
+
+  const auto now = unix_ms_now();
+  status_.leader_bytes = obj_map.size() + edge_map.size();
+  status_.applied_bytes = replica_.object_segment_bytes() + replica_.edge_segment_bytes();
+  status_.lag_bytes = status_.leader_bytes - status_.applied_bytes;
+  status_.applied_records = applied.records;
+  status_.total_applied += status_.applied_records;
+  status_.last_poll_unix_ms = now;
+  if (applied.newest_created_unix_ms > 0) {
+    status_.last_record_unix_ms = applied.newest_created_unix_ms;
+    status_.apply_delay_ms = now > applied.newest_created_unix_ms
+                                 ? now - applied.newest_created_unix_ms : 0;
+  }
+  return Result<ReplicationStatus>::ok(status_);
+}
+
+} // namespace referee
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace referee {
+
+struct ReplicationStatus {
+  std::uint64_t leader_bytes{0};        // leader objects.seg + edges.seg at the last poll
+  std::uint64_t applied_bytes{0};       // replica objects.seg + edges.seg
+  std::uint64_t lag_bytes{0};           // leader bytes not yet applied (incl. partial frames)
+  std::uint64_t applied_records{0};     // records applied by the last poll
+  std::uint64_t total_applied{0};       // records applied by this follower since construction
+  std::uint64_t last_record_unix_ms{0}; // created_at of the newest applied record
+  std::uint64_t apply_delay_ms{0};      // leader write to replica apply, for that record
+  std::uint64_t last_poll_unix_ms{0};
+};
+
+// Log-shipping follower over a shared directory: tails the leader's segment files
+// and applies each complete frame, byte for byte, to a replica SqliteStore. Because
+// replica segments are exact prefixes of the leader's, the replica's own segment
+// lengths are the replication position and a restarted follower resumes from them.
+class SegmentFollower {
+public:
+  // `replica` must be open with SqliteConfig::replica set.
+  SegmentFollower(SqliteStore& replica, std::string leader_filename);
+
+  // Apply whatever the leader has appended since the last poll, up to `max_bytes`
+  // per segment (0 = no limit). The first pending frame of a segment is applied
+  // even when it alone exceeds `max_bytes`.
+  Result<ReplicationStatus> poll(std::uint64_t max_bytes = 0);
+
+  const ReplicationStatus& status() const { return status_; }
+
+private:
+  SqliteStore& replica_;
+  std::filesystem::path leader_segments_;
+  ReplicationStatus status_{};
+};
+
+} // namespace referee
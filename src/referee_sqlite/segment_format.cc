@@ -0,0 +1,187 @@
+#include "referee_sqlite/segment_format.h"
+
+#include <cstring>
+
+namespace referee::segment_format {
+namespace {
+
+std::uint32_t load_u32(const std::uint8_t* p) {
+  return (std::uint32_t)p[0]
+       | (std::uint32_t(p[1]) << 8)
+       | (std::uint32_t(p[2]) << 16)
+       | (std::uint32_t(p[3]) << 24);
+}
+
+std::uint64_t load_u64(const std::uint8_t* p) {
+  return (std::uint64_t)load_u32(p) | (std::uint64_t(load_u32(p + 4)) << 32);
+}
+
+void put_u32(Bytes* out, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+
+void put_u64(Bytes* out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out->push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+
+void put_bytes(Bytes* out, const void* data, std::size_t n) {
+  const auto* p = static_cast<const std::uint8_t*>(data);
+  out->insert(out->end(), p, p + n);
+}
+
+void append_hex(std::string* out, const ObjectID& id) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  for (auto b : id.bytes) {
+    out->push_back(kHex[b >> 4]);
+    out->push_back(kHex[b & 0x0F]);
+  }
+}
+
+void append_ref(std::string* out, const ObjectRef& ref) {
+  append_hex(out, ref.id);
+  out->push_back(':');
+  out->append(std::to_string(ref.ver.v));
+}
+
+void finish_line(std::string* out, std::uint64_t offset) {
+  out->push_back('\t');
+  out->append(std::to_string(offset));
+  out->push_back('\n');
+}
+
+} // namespace
+
+FrameStatus object_frame_size(const std::uint8_t* data, std::uint64_t avail, std::uint64_t* size) {
+  if (avail < 4) return FrameStatus::Truncated;
+  if (load_u32(data) != kObjTag) return FrameStatus::BadTag;
+  if (avail < kObjHeaderBytes) return FrameStatus::Truncated;
+  const std::uint64_t total = kObjHeaderBytes + load_u32(data + 4);
+  if (avail < total) return FrameStatus::Truncated;
+  *size = total;
+  return FrameStatus::Ok;
+}
+
+FrameStatus edge_frame_size(const std::uint8_t* data, std::uint64_t avail, std::uint64_t* size) {
+  if (avail < 4) return FrameStatus::Truncated;
+  if (load_u32(data) != kEdgeTag) return FrameStatus::BadTag;
+  if (avail < kEdgeHeaderBytes) return FrameStatus::Truncated;
+  const std::uint64_t total = kEdgeHeaderBytes
+      + std::uint64_t(load_u32(data + 4)) + load_u32(data + 8) + load_u32(data + 12);
+  if (avail < total) return FrameStatus::Truncated;
+  *size = total;
+  return FrameStatus::Ok;
+}
+
+void decode_object_frame(const std::uint8_t* data, ObjectRecord* out) {
+  const std::uint32_t payload_size = load_u32(data + 4);
+  out->ref.ver = Version{load_u64(data + 8)};
+  out->type = TypeID{load_u64(data + 16)};
+  out->created_at_unix_ms = load_u64(data + 24);
+  std::memcpy(out->ref.id.bytes.data(), data + 32, 16);
+  std::memcpy(out->definition_id.bytes.data(), data + 48, 16);
+  const auto* payload = data + kObjHeaderBytes;
+  out->payload_cbor.assign(payload, payload + payload_size);
+}
+
+void decode_edge_frame(const std::uint8_t* data, EdgeRecord* out) {
+  const std::uint32_t name_len = load_u32(data + 4);
+  const std::uint32_t role_len = load_u32(data + 8);
+  const std::uint32_t props_len = load_u32(data + 12);
+  out->created_at_unix_ms = load_u64(data + 16);
+  std::memcpy(out->from.id.bytes.data(), data + 24, 16);
+  out->from.ver = Version{load_u64(data + 40)};
+  std::memcpy(out->to.id.bytes.data(), data + 48, 16);
+  out->to.ver = Version{load_u64(data + 64)};
+  const auto* p = reinterpret_cast<const char*>(data + kEdgeHeaderBytes);
+  out->name.assign(p, name_len);
+  out->role.assign(p + name_len, role_len);
+  const auto* props = data + kEdgeHeaderBytes + name_len + role_len;
+  out->props_cbor.assign(props, props + props_len);
+}
+
+void decode_object_key(const std::uint8_t* header, ObjectKey* out) {
+  out->payload_bytes = load_u32(header + 4);
+  out->ref.ver = Version{load_u64(header + 8)};
+  out->type = TypeID{load_u64(header + 16)};
+  out->created_at_unix_ms = load_u64(header + 24);
+  std::memcpy(out->ref.id.bytes.data(), header + 32, 16);
+}
+
+void decode_edge_key(const std::uint8_t* header, EdgeKey* out) {
+  out->body_bytes = std::uint64_t(load_u32(header + 4)) + load_u32(header + 8) + load_u32(header + 12);
+  std::memcpy(out->from.id.bytes.data(), header + 24, 16);
+  out->from.ver = Version{load_u64(header + 40)};
+  std::memcpy(out->to.id.bytes.data(), header + 48, 16);
+  out->to.ver = Version{load_u64(header + 64)};
+}
+
+ObjectKey object_key(const ObjectRecord& rec) {
+  return ObjectKey{rec.ref, rec.type, rec.created_at_unix_ms,
+                   static_cast<std::uint32_t>(rec.payload_cbor.size())};
+}
+
+EdgeKey edge_key(const EdgeRecord& rec) {
+  return EdgeKey{rec.from, rec.to, rec.name.size() + rec.role.size() + rec.props_cbor.size()};
+}
+
+void encode_object_frame(const ObjectRecord& rec, Bytes* out) {
+  out->reserve(out->size() + object_frame_bytes(rec));
+  put_u32(out, kObjTag);
+  put_u32(out, static_cast<std::uint32_t>(rec.payload_cbor.size()));
+  put_u64(out, rec.ref.ver.v);
+  put_u64(out, rec.type.v);
+  put_u64(out, rec.created_at_unix_ms);
+  put_bytes(out, rec.ref.id.bytes.data(), rec.ref.id.bytes.size());
+  put_bytes(out, rec.definition_id.bytes.data(), rec.definition_id.bytes.size());
+  put_bytes(out, rec.payload_cbor.data(), rec.payload_cbor.size());
+}
+
+void encode_edge_frame(const EdgeRecord& rec, Bytes* out) {
+  out->reserve(out->size() + edge_frame_bytes(rec));
+  put_u32(out, kEdgeTag);
+  put_u32(out, static_cast<std::uint32_t>(rec.name.size()));
+  put_u32(out, static_cast<std::uint32_t>(rec.role.size()));
+  put_u32(out, static_cast<std::uint32_t>(rec.props_cbor.size()));
+  put_u64(out, rec.created_at_unix_ms);
+  put_bytes(out, rec.from.id.bytes.data(), rec.from.id.bytes.size());
+  put_u64(out, rec.from.ver.v);
+  put_bytes(out, rec.to.id.bytes.data(), rec.to.id.bytes.size());
+  put_u64(out, rec.to.ver.v);
+  put_bytes(out, rec.name.data(), rec.name.size());
+  put_bytes(out, rec.role.data(), rec.role.size());
+  put_bytes(out, rec.props_cbor.data(), rec.props_cbor.size());
+}
+
+std::uint64_t object_frame_bytes(const ObjectRecord& rec) {
+  return kObjHeaderBytes + rec.payload_cbor.size();
+}
+
+std::uint64_t edge_frame_bytes(const EdgeRecord& rec) {
+  return kEdgeHeaderBytes + rec.name.size() + rec.role.size() + rec.props_cbor.size();
+}
+
+void append_object_index_lines(const ObjectRecord& rec, std::uint64_t offset,
+                               std::string* by_id, std::string* by_type) {
+  append_ref(by_id, rec.ref);
+  finish_line(by_id, offset);
+
+  by_type->append(std::to_string(rec.type.v));
+  by_type->push_back(':');
+  append_ref(by_type, rec.ref);
+  finish_line(by_type, offset);
+}
+
+void append_edge_index_lines(const EdgeRecord& rec, std::uint64_t offset,
+                             std::string* from, std::string* to) {
+  append_ref(from, rec.from);
+  from->append(":" + rec.name + ":" + rec.role + ":");
+  append_ref(from, rec.to);
+  finish_line(from, offset);
+
+  append_ref(to, rec.to);
+  to->append(":" + rec.name + ":" + rec.role + ":");
+  append_ref(to, rec.from);
+  finish_line(to, offset);
+}
+
+} // namespace referee::segment_format
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <string>
+
+// On-disk frame layout shared by the segment writer, loader and tailers.
+//
+// objects.seg frame:
+//   u32 tag "OBJ1" | u32 payload_len | u64 ver | u64 type | u64 created_ms
+//   | 16B id | 16B definition_id | payload
+// edges.seg frame:
+//   u32 tag "EDG1" | u32 name_len | u32 role_len | u32 props_len | u64 created_ms
+//   | 16B from.id | u64 from.ver | 16B to.id | u64 to.ver | name | role | props
+//
+// All integers are little-endian.
+namespace referee::segment_format {
+
+constexpr std::uint32_t kObjTag = 0x314a424f; // "OBJ1"
+constexpr std::uint32_t kEdgeTag = 0x31474445; // "EDG1"
+
+constexpr std::uint64_t kObjHeaderBytes = 4 + 4 + 8 + 8 + 8 + 16 + 16;
+constexpr std::uint64_t kEdgeHeaderBytes = 4 + 4 + 4 + 4 + 8 + 16 + 8 + 16 + 8;
+
+enum class FrameStatus {
+  Ok,
+  Truncated,
+  BadTag
+};
+
+// The fields the in-memory indexes key on. They all live in the fixed-size frame
+// header, so they can be read (or checkpointed) without touching the frame body.
+struct ObjectKey {
+  ObjectRef ref{};
+  TypeID type{};
+  std::uint64_t created_at_unix_ms{0};
+  std::uint32_t payload_bytes{0};
+
+  std::uint64_t frame_bytes() const { return kObjHeaderBytes + payload_bytes; }
+  friend bool operator==(const ObjectKey&, const ObjectKey&) = default;
+};
+
+struct EdgeKey {
+  ObjectRef from{};
+  ObjectRef to{};
+  std::uint64_t body_bytes{0};  // name + role + props
+
+  std::uint64_t frame_bytes() const { return kEdgeHeaderBytes + body_bytes; }
+  friend bool operator==(const EdgeKey&, const EdgeKey&) = default;
+};
+
+// Validates the tag at `data` and reports the full frame length. Truncated means the
+// header or body extends past `avail` bytes (a partially written tail).
+FrameStatus object_frame_size(const std::uint8_t* data, std::uint64_t avail, std::uint64_t* size);
+FrameStatus edge_frame_size(const std::uint8_t* data, std::uint64_t avail, std::uint64_t* size);
+
+// Decode a complete frame previously sized by *_frame_size.
+void decode_object_frame(const std::uint8_t* data, ObjectRecord* out);
+void decode_edge_frame(const std::uint8_t* data, EdgeRecord* out);
+
+// Read the key fields from a frame header (kObjHeaderBytes / kEdgeHeaderBytes).
+void decode_object_key(const std::uint8_t* header, ObjectKey* out);
+void decode_edge_key(const std::uint8_t* header, EdgeKey* out);
+
+ObjectKey object_key(const ObjectRecord& rec);
+EdgeKey edge_key(const EdgeRecord& rec);
+
+// Append a complete frame to `out`.
+void encode_object_frame(const ObjectRecord& rec, Bytes* out);
+void encode_edge_frame(const EdgeRecord& rec, Bytes* out);
+
+std::uint64_t object_frame_bytes(const ObjectRecord& rec);
+std::uint64_t edge_frame_bytes(const EdgeRecord& rec);
+
+// Text index lines ("key\toffset\n") written to indexes/*.idx.
+void append_object_index_lines(const ObjectRecord& rec, std::uint64_t offset,
+                               std::string* by_id, std::string* by_type);
+void append_edge_index_lines(const EdgeRecord& rec, std::uint64_t offset,
+                             std::string* from, std::string* to);
+
+} // namespace referee::segment_format
@@ -0,0 +1,261 @@
+#include "referee_sqlite/segment_loader.h"
+
+#include "referee_sqlite/segment_format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace referee::segment_loader {
+namespace {
+
+constexpr std::uint64_t kMinChunkBytes = 4ULL << 20;
+constexpr std::uint64_t kRemapBytes = 4ULL << 20;
+
+struct Span {
+  std::uint64_t begin{0};
+  std::uint64_t end{0};
+};
+
+using FrameSizer = segment_format::FrameStatus (*)(const std::uint8_t*, std::uint64_t,
+                                                   std::uint64_t*);
+
+// Walks frame headers once, cutting the segment into at most `workers` spans of
+// roughly equal byte size that each start on a validated frame tag.
+Result<std::vector<Span>> split_frames(const std::uint8_t* data, std::uint64_t size,
+                                       unsigned workers, FrameSizer sizer,
+                                       const char* bad_tag_message,
+                                       std::uint64_t* records, std::uint64_t* valid_bytes) {
+  std::vector<Span> spans;
+  const std::uint64_t target = std::max<std::uint64_t>(1, size / std::max(1u, workers));
+  std::uint64_t pos = 0;
+  std::uint64_t span_start = 0;
+  *records = 0;
+
+  while (pos < size) {
+    std::uint64_t frame = 0;
+    auto status = sizer(data + pos, size - pos, &frame);
+    if (status == segment_format::FrameStatus::BadTag) {
+      return Result<std::vector<Span>>::err(bad_tag_message);
+    }
+    if (status == segment_format::FrameStatus::Truncated) break;
+    pos += frame;
+    ++*records;
+    if (pos - span_start >= target && spans.size() + 1 < workers) {
+      spans.push_back(Span{span_start, pos});
+      span_start = pos;
+    }
+  }
+  if (pos > span_start) spans.push_back(Span{span_start, pos});
+  *valid_bytes = pos;
+  return Result<std::vector<Span>>::ok(std::move(spans));
+}
+
+void parse_objects(const std::uint8_t* data, Span span, std::uint64_t base_offset,
+                   ObjectChunk* out) {
+  std::uint64_t pos = span.begin;
+  while (pos < span.end) {
+    std::uint64_t frame = 0;
+    segment_format::object_frame_size(data + pos, span.end - pos, &frame);
+    ObjectRecord rec;
+    segment_format::decode_object_frame(data + pos, &rec);
+    segment_format::append_object_index_lines(rec, base_offset + pos, &out->by_id_lines,
+                                              &out->by_type_lines);
+    out->records.push_back(std::move(rec));
+    pos += frame;
+  }
+}
+
+void parse_edges(const std::uint8_t* data, Span span, std::uint64_t base_offset, EdgeChunk* out) {
+  std::uint64_t pos = span.begin;
+  while (pos < span.end) {
+    std::uint64_t frame = 0;
+    segment_format::edge_frame_size(data + pos, span.end - pos, &frame);
+    EdgeRecord rec;
+    segment_format::decode_edge_frame(data + pos, &rec);
+    segment_format::append_edge_index_lines(rec, base_offset + pos, &out->from_lines,
+                                            &out->to_lines);
+    out->records.push_back(std::move(rec));
+    pos += frame;
+  }
+}
+
+template <typename Chunk, typename ParseFn>
+void run_chunks(const std::uint8_t* data, const std::vector<Span>& spans, std::uint64_t base_offset,
+                std::vector<Chunk>* chunks, ParseFn parse) {
+  chunks->resize(spans.size());
+  for (std::size_t i = 0; i < spans.size(); ++i) (*chunks)[i].offset = base_offset + spans[i].begin;
+  if (spans.size() == 1) {
+    parse(data, spans[0], base_offset, &(*chunks)[0]);
+    return;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(spans.size());
+  for (std::size_t i = 0; i < spans.size(); ++i) {
+    threads.emplace_back(parse, data, spans[i], base_offset, &(*chunks)[i]);
+  }
+  for (auto& t : threads) t.join();
+}
+
+} // namespace
+
+MappedFile::~MappedFile() { reset(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    reset();
+    data_ = other.data_;
+    size_ = other.size_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+void MappedFile::reset() {
+  if (data_) ::munmap(const_cast<std::uint8_t*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+Result<MappedFile> MappedFile::open(const std::filesystem::path& path, Access access) {
+  MappedFile out;
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT) return Result<MappedFile>::ok(std::move(out));
+    return Result<MappedFile>::err("failed to open " + path.filename().string());
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return Result<MappedFile>::err("failed to stat " + path.filename().string());
+  }
+  if (st.st_size > 0) {
+    void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      return Result<MappedFile>::err("failed to map " + path.filename().string());
+    }
+    ::madvise(p, static_cast<std::size_t>(st.st_size),
+              access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    out.data_ = static_cast<const std::uint8_t*>(p);
+    out.size_ = static_cast<std::uint64_t>(st.st_size);
+  }
+  ::close(fd);
+  return Result<MappedFile>::ok(std::move(out));
+}
+
+SegmentReader::~SegmentReader() { reset(); }
+
+SegmentReader::SegmentReader(SegmentReader&& other) noexcept
+    : path_(std::move(other.path_)), map_(std::move(other.map_)), fd_(other.fd_) {
+  other.fd_ = -1;
+}
+
+SegmentReader& SegmentReader::operator=(SegmentReader&& other) noexcept {
+  if (this != &other) {
+    reset();
+    path_ = std::move(other.path_);
+    map_ = std::move(other.map_);
+    fd_ = other.fd_;
+    other.fd_ = -1;
+  }
+  return *this;
+}
+
+void SegmentReader::reset() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  map_ = MappedFile{};
+}
+
+Result<SegmentReader> SegmentReader::open(const std::filesystem::path& path) {
+  SegmentReader out;
+  out.path_ = path;
+  auto mapR = MappedFile::open(path, MappedFile::Access::Random);
+  if (!mapR) return Result<SegmentReader>::err(mapR.error->message);
+  out.map_ = std::move(mapR.value.value());
+  return Result<SegmentReader>::ok(std::move(out));
+}
+
+Result<const std::uint8_t*> SegmentReader::object_frame(std::uint64_t offset, Bytes* scratch) {
+  return frame(offset, segment_format::kObjHeaderBytes, &segment_format::object_frame_size, scratch);
+}
+
+Result<const std::uint8_t*> SegmentReader::edge_frame(std::uint64_t offset, Bytes* scratch) {
+  return frame(offset, segment_format::kEdgeHeaderBytes, &segment_format::edge_frame_size, scratch);
+}
+
+Result<const std::uint8_t*> SegmentReader::frame(std::uint64_t offset, std::uint64_t header_bytes,
+                                                 FrameSizer sizer, Bytes* scratch) {
+  const auto bad = [&]() {
+    return Result<const std::uint8_t*>::err("no frame at offset " + std::to_string(offset) + " of " +
+                                            path_.filename().string());
+  };
+  if (offset >= map_.size() + kRemapBytes) {
+    auto mapR = MappedFile::open(path_, MappedFile::Access::Random);
+    if (!mapR) return Result<const std::uint8_t*>::err(mapR.error->message);
+    map_ = std::move(mapR.value.value());
+  }
+  if (offset < map_.size()) {
+    std::uint64_t size = 0;
+    const auto status = sizer(map_.data() + offset, map_.size() - offset, &size);
+    if (status == segment_format::FrameStatus::Ok) return Result<const std::uint8_t*>::ok(map_.data() + offset);
+    if (status == segment_format::FrameStatus::BadTag) return bad();
+  }
+
+  // Written after the mapping was taken: read the header, then the rest of the frame.
+  if (fd_ < 0) {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) return Result<const std::uint8_t*>::err("failed to open " + path_.filename().string());
+  }
+  const auto read_at = [&](std::uint64_t from, std::uint64_t count) {
+    scratch->resize(from + count);
+    const auto n = ::pread(fd_, scratch->data() + from, count, static_cast<off_t>(offset + from));
+    return n == static_cast<ssize_t>(count);
+  };
+  if (!read_at(0, header_bytes)) return bad();
+  // The header alone determines the frame size, so claim the whole frame is there.
+  std::uint64_t size = 0;
+  if (sizer(scratch->data(), ~std::uint64_t{0}, &size) != segment_format::FrameStatus::Ok) return bad();
+  if (!read_at(header_bytes, size - header_bytes)) return bad();
+  return Result<const std::uint8_t*>::ok(scratch->data());
+}
+
+unsigned workers_for(std::uint64_t bytes) {
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  const std::uint64_t by_size = std::max<std::uint64_t>(1, bytes / kMinChunkBytes);
+  return static_cast<unsigned>(std::min<std::uint64_t>(cores, by_size));
+}
+
+Result<SegmentLoad<ObjectChunk>> load_objects(const std::uint8_t* data, std::uint64_t size,
+                                              std::uint64_t base_offset, unsigned workers) {
+  SegmentLoad<ObjectChunk> out;
+  auto spansR = split_frames(data, size, workers, &segment_format::object_frame_size,
+                             "invalid object segment tag", &out.records, &out.valid_bytes);
+  if (!spansR) return Result<SegmentLoad<ObjectChunk>>::err(spansR.error->message);
+  run_chunks(data, spansR.value.value(), base_offset, &out.chunks, &parse_objects);
+  return Result<SegmentLoad<ObjectChunk>>::ok(std::move(out));
+}
+
+Result<SegmentLoad<EdgeChunk>> load_edges(const std::uint8_t* data, std::uint64_t size,
+                                          std::uint64_t base_offset, unsigned workers) {
+  SegmentLoad<EdgeChunk> out;
+  auto spansR = split_frames(data, size, workers, &segment_format::edge_frame_size,
+                             "invalid edge segment tag", &out.records, &out.valid_bytes);
+  if (!spansR) return Result<SegmentLoad<EdgeChunk>>::err(spansR.error->message);
+  run_chunks(data, spansR.value.value(), base_offset, &out.chunks, &parse_edges);
+  return Result<SegmentLoad<EdgeChunk>>::ok(std::move(out));
+}
+
+} // namespace referee::segment_loader
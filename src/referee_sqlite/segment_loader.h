@@ -0,0 +1,106 @@
+#pragma once
+
+#include "referee/referee.h"
+#include "referee_sqlite/segment_format.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace referee::segment_loader {
+
+// Read-only mapping of a segment file. A missing or empty file maps to size() == 0.
+// Sequential mappings are read front to back (open, tailing); random ones serve
+// lookups of single frames.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  enum class Access { Sequential, Random };
+
+  static Result<MappedFile> open(const std::filesystem::path& path, Access access = Access::Sequential);
+
+  const std::uint8_t* data() const { return data_; }
+  std::uint64_t size() const { return size_; }
+
+private:
+  void reset();
+
+  const std::uint8_t* data_{nullptr};
+  std::uint64_t size_{0};
+};
+
+// Random access to the frames of a segment that keeps growing while it is read.
+// Frames inside the mapping are read in place; newer ones are read with pread until
+// the file has grown far enough past the mapping to be worth remapping.
+class SegmentReader {
+public:
+  SegmentReader() = default;
+  ~SegmentReader();
+
+  SegmentReader(SegmentReader&& other) noexcept;
+  SegmentReader& operator=(SegmentReader&& other) noexcept;
+  SegmentReader(const SegmentReader&) = delete;
+  SegmentReader& operator=(const SegmentReader&) = delete;
+
+  static Result<SegmentReader> open(const std::filesystem::path& path);
+
+  // The complete frame at `offset`. A frame read past the mapping is copied into
+  // `*scratch`, which then backs the returned pointer.
+  Result<const std::uint8_t*> object_frame(std::uint64_t offset, Bytes* scratch);
+  Result<const std::uint8_t*> edge_frame(std::uint64_t offset, Bytes* scratch);
+
+private:
+  using FrameSizer = segment_format::FrameStatus (*)(const std::uint8_t*, std::uint64_t, std::uint64_t*);
+
+  Result<const std::uint8_t*> frame(std::uint64_t offset, std::uint64_t header_bytes, FrameSizer sizer,
+                                    Bytes* scratch);
+  void reset();
+
+  std::filesystem::path path_;
+  MappedFile map_;
+  int fd_{-1};
+};
+
+struct ObjectChunk {
+  std::uint64_t offset{0};         // segment offset of the first record
+  std::vector<ObjectRecord> records;
+  std::string by_id_lines;
+  std::string by_type_lines;
+};
+
+struct EdgeChunk {
+  std::uint64_t offset{0};         // segment offset of the first record
+  std::vector<EdgeRecord> records;
+  std::string from_lines;
+  std::string to_lines;
+};
+
+template <typename Chunk>
+struct SegmentLoad {
+  std::vector<Chunk> chunks;       // in segment order
+  std::uint64_t records{0};
+  std::uint64_t valid_bytes{0};    // end of the last complete frame, relative to `data`
+};
+
+// Worker count for a segment of `bytes`: one per core, but never chunks smaller
+// than a few MiB where thread start-up would dominate.
+unsigned workers_for(std::uint64_t bytes);
+
+// Parse the frames in [data, data + size). Record boundaries are found by walking the
+// frame tags and length fields; the frames are then split into `workers` contiguous
+// chunks that are decoded (and their index lines formatted) in parallel.
+// `base_offset` is the segment offset of `data`, used for index lines and chunk offsets.
+Result<SegmentLoad<ObjectChunk>> load_objects(const std::uint8_t* data, std::uint64_t size,
+                                              std::uint64_t base_offset, unsigned workers);
+Result<SegmentLoad<EdgeChunk>> load_edges(const std::uint8_t* data, std::uint64_t size,
+                                          std::uint64_t base_offset, unsigned workers);
+
+} // namespace referee::segment_loader
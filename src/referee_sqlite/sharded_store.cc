@@ -0,0 +1,491 @@
+#include "referee_sqlite/sharded_store.h"
+
+#include "referee_sqlite/index_checkpoint.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+namespace referee {
+namespace {
+
+// Stable across builds and platforms: the shard of an object is part of the on-disk layout.
+std::uint64_t fnv1a(const ObjectID& id) {
+  std::uint64_t h = 1469598103934665603ULL;
+  for (auto b : id.bytes) {
+    h ^= b;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+struct SegmentLengths {
+  std::uint64_t object_bytes{0};
+  std::uint64_t edge_bytes{0};
+};
+
+std::filesystem::path intent_path(const std::string& filename) { return filename + ".txn"; }
+std::filesystem::path manifest_path(const std::string& filename) { return filename + ".shards"; }
+
+constexpr const char* kCommittedMark = "committed";
+
+} // namespace
+
+struct ShardedStore::Shard {
+  std::unique_ptr<SqliteStore> store;
+  mutable std::mutex mu; // guards `store`
+
+  std::mutex queue_mu;
+  std::condition_variable queue_cv;
+  std::deque<std::function<void()>> queue;
+  bool stopping{false};
+  std::thread writer;
+
+  void start() {
+    stopping = false;
+    writer = std::thread([this]() { run(); });
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lk(queue_mu);
+      stopping = true;
+    }
+    queue_cv.notify_one();
+    if (writer.joinable()) writer.join();
+  }
+
+  void run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lk(queue_mu);
+        queue_cv.wait(lk, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) return;
+        task = std::move(queue.front());
+        queue.pop_front();
+      }
+      std::lock_guard<std::mutex> lk(mu);
+      task();
+    }
+  }
+
+  // Queue `fn` for the writer thread, which runs it holding `mu`.
+  template <typename Fn>
+  std::future<std::invoke_result_t<Fn&>> submit(Fn fn) {
+    using R = std::invoke_result_t<Fn&>;
+    auto task = std::make_shared<std::packaged_task<R()>>(std::move(fn));
+    auto fut = task->get_future();
+    {
+      std::lock_guard<std::mutex> lk(queue_mu);
+      queue.push_back([task]() { (*task)(); });
+    }
+    queue_cv.notify_one();
+    return fut;
+  }
+};
+
+ShardedStore::ShardedStore(ShardedConfig cfg) : cfg_(std::move(cfg)) {
+  if (cfg_.shards == 0) cfg_.shards = 1;
+}
+
+ShardedStore::~ShardedStore() { (void)close(); }
+
+std::size_t ShardedStore::shard_for(const ObjectID& id) const {
+  return static_cast<std::size_t>(fnv1a(id) % cfg_.shards);
+}
+
+std::string ShardedStore::shard_filename(std::size_t i) const {
+  if (memory_only_) return cfg_.filename;
+  return cfg_.filename + ".shard" + std::to_string(i);
+}
+
+Result<void> ShardedStore::check_manifest() const {
+  const auto path = manifest_path(cfg_.filename);
+  std::ifstream in(path);
+  if (in) {
+    std::size_t recorded = 0;
+    if (!(in >> recorded) || recorded == 0) return Result<void>::err("invalid shard manifest");
+    if (recorded != cfg_.shards) {
+      return Result<void>::err("store has " + std::to_string(recorded) + " shards, not " +
+                               std::to_string(cfg_.shards));
+    }
+    return Result<void>::ok();
+  }
+  std::error_code ec;
+  const auto parent = path.parent_path();
+  if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+  std::ofstream out(path, std::ios::trunc);
+  out << cfg_.shards << "\n";
+  out.flush();
+  if (!out) return Result<void>::err("failed to write shard manifest");
+  return Result<void>::ok();
+}
+
+// Intent file: one "<object_bytes> <edge_bytes>" line per shard, published by rename,
+// then a "committed" line appended once every shard has committed.
+Result<void> ShardedStore::write_intent() const {
+  std::ostringstream body;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    body << shard->store->object_segment_bytes() << ' ' << shard->store->edge_segment_bytes() << '\n';
+  }
+  const auto path = intent_path(cfg_.filename);
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << body.str();
+    out.flush();
+    if (!out) return Result<void>::err("failed to write transaction intent");
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) return Result<void>::err("failed to publish transaction intent");
+  return Result<void>::ok();
+}
+
+Result<void> ShardedStore::mark_intent_committed() const {
+  std::ofstream out(intent_path(cfg_.filename), std::ios::app);
+  out << kCommittedMark << '\n';
+  out.flush();
+  if (!out) return Result<void>::err("failed to mark transaction intent committed");
+  return Result<void>::ok();
+}
+
+void ShardedStore::remove_intent() const {
+  std::error_code ec;
+  std::filesystem::remove(intent_path(cfg_.filename), ec);
+}
+
+// Undo a commit that did not finish: cut every shard back to the lengths recorded
+// before it started. Shards must be closed. A checkpoint past the cut would later be
+// extended over different frames, so it is dropped and the shard reloads in full once.
+// An intent marked committed belongs to a commit that finished on every shard and
+// only lost its cleanup, so it is rolled forward by removing it.
+Result<void> ShardedStore::recover_intent() {
+  std::ifstream in(intent_path(cfg_.filename));
+  if (!in) return Result<void>::ok();
+
+  std::vector<SegmentLengths> lengths;
+  SegmentLengths len;
+  while (in >> len.object_bytes >> len.edge_bytes) lengths.push_back(len);
+  if (lengths.size() != cfg_.shards) return Result<void>::err("invalid transaction intent");
+  in.clear();
+  std::string mark;
+  if (in >> mark && mark == kCommittedMark) {
+    in.close();
+    remove_intent();
+    return Result<void>::ok();
+  }
+
+  for (std::size_t i = 0; i < lengths.size(); ++i) {
+    const std::filesystem::path store_dir = SqliteStore::store_dir_from_filename(shard_filename(i));
+    const auto segments_dir = store_dir / "segments";
+    const std::pair<std::filesystem::path, std::uint64_t> cuts[] = {
+        {segments_dir / "objects.seg", lengths[i].object_bytes},
+        {segments_dir / "edges.seg", lengths[i].edge_bytes}};
+    bool truncated = false;
+    for (const auto& [path, keep] : cuts) {
+      std::error_code ec;
+      const auto size = std::filesystem::file_size(path, ec);
+      if (ec || size <= keep) continue;
+      std::filesystem::resize_file(path, keep, ec);
+      if (ec) return Result<void>::err("failed to roll back " + path.filename().string());
+      truncated = true;
+    }
+    if (truncated) {
+      std::error_code ec;
+      std::filesystem::remove(index_checkpoint::checkpoint_path(store_dir), ec);
+    }
+  }
+  remove_intent();
+  return Result<void>::ok();
+}
+
+Result<void> ShardedStore::open_shard(std::size_t i) {
+  SqliteConfig shard_cfg;
+  shard_cfg.filename = shard_filename(i);
+  shard_cfg.checkpoint_interval_bytes = cfg_.checkpoint_interval_bytes;
+  auto store = std::make_unique<SqliteStore>(std::move(shard_cfg));
+  auto r = store->open();
+  if (!r) return Result<void>::err("shard " + std::to_string(i) + ": " + r.error->message);
+  shards_[i]->store = std::move(store);
+  return Result<void>::ok();
+}
+
+Result<void> ShardedStore::open() {
+  if (open_) return Result<void>::ok();
+  memory_only_ = (cfg_.filename == ":memory:");
+  if (!memory_only_) {
+    auto r = check_manifest();
+    if (!r) return r;
+    r = recover_intent();
+    if (!r) return r;
+  }
+
+  shards_.clear();
+  for (std::size_t i = 0; i < cfg_.shards; ++i) shards_.push_back(std::make_unique<Shard>());
+
+  // Shards load their segments concurrently.
+  std::vector<std::future<Result<void>>> opens;
+  for (std::size_t i = 0; i < cfg_.shards; ++i) {
+    opens.push_back(std::async(std::launch::async, [this, i]() { return open_shard(i); }));
+  }
+  std::optional<std::string> failure;
+  for (auto& f : opens) {
+    auto r = f.get();
+    if (!r && !failure) failure = r.error->message;
+  }
+  if (failure) {
+    shards_.clear();
+    return Result<void>::err(*failure);
+  }
+
+  for (auto& shard : shards_) shard->start();
+  open_ = true;
+  in_txn_ = false;
+  return Result<void>::ok();
+}
+
+Result<void> ShardedStore::close() {
+  if (!open_) return Result<void>::ok();
+  for (auto& shard : shards_) shard->stop();
+  for (auto& shard : shards_) {
+    if (shard->store) (void)shard->store->close();
+  }
+  shards_.clear();
+  open_ = false;
+  in_txn_ = false;
+  return Result<void>::ok();
+}
+
+Result<void> ShardedStore::begin() {
+  std::unique_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<void>::err("store not open");
+  if (in_txn_) return Result<void>::err("transaction already open");
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    auto r = shard->store->begin();
+    if (!r) return r;
+  }
+  in_txn_ = true;
+  return Result<void>::ok();
+}
+
+Result<void> ShardedStore::commit() {
+  std::unique_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_ || !in_txn_) return Result<void>::ok();
+
+  if (!memory_only_) {
+    auto r = write_intent();
+    if (!r) return r;
+  }
+
+  std::vector<std::future<Result<void>>> commits;
+  commits.reserve(shards_.size());
+  for (auto& shard : shards_) {
+    SqliteStore* store = shard->store.get();
+    commits.push_back(shard->submit([store]() { return store->commit(); }));
+  }
+  std::optional<std::string> failure;
+  for (auto& f : commits) {
+    auto r = f.get();
+    if (!r && !failure) failure = r.error->message;
+  }
+  in_txn_ = false;
+
+  if (failure) {
+    if (memory_only_) return Result<void>::err(*failure);
+    return reopen_after_failed_commit(*failure);
+  }
+  if (!memory_only_) {
+    // Once marked, a crash before the removal rolls forward instead of back.
+    auto r = mark_intent_committed();
+    if (!r) return r;
+    remove_intent();
+  }
+  return Result<void>::ok();
+}
+
+// Some shards may hold part of the transaction: reload every shard from disk after
+// cutting them back to the intent, so memory and segments agree again.
+Result<void> ShardedStore::reopen_after_failed_commit(const std::string& cause) {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    (void)shard->store->close();
+  }
+  auto r = recover_intent();
+  for (std::size_t i = 0; i < shards_.size() && r; ++i) {
+    std::lock_guard<std::mutex> lk(shards_[i]->mu);
+    r = open_shard(i);
+  }
+  if (!r) return Result<void>::err("commit failed (" + cause + "); recovery failed: " + r.error->message);
+  return Result<void>::err("commit failed and was rolled back: " + cause);
+}
+
+Result<void> ShardedStore::rollback() {
+  std::unique_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_ || !in_txn_) return Result<void>::ok();
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    (void)shard->store->rollback();
+  }
+  in_txn_ = false;
+  return Result<void>::ok();
+}
+
+Result<ObjectRecord> ShardedStore::create_object(TypeID type, ObjectID definition_id,
+                                                 const Bytes& payload_cbor) {
+  return create_object_with_id(ObjectID::random(), type, definition_id, payload_cbor);
+}
+
+Result<ObjectRecord> ShardedStore::create_object_with_id(ObjectID object_id, TypeID type,
+                                                         ObjectID definition_id,
+                                                         const Bytes& payload_cbor) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<ObjectRecord>::err("store not open");
+  auto& shard = *shards_[shard_for(object_id)];
+  SqliteStore* store = shard.store.get();
+  return shard.submit([&]() {
+    return store->create_object_with_id(object_id, type, definition_id, payload_cbor);
+  }).get();
+}
+
+Result<std::vector<ObjectRecord>> ShardedStore::create_objects(const std::vector<NewObject>& batch) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::vector<ObjectRecord>>::err("store not open");
+
+  std::vector<ObjectID> ids(batch.size());
+  std::vector<std::vector<std::size_t>> by_shard(shards_.size());
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    ids[i] = ObjectID::random();
+    by_shard[shard_for(ids[i])].push_back(i);
+  }
+
+  // Each writer fills only the slots of its own share, so `out` needs no locking.
+  std::vector<ObjectRecord> out(batch.size());
+  std::vector<std::future<Result<void>>> writes;
+  for (std::size_t s = 0; s < shards_.size(); ++s) {
+    if (by_shard[s].empty()) continue;
+    SqliteStore* store = shards_[s]->store.get();
+    const auto* indices = &by_shard[s];
+    writes.push_back(shards_[s]->submit([&, store, indices]() -> Result<void> {
+      for (auto i : *indices) {
+        const auto& obj = batch[i];
+        auto r = store->create_object_with_id(ids[i], obj.type, obj.definition_id, obj.payload_cbor);
+        if (!r) return Result<void>::err(r.error->message);
+        out[i] = std::move(r.value.value());
+      }
+      return Result<void>::ok();
+    }));
+  }
+  std::optional<std::string> failure;
+  for (auto& f : writes) {
+    auto r = f.get();
+    if (!r && !failure) failure = r.error->message;
+  }
+  if (failure) return Result<std::vector<ObjectRecord>>::err(*failure);
+  return Result<std::vector<ObjectRecord>>::ok(std::move(out));
+}
+
+Result<std::optional<ObjectRecord>> ShardedStore::get_object(ObjectRef ref) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::optional<ObjectRecord>>::err("store not open");
+  auto& shard = *shards_[shard_for(ref.id)];
+  std::lock_guard<std::mutex> lk(shard.mu);
+  return shard.store->get_object(ref);
+}
+
+Result<std::optional<ObjectRecord>> ShardedStore::get_latest(ObjectID id) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::optional<ObjectRecord>>::err("store not open");
+  auto& shard = *shards_[shard_for(id)];
+  std::lock_guard<std::mutex> lk(shard.mu);
+  return shard.store->get_latest(id);
+}
+
+Result<std::vector<ObjectRecord>> ShardedStore::list_by_type(TypeID type) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::vector<ObjectRecord>>::err("store not open");
+  // Each shard lists in append order; merging on (created_at, id) interleaves them
+  // the way a single store would have appended them.
+  auto before = [](const ObjectRecord& a, const ObjectRecord& b) {
+    if (a.created_at_unix_ms != b.created_at_unix_ms) return a.created_at_unix_ms < b.created_at_unix_ms;
+    return a.ref.id.bytes < b.ref.id.bytes;
+  };
+  std::vector<ObjectRecord> out;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    auto r = shard->store->list_by_type(type);
+    if (!r) return r;
+    auto& part = r.value.value();
+    std::vector<ObjectRecord> merged;
+    merged.reserve(out.size() + part.size());
+    std::merge(std::make_move_iterator(out.begin()), std::make_move_iterator(out.end()),
+               std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()),
+               std::back_inserter(merged), before);
+    out = std::move(merged);
+  }
+  return Result<std::vector<ObjectRecord>>::ok(std::move(out));
+}
+
+Result<void> ShardedStore::add_edge(ObjectRef from, ObjectRef to, std::string name, std::string role,
+                                    const Bytes& props_cbor) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<void>::err("store not open");
+  auto& shard = *shards_[shard_for(from.id)];
+  SqliteStore* store = shard.store.get();
+  return shard.submit([&]() {
+    return store->add_edge(from, to, std::move(name), std::move(role), props_cbor);
+  }).get();
+}
+
+Result<std::vector<EdgeRecord>> ShardedStore::edges_from(ObjectRef from,
+                                                         std::optional<std::string> name_filter,
+                                                         std::optional<std::string> role_filter) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::vector<EdgeRecord>>::err("store not open");
+  auto& shard = *shards_[shard_for(from.id)];
+  std::lock_guard<std::mutex> lk(shard.mu);
+  return shard.store->edges_from(from, std::move(name_filter), std::move(role_filter));
+}
+
+Result<std::vector<EdgeRecord>> ShardedStore::edges_to(ObjectRef to,
+                                                       std::optional<std::string> name_filter,
+                                                       std::optional<std::string> role_filter) {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::vector<EdgeRecord>>::err("store not open");
+  std::vector<EdgeRecord> out;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    auto r = shard->store->edges_to(to, name_filter, role_filter);
+    if (!r) return r;
+    auto& part = r.value.value();
+    out.insert(out.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+  }
+  return Result<std::vector<EdgeRecord>>::ok(std::move(out));
+}
+
+Result<std::vector<StoreStats>> ShardedStore::shard_stats() const {
+  std::shared_lock<std::shared_mutex> gate(txn_gate_);
+  if (!open_) return Result<std::vector<StoreStats>>::err("store not open");
+  std::vector<StoreStats> out;
+  out.reserve(shards_.size());
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lk(shard->mu);
+    auto r = shard->store->stats();
+    if (!r) return Result<std::vector<StoreStats>>::err(r.error->message);
+    out.push_back(std::move(r.value.value()));
+  }
+  return Result<std::vector<StoreStats>>::ok(std::move(out));
+}
+
+} // namespace referee
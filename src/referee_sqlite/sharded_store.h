@@ -0,0 +1,105 @@
+#pragma once
+
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace referee {
+
+struct ShardedConfig {
+  std::string filename;     // base path; shard i lives at "<filename>.shard<i>" (":memory:" for in-memory)
+  std::size_t shards{4};    // fixed at creation, recorded in "<filename>.shards"
+  std::uint64_t checkpoint_interval_bytes{64ULL << 20}; // per shard, see SqliteConfig
+};
+
+struct NewObject {
+  TypeID type{};
+  ObjectID definition_id{};
+  Bytes payload_cbor;
+};
+
+// Store facade that partitions objects by ObjectID hash across N SqliteStore shards,
+// each with its own segment directory, writer lock and writer thread. Edges live on
+// the shard owning `from`, so edges_to() and list_by_type() fan out to every shard.
+//
+// Transactions span all shards. commit() records every shard's segment lengths in
+// "<filename>.txn" before committing the shards in parallel, and marks the file
+// committed, then removes it, once all succeed. A commit that fails part-way, or is
+// interrupted by a crash before the mark, is rolled back by truncating each shard to
+// the recorded lengths; one interrupted after the mark is kept.
+class ShardedStore {
+public:
+  explicit ShardedStore(ShardedConfig cfg);
+  ~ShardedStore();
+
+  ShardedStore(const ShardedStore&) = delete;
+  ShardedStore& operator=(const ShardedStore&) = delete;
+
+  Result<void> open();
+  Result<void> close();
+
+  std::size_t shard_count() const { return cfg_.shards; }
+  std::size_t shard_for(const ObjectID& id) const;
+
+  // Transactions
+  Result<void> begin();
+  Result<void> commit();
+  Result<void> rollback();
+
+  // Core operations, routed to the owning shard's writer thread.
+  Result<ObjectRecord> create_object(TypeID type, ObjectID definition_id, const Bytes& payload_cbor);
+  Result<ObjectRecord> create_object_with_id(ObjectID object_id, TypeID type, ObjectID definition_id,
+                                             const Bytes& payload_cbor);
+  // Batch create: each shard's share is written by its writer thread concurrently.
+  // Records are returned in input order.
+  Result<std::vector<ObjectRecord>> create_objects(const std::vector<NewObject>& batch);
+  Result<std::optional<ObjectRecord>> get_object(ObjectRef ref);
+  Result<std::optional<ObjectRecord>> get_latest(ObjectID id);
+  // Merged across shards in (created_at, id) order.
+  Result<std::vector<ObjectRecord>> list_by_type(TypeID type);
+
+  // Edge operations
+  Result<void> add_edge(ObjectRef from, ObjectRef to, std::string name, std::string role,
+                        const Bytes& props_cbor);
+  Result<std::vector<EdgeRecord>> edges_from(ObjectRef from,
+                                             std::optional<std::string> name_filter = std::nullopt,
+                                             std::optional<std::string> role_filter = std::nullopt);
+  Result<std::vector<EdgeRecord>> edges_to(ObjectRef to,
+                                           std::optional<std::string> name_filter = std::nullopt,
+                                           std::optional<std::string> role_filter = std::nullopt);
+
+  // One entry per shard, in shard order.
+  Result<std::vector<StoreStats>> shard_stats() const;
+
+private:
+  struct Shard;
+
+  std::string shard_filename(std::size_t i) const;
+  Result<void> check_manifest() const;
+  Result<void> recover_intent();
+  Result<void> write_intent() const;
+  Result<void> mark_intent_committed() const;
+  void remove_intent() const;
+  Result<void> open_shard(std::size_t i);
+  Result<void> reopen_after_failed_commit(const std::string& cause);
+
+private:
+  ShardedConfig cfg_;
+  bool open_{false};
+  bool memory_only_{false};
+  bool in_txn_{false};
+
+  // Writes hold it shared; begin/commit/rollback hold it exclusively so a commit sees
+  // stable segment lengths and never interleaves with direct appends.
+  mutable std::shared_mutex txn_gate_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace referee
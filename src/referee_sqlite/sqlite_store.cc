@@ -1,91 +1,91 @@
 #include "referee_sqlite/sqlite_store.h"
 
+#include "referee_sqlite/segment_format.h"
+#include "referee_sqlite/segment_loader.h"
+
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <future>
 
 namespace referee {
 namespace {
 
-constexpr std::uint32_t kObjTag = 0x314a424f; // "OBJ1"
-constexpr std::uint32_t kEdgeTag = 0x31474445; // "EDG1"
-
-void write_u32(std::ostream& out, std::uint32_t v) {
-  std::array<std::uint8_t, 4> b{
-    static_cast<std::uint8_t>(v & 0xFFu),
-    static_cast<std::uint8_t>((v >> 8) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 16) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 24) & 0xFFu)
-  };
-  out.write(reinterpret_cast<const char*>(b.data()), b.size());
-}
-
-void write_u64(std::ostream& out, std::uint64_t v) {
-  std::array<std::uint8_t, 8> b{
-    static_cast<std::uint8_t>(v & 0xFFu),
-    static_cast<std::uint8_t>((v >> 8) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 16) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 24) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 32) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 40) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 48) & 0xFFu),
-    static_cast<std::uint8_t>((v >> 56) & 0xFFu)
-  };
-  out.write(reinterpret_cast<const char*>(b.data()), b.size());
-}
-
-bool read_exact(std::istream& in, void* dst, std::size_t n) {
-  in.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(n));
-  return in.good();
-}
+using SteadyClock = std::chrono::steady_clock;
 
-bool read_u32(std::istream& in, std::uint32_t* out) {
-  std::array<std::uint8_t, 4> b{};
-  if (!read_exact(in, b.data(), b.size())) return false;
-  *out = (std::uint32_t)b[0]
-       | (std::uint32_t(b[1]) << 8)
-       | (std::uint32_t(b[2]) << 16)
-       | (std::uint32_t(b[3]) << 24);
-  return true;
+std::uint64_t elapsed_ns(SteadyClock::time_point start) {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - start).count());
 }
 
-bool read_u64(std::istream& in, std::uint64_t* out) {
-  std::array<std::uint8_t, 8> b{};
-  if (!read_exact(in, b.data(), b.size())) return false;
-  *out = (std::uint64_t)b[0]
-       | (std::uint64_t(b[1]) << 8)
-       | (std::uint64_t(b[2]) << 16)
-       | (std::uint64_t(b[3]) << 24)
-       | (std::uint64_t(b[4]) << 32)
-       | (std::uint64_t(b[5]) << 40)
-       | (std::uint64_t(b[6]) << 48)
-       | (std::uint64_t(b[7]) << 56);
-  return true;
+void write_lines(std::ofstream& out, const std::string& lines) {
+  if (!out.is_open() || lines.empty()) return;
+  out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
 }
 
-std::string key_object_id(const ObjectID& id, std::uint64_t ver) {
-  return id.to_hex() + ":" + std::to_string(ver);
-}
+template <typename Chunk>
+struct SegmentParse {
+  segment_loader::SegmentLoad<Chunk> tail;  // frames walked after the checkpoint
+  std::uint64_t end{0};                     // end of the last complete frame
+};
 
-std::string key_type_id(const TypeID& type, const ObjectID& id, std::uint64_t ver) {
-  return std::to_string(type.v) + ":" + id.to_hex() + ":" + std::to_string(ver);
-}
-
-std::string key_edge_from(const EdgeRecord& rec) {
-  return rec.from.id.to_hex() + ":" + std::to_string(rec.from.ver.v) + ":" + rec.name + ":" + rec.role
-         + ":" + rec.to.id.to_hex() + ":" + std::to_string(rec.to.ver.v);
+template <typename Chunk, typename TailFn>
+Result<void> parse_segment(const segment_loader::MappedFile& map, std::uint64_t covered,
+                           unsigned workers, TailFn tail_fn, SegmentParse<Chunk>* out) {
+  *out = SegmentParse<Chunk>{};
+  auto tailR = tail_fn(map.data() + covered, map.size() - covered, covered, workers);
+  if (!tailR) return Result<void>::err(tailR.error->message);
+  out->tail = std::move(tailR.value.value());
+  out->end = covered + out->tail.valid_bytes;
+  return Result<void>::ok();
 }
 
-std::string key_edge_to(const EdgeRecord& rec) {
-  return rec.to.id.to_hex() + ":" + std::to_string(rec.to.ver.v) + ":" + rec.name + ":" + rec.role
-         + ":" + rec.from.id.to_hex() + ":" + std::to_string(rec.from.ver.v);
+// Parses whatever complete frames follow `from` in the segment at `path`.
+template <typename Chunk, typename TailFn>
+Result<void> parse_segment_tail(const std::filesystem::path& path, std::uint64_t from,
+                                TailFn tail_fn, SegmentParse<Chunk>* out) {
+  auto mapR = segment_loader::MappedFile::open(path);
+  if (!mapR) return Result<void>::err(mapR.error->message);
+  const auto& map = mapR.value.value();
+  if (map.size() < from) return Result<void>::err(path.filename().string() + " shrank; reopen the store");
+  auto tailR = tail_fn(map.data() + from, map.size() - from, from, 1);
+  if (!tailR) return Result<void>::err(tailR.error->message);
+  out->tail = std::move(tailR.value.value());
+  out->end = from + out->tail.valid_bytes;
+  return Result<void>::ok();
 }
 
-void append_index(std::ofstream& out, const std::string& key, std::uint64_t offset) {
-  if (!out.is_open()) return;
-  out << key << '\t' << offset << '\n';
+// The last covered frame must still sit where the checkpoint says and end at the
+// mark; together with the key hashes that catches a segment rewritten under it.
+template <typename Key, typename Sizer, typename Decode>
+bool keys_match(const segment_loader::MappedFile& map, std::uint64_t covered,
+                const std::vector<index_checkpoint::KeyAt<Key>>& keys, Sizer sizer, Decode decode) {
+  if (keys.empty()) return covered == 0;
+  const auto& last = keys.back();
+  std::uint64_t frame = 0;
+  if (last.offset >= covered || sizer(map.data() + last.offset, covered - last.offset, &frame) !=
+                                    segment_format::FrameStatus::Ok) {
+    return false;
+  }
+  Key key;
+  decode(map.data() + last.offset, &key);
+  return last.offset + frame == covered && key == last.key;
+}
+
+bool checkpoint_usable(const index_checkpoint::IndexCheckpoint& ckpt, const segment_loader::MappedFile& objects,
+                       const segment_loader::MappedFile& edges, const std::filesystem::path& indexes_dir) {
+  if (ckpt.mark.object_bytes > objects.size() || ckpt.mark.edge_bytes > edges.size()) return false;
+  for (std::size_t i = 0; i < index_checkpoint::kIndexFileCount; ++i) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(indexes_dir / index_checkpoint::kIndexFiles[i], ec);
+    if (ec || size < ckpt.mark.index_bytes[i]) return false;
+  }
+  return keys_match(objects, ckpt.mark.object_bytes, ckpt.objects, &segment_format::object_frame_size,
+                    &segment_format::decode_object_key) &&
+         keys_match(edges, ckpt.mark.edge_bytes, ckpt.edges, &segment_format::edge_frame_size,
+                    &segment_format::decode_edge_key);
 }
 
 } // namespace
@@ -120,6 +120,7 @@ std::string SqliteStore::base_dir() const {
 
 Result<void> SqliteStore::open() {
   if (open_) return Result<void>::ok();
+  const auto open_start = SteadyClock::now();
   memory_only_ = (cfg_.filename == ":memory:");
   if (memory_only_) {
     open_ = true;
@@ -130,42 +131,48 @@ Result<void> SqliteStore::open() {
   const auto segments_dir = std::filesystem::path(base) / "segments";
   const auto indexes_dir = std::filesystem::path(base) / "indexes";
 
-  std::error_code ec;
-  std::filesystem::create_directories(segments_dir, ec);
-  if (ec) return Result<void>::err("failed to create segments directory");
-  std::filesystem::create_directories(indexes_dir, ec);
-  if (ec) return Result<void>::err("failed to create indexes directory");
+  if (!read_only()) {
+    std::error_code ec;
+    std::filesystem::create_directories(segments_dir, ec);
+    if (ec) return Result<void>::err("failed to create segments directory");
+    std::filesystem::create_directories(indexes_dir, ec);
+    if (ec) return Result<void>::err("failed to create indexes directory");
 
-  const auto obj_path = segments_dir / "objects.seg";
-  const auto edge_path = segments_dir / "edges.seg";
+    auto lockR = WriterLock::acquire(base);
+    if (!lockR) return Result<void>::err(lockR.error->message);
+    writer_lock_ = std::move(lockR.value.value());
 
-  object_seg_.open(obj_path, std::ios::binary | std::ios::app);
-  if (!object_seg_) return Result<void>::err("failed to open objects.seg");
-  edge_seg_.open(edge_path, std::ios::binary | std::ios::app);
-  if (!edge_seg_) return Result<void>::err("failed to open edges.seg");
+    const auto obj_path = segments_dir / "objects.seg";
+    const auto edge_path = segments_dir / "edges.seg";
 
-  idx_objects_by_id_.open(indexes_dir / "objects_by_id.idx", std::ios::app);
-  idx_objects_by_type_.open(indexes_dir / "objects_by_type.idx", std::ios::app);
-  idx_edges_from_.open(indexes_dir / "edges_from.idx", std::ios::app);
-  idx_edges_to_.open(indexes_dir / "edges_to.idx", std::ios::app);
+    object_seg_.open(obj_path, std::ios::binary | std::ios::app);
+    if (!object_seg_) return Result<void>::err("failed to open objects.seg");
+    edge_seg_.open(edge_path, std::ios::binary | std::ios::app);
+    if (!edge_seg_) return Result<void>::err("failed to open edges.seg");
+  }
 
   auto r = load_segments();
-  if (!r) return r;
-  r = rebuild_indexes();
-  if (!r) return r;
+  if (!r) {
+    writer_lock_.release();
+    return r;
+  }
+  timings_.open_us = elapsed_ns(open_start) / 1000;
 
   open_ = true;
+  maybe_checkpoint();
   return Result<void>::ok();
 }
 
 Result<void> SqliteStore::close() {
   if (!open_) return Result<void>::ok();
+  join_checkpoint();
   if (object_seg_.is_open()) object_seg_.close();
   if (edge_seg_.is_open()) edge_seg_.close();
   if (idx_objects_by_id_.is_open()) idx_objects_by_id_.close();
   if (idx_objects_by_type_.is_open()) idx_objects_by_type_.close();
   if (idx_edges_from_.is_open()) idx_edges_from_.close();
   if (idx_edges_to_.is_open()) idx_edges_to_.close();
+  writer_lock_.release();
   open_ = false;
   return Result<void>::ok();
 }
@@ -185,18 +192,18 @@ Result<void> SqliteStore::begin() {
 Result<void> SqliteStore::commit() {
   if (!in_txn_) return Result<void>::ok();
   for (const auto& rec : pending_objects_) {
-    auto r = append_object(rec);
+    auto r = persist_object(rec);
     if (!r) return r;
-    index_object(rec);
   }
   for (const auto& rec : pending_edges_) {
-    auto r = append_edge(rec);
+    auto r = persist_edge(rec);
     if (!r) return r;
-    index_edge(rec);
   }
+  const bool wrote = !pending_objects_.empty() || !pending_edges_.empty();
   pending_objects_.clear();
   pending_edges_.clear();
   in_txn_ = false;
+  if (wrote) notify_commit();
   return Result<void>::ok();
 }
 
@@ -216,11 +223,33 @@ Result<ObjectRecord> SqliteStore::create_object(TypeID type, ObjectID definition
 Result<ObjectRecord> SqliteStore::create_object_with_id(ObjectID object_id, TypeID type,
                                                         ObjectID definition_id,
                                                         const Bytes& payload_cbor) {
+  return write_object(ObjectRef{object_id, Version{1}}, type, definition_id, payload_cbor);
+}
+
+Result<ObjectRecord> SqliteStore::create_version(ObjectRef prior, ObjectID definition_id,
+                                                 const Bytes& payload_cbor) {
+  if (!open_) return Result<ObjectRecord>::err("store not open");
+  auto latestR = get_latest(prior.id);
+  if (!latestR) return Result<ObjectRecord>::err(latestR.error->message);
+  if (!latestR.value->has_value()) return Result<ObjectRecord>::err("object not found");
+  const auto& latest = latestR.value->value();
+  if (latest.ref.ver != prior.ver) return Result<ObjectRecord>::err("stale version: object has changed");
+  return write_object(ObjectRef{prior.id, Version{prior.ver.v + 1}}, latest.type, definition_id,
+                      payload_cbor);
+}
+
+Result<ObjectRecord> SqliteStore::write_object(ObjectRef ref, TypeID type, ObjectID definition_id,
+                                               const Bytes& payload_cbor) {
   if (!open_) return Result<ObjectRecord>::err("store not open");
+  if (auto w = require_writable(); !w) return Result<ObjectRecord>::err(w.error->message);
+  if (validator_) {
+    if (auto v = validator_(type, definition_id, payload_cbor); !v) {
+      return Result<ObjectRecord>::err(v.error->message);
+    }
+  }
 
   ObjectRecord rec;
-  rec.ref.id = object_id;
-  rec.ref.ver = Version{1};
+  rec.ref = ref;
   rec.type = type;
   rec.definition_id = definition_id;
   rec.payload_cbor = payload_cbor;
@@ -229,9 +258,9 @@ Result<ObjectRecord> SqliteStore::create_object_with_id(ObjectID object_id, Type
   if (in_txn_) {
     pending_objects_.push_back(rec);
   } else {
-    auto r = append_object(rec);
+    auto r = persist_object(rec);
     if (!r) return Result<ObjectRecord>::err(r.error->message);
-    index_object(rec);
+    notify_commit();
   }
 
   return Result<ObjectRecord>::ok(std::move(rec));
@@ -248,8 +277,14 @@ Result<std::optional<ObjectRecord>> SqliteStore::get_object(ObjectRef ref) {
   }
   ObjectRefKey key{ref.id, ref.ver};
   auto it = objects_by_ref_.find(key);
-  if (it == objects_by_ref_.end()) return Result<std::optional<ObjectRecord>>::ok(std::nullopt);
-  return Result<std::optional<ObjectRecord>>::ok(std::optional<ObjectRecord>(it->second));
+  if (it == objects_by_ref_.end()) {
+    ++object_lookups_.misses;
+    return Result<std::optional<ObjectRecord>>::ok(std::nullopt);
+  }
+  ++object_lookups_.hits;
+  auto recR = read_object(it->second);
+  if (!recR) return Result<std::optional<ObjectRecord>>::err(recR.error->message);
+  return Result<std::optional<ObjectRecord>>::ok(std::move(recR.value));
 }
 
 Result<std::optional<ObjectRecord>> SqliteStore::get_latest(ObjectID id) {
@@ -268,8 +303,14 @@ Result<std::optional<ObjectRecord>> SqliteStore::get_latest(ObjectID id) {
     }
   }
   auto it = latest_by_id_.find(id);
-  if (it == latest_by_id_.end()) return Result<std::optional<ObjectRecord>>::ok(std::nullopt);
-  return Result<std::optional<ObjectRecord>>::ok(std::optional<ObjectRecord>(it->second));
+  if (it == latest_by_id_.end()) {
+    ++latest_lookups_.misses;
+    return Result<std::optional<ObjectRecord>>::ok(std::nullopt);
+  }
+  ++latest_lookups_.hits;
+  auto recR = read_object(it->second);
+  if (!recR) return Result<std::optional<ObjectRecord>>::err(recR.error->message);
+  return Result<std::optional<ObjectRecord>>::ok(std::move(recR.value));
 }
 
 Result<std::vector<ObjectRecord>> SqliteStore::list_by_type(TypeID type) {
@@ -277,7 +318,12 @@ Result<std::vector<ObjectRecord>> SqliteStore::list_by_type(TypeID type) {
   std::vector<ObjectRecord> out;
   auto it = objects_by_type_.find(type);
   if (it != objects_by_type_.end()) {
-    out = it->second;
+    out.reserve(it->second.size());
+    for (const auto& entry : it->second) {
+      auto recR = read_object(entry.offset);
+      if (!recR) return Result<std::vector<ObjectRecord>>::err(recR.error->message);
+      out.push_back(std::move(recR.value.value()));
+    }
   }
   if (in_txn_) {
     for (const auto& rec : pending_objects_) {
@@ -292,9 +338,45 @@ Result<std::vector<ObjectRecord>> SqliteStore::list_by_type(TypeID type) {
   return Result<std::vector<ObjectRecord>>::ok(std::move(out));
 }
 
+Result<std::vector<ObjectRecord>> SqliteStore::list_by_type_from(TypeID type, std::uint64_t from,
+                                                                 std::size_t limit) const {
+  if (!open_) return Result<std::vector<ObjectRecord>>::err("store not open");
+  std::vector<ObjectRecord> out;
+  auto it = objects_by_type_.find(type);
+  if (it != objects_by_type_.end() && from < it->second.size()) {
+    const auto& entries = it->second;
+    const auto end = from + std::min<std::uint64_t>(limit, entries.size() - from);
+    out.reserve(end - from);
+    for (auto i = from; i < end; ++i) {
+      auto recR = read_object(entries[i].offset);
+      if (!recR) return Result<std::vector<ObjectRecord>>::err(recR.error->message);
+      out.push_back(std::move(recR.value.value()));
+    }
+  }
+  return Result<std::vector<ObjectRecord>>::ok(std::move(out));
+}
+
+TypeMark SqliteStore::type_mark(TypeID type) const {
+  TypeMark out;
+  auto it = objects_by_type_.find(type);
+  if (it != objects_by_type_.end() && !it->second.empty()) {
+    out.count = it->second.size();
+    out.last = it->second.back().ref;
+  }
+  if (in_txn_) {
+    for (const auto& rec : pending_objects_) {
+      if (rec.type != type) continue;
+      ++out.count;
+      out.last = rec.ref;
+    }
+  }
+  return out;
+}
+
 Result<void> SqliteStore::add_edge(ObjectRef from, ObjectRef to, std::string name, std::string role,
                                    const Bytes& props_cbor) {
   if (!open_) return Result<void>::err("store not open");
+  if (auto w = require_writable(); !w) return w;
 
   EdgeRecord rec;
   rec.from = from;
@@ -307,9 +389,9 @@ Result<void> SqliteStore::add_edge(ObjectRef from, ObjectRef to, std::string nam
   if (in_txn_) {
     pending_edges_.push_back(rec);
   } else {
-    auto r = append_edge(rec);
+    auto r = persist_edge(rec);
     if (!r) return r;
-    index_edge(rec);
+    notify_commit();
   }
 
   return Result<void>::ok();
@@ -323,10 +405,13 @@ Result<std::vector<EdgeRecord>> SqliteStore::edges_from(ObjectRef from,
   std::vector<EdgeRecord> out;
   auto it = edges_from_.find(key);
   if (it != edges_from_.end()) {
-    for (const auto& e : it->second) {
+    for (auto offset : it->second) {
+      auto edgeR = read_edge(offset);
+      if (!edgeR) return Result<std::vector<EdgeRecord>>::err(edgeR.error->message);
+      auto& e = edgeR.value.value();
       if (name_filter && e.name != *name_filter) continue;
       if (role_filter && e.role != *role_filter) continue;
-      out.push_back(e);
+      out.push_back(std::move(e));
     }
   }
   if (in_txn_) {
@@ -348,10 +433,13 @@ Result<std::vector<EdgeRecord>> SqliteStore::edges_to(ObjectRef to,
   std::vector<EdgeRecord> out;
   auto it = edges_to_.find(key);
   if (it != edges_to_.end()) {
-    for (const auto& e : it->second) {
+    for (auto offset : it->second) {
+      auto edgeR = read_edge(offset);
+      if (!edgeR) return Result<std::vector<EdgeRecord>>::err(edgeR.error->message);
+      auto& e = edgeR.value.value();
       if (name_filter && e.name != *name_filter) continue;
       if (role_filter && e.role != *role_filter) continue;
-      out.push_back(e);
+      out.push_back(std::move(e));
     }
   }
   if (in_txn_) {
@@ -365,258 +453,429 @@ Result<std::vector<EdgeRecord>> SqliteStore::edges_to(ObjectRef to,
   return Result<std::vector<EdgeRecord>>::ok(std::move(out));
 }
 
-Result<void> SqliteStore::append_object(const ObjectRecord& rec) {
-  if (memory_only_) return Result<void>::ok();
-  if (!object_seg_.is_open()) return Result<void>::err("objects segment not open");
-
-  const auto offset = static_cast<std::uint64_t>(object_seg_.tellp());
-
-  write_u32(object_seg_, kObjTag);
-  write_u32(object_seg_, static_cast<std::uint32_t>(rec.payload_cbor.size()));
-  write_u64(object_seg_, rec.ref.ver.v);
-  write_u64(object_seg_, rec.type.v);
-  write_u64(object_seg_, rec.created_at_unix_ms);
-  object_seg_.write(reinterpret_cast<const char*>(rec.ref.id.bytes.data()), rec.ref.id.bytes.size());
-  object_seg_.write(reinterpret_cast<const char*>(rec.definition_id.bytes.data()),
-                    rec.definition_id.bytes.size());
-  if (!rec.payload_cbor.empty()) {
-    object_seg_.write(reinterpret_cast<const char*>(rec.payload_cbor.data()),
-                      static_cast<std::streamsize>(rec.payload_cbor.size()));
+// Returns the offset of the appended frame.
+Result<std::uint64_t> SqliteStore::append_object(const ObjectRecord& rec) {
+  if (memory_only_) {
+    const std::uint64_t offset = object_frames_.size();
+    segment_format::encode_object_frame(rec, &object_frames_);
+    return Result<std::uint64_t>::ok(offset);
   }
+  if (!object_seg_.is_open()) return Result<std::uint64_t>::err("objects segment not open");
+
+  const auto offset = object_seg_bytes_;
+  Bytes frame;
+  segment_format::encode_object_frame(rec, &frame);
+  object_seg_.write(reinterpret_cast<const char*>(frame.data()),
+                    static_cast<std::streamsize>(frame.size()));
   object_seg_.flush();
+  if (!object_seg_) return Result<std::uint64_t>::err("failed to append to objects.seg");
+  object_seg_bytes_ += frame.size();
 
-  append_index(idx_objects_by_id_, key_object_id(rec.ref.id, rec.ref.ver.v), offset);
-  append_index(idx_objects_by_type_, key_type_id(rec.type, rec.ref.id, rec.ref.ver.v), offset);
+  std::string by_id;
+  std::string by_type;
+  segment_format::append_object_index_lines(rec, offset, &by_id, &by_type);
+  write_lines(idx_objects_by_id_, by_id);
+  write_lines(idx_objects_by_type_, by_type);
 
-  return Result<void>::ok();
+  return Result<std::uint64_t>::ok(offset);
 }
 
-Result<void> SqliteStore::append_edge(const EdgeRecord& rec) {
-  if (memory_only_) return Result<void>::ok();
-  if (!edge_seg_.is_open()) return Result<void>::err("edges segment not open");
-
-  const auto offset = static_cast<std::uint64_t>(edge_seg_.tellp());
-
-  write_u32(edge_seg_, kEdgeTag);
-  write_u32(edge_seg_, static_cast<std::uint32_t>(rec.name.size()));
-  write_u32(edge_seg_, static_cast<std::uint32_t>(rec.role.size()));
-  write_u32(edge_seg_, static_cast<std::uint32_t>(rec.props_cbor.size()));
-  write_u64(edge_seg_, rec.created_at_unix_ms);
-  edge_seg_.write(reinterpret_cast<const char*>(rec.from.id.bytes.data()), rec.from.id.bytes.size());
-  write_u64(edge_seg_, rec.from.ver.v);
-  edge_seg_.write(reinterpret_cast<const char*>(rec.to.id.bytes.data()), rec.to.id.bytes.size());
-  write_u64(edge_seg_, rec.to.ver.v);
-  if (!rec.name.empty()) edge_seg_.write(rec.name.data(), static_cast<std::streamsize>(rec.name.size()));
-  if (!rec.role.empty()) edge_seg_.write(rec.role.data(), static_cast<std::streamsize>(rec.role.size()));
-  if (!rec.props_cbor.empty()) {
-    edge_seg_.write(reinterpret_cast<const char*>(rec.props_cbor.data()),
-                    static_cast<std::streamsize>(rec.props_cbor.size()));
+Result<std::uint64_t> SqliteStore::append_edge(const EdgeRecord& rec) {
+  if (memory_only_) {
+    const std::uint64_t offset = edge_frames_.size();
+    segment_format::encode_edge_frame(rec, &edge_frames_);
+    return Result<std::uint64_t>::ok(offset);
   }
-  edge_seg_.flush();
+  if (!edge_seg_.is_open()) return Result<std::uint64_t>::err("edges segment not open");
 
-  append_index(idx_edges_from_, key_edge_from(rec), offset);
-  append_index(idx_edges_to_, key_edge_to(rec), offset);
+  const auto offset = edge_seg_bytes_;
+  Bytes frame;
+  segment_format::encode_edge_frame(rec, &frame);
+  edge_seg_.write(reinterpret_cast<const char*>(frame.data()),
+                  static_cast<std::streamsize>(frame.size()));
+  edge_seg_.flush();
+  if (!edge_seg_) return Result<std::uint64_t>::err("failed to append to edges.seg");
+  edge_seg_bytes_ += frame.size();
+
+  std::string from;
+  std::string to;
+  segment_format::append_edge_index_lines(rec, offset, &from, &to);
+  write_lines(idx_edges_from_, from);
+  write_lines(idx_edges_to_, to);
+
+  return Result<std::uint64_t>::ok(offset);
+}
+
+Result<void> SqliteStore::persist_object(const ObjectRecord& rec) {
+  const auto start = SteadyClock::now();
+  auto offsetR = append_object(rec);
+  if (!offsetR) return Result<void>::err(offsetR.error->message);
+  index_object(segment_format::object_key(rec), offsetR.value.value());
+  object_append_latency_.record(elapsed_ns(start));
+  notify(ChangeEvent{ChangeKind::ObjectCreated, &rec, nullptr, {}});
+  maybe_checkpoint();
+  return Result<void>::ok();
+}
 
+Result<void> SqliteStore::persist_edge(const EdgeRecord& rec) {
+  const auto start = SteadyClock::now();
+  auto offsetR = append_edge(rec);
+  if (!offsetR) return Result<void>::err(offsetR.error->message);
+  index_edge(segment_format::edge_key(rec), offsetR.value.value());
+  edge_append_latency_.record(elapsed_ns(start));
+  notify(ChangeEvent{ChangeKind::EdgeAdded, nullptr, &rec, {}});
+  maybe_checkpoint();
   return Result<void>::ok();
 }
 
-void SqliteStore::index_object(const ObjectRecord& rec) {
-  ObjectRefKey key{rec.ref.id, rec.ref.ver};
-  objects_by_ref_[key] = rec;
-  latest_by_id_[rec.ref.id] = rec;
-  objects_by_type_[rec.type].push_back(rec);
+void SqliteStore::index_object(const segment_format::ObjectKey& key, std::uint64_t offset) {
+  objects_by_ref_[ObjectRefKey{key.ref.id, key.ref.ver}] = offset;
+  latest_by_id_[key.ref.id] = offset;
+  objects_by_type_[key.type].push_back(ObjectEntry{key.ref, key.created_at_unix_ms, offset, key.payload_bytes});
+}
+
+void SqliteStore::index_edge(const segment_format::EdgeKey& key, std::uint64_t offset) {
+  edges_from_[ObjectRefKey{key.from.id, key.from.ver}].push_back(offset);
+  edges_to_[ObjectRefKey{key.to.id, key.to.ver}].push_back(offset);
+  ++edge_count_;
+}
+
+void SqliteStore::index_objects(const segment_loader::ObjectChunk& chunk) {
+  auto offset = chunk.offset;
+  for (const auto& rec : chunk.records) {
+    const auto key = segment_format::object_key(rec);
+    index_object(key, offset);
+    offset += key.frame_bytes();
+  }
 }
 
-void SqliteStore::index_edge(const EdgeRecord& rec) {
-  ObjectRefKey from_key{rec.from.id, rec.from.ver};
-  ObjectRefKey to_key{rec.to.id, rec.to.ver};
-  edges_from_[from_key].push_back(rec);
-  edges_to_[to_key].push_back(rec);
+void SqliteStore::index_edges(const segment_loader::EdgeChunk& chunk) {
+  auto offset = chunk.offset;
+  for (const auto& rec : chunk.records) {
+    const auto key = segment_format::edge_key(rec);
+    index_edge(key, offset);
+    offset += key.frame_bytes();
+  }
 }
 
+Result<ObjectRecord> SqliteStore::read_object(std::uint64_t offset) const {
+  ObjectRecord rec;
+  if (memory_only_) {
+    segment_format::decode_object_frame(object_frames_.data() + offset, &rec);
+    return Result<ObjectRecord>::ok(std::move(rec));
+  }
+  Bytes scratch;
+  auto frameR = object_reader_.object_frame(offset, &scratch);
+  if (!frameR) return Result<ObjectRecord>::err(frameR.error->message);
+  segment_format::decode_object_frame(frameR.value.value(), &rec);
+  return Result<ObjectRecord>::ok(std::move(rec));
+}
+
+Result<EdgeRecord> SqliteStore::read_edge(std::uint64_t offset) const {
+  EdgeRecord rec;
+  if (memory_only_) {
+    segment_format::decode_edge_frame(edge_frames_.data() + offset, &rec);
+    return Result<EdgeRecord>::ok(std::move(rec));
+  }
+  Bytes scratch;
+  auto frameR = edge_reader_.edge_frame(offset, &scratch);
+  if (!frameR) return Result<EdgeRecord>::err(frameR.error->message);
+  segment_format::decode_edge_frame(frameR.value.value(), &rec);
+  return Result<EdgeRecord>::ok(std::move(rec));
+}
+
+Result<void> SqliteStore::open_readers() {
+  const auto segments_dir = std::filesystem::path(base_dir()) / "segments";
+  auto objR = segment_loader::SegmentReader::open(segments_dir / "objects.seg");
+  if (!objR) return Result<void>::err(objR.error->message);
+  auto edgeR = segment_loader::SegmentReader::open(segments_dir / "edges.seg");
+  if (!edgeR) return Result<void>::err(edgeR.error->message);
+  object_reader_ = std::move(objR.value.value());
+  edge_reader_ = std::move(edgeR.value.value());
+  return Result<void>::ok();
+}
+
+// Single pass over both segments: objects and edges load concurrently, each segment is
+// split into frame-aligned chunks decoded on worker threads, and the chunks are then
+// merged in segment order into the hash indexes and the on-disk .idx files. When a
+// valid checkpoint exists, the prefix it covers is indexed from its stored keys
+// without reading those frames, and its .idx lines are kept; only the tail written
+// after it is walked and indexed.
 Result<void> SqliteStore::load_segments() {
   if (memory_only_) return Result<void>::ok();
 
-  const auto base = base_dir();
-  const auto segments_dir = std::filesystem::path(base) / "segments";
-  const auto obj_path = segments_dir / "objects.seg";
-  const auto edge_path = segments_dir / "edges.seg";
-
-  if (std::filesystem::exists(obj_path)) {
-    std::ifstream in(obj_path, std::ios::binary);
-    while (in.good()) {
-      std::uint32_t tag = 0;
-      if (!read_u32(in, &tag)) break;
-      if (tag != kObjTag) return Result<void>::err("invalid object segment tag");
-
-      std::uint32_t payload_size = 0;
-      std::uint64_t ver = 0;
-      std::uint64_t type = 0;
-      std::uint64_t created = 0;
-      if (!read_u32(in, &payload_size)) break;
-      if (!read_u64(in, &ver)) break;
-      if (!read_u64(in, &type)) break;
-      if (!read_u64(in, &created)) break;
-
-      ObjectRecord rec;
-      if (!read_exact(in, rec.ref.id.bytes.data(), rec.ref.id.bytes.size())) break;
-      if (!read_exact(in, rec.definition_id.bytes.data(), rec.definition_id.bytes.size())) break;
-
-      rec.ref.ver = Version{ver};
-      rec.type = TypeID{type};
-      rec.created_at_unix_ms = created;
-      rec.payload_cbor.resize(payload_size);
-      if (payload_size > 0 && !read_exact(in, rec.payload_cbor.data(), payload_size)) break;
-
-      index_object(rec);
+  const auto base = std::filesystem::path(base_dir());
+  const auto segments_dir = base / "segments";
+  const auto indexes_dir = base / "indexes";
+
+  auto load_start = SteadyClock::now();
+  auto objMapR = segment_loader::MappedFile::open(segments_dir / "objects.seg");
+  if (!objMapR) return Result<void>::err(objMapR.error->message);
+  auto edgeMapR = segment_loader::MappedFile::open(segments_dir / "edges.seg");
+  if (!edgeMapR) return Result<void>::err(edgeMapR.error->message);
+  const auto& obj_map = objMapR.value.value();
+  const auto& edge_map = edgeMapR.value.value();
+  object_seg_bytes_ = obj_map.size();
+  edge_seg_bytes_ = edge_map.size();
+
+  auto ckpt = index_checkpoint::read(base);
+  if (ckpt && !checkpoint_usable(*ckpt, obj_map, edge_map, indexes_dir)) {
+    ckpt.reset();
+  }
+
+  // Share the cores between the two tails in proportion to their size.
+  const std::uint64_t obj_tail = obj_map.size() - (ckpt ? ckpt->mark.object_bytes : 0);
+  const std::uint64_t edge_tail = edge_map.size() - (ckpt ? ckpt->mark.edge_bytes : 0);
+  const std::uint64_t total = obj_tail + edge_tail;
+  const unsigned workers = segment_loader::workers_for(total);
+  const unsigned edge_workers = total == 0 ? 1 : std::max<unsigned>(
+      1, static_cast<unsigned>(workers * edge_tail / total));
+  const unsigned obj_workers = std::max<unsigned>(1, workers - std::min(workers - 1, edge_workers));
+
+  SegmentParse<segment_loader::ObjectChunk> objects;
+  SegmentParse<segment_loader::EdgeChunk> edges;
+  auto parse = [&](const index_checkpoint::IndexCheckpoint* from) -> Result<void> {
+    auto edgesF = std::async(std::launch::async, [&]() {
+      return parse_segment(edge_map, from ? from->mark.edge_bytes : 0, edge_workers,
+                           &segment_loader::load_edges, &edges);
+    });
+    auto objR = parse_segment(obj_map, from ? from->mark.object_bytes : 0, obj_workers,
+                              &segment_loader::load_objects, &objects);
+    auto edgeR = edgesF.get();
+    if (!objR) return objR;
+    return edgeR;
+  };
+  auto parsed = parse(ckpt ? &*ckpt : nullptr);
+  if (!parsed && ckpt) {
+    // A checkpoint that disagrees with the segments is ignored, not fatal.
+    ckpt.reset();
+    parsed = parse(nullptr);
+  }
+  if (!parsed) return parsed;
+  timings_.load_us = elapsed_ns(load_start) / 1000;
+
+  auto rebuild_start = SteadyClock::now();
+  const std::array<std::ofstream*, index_checkpoint::kIndexFileCount> idx_streams = {
+      &idx_objects_by_id_, &idx_objects_by_type_, &idx_edges_from_, &idx_edges_to_};
+  for (std::size_t i = 0; i < idx_streams.size() && !read_only(); ++i) {
+    const auto path = indexes_dir / index_checkpoint::kIndexFiles[i];
+    if (ckpt) {
+      std::error_code ec;
+      std::filesystem::resize_file(path, ckpt->mark.index_bytes[i], ec);
+      if (ec) return Result<void>::err("failed to trim index files");
+      idx_streams[i]->open(path, std::ios::app);
+    } else {
+      idx_streams[i]->open(path, std::ios::trunc);
     }
+    if (!*idx_streams[i]) return Result<void>::err("failed to rebuild index files");
   }
 
-  if (std::filesystem::exists(edge_path)) {
-    std::ifstream in(edge_path, std::ios::binary);
-    while (in.good()) {
-      std::uint32_t tag = 0;
-      if (!read_u32(in, &tag)) break;
-      if (tag != kEdgeTag) return Result<void>::err("invalid edge segment tag");
-
-      std::uint32_t name_len = 0;
-      std::uint32_t role_len = 0;
-      std::uint32_t props_len = 0;
-      std::uint64_t created = 0;
-      if (!read_u32(in, &name_len)) break;
-      if (!read_u32(in, &role_len)) break;
-      if (!read_u32(in, &props_len)) break;
-      if (!read_u64(in, &created)) break;
-
-      EdgeRecord rec;
-      if (!read_exact(in, rec.from.id.bytes.data(), rec.from.id.bytes.size())) break;
-      std::uint64_t from_ver = 0;
-      if (!read_u64(in, &from_ver)) break;
-      rec.from.ver = Version{from_ver};
-
-      if (!read_exact(in, rec.to.id.bytes.data(), rec.to.id.bytes.size())) break;
-      std::uint64_t to_ver = 0;
-      if (!read_u64(in, &to_ver)) break;
-      rec.to.ver = Version{to_ver};
-
-      rec.created_at_unix_ms = created;
-      rec.name.resize(name_len);
-      rec.role.resize(role_len);
-      rec.props_cbor.resize(props_len);
-
-      if (name_len > 0 && !read_exact(in, rec.name.data(), name_len)) break;
-      if (role_len > 0 && !read_exact(in, rec.role.data(), role_len)) break;
-      if (props_len > 0 && !read_exact(in, rec.props_cbor.data(), props_len)) break;
-
-      index_edge(rec);
+  // Object and edge indexes are disjoint members, so the two merges run side by side.
+  auto edgeMergeF = std::async(std::launch::async, [&]() {
+    const auto records = (ckpt ? ckpt->edges.size() : 0) + edges.tail.records;
+    edges_from_.reserve(edges_from_.size() + records);
+    edges_to_.reserve(edges_to_.size() + records);
+    if (ckpt) {
+      for (const auto& at : ckpt->edges) index_edge(at.key, at.offset);
     }
+    for (const auto& chunk : edges.tail.chunks) {
+      index_edges(chunk);
+      write_lines(idx_edges_from_, chunk.from_lines);
+      write_lines(idx_edges_to_, chunk.to_lines);
+    }
+  });
+
+  const auto object_records = (ckpt ? ckpt->objects.size() : 0) + objects.tail.records;
+  objects_by_ref_.reserve(objects_by_ref_.size() + object_records);
+  latest_by_id_.reserve(latest_by_id_.size() + object_records);
+  if (ckpt) {
+    for (const auto& at : ckpt->objects) index_object(at.key, at.offset);
+  }
+  for (const auto& chunk : objects.tail.chunks) {
+    index_objects(chunk);
+    write_lines(idx_objects_by_id_, chunk.by_id_lines);
+    write_lines(idx_objects_by_type_, chunk.by_type_lines);
+  }
+  edgeMergeF.get();
+  timings_.rebuild_us = elapsed_ns(rebuild_start) / 1000;
+
+  // Drop a partially written tail so new frames are appended on a frame boundary.
+  // Readers leave it alone: it may be a frame the writer is still appending.
+  std::error_code ec;
+  if (objects.end < object_seg_bytes_) {
+    if (!read_only()) std::filesystem::resize_file(segments_dir / "objects.seg", objects.end, ec);
+    if (ec) return Result<void>::err("failed to trim objects.seg");
+    object_seg_bytes_ = objects.end;
+  }
+  if (edges.end < edge_seg_bytes_) {
+    if (!read_only()) std::filesystem::resize_file(segments_dir / "edges.seg", edges.end, ec);
+    if (ec) return Result<void>::err("failed to trim edges.seg");
+    edge_seg_bytes_ = edges.end;
   }
+  auto r = open_readers();
+  if (!r) return r;
+
+  checkpoint_usage_ = CheckpointUsage{};
+  checkpoint_usage_.loaded = ckpt.has_value();
+  checkpoint_usage_.covered_bytes = ckpt ? ckpt->mark.segment_bytes() : 0;
+  checkpoint_usage_.replayed_bytes = object_seg_bytes_ + edge_seg_bytes_ - checkpoint_usage_.covered_bytes;
+  last_checkpoint_bytes_ = checkpoint_usage_.covered_bytes;
 
   return Result<void>::ok();
 }
 
-Result<void> SqliteStore::rebuild_indexes() {
+Result<void> SqliteStore::checkpoint() {
+  if (!open_) return Result<void>::err("store not open");
   if (memory_only_) return Result<void>::ok();
-  const auto base = base_dir();
-  const auto indexes_dir = std::filesystem::path(base) / "indexes";
-
-  idx_objects_by_id_.close();
-  idx_objects_by_type_.close();
-  idx_edges_from_.close();
-  idx_edges_to_.close();
-
-  idx_objects_by_id_.open(indexes_dir / "objects_by_id.idx", std::ios::trunc);
-  idx_objects_by_type_.open(indexes_dir / "objects_by_type.idx", std::ios::trunc);
-  idx_edges_from_.open(indexes_dir / "edges_from.idx", std::ios::trunc);
-  idx_edges_to_.open(indexes_dir / "edges_to.idx", std::ios::trunc);
+  if (read_only()) return Result<void>::err("store opened read-only");
+  join_checkpoint();
+  const auto mark = checkpoint_mark();
+  auto r = index_checkpoint::write(base_dir(), mark);
+  if (!r) return r;
+  last_checkpoint_bytes_ = mark.segment_bytes();
+  ++checkpoints_written_;
+  return Result<void>::ok();
+}
 
-  if (!idx_objects_by_id_ || !idx_objects_by_type_ || !idx_edges_from_ || !idx_edges_to_) {
-    return Result<void>::err("failed to rebuild index files");
+index_checkpoint::CheckpointMark SqliteStore::checkpoint_mark() {
+  index_checkpoint::CheckpointMark mark;
+  mark.object_bytes = object_seg_bytes_;
+  mark.edge_bytes = edge_seg_bytes_;
+  const std::array<std::ofstream*, index_checkpoint::kIndexFileCount> idx_streams = {
+      &idx_objects_by_id_, &idx_objects_by_type_, &idx_edges_from_, &idx_edges_to_};
+  for (std::size_t i = 0; i < idx_streams.size(); ++i) {
+    idx_streams[i]->flush();
+    const auto pos = idx_streams[i]->tellp();
+    mark.index_bytes[i] = pos < 0 ? 0 : static_cast<std::uint64_t>(pos);
+  }
+  return mark;
+}
+
+// Starts a background checkpoint once the segments have grown by the configured
+// interval. The writer only captures the mark; the checkpoint thread walks the
+// segment bytes added since the previous checkpoint on its own, so appends never
+// wait on it.
+void SqliteStore::maybe_checkpoint() {
+  if (memory_only_ || read_only() || cfg_.checkpoint_interval_bytes == 0) return;
+  const auto bytes = object_seg_bytes_ + edge_seg_bytes_;
+  if (bytes - last_checkpoint_bytes_ < cfg_.checkpoint_interval_bytes) return;
+  if (checkpoint_running_.load()) return;
+  join_checkpoint();
+
+  const auto mark = checkpoint_mark();
+  last_checkpoint_bytes_ = bytes;
+  checkpoint_running_ = true;
+  checkpoint_thread_ = std::thread([this, dir = std::filesystem::path(base_dir()), mark]() {
+    if (index_checkpoint::write(dir, mark)) ++checkpoints_written_;
+    checkpoint_running_ = false;
+  });
+}
+
+// Frames are only consumed once complete, so a reader racing the writer simply
+// picks up a half-written frame on a later refresh.
+Result<std::uint64_t> SqliteStore::refresh() {
+  if (!open_) return Result<std::uint64_t>::err("store not open");
+  if (!read_only()) return Result<std::uint64_t>::ok(0);
+
+  const auto segments_dir = std::filesystem::path(base_dir()) / "segments";
+  SegmentParse<segment_loader::ObjectChunk> objects;
+  SegmentParse<segment_loader::EdgeChunk> edges;
+  auto r = parse_segment_tail(segments_dir / "objects.seg", object_seg_bytes_,
+                              &segment_loader::load_objects, &objects);
+  if (!r) return Result<std::uint64_t>::err(r.error->message);
+  r = parse_segment_tail(segments_dir / "edges.seg", edge_seg_bytes_,
+                         &segment_loader::load_edges, &edges);
+  if (!r) return Result<std::uint64_t>::err(r.error->message);
+
+  for (const auto& chunk : objects.tail.chunks) index_objects(chunk);
+  for (const auto& chunk : edges.tail.chunks) index_edges(chunk);
+  object_seg_bytes_ = objects.end;
+  edge_seg_bytes_ = edges.end;
+  const auto records = objects.tail.records + edges.tail.records;
+  if (records > 0 && !subscribers_.empty()) {
+    for (const auto& chunk : objects.tail.chunks) {
+      for (const auto& rec : chunk.records) notify(ChangeEvent{ChangeKind::ObjectCreated, &rec, nullptr, {}});
+    }
+    for (const auto& chunk : edges.tail.chunks) {
+      for (const auto& rec : chunk.records) notify(ChangeEvent{ChangeKind::EdgeAdded, nullptr, &rec, {}});
+    }
+    notify_commit();
   }
+  return Result<std::uint64_t>::ok(records);
+}
+
+Result<ChangeCursor> SqliteStore::read_changes(ChangeCursor from, const ChangeFilter& filter,
+                                               const ChangeListener& listener) const {
+  if (!open_) return Result<ChangeCursor>::err("store not open");
+  if (memory_only_) return Result<ChangeCursor>::err("in-memory stores keep no change history");
+
+  const auto segments_dir = std::filesystem::path(base_dir()) / "segments";
+  SegmentParse<segment_loader::ObjectChunk> objects;
+  SegmentParse<segment_loader::EdgeChunk> edges;
+  auto r = parse_segment_tail(segments_dir / "objects.seg", from.object_bytes,
+                              &segment_loader::load_objects, &objects);
+  if (!r) return Result<ChangeCursor>::err(r.error->message);
+  r = parse_segment_tail(segments_dir / "edges.seg", from.edge_bytes,
+                         &segment_loader::load_edges, &edges);
+  if (!r) return Result<ChangeCursor>::err(r.error->message);
+
+  auto deliver = [&](const ChangeEvent& event) {
+    if (filter.accepts(event)) listener(event);
+  };
+  for (const auto& chunk : objects.tail.chunks) {
+    for (const auto& rec : chunk.records) deliver(ChangeEvent{ChangeKind::ObjectCreated, &rec, nullptr, {}});
+  }
+  for (const auto& chunk : edges.tail.chunks) {
+    for (const auto& rec : chunk.records) deliver(ChangeEvent{ChangeKind::EdgeAdded, nullptr, &rec, {}});
+  }
+  const ChangeCursor reached{objects.end, edges.end};
+  deliver(ChangeEvent{ChangeKind::Commit, nullptr, nullptr, reached});
+  return Result<ChangeCursor>::ok(reached);
+}
 
-  const auto segments_dir = std::filesystem::path(base) / "segments";
-  const auto obj_path = segments_dir / "objects.seg";
-  const auto edge_path = segments_dir / "edges.seg";
-
-  if (std::filesystem::exists(obj_path)) {
-    std::ifstream in(obj_path, std::ios::binary);
-    while (in.good()) {
-      auto start = in.tellg();
-      if (start < 0) break;
-      std::uint32_t tag = 0;
-      if (!read_u32(in, &tag)) break;
-      if (tag != kObjTag) break;
-
-      std::uint32_t payload_size = 0;
-      std::uint64_t ver = 0;
-      std::uint64_t type = 0;
-      std::uint64_t created = 0;
-      if (!read_u32(in, &payload_size)) break;
-      if (!read_u64(in, &ver)) break;
-      if (!read_u64(in, &type)) break;
-      if (!read_u64(in, &created)) break;
-
-      ObjectID id{};
-      ObjectID def{};
-      if (!read_exact(in, id.bytes.data(), id.bytes.size())) break;
-      if (!read_exact(in, def.bytes.data(), def.bytes.size())) break;
-      if (payload_size > 0) {
-        in.seekg(static_cast<std::streamoff>(payload_size), std::ios::cur);
-        if (!in.good()) break;
-      }
+SubscriptionID SqliteStore::subscribe(ChangeFilter filter, ChangeListener listener) {
+  auto sub = std::make_shared<Subscriber>();
+  sub->id = next_subscription_++;
+  sub->filter = std::move(filter);
+  sub->listener = std::move(listener);
+  subscribers_.push_back(std::move(sub));
+  return subscribers_.back()->id;
+}
 
-      const auto offset = static_cast<std::uint64_t>(start);
+void SqliteStore::unsubscribe(SubscriptionID id) {
+  subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                    [&](const auto& sub) { return sub->id == id; }),
+                     subscribers_.end());
+}
 
-      append_index(idx_objects_by_id_, key_object_id(id, ver), offset);
-      append_index(idx_objects_by_type_, key_type_id(TypeID{type}, id, ver), offset);
-    }
+void SqliteStore::notify(const ChangeEvent& event) {
+  if (subscribers_.empty()) return;
+  const auto snapshot = subscribers_;
+  for (const auto& sub : snapshot) {
+    if (sub->filter.accepts(event)) sub->listener(event);
   }
+}
 
-  if (std::filesystem::exists(edge_path)) {
-    std::ifstream in(edge_path, std::ios::binary);
-    while (in.good()) {
-      auto start = in.tellg();
-      if (start < 0) break;
-      std::uint32_t tag = 0;
-      if (!read_u32(in, &tag)) break;
-      if (tag != kEdgeTag) break;
-
-      std::uint32_t name_len = 0;
-      std::uint32_t role_len = 0;
-      std::uint32_t props_len = 0;
-      std::uint64_t created = 0;
-      if (!read_u32(in, &name_len)) break;
-      if (!read_u32(in, &role_len)) break;
-      if (!read_u32(in, &props_len)) break;
-      if (!read_u64(in, &created)) break;
-
-      EdgeRecord rec;
-      if (!read_exact(in, rec.from.id.bytes.data(), rec.from.id.bytes.size())) break;
-      std::uint64_t from_ver = 0;
-      if (!read_u64(in, &from_ver)) break;
-      rec.from.ver = Version{from_ver};
-
-      if (!read_exact(in, rec.to.id.bytes.data(), rec.to.id.bytes.size())) break;
-      std::uint64_t to_ver = 0;
-      if (!read_u64(in, &to_ver)) break;
-      rec.to.ver = Version{to_ver};
-
-      rec.name.resize(name_len);
-      rec.role.resize(role_len);
-      rec.props_cbor.resize(props_len);
-
-      if (name_len > 0 && !read_exact(in, rec.name.data(), name_len)) break;
-      if (role_len > 0 && !read_exact(in, rec.role.data(), role_len)) break;
-      if (props_len > 0 && !read_exact(in, rec.props_cbor.data(), props_len)) break;
-
-      const auto offset = static_cast<std::uint64_t>(start);
-
-      append_index(idx_edges_from_, key_edge_from(rec), offset);
-      append_index(idx_edges_to_, key_edge_to(rec), offset);
-    }
+bool ChangeFilter::accepts(const ChangeEvent& event) const {
+  switch (event.kind) {
+    case ChangeKind::ObjectCreated:
+      return objects && (!type || event.object->type == *type);
+    case ChangeKind::EdgeAdded:
+      return edges && (!edge_name || event.edge->name == *edge_name);
+    case ChangeKind::Commit:
+      return commits;
   }
+  return false;
+}
 
+Result<void> SqliteStore::require_writable() const {
+  if (read_only()) return Result<void>::err("store opened read-only");
+  if (cfg_.replica) return Result<void>::err("store is a replication follower");
   return Result<void>::ok();
 }
 
+void SqliteStore::join_checkpoint() {
+  if (checkpoint_thread_.joinable()) checkpoint_thread_.join();
+}
+
 } // namespace referee
@@ -1,15 +1,24 @@
 #pragma once
 
 #include "referee/referee.h"
+#include "referee_sqlite/change_feed.h"
+#include "referee_sqlite/index_checkpoint.h"
+#include "referee_sqlite/segment_loader.h"
+#include "referee_sqlite/store_lock.h"
+#include "referee_sqlite/store_stats.h"
 
 #ifdef fail
 #undef fail
 #endif
 
+#include <atomic>
 #include <cstdint>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -19,6 +28,30 @@ struct SqliteConfig {
   std::string filename;     // base path for segment store (":memory:" for in-memory)
   bool enable_wal{true};
   bool enable_foreign_keys{true};
+  std::uint64_t checkpoint_interval_bytes{64ULL << 20}; // segment growth between background checkpoints; 0 disables
+  bool read_only{false};    // shared reader: maps the segments, takes no writer lock, never writes
+  bool replica{false};      // follower: local writes refused, records arrive via apply_replicated()
+};
+
+// Change check for caches layered over list_by_type(): record count of a type,
+// including uncommitted ones, and the most recently added record.
+struct TypeMark {
+  std::uint64_t count{0};
+  ObjectRef last{};
+
+  friend bool operator==(const TypeMark& a, const TypeMark& b) noexcept {
+    return a.count == b.count && a.last == b.last;
+  }
+};
+
+// Checks a payload before create_object* writes it; an error refuses the write.
+// Records arriving through apply_replicated() or loaded from segments are not checked.
+using ObjectValidator =
+    std::function<Result<void>(TypeID type, ObjectID definition_id, const Bytes& payload_cbor)>;
+
+struct AppliedFrames {
+  std::uint64_t records{0};
+  std::uint64_t newest_created_unix_ms{0};
 };
 
 class SqliteStore {
@@ -44,9 +77,19 @@ public:
   Result<ObjectRecord> create_object(TypeID type, ObjectID definition_id, const Bytes& payload_cbor);
   Result<ObjectRecord> create_object_with_id(ObjectID object_id, TypeID type, ObjectID definition_id,
                                              const Bytes& payload_cbor);
+  // Next version of the object at `prior`, which must still be its latest version.
+  // The type carries over.
+  Result<ObjectRecord> create_version(ObjectRef prior, ObjectID definition_id, const Bytes& payload_cbor);
   Result<std::optional<ObjectRecord>> get_object(ObjectRef ref);
   Result<std::optional<ObjectRecord>> get_latest(ObjectID id);
   Result<std::vector<ObjectRecord>> list_by_type(TypeID type);
+  // Up to `limit` committed records of `type` in append order, starting at position
+  // `from` (positions are stable: records are only ever appended).
+  Result<std::vector<ObjectRecord>> list_by_type_from(TypeID type, std::uint64_t from, std::size_t limit) const;
+  TypeMark type_mark(TypeID type) const;
+
+  // Optional; an empty validator turns checking off.
+  void set_object_validator(ObjectValidator validator) { validator_ = std::move(validator); }
 
   // Edge operations
   Result<void> add_edge(ObjectRef from, ObjectRef to, std::string name, std::string role,
@@ -58,6 +101,38 @@ public:
                                            std::optional<std::string> name_filter = std::nullopt,
                                            std::optional<std::string> role_filter = std::nullopt);
 
+  // Change feed: listeners see committed objects and edges that pass their filter,
+  // including records picked up by refresh() and apply_replicated().
+  SubscriptionID subscribe(ChangeFilter filter, ChangeListener listener);
+  void unsubscribe(SubscriptionID id);
+  ChangeCursor change_cursor() const { return ChangeCursor{object_seg_bytes_, edge_seg_bytes_}; }
+  // Catch-up for segment stores: delivers the records written after `from` (objects,
+  // then edges) and a final Commit, and returns the cursor reached.
+  Result<ChangeCursor> read_changes(ChangeCursor from, const ChangeFilter& filter,
+                                    const ChangeListener& listener) const;
+
+  // Runtime accounting: counts, segment sizes, index footprint, timings, latencies.
+  Result<StoreStats> stats() const;
+
+  // Write an index checkpoint covering everything appended so far, waiting for it.
+  Result<void> checkpoint();
+
+  // Read-only handles: index records the writer appended since open or the last
+  // refresh, found by comparing segment lengths. Returns the number of new records.
+  Result<std::uint64_t> refresh();
+  bool read_only() const { return cfg_.read_only && !memory_only_; }
+
+  // Replica handles: append complete frames copied verbatim from a leader's segments
+  // and index them. Each buffer must start where this store's segment ends; a
+  // trailing partial frame is ignored.
+  Result<AppliedFrames> apply_replicated(const std::uint8_t* objects, std::uint64_t object_bytes,
+                                         const std::uint8_t* edges, std::uint64_t edge_bytes);
+  std::uint64_t object_segment_bytes() const { return object_seg_bytes_; }
+  std::uint64_t edge_segment_bytes() const { return edge_seg_bytes_; }
+
+  // Segment store directory backing `filename` ("<filename>.segments").
+  static std::string store_dir_from_filename(std::string_view filename);
+
 private:
   struct ObjectRefKey {
     ObjectID id{};
@@ -82,22 +157,46 @@ private:
     }
   };
 
+  // A committed object as the per-type index holds it: enough to order and count
+  // records without reading their frames.
+  struct ObjectEntry {
+    ObjectRef ref{};
+    std::uint64_t created_at_unix_ms{0};
+    std::uint64_t offset{0};
+    std::uint32_t payload_bytes{0};
+  };
+
   Result<void> load_segments();
-  Result<void> rebuild_indexes();
-  Result<void> append_object(const ObjectRecord& rec);
-  Result<void> append_edge(const EdgeRecord& rec);
-  void index_object(const ObjectRecord& rec);
-  void index_edge(const EdgeRecord& rec);
+  Result<void> require_writable() const;
+  Result<ObjectRecord> write_object(ObjectRef ref, TypeID type, ObjectID definition_id,
+                                    const Bytes& payload_cbor);
+  index_checkpoint::CheckpointMark checkpoint_mark();
+  void maybe_checkpoint();
+  void join_checkpoint();
+  Result<std::uint64_t> append_object(const ObjectRecord& rec);
+  Result<std::uint64_t> append_edge(const EdgeRecord& rec);
+  Result<void> persist_object(const ObjectRecord& rec);
+  Result<void> persist_edge(const EdgeRecord& rec);
+  void index_object(const segment_format::ObjectKey& key, std::uint64_t offset);
+  void index_edge(const segment_format::EdgeKey& key, std::uint64_t offset);
+  void index_objects(const segment_loader::ObjectChunk& chunk);
+  void index_edges(const segment_loader::EdgeChunk& chunk);
+  Result<void> open_readers();
+  Result<ObjectRecord> read_object(std::uint64_t offset) const;
+  Result<EdgeRecord> read_edge(std::uint64_t offset) const;
+  void notify(const ChangeEvent& event);
+  void notify_commit() { notify(ChangeEvent{ChangeKind::Commit, nullptr, nullptr, change_cursor()}); }
 
   std::string base_dir() const;
-  static std::string store_dir_from_filename(std::string_view filename);
 
 private:
   SqliteConfig cfg_;
+  ObjectValidator validator_;
   bool open_{false};
   bool memory_only_{false};
   bool in_txn_{false};
 
+  WriterLock writer_lock_;
   std::ofstream object_seg_;
   std::ofstream edge_seg_;
   std::ofstream idx_objects_by_id_;
@@ -108,11 +207,43 @@ private:
   std::vector<ObjectRecord> pending_objects_;
   std::vector<EdgeRecord> pending_edges_;
 
-  std::unordered_map<ObjectRefKey, ObjectRecord, ObjectRefKeyHash> objects_by_ref_;
-  std::unordered_map<ObjectID, ObjectRecord, ObjectIDHash> latest_by_id_;
-  std::unordered_map<TypeID, std::vector<ObjectRecord>, TypeIDHash> objects_by_type_;
-  std::unordered_map<ObjectRefKey, std::vector<EdgeRecord>, ObjectRefKeyHash> edges_from_;
-  std::unordered_map<ObjectRefKey, std::vector<EdgeRecord>, ObjectRefKeyHash> edges_to_;
+  struct Subscriber {
+    SubscriptionID id{0};
+    ChangeFilter filter;
+    ChangeListener listener;
+  };
+  // Shared so a listener can (un)subscribe while being called.
+  std::vector<std::shared_ptr<const Subscriber>> subscribers_;
+  SubscriptionID next_subscription_{1};
+
+  // The indexes map keys to segment offsets; payloads, definition ids and edge
+  // names stay in the segment and are decoded when a lookup returns the record.
+  std::unordered_map<ObjectRefKey, std::uint64_t, ObjectRefKeyHash> objects_by_ref_;
+  std::unordered_map<ObjectID, std::uint64_t, ObjectIDHash> latest_by_id_;
+  std::unordered_map<TypeID, std::vector<ObjectEntry>, TypeIDHash> objects_by_type_;
+  std::unordered_map<ObjectRefKey, std::vector<std::uint64_t>, ObjectRefKeyHash> edges_from_;
+  std::unordered_map<ObjectRefKey, std::vector<std::uint64_t>, ObjectRefKeyHash> edges_to_;
+  // Frame sources for those offsets: the segment files, or for ":memory:" stores
+  // buffers holding the frames the files would.
+  mutable segment_loader::SegmentReader object_reader_;
+  mutable segment_loader::SegmentReader edge_reader_;
+  Bytes object_frames_;
+  Bytes edge_frames_;
+
+  std::uint64_t object_seg_bytes_{0};
+  std::uint64_t edge_seg_bytes_{0};
+  std::uint64_t edge_count_{0};
+  StoreTimings timings_{};
+  LatencyHistogram object_append_latency_{};
+  LatencyHistogram edge_append_latency_{};
+  HitCounter object_lookups_{};
+  HitCounter latest_lookups_{};
+
+  CheckpointUsage checkpoint_usage_{};
+  std::uint64_t last_checkpoint_bytes_{0};
+  std::thread checkpoint_thread_;
+  std::atomic<bool> checkpoint_running_{false};
+  std::atomic<std::uint64_t> checkpoints_written_{0};
 };
 
 } // namespace referee
@@ -0,0 +1,54 @@
+#include "referee_sqlite/store_lock.h"
+
+#include <cerrno>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace referee {
+
+WriterLock::~WriterLock() { release(); }
+
+WriterLock::WriterLock(WriterLock&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+
+WriterLock& WriterLock::operator=(WriterLock&& other) noexcept {
+  if (this != &other) {
+    release();
+    fd_ = other.fd_;
+    other.fd_ = -1;
+  }
+  return *this;
+}
+
+void WriterLock::release() {
+  if (fd_ < 0) return;
+  ::flock(fd_, LOCK_UN);
+  ::close(fd_);
+  fd_ = -1;
+}
+
+Result<WriterLock> WriterLock::acquire(const std::filesystem::path& store_dir) {
+  const auto path = store_dir / "LOCK";
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) return Result<WriterLock>::err("failed to open store lock");
+  if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    const bool busy = (errno == EWOULDBLOCK);
+    ::close(fd);
+    return Result<WriterLock>::err(busy ? "store is locked by another writer"
+                                        : "failed to lock store");
+  }
+
+  // Record the holder for diagnostics; the lock itself is the flock.
+  const auto pid = std::to_string(::getpid()) + "\n";
+  if (::ftruncate(fd, 0) == 0 && ::pwrite(fd, pid.data(), pid.size(), 0) < 0) {
+    // Best effort only.
+  }
+
+  WriterLock out;
+  out.fd_ = fd;
+  return Result<WriterLock>::ok(std::move(out));
+}
+
+} // namespace referee
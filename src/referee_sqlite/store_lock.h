@@ -0,0 +1,31 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <filesystem>
+
+namespace referee {
+
+// Advisory single-writer lock on <store>/LOCK (flock). Held for the lifetime of a
+// writable SqliteStore; read-only handles never take it.
+class WriterLock {
+public:
+  WriterLock() = default;
+  ~WriterLock();
+
+  WriterLock(WriterLock&& other) noexcept;
+  WriterLock& operator=(WriterLock&& other) noexcept;
+  WriterLock(const WriterLock&) = delete;
+  WriterLock& operator=(const WriterLock&) = delete;
+
+  // Fails immediately rather than waiting if another handle holds the lock.
+  static Result<WriterLock> acquire(const std::filesystem::path& store_dir);
+
+  bool held() const { return fd_ >= 0; }
+  void release();
+
+private:
+  int fd_{-1};
+};
+
+} // namespace referee
@@ -0,0 +1,130 @@
+#include "referee_sqlite/sqlite_store.h"
+
+#include <algorithm>
+#include <bit>
+#include <map>
+
+namespace referee {
+namespace {
+
+// Bucket array plus one node per element (value, next pointer, cached hash).
+template <typename Map>
+std::uint64_t table_bytes(const Map& map) {
+  const std::uint64_t node = sizeof(typename Map::value_type) + sizeof(void*) + sizeof(std::size_t);
+  return map.bucket_count() * sizeof(void*) + map.size() * node;
+}
+
+template <typename Map>
+IndexFootprint map_footprint(std::string name, const Map& map) {
+  IndexFootprint out;
+  out.name = std::move(name);
+  out.entries = map.size();
+  out.bytes = table_bytes(map);
+  return out;
+}
+
+template <typename Map>
+IndexFootprint list_footprint(std::string name, const Map& map) {
+  using Entry = typename Map::mapped_type::value_type;
+  IndexFootprint out;
+  out.name = std::move(name);
+  out.bytes = table_bytes(map);
+  for (const auto& kv : map) {
+    out.entries += kv.second.size();
+    out.bytes += kv.second.capacity() * sizeof(Entry);
+  }
+  return out;
+}
+
+} // namespace
+
+void LatencyHistogram::record(std::uint64_t ns) {
+  std::size_t bucket = ns == 0 ? 0 : static_cast<std::size_t>(std::bit_width(ns) - 1);
+  if (bucket >= kBuckets) bucket = kBuckets - 1;
+  ++buckets[bucket];
+  ++count;
+  total_ns += ns;
+  if (ns > max_ns) max_ns = ns;
+}
+
+double LatencyHistogram::mean_ns() const {
+  return count == 0 ? 0.0 : static_cast<double>(total_ns) / static_cast<double>(count);
+}
+
+std::uint64_t LatencyHistogram::percentile_ns(double p) const {
+  if (count == 0) return 0;
+  p = std::clamp(p, 0.0, 1.0);
+  auto rank = static_cast<std::uint64_t>(p * static_cast<double>(count));
+  if (rank == 0) rank = 1;
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) return std::min<std::uint64_t>((std::uint64_t{2} << i) - 1, max_ns);
+  }
+  return max_ns;
+}
+
+std::uint64_t StoreStats::index_bytes() const {
+  std::uint64_t total = 0;
+  for (const auto& index : indexes) total += index.bytes;
+  return total;
+}
+
+Result<StoreStats> SqliteStore::stats() const {
+  if (!open_) return Result<StoreStats>::err("store not open");
+
+  StoreStats out;
+  out.object_count = objects_by_ref_.size();
+  out.edge_count = edge_count_;
+
+  out.objects_by_type.reserve(objects_by_type_.size());
+  for (const auto& kv : objects_by_type_) {
+    TypeUsage usage;
+    usage.type = kv.first;
+    usage.objects = kv.second.size();
+    for (const auto& entry : kv.second) usage.payload_bytes += entry.payload_bytes;
+    out.objects_by_type.push_back(usage);
+  }
+  std::sort(out.objects_by_type.begin(), out.objects_by_type.end(),
+            [](const TypeUsage& a, const TypeUsage& b) {
+              if (a.objects != b.objects) return a.objects > b.objects;
+              return a.type.v < b.type.v;
+            });
+
+  // Edge names live only in the frames, so this reads every edge back.
+  std::map<std::string, EdgeUsage> by_name;
+  for (const auto& kv : edges_from_) {
+    for (auto offset : kv.second) {
+      auto edgeR = read_edge(offset);
+      if (!edgeR) return Result<StoreStats>::err(edgeR.error->message);
+      const auto& edge = edgeR.value.value();
+      auto& usage = by_name[edge.name];
+      usage.name = edge.name;
+      ++usage.edges;
+      usage.props_bytes += edge.props_cbor.size();
+    }
+  }
+  out.edges_by_name.reserve(by_name.size());
+  for (auto& kv : by_name) out.edges_by_name.push_back(std::move(kv.second));
+
+  out.segments.push_back(SegmentUsage{"objects.seg", object_seg_bytes_, out.object_count});
+  out.segments.push_back(SegmentUsage{"edges.seg", edge_seg_bytes_, out.edge_count});
+
+  out.indexes.push_back(map_footprint("objects_by_ref", objects_by_ref_));
+  out.indexes.push_back(map_footprint("latest_by_id", latest_by_id_));
+  out.indexes.push_back(list_footprint("objects_by_type", objects_by_type_));
+  out.indexes.push_back(list_footprint("edges_from", edges_from_));
+  out.indexes.push_back(list_footprint("edges_to", edges_to_));
+
+  out.timings = timings_;
+  out.checkpoint = checkpoint_usage_;
+  out.checkpoint.written = checkpoints_written_.load();
+  out.object_appends = object_append_latency_;
+  out.edge_appends = edge_append_latency_;
+  out.object_lookups = object_lookups_;
+  out.latest_lookups = latest_lookups_;
+
+  return Result<StoreStats>::ok(std::move(out));
+}
+
+} // namespace referee
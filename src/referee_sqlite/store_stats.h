@@ -0,0 +1,97 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace referee {
+
+// Log2-bucketed latency histogram. Bucket i counts samples in [2^i, 2^(i+1)) ns;
+// bucket 0 also absorbs sub-nanosecond samples.
+struct LatencyHistogram {
+  static constexpr std::size_t kBuckets = 40;
+
+  std::array<std::uint64_t, kBuckets> buckets{};
+  std::uint64_t count{0};
+  std::uint64_t total_ns{0};
+  std::uint64_t max_ns{0};
+
+  void record(std::uint64_t ns);
+  double mean_ns() const;
+  // Upper bound of the bucket holding the p-th percentile sample (p in [0, 1]).
+  std::uint64_t percentile_ns(double p) const;
+};
+
+struct HitCounter {
+  std::uint64_t hits{0};
+  std::uint64_t misses{0};
+
+  double hit_rate() const {
+    const auto total = hits + misses;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+  }
+};
+
+struct TypeUsage {
+  TypeID type{};
+  std::uint64_t objects{0};
+  std::uint64_t payload_bytes{0};
+};
+
+struct EdgeUsage {
+  std::string name;
+  std::uint64_t edges{0};
+  std::uint64_t props_bytes{0};
+};
+
+struct SegmentUsage {
+  std::string name;
+  std::uint64_t bytes{0};
+  std::uint64_t records{0};
+};
+
+// Approximate heap footprint of one in-memory index (table + nodes + entry lists).
+struct IndexFootprint {
+  std::string name;
+  std::uint64_t entries{0};
+  std::uint64_t bytes{0};
+
+  double bytes_per_record() const {
+    return entries == 0 ? 0.0 : static_cast<double>(bytes) / static_cast<double>(entries);
+  }
+};
+
+struct StoreTimings {
+  std::uint64_t open_us{0};
+  std::uint64_t load_us{0};
+  std::uint64_t rebuild_us{0};
+};
+
+struct CheckpointUsage {
+  bool loaded{false};              // open() started from a checkpoint
+  std::uint64_t covered_bytes{0};  // segment bytes indexed from its keys, not read
+  std::uint64_t replayed_bytes{0}; // segment tail walked and re-indexed after it
+  std::uint64_t written{0};        // checkpoints written by this handle
+};
+
+struct StoreStats {
+  std::uint64_t object_count{0};
+  std::uint64_t edge_count{0};
+  std::vector<TypeUsage> objects_by_type;
+  std::vector<EdgeUsage> edges_by_name;
+  std::vector<SegmentUsage> segments;
+  std::vector<IndexFootprint> indexes;
+  StoreTimings timings{};
+  CheckpointUsage checkpoint{};
+  LatencyHistogram object_appends{};
+  LatencyHistogram edge_appends{};
+  HitCounter object_lookups{};
+  HitCounter latest_lookups{};
+
+  std::uint64_t index_bytes() const;
+};
+
+} // namespace referee
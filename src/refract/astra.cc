@@ -0,0 +1,334 @@
+#include "refract/astra.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define IRIS_ASTRA_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace iris::refract {
+
+namespace {
+
+constexpr std::uint8_t kMagic[4] = { 'A', 'S', 'T', 'R' };
+constexpr std::uint8_t kVersion = 1;
+constexpr std::size_t kFixedHeader = 8;
+
+void put_u64(std::uint8_t* p, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+std::uint64_t get_u64(const std::uint8_t* p) {
+  std::uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+  return v;
+}
+
+void put_doubles(std::uint8_t* p, const double* values, std::size_t n) {
+  if constexpr (std::endian::native == std::endian::little) {
+    if (n != 0) std::memcpy(p, values, n * sizeof(double));
+  } else {
+    for (std::size_t i = 0; i < n; ++i) put_u64(p + 8 * i, std::bit_cast<std::uint64_t>(values[i]));
+  }
+}
+
+void get_doubles(const std::uint8_t* p, double* values, std::size_t n) {
+  if constexpr (std::endian::native == std::endian::little) {
+    if (n != 0) std::memcpy(values, p, n * sizeof(double));
+  } else {
+    for (std::size_t i = 0; i < n; ++i) values[i] = std::bit_cast<double>(get_u64(p + 8 * i));
+  }
+}
+
+// Head of a definite-length CBOR byte string.
+void put_bytes_head(referee::Bytes& out, std::uint64_t size) {
+  constexpr std::uint8_t major = 2 << 5;
+  if (size < 24) {
+    out.push_back(static_cast<std::uint8_t>(major | size));
+    return;
+  }
+  int width = size <= 0xFF ? 1 : size <= 0xFFFF ? 2 : size <= 0xFFFFFFFFULL ? 4 : 8;
+  out.push_back(static_cast<std::uint8_t>(major | (width == 1 ? 24 : width == 2 ? 25 : width == 4 ? 26 : 27)));
+  for (int i = width - 1; i >= 0; --i) out.push_back(static_cast<std::uint8_t>(size >> (8 * i)));
+}
+
+bool get_bytes_head(const referee::Bytes& in, std::size_t* offset, std::uint64_t* size) {
+  if (in.empty() || (in[0] >> 5) != 2) return false;
+  const std::uint8_t info = in[0] & 0x1F;
+  if (info < 24) {
+    *offset = 1;
+    *size = info;
+    return true;
+  }
+  if (info > 27) return false;
+  const std::size_t width = std::size_t{1} << (info - 24);
+  if (in.size() < 1 + width) return false;
+  std::uint64_t v = 0;
+  for (std::size_t i = 0; i < width; ++i) v = (v << 8) | in[1 + i];
+  *offset = 1 + width;
+  *size = v;
+  return true;
+}
+
+template <AstraElementwise Op>
+void elementwise_scalar(const double* x, const double* y, double* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if constexpr (Op == AstraElementwise::Add) out[i] = x[i] + y[i];
+    if constexpr (Op == AstraElementwise::Sub) out[i] = x[i] - y[i];
+    if constexpr (Op == AstraElementwise::Mul) out[i] = x[i] * y[i];
+    if constexpr (Op == AstraElementwise::Div) out[i] = x[i] / y[i];
+  }
+}
+
+#if defined(IRIS_ASTRA_AVX2)
+
+__attribute__((target("avx2"))) double dot_avx2(const double* x, const double* y, std::size_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  __m256d acc2 = _mm256_setzero_pd();
+  __m256d acc3 = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+    acc2 = _mm256_add_pd(acc2, _mm256_mul_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8)));
+    acc3 = _mm256_add_pd(acc3, _mm256_mul_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12)));
+  }
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+  }
+  const __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+  const __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+  double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+  for (; i < n; ++i) sum += x[i] * y[i];
+  return sum;
+}
+
+__attribute__((target("avx2"))) void axpy_avx2(double alpha, const double* x, double* y, std::size_t n) {
+  const __m256d a = _mm256_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256d y0 = _mm256_add_pd(_mm256_mul_pd(a, _mm256_loadu_pd(x + i)), _mm256_loadu_pd(y + i));
+    const __m256d y1 = _mm256_add_pd(_mm256_mul_pd(a, _mm256_loadu_pd(x + i + 4)), _mm256_loadu_pd(y + i + 4));
+    _mm256_storeu_pd(y + i, y0);
+    _mm256_storeu_pd(y + i + 4, y1);
+  }
+  for (; i < n; ++i) y[i] = alpha * x[i] + y[i];
+}
+
+template <AstraElementwise Op>
+__attribute__((target("avx2"))) inline __m256d lane_avx2(__m256d a, __m256d b) {
+  if constexpr (Op == AstraElementwise::Add) return _mm256_add_pd(a, b);
+  if constexpr (Op == AstraElementwise::Sub) return _mm256_sub_pd(a, b);
+  if constexpr (Op == AstraElementwise::Mul) return _mm256_mul_pd(a, b);
+  if constexpr (Op == AstraElementwise::Div) return _mm256_div_pd(a, b);
+}
+
+template <AstraElementwise Op>
+__attribute__((target("avx2"))) void elementwise_avx2(const double* x, const double* y, double* out, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256d r0 = lane_avx2<Op>(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+    const __m256d r1 = lane_avx2<Op>(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4));
+    _mm256_storeu_pd(out + i, r0);
+    _mm256_storeu_pd(out + i + 4, r1);
+  }
+  elementwise_scalar<Op>(x + i, y + i, out + i, n - i);
+}
+
+#endif
+
+template <AstraElementwise Op>
+void elementwise(const double* x, const double* y, double* out, std::size_t n) {
+#if defined(IRIS_ASTRA_AVX2)
+  if (astra_uses_avx2()) return elementwise_avx2<Op>(x, y, out, n);
+#endif
+  elementwise_scalar<Op>(x, y, out, n);
+}
+
+// ---- native operations ----
+
+using R = referee::Result<AstraValue>;
+
+R array_result(AstraArray array) {
+  AstraValue out;
+  out.array = std::move(array);
+  return R::ok(std::move(out));
+}
+
+const AstraArray* array_arg(std::span<const AstraValue> args, std::size_t i) {
+  return i < args.size() && args[i].array ? &*args[i].array : nullptr;
+}
+
+R native_dot(const AstraArray& self, std::span<const AstraValue> args) {
+  const auto* other = array_arg(args, 0);
+  if (!other) return R::err("dot expects an array argument");
+  if (other->shape != self.shape) return R::err("dot: shapes differ");
+  AstraValue out;
+  out.scalar = astra_dot(self.values.data(), other->values.data(), self.values.size());
+  return R::ok(out);
+}
+
+R native_axpy(const AstraArray& self, std::span<const AstraValue> args) {
+  const auto* x = array_arg(args, 1);
+  if (args.empty() || args[0].array || !x) return R::err("axpy expects (alpha, x)");
+  if (x->shape != self.shape) return R::err("axpy: shapes differ");
+  auto y = self;
+  astra_axpy(args[0].scalar, x->values.data(), y.values.data(), y.values.size());
+  return array_result(std::move(y));
+}
+
+R native_matmul(const AstraArray& self, std::span<const AstraValue> args) {
+  const auto* other = array_arg(args, 0);
+  if (!other) return R::err("matmul expects a matrix argument");
+  if (self.rank() != 2 || other->rank() != 2) return R::err("matmul: operands must be matrices");
+  if (self.shape[1] != other->shape[0]) return R::err("matmul: inner dimensions differ");
+  const auto m = self.shape[0];
+  const auto k = self.shape[1];
+  const auto n = other->shape[1];
+  auto out = AstraArray::matrix(m, n, std::vector<double>(static_cast<std::size_t>(m * n)));
+  astra_matmul(self.values.data(), other->values.data(), out.values.data(), m, k, n);
+  return array_result(std::move(out));
+}
+
+template <AstraElementwise Op>
+R native_elementwise(const AstraArray& self, std::span<const AstraValue> args) {
+  const auto* other = array_arg(args, 0);
+  if (!other) return R::err("elementwise operations expect an array argument");
+  if (other->shape != self.shape) return R::err("elementwise: shapes differ");
+  auto out = self;
+  astra_elementwise(Op, self.values.data(), other->values.data(), out.values.data(), out.values.size());
+  return array_result(std::move(out));
+}
+
+} // namespace
+
+AstraArray AstraArray::vector(std::vector<double> values) {
+  AstraArray out;
+  out.shape = { values.size() };
+  out.values = std::move(values);
+  return out;
+}
+
+AstraArray AstraArray::matrix(std::uint64_t rows, std::uint64_t cols, std::vector<double> values) {
+  AstraArray out;
+  out.shape = { rows, cols };
+  out.values = std::move(values);
+  return out;
+}
+
+referee::Bytes pack_astra(const AstraArray& array) {
+  const std::size_t blob = kFixedHeader + 8 * array.shape.size() + 8 * array.values.size();
+  referee::Bytes out;
+  out.reserve(blob + 9);
+  put_bytes_head(out, blob);
+  const auto start = out.size();
+  out.resize(start + blob);
+  auto* p = out.data() + start;
+  std::memcpy(p, kMagic, 4);
+  p[4] = kVersion;
+  p[5] = sizeof(double);
+  p[6] = static_cast<std::uint8_t>(array.shape.size());
+  p[7] = 0;
+  p += kFixedHeader;
+  for (auto dim : array.shape) {
+    put_u64(p, dim);
+    p += 8;
+  }
+  put_doubles(p, array.values.data(), array.values.size());
+  return out;
+}
+
+referee::Result<AstraArray> unpack_astra(const referee::Bytes& payload) {
+  using RA = referee::Result<AstraArray>;
+  std::size_t offset = 0;
+  std::uint64_t size = 0;
+  if (!get_bytes_head(payload, &offset, &size) || size != payload.size() - offset) {
+    return RA::err("astra payload is not a single byte string");
+  }
+  const auto* p = payload.data() + offset;
+  if (size < kFixedHeader || std::memcmp(p, kMagic, 4) != 0) return RA::err("astra payload has no header");
+  if (p[4] != kVersion) return RA::err("astra payload version " + std::to_string(p[4]) + " is not supported");
+  if (p[5] != sizeof(double)) return RA::err("astra payload elements must be f64");
+  const std::size_t rank = p[6];
+  if (size < kFixedHeader + 8 * rank) return RA::err("astra payload shape is truncated");
+
+  AstraArray out;
+  out.shape.resize(rank);
+  std::uint64_t count = 1;
+  const std::uint64_t room = (size - kFixedHeader - 8 * rank) / 8;
+  for (std::size_t i = 0; i < rank; ++i) {
+    out.shape[i] = get_u64(p + kFixedHeader + 8 * i);
+    if (out.shape[i] != 0 && count > room / out.shape[i]) return RA::err("astra payload shape exceeds its data");
+    count *= out.shape[i];
+  }
+  if (size != kFixedHeader + 8 * rank + 8 * count) return RA::err("astra payload size does not match its shape");
+  out.values.resize(static_cast<std::size_t>(count));
+  get_doubles(p + kFixedHeader + 8 * rank, out.values.data(), out.values.size());
+  return RA::ok(std::move(out));
+}
+
+bool astra_uses_avx2() {
+#if defined(IRIS_ASTRA_AVX2)
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+double astra_dot(const double* x, const double* y, std::size_t n) {
+#if defined(IRIS_ASTRA_AVX2)
+  if (astra_uses_avx2()) return dot_avx2(x, y, n);
+#endif
+  double sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) sum += x[i] * y[i];
+  return sum;
+}
+
+void astra_axpy(double alpha, const double* x, double* y, std::size_t n) {
+#if defined(IRIS_ASTRA_AVX2)
+  if (astra_uses_avx2()) return axpy_avx2(alpha, x, y, n);
+#endif
+  for (std::size_t i = 0; i < n; ++i) y[i] = alpha * x[i] + y[i];
+}
+
+void astra_elementwise(AstraElementwise op, const double* x, const double* y, double* out, std::size_t n) {
+  switch (op) {
+    case AstraElementwise::Add: return elementwise<AstraElementwise::Add>(x, y, out, n);
+    case AstraElementwise::Sub: return elementwise<AstraElementwise::Sub>(x, y, out, n);
+    case AstraElementwise::Mul: return elementwise<AstraElementwise::Mul>(x, y, out, n);
+    case AstraElementwise::Div: return elementwise<AstraElementwise::Div>(x, y, out, n);
+  }
+}
+
+void astra_matmul(const double* a, const double* b, double* c, std::size_t m, std::size_t k, std::size_t n) {
+  // Row i of c accumulates a[i][p] * row p of b: each step is an axpy over
+  // contiguous rows, so the inner loop runs in SIMD lanes.
+  for (std::size_t i = 0; i < m; ++i) {
+    double* row = c + i * n;
+    std::fill(row, row + n, 0.0);
+    for (std::size_t p = 0; p < k; ++p) astra_axpy(a[i * k + p], b + p * n, row, n);
+  }
+}
+
+AstraNative astra_native(const BoundOperation& op) {
+  const auto& match = op.match();
+  const auto owner = match.owner_type;
+  if (owner != kAstraVectorType && owner != kAstraMatrixType && owner != kAstraTensorType) return nullptr;
+  const auto& name = match.operation.name;
+  if (name == "dot") return native_dot;
+  if (name == "axpy") return native_axpy;
+  if (name == "matmul") return native_matmul;
+  if (name == "add") return native_elementwise<AstraElementwise::Add>;
+  if (name == "sub") return native_elementwise<AstraElementwise::Sub>;
+  if (name == "mul") return native_elementwise<AstraElementwise::Mul>;
+  if (name == "div") return native_elementwise<AstraElementwise::Div>;
+  return nullptr;
+}
+
+} // namespace iris::refract
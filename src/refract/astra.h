@@ -0,0 +1,66 @@
+#pragma once
+
+#include "refract/dispatch.h"
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Packed payloads and numeric kernels for Astra::Vector, Astra::Matrix and
+// Astra::Tensor.
+//
+// A packed payload is one CBOR byte string holding
+//   "ASTR" u8 version (1) u8 element bytes (8) u8 rank u8 reserved
+//   u64 dims[rank] f64 elements[product of dims]
+// all little-endian, elements row-major. Vectors have rank 1 and matrices rank 2
+// (rows, then columns); tensors any rank.
+namespace iris::refract {
+
+inline constexpr referee::TypeID kAstraVectorType{0x4153545200000003ULL};
+inline constexpr referee::TypeID kAstraMatrixType{0x4153545200000004ULL};
+inline constexpr referee::TypeID kAstraTensorType{0x4153545200000005ULL};
+
+struct AstraArray {
+  std::vector<std::uint64_t> shape;
+  std::vector<double> values;
+
+  static AstraArray vector(std::vector<double> values);
+  static AstraArray matrix(std::uint64_t rows, std::uint64_t cols, std::vector<double> values);
+
+  std::size_t rank() const { return shape.size(); }
+};
+
+referee::Bytes pack_astra(const AstraArray& array);
+// Fails unless `payload` is a packed array whose element count matches its shape.
+referee::Result<AstraArray> unpack_astra(const referee::Bytes& payload);
+
+// Kernels over raw arrays. They use AVX2 when the CPU has it (checked once) and
+// plain loops otherwise; out may alias an input.
+enum class AstraElementwise : std::uint8_t { Add, Sub, Mul, Div };
+
+bool astra_uses_avx2();
+double astra_dot(const double* x, const double* y, std::size_t n);
+// y = alpha * x + y
+void astra_axpy(double alpha, const double* x, double* y, std::size_t n);
+void astra_elementwise(AstraElementwise op, const double* x, const double* y, double* out, std::size_t n);
+// c (m x n) = a (m x k) * b (k x n), all row-major.
+void astra_matmul(const double* a, const double* b, double* c, std::size_t m, std::size_t k, std::size_t n);
+
+// An argument or result of a native Astra operation: an array, or an F64 scalar.
+struct AstraValue {
+  std::optional<AstraArray> array;
+  double scalar{0.0};
+};
+
+// The native implementation behind an operation declared by an Astra type; `self`
+// is the receiver and `args` follow the operation's parameters.
+using AstraNative = referee::Result<AstraValue> (*)(const AstraArray& self, std::span<const AstraValue> args);
+
+// nullptr unless `op` resolved to dot, axpy, matmul, add, sub, mul or div declared
+// on Astra::Vector, Astra::Matrix or Astra::Tensor.
+AstraNative astra_native(const BoundOperation& op);
+
+} // namespace iris::refract
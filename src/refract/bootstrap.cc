@@ -1,5 +1,11 @@
 #include "refract/bootstrap.h"
 
+#include "refract/payload_codec.h"
+#include "refract/schema_image.h"
+#include "referee/cbor_path.h"
+#include "referee/cbor_writer.h"
+
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <cstdlib>
@@ -8,8 +14,6 @@
 #include <optional>
 #include <string_view>
 
-#include <nlohmann/json.hpp>
-
 namespace iris::refract {
 
 namespace {
@@ -28,6 +32,7 @@ constexpr referee::TypeID kTypeCrateList{0x4352415400000002ULL};
 constexpr referee::TypeID kTypeCrateSet{0x4352415400000003ULL};
 constexpr referee::TypeID kTypeCrateMap{0x4352415400000004ULL};
 constexpr referee::TypeID kTypeCrateTuple{0x4352415400000005ULL};
+constexpr referee::TypeID kTypeCrateChunk{0x4352415400000006ULL};
 
 constexpr referee::TypeID kTypeAstraFloat{0x4153545200000001ULL};
 constexpr referee::TypeID kTypeAstraDouble{0x4153545200000002ULL};
@@ -181,6 +186,28 @@ void add_compare_operation(TypeDefinition& def, referee::TypeID type_id) {
   def.operations.push_back(std::move(op));
 }
 
+void add_binary_operation(TypeDefinition& def, std::string name, referee::TypeID other_type,
+                          referee::TypeID result_type) {
+  OperationDefinition op;
+  op.name = std::move(name);
+  op.scope = OperationScope::Object;
+  op.signature.params.push_back(ParameterDefinition{ "other", other_type, false });
+  op.signature.outputs.push_back(ParameterDefinition{ "result", result_type, false });
+  def.operations.push_back(std::move(op));
+}
+
+// Elementwise add/sub/mul/div and axpy (alpha * x + self) on packed Astra arrays.
+void add_astra_array_operations(TypeDefinition& def, referee::TypeID type_id) {
+  for (const char* name : { "add", "sub", "mul", "div" }) add_binary_operation(def, name, type_id, type_id);
+  OperationDefinition op;
+  op.name = "axpy";
+  op.scope = OperationScope::Object;
+  op.signature.params.push_back(ParameterDefinition{ "alpha", kTypeF64, false });
+  op.signature.params.push_back(ParameterDefinition{ "x", type_id, false });
+  op.signature.outputs.push_back(ParameterDefinition{ "result", type_id, false });
+  def.operations.push_back(std::move(op));
+}
+
 void add_core_ops(TypeDefinition& def, referee::TypeID type_id) {
   add_to_string_operation(def);
   add_print_operation(def);
@@ -281,6 +308,16 @@ TypeDefinition make_crate_tuple() {
   return def;
 }
 
+// One chunk of a natively stored Crate collection (see refract/crate.h).
+TypeDefinition make_crate_chunk() {
+  TypeDefinition def{};
+  def.type_id = kTypeCrateChunk;
+  def.name = "Chunk";
+  def.namespace_name = "Crate";
+  def.version = 1;
+  return def;
+}
+
 TypeDefinition make_astra_float() {
   TypeDefinition def{};
   def.type_id = kTypeAstraFloat;
@@ -310,6 +347,8 @@ TypeDefinition make_astra_vector() {
   add_iterate_operation(def);
   add_index_operation(def, kTypeU64, kTypeBytes);
   add_contains_operation(def, kTypeBytes);
+  add_astra_array_operations(def, kTypeAstraVector);
+  add_binary_operation(def, "dot", kTypeAstraVector, kTypeF64);
   return def;
 }
 
@@ -324,6 +363,8 @@ TypeDefinition make_astra_matrix() {
   add_iterate_operation(def);
   add_index_operation(def, kTypeU64, kTypeBytes);
   add_contains_operation(def, kTypeBytes);
+  add_astra_array_operations(def, kTypeAstraMatrix);
+  add_binary_operation(def, "matmul", kTypeAstraMatrix, kTypeAstraMatrix);
   return def;
 }
 
@@ -338,6 +379,7 @@ TypeDefinition make_astra_tensor() {
   add_iterate_operation(def);
   add_index_operation(def, kTypeU64, kTypeBytes);
   add_contains_operation(def, kTypeBytes);
+  add_astra_array_operations(def, kTypeAstraTensor);
   return def;
 }
 
@@ -816,6 +858,7 @@ std::vector<TypeDefinition> core_schema_definitions() {
   defs.push_back(make_crate_set());
   defs.push_back(make_crate_map());
   defs.push_back(make_crate_tuple());
+  defs.push_back(make_crate_chunk());
   defs.push_back(make_astra_float());
   defs.push_back(make_astra_double());
   defs.push_back(make_astra_vector());
@@ -855,8 +898,15 @@ std::vector<TypeDefinition> core_schema_definitions() {
   return defs;
 }
 
+const SchemaImage& core_schema_image() {
+  static const SchemaImage image = SchemaImage::build(core_schema_definitions());
+  return image;
+}
+
 namespace {
 
+constexpr referee::TypeID kTypeSchemaImageMark{0x5246524349000001ULL};
+
 bool allow_schema_recovery_reseed() {
   const char* raw = std::getenv("IRIS_REFRACT_SCHEMA_RECOVER");
   if (!raw || !*raw) return false;
@@ -867,30 +917,114 @@ bool allow_schema_recovery_reseed() {
       || std::strcmp(raw, "YES") == 0;
 }
 
+// One marker object per imported image, named by its fingerprint, so an existing
+// store is verified with a single lookup.
+referee::ObjectID image_marker_id(std::uint64_t fingerprint) {
+  referee::ObjectID id{};
+  std::array<std::uint8_t, 8> tag = { 'R','E','F','R','A','C','T','I' };
+  for (std::size_t i = 0; i < tag.size(); ++i) id.bytes[i] = tag[i];
+  for (int i = 0; i < 8; ++i) {
+    id.bytes[15 - i] = (std::uint8_t)(fingerprint & 0xFFu);
+    fingerprint >>= 8;
+  }
+  return id;
+}
+
+referee::Result<referee::ObjectRecord> write_image_marker(referee::SqliteStore& store, const SchemaImage& image) {
+  referee::CborWriter w;
+  w.map(2);
+  w.text("definitions");
+  w.uint(image.size());
+  w.text("fingerprint");
+  w.uint(image.fingerprint());
+  const auto id = image_marker_id(image.fingerprint());
+  return store.create_object_with_id(id, kTypeSchemaImageMark, referee::ObjectID{}, w.take());
+}
+
+// Stores that predate the marker: every image definition under its deterministic
+// id with identical bytes.
+referee::Result<bool> store_holds_image(referee::SqliteStore& store, const SchemaImage& image) {
+  for (std::size_t i = 0; i < image.size(); ++i) {
+    const auto entry = image.entry(i);
+    auto recR = store.get_object(referee::ObjectRef{definition_id_for(entry.type_id), referee::Version{1}});
+    if (!recR) return referee::Result<bool>::err(recR.error->message);
+    if (!recR.value->has_value()) return referee::Result<bool>::ok(false);
+    const auto& payload = recR.value->value().payload_cbor;
+    if (payload.size() != entry.size || !std::equal(payload.begin(), payload.end(), entry.payload)) {
+      return referee::Result<bool>::ok(false);
+    }
+  }
+  return referee::Result<bool>::ok(true);
+}
+
+referee::Result<std::size_t> import_image(referee::SqliteStore& store, const SchemaImage& image) {
+  using R = referee::Result<std::size_t>;
+  // Joins a transaction the caller already holds.
+  const bool own_txn = static_cast<bool>(store.begin());
+  for (std::size_t i = 0; i < image.size(); ++i) {
+    const auto id = definition_id_for(image.entry(i).type_id);
+    auto createR = store.create_object_with_id(id, kTypeDefinitionType, id, image.payload(i));
+    if (!createR) {
+      if (own_txn) store.rollback();
+      return R::err(createR.error->message);
+    }
+  }
+  auto markR = write_image_marker(store, image);
+  if (!markR) {
+    if (own_txn) store.rollback();
+    return R::err(markR.error->message);
+  }
+  if (own_txn) {
+    auto commitR = store.commit();
+    if (!commitR) return R::err(commitR.error->message);
+  }
+  return R::ok(image.size());
+}
+
 } // namespace
 
 referee::Result<BootstrapResult> bootstrap_core_schema(SchemaRegistry& registry) {
   BootstrapResult out;
-  auto listR = registry.list_types();
-  if (!listR) return referee::Result<BootstrapResult>::err(listR.error->message);
+  auto& store = registry.store();
+  const auto& image = core_schema_image();
+
+  auto markR = store.get_object(referee::ObjectRef{image_marker_id(image.fingerprint()), referee::Version{1}});
+  if (!markR) return referee::Result<BootstrapResult>::err(markR.error->message);
+  if (markR.value->has_value()) {
+    out.existing = image.size();
+    return referee::Result<BootstrapResult>::ok(out);
+  }
 
-  if (!listR.value->empty()) {
-    out.existing = listR.value->size();
-    if (!allow_schema_recovery_reseed()) {
-      return referee::Result<BootstrapResult>::ok(out);
-    }
+  if (store.type_mark(kTypeDefinitionType).count == 0) {
+    auto importR = import_image(store, image);
+    if (!importR) return referee::Result<BootstrapResult>::err(importR.error->message);
+    out.inserted = importR.value.value();
+    return referee::Result<BootstrapResult>::ok(out);
   }
 
-  auto defs = core_schema_definitions();
-  for (const auto& def : defs) {
-    auto existing = registry.get_definition_by_type(def.type_id);
+  auto heldR = store_holds_image(store, image);
+  if (!heldR) return referee::Result<BootstrapResult>::err(heldR.error->message);
+  if (heldR.value.value()) {
+    // Best effort: without the marker the next open checks the definitions again.
+    if (!store.read_only()) write_image_marker(store, image);
+    out.existing = image.size();
+    return referee::Result<BootstrapResult>::ok(out);
+  }
+
+  // A store seeded by another build: leave it unless recovery is requested.
+  auto listR = registry.list_types();
+  if (!listR) return referee::Result<BootstrapResult>::err(listR.error->message);
+  out.existing = listR.value->size();
+  if (!allow_schema_recovery_reseed()) return referee::Result<BootstrapResult>::ok(out);
+
+  for (std::size_t i = 0; i < image.size(); ++i) {
+    const auto type_id = image.entry(i).type_id;
+    auto existing = registry.get_definition_by_type(type_id);
     if (!existing) return referee::Result<BootstrapResult>::err(existing.error->message);
-    if (existing.value->has_value()) {
-      ++out.existing;
-      continue;
-    }
-    auto definition_id = definition_id_for(def.type_id);
-    auto reg = registry.register_definition_with_id(def, definition_id);
+    if (existing.value->has_value()) continue;
+    auto defR = decode_definition_payload(image.payload(i));
+    if (!defR) return referee::Result<BootstrapResult>::err(defR.error->message);
+    auto reg = registry.register_definition_with_id(defR.value.value(), definition_id_for(type_id));
     if (!reg) return referee::Result<BootstrapResult>::err(reg.error->message);
     ++out.inserted;
   }
@@ -903,7 +1037,7 @@ namespace {
 struct DimensionSeed {
   std::string name;
   std::string symbol;
-  nlohmann::json components;
+  std::map<std::string, std::int64_t> components; // key order, as the DOM wrote it
 };
 
 struct UnitSeed {
@@ -931,20 +1065,20 @@ std::map<std::string, referee::ObjectID> load_named_objects(
   auto listR = store.list_by_type(type_id);
   if (!listR) return out;
   for (const auto& rec : listR.value.value()) {
-    try {
-      auto j = nlohmann::json::from_cbor(rec.payload_cbor);
-      if (!j.contains(key)) continue;
-      auto name = j.at(key).get<std::string>();
-      if (!name.empty()) out[name] = rec.ref.id;
-    } catch (const std::exception&) {
-      continue;
-    }
+    auto name = referee::cbor_find_text(rec.payload_cbor, {key});
+    if (name.has_value() && !name->empty()) out[std::string(*name)] = rec.ref.id;
   }
   return out;
 }
 
-referee::Bytes cbor_from_json(const nlohmann::json& j) {
-  return nlohmann::json::to_cbor(j);
+referee::Bytes encode_components(const std::map<std::string, std::int64_t>& components) {
+  referee::CborWriter w;
+  w.map(components.size());
+  for (const auto& [name, power] : components) {
+    w.text(name);
+    w.integer(power);
+  }
+  return w.take();
 }
 
 } // namespace
@@ -957,6 +1091,8 @@ referee::Result<CatalogBootstrapResult> bootstrap_core_catalog(SchemaRegistry& r
   if (!dim_def) return referee::Result<CatalogBootstrapResult>::err(dim_def.error->message);
   auto unit_def = require_definition(registry, kTypeCaliperUnit);
   if (!unit_def) return referee::Result<CatalogBootstrapResult>::err(unit_def.error->message);
+  const auto dim_codec = PayloadCodec::compile(dim_def.value->definition);
+  const auto unit_codec = PayloadCodec::compile(unit_def.value->definition);
 
   std::map<std::string, referee::ObjectID> dimensions_by_name =
       load_named_objects(store, kTypeCaliperDimension, "name");
@@ -964,20 +1100,20 @@ referee::Result<CatalogBootstrapResult> bootstrap_core_catalog(SchemaRegistry& r
       load_named_objects(store, kTypeCaliperUnit, "symbol");
 
   const std::vector<DimensionSeed> dimension_seeds = {
-    { "Dimensionless", "1", nlohmann::json::object() },
-    { "Length", "L", nlohmann::json{ { "Length", 1 } } },
-    { "Mass", "M", nlohmann::json{ { "Mass", 1 } } },
-    { "Time", "T", nlohmann::json{ { "Time", 1 } } },
-    { "Angle", "Ang", nlohmann::json{ { "Angle", 1 } } },
-    { "Temperature", "Temp", nlohmann::json{ { "Temperature", 1 } } },
-    { "Area", "L2", nlohmann::json{ { "Length", 2 } } },
-    { "Volume", "L3", nlohmann::json{ { "Length", 3 } } },
-    { "Velocity", "L/T", nlohmann::json{ { "Length", 1 }, { "Time", -1 } } },
-    { "Acceleration", "L/T2", nlohmann::json{ { "Length", 1 }, { "Time", -2 } } },
-    { "Force", "M*L/T2", nlohmann::json{ { "Mass", 1 }, { "Length", 1 }, { "Time", -2 } } },
-    { "Pressure", "M/L/T2", nlohmann::json{ { "Mass", 1 }, { "Length", -1 }, { "Time", -2 } } },
-    { "Energy", "M*L2/T2", nlohmann::json{ { "Mass", 1 }, { "Length", 2 }, { "Time", -2 } } },
-    { "Power", "M*L2/T3", nlohmann::json{ { "Mass", 1 }, { "Length", 2 }, { "Time", -3 } } },
+    { "Dimensionless", "1", {} },
+    { "Length", "L", { { "Length", 1 } } },
+    { "Mass", "M", { { "Mass", 1 } } },
+    { "Time", "T", { { "Time", 1 } } },
+    { "Angle", "Ang", { { "Angle", 1 } } },
+    { "Temperature", "Temp", { { "Temperature", 1 } } },
+    { "Area", "L2", { { "Length", 2 } } },
+    { "Volume", "L3", { { "Length", 3 } } },
+    { "Velocity", "L/T", { { "Length", 1 }, { "Time", -1 } } },
+    { "Acceleration", "L/T2", { { "Length", 1 }, { "Time", -2 } } },
+    { "Force", "M*L/T2", { { "Mass", 1 }, { "Length", 1 }, { "Time", -2 } } },
+    { "Pressure", "M/L/T2", { { "Mass", 1 }, { "Length", -1 }, { "Time", -2 } } },
+    { "Energy", "M*L2/T2", { { "Mass", 1 }, { "Length", 2 }, { "Time", -2 } } },
+    { "Power", "M*L2/T3", { { "Mass", 1 }, { "Length", 2 }, { "Time", -3 } } },
   };
 
   for (const auto& seed : dimension_seeds) {
@@ -986,13 +1122,15 @@ referee::Result<CatalogBootstrapResult> bootstrap_core_catalog(SchemaRegistry& r
       ++out.existing;
       continue;
     }
-    nlohmann::json j;
-    j["name"] = seed.name;
-    j["symbol"] = seed.symbol;
-    j["components"] = seed.components;
+    auto payloadR = dim_codec.encoder()
+                        .set_text("name", seed.name)
+                        .set_text("symbol", seed.symbol)
+                        .set_encoded("components", encode_components(seed.components))
+                        .finish();
+    if (!payloadR) return referee::Result<CatalogBootstrapResult>::err(payloadR.error->message);
     auto createR = store.create_object(dim_def.value->definition.type_id,
                                        dim_def.value->ref.id,
-                                       cbor_from_json(j));
+                                       payloadR.value.value());
     if (!createR) return referee::Result<CatalogBootstrapResult>::err(createR.error->message);
     dimensions_by_name[seed.name] = createR.value->ref.id;
     ++out.inserted;
@@ -1072,23 +1210,25 @@ referee::Result<CatalogBootstrapResult> bootstrap_core_catalog(SchemaRegistry& r
     auto dimR = require_dimension(seed.dimension);
     if (!dimR) return referee::Result<CatalogBootstrapResult>::err(dimR.error->message);
 
-    nlohmann::json j;
-    j["name"] = seed.name;
-    j["symbol"] = seed.symbol;
-    j["dimension_id"] = dimR.value->to_hex();
-    if (!seed.system.empty()) j["system"] = seed.system;
-    if (seed.scale.has_value()) j["scale"] = seed.scale.value();
-    if (seed.offset.has_value()) j["offset"] = seed.offset.value();
+    auto unit = unit_codec.encoder();
+    unit.set_text("name", seed.name)
+        .set_text("symbol", seed.symbol)
+        .set_object_id("dimension_id", dimR.value.value());
+    if (!seed.system.empty()) unit.set_text("system", seed.system);
+    if (seed.scale.has_value()) unit.set_number("scale", seed.scale.value());
+    if (seed.offset.has_value()) unit.set_number("offset", seed.offset.value());
     if (seed.base_symbol.has_value()) {
       auto base_it = units_by_symbol.find(seed.base_symbol.value());
       if (base_it != units_by_symbol.end()) {
-        j["base_unit_id"] = base_it->second.to_hex();
+        unit.set_object_id("base_unit_id", base_it->second);
       }
     }
+    auto payloadR = unit.finish();
+    if (!payloadR) return referee::Result<CatalogBootstrapResult>::err(payloadR.error->message);
 
     auto createR = store.create_object(unit_def.value->definition.type_id,
                                        unit_def.value->ref.id,
-                                       cbor_from_json(j));
+                                       payloadR.value.value());
     if (!createR) return referee::Result<CatalogBootstrapResult>::err(createR.error->message);
     units_by_symbol[seed.symbol] = createR.value->ref.id;
     ++out.inserted;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "refract/schema_image.h"
 #include "refract/schema_registry.h"
 
 #include <vector>
@@ -19,8 +20,14 @@ struct CatalogBootstrapResult {
 // Returns the canonical TypeDefinition set for Refract core schema.
 std::vector<TypeDefinition> core_schema_definitions();
 
-// Ensures core schema definitions exist in Referee (idempotent).
-// When schemas already exist, no changes are made unless IRIS_REFRACT_SCHEMA_RECOVER is set.
+// core_schema_definitions() packed into one image, built once per process.
+const SchemaImage& core_schema_image();
+
+// Ensures core schema definitions exist in Referee (idempotent). A fresh store
+// imports core_schema_image() in one transaction and records its fingerprint; a
+// store holding that fingerprint is accepted without reading any definition.
+// When other schemas already exist, no changes are made unless
+// IRIS_REFRACT_SCHEMA_RECOVER is set.
 referee::Result<BootstrapResult> bootstrap_core_schema(SchemaRegistry& registry);
 
 // Ensures core catalog objects exist in Referee (idempotent).
@@ -0,0 +1,66 @@
+#include "refract/capabilities.h"
+
+#include <atomic>
+#include <bit>
+
+namespace iris::refract {
+
+namespace {
+
+std::atomic<std::uint64_t> next_principal{1};
+std::atomic<std::uint64_t> next_epoch{1};
+
+} // namespace
+
+CapabilityID CapabilitySet::first_missing(const CapabilitySet& required) const {
+  for (std::size_t w = 0; w < words_.size(); ++w) {
+    const std::uint64_t missing = required.words_[w] & ~words_[w];
+    if (missing != 0) return static_cast<CapabilityID>(w * 64 + static_cast<std::size_t>(std::countr_zero(missing)));
+  }
+  return kNoCapability;
+}
+
+CapabilityID CapabilityTable::intern(std::string_view name) {
+  auto it = ids_.find(std::string(name));
+  if (it != ids_.end()) return it->second;
+  if (names_.size() >= CapabilitySet::kBits) return kNoCapability;
+  const auto id = static_cast<CapabilityID>(names_.size());
+  names_.emplace_back(name);
+  ids_.emplace(names_.back(), id);
+  return id;
+}
+
+CapabilityID CapabilityTable::find(std::string_view name) const {
+  auto it = ids_.find(std::string(name));
+  return it == ids_.end() ? kNoCapability : it->second;
+}
+
+CapabilityPrincipal::CapabilityPrincipal()
+  : id_(next_principal.fetch_add(1, std::memory_order_relaxed)),
+    epoch_(next_epoch.fetch_add(1, std::memory_order_relaxed)) {}
+
+void CapabilityPrincipal::grant(CapabilityID capability) {
+  granted_.set(capability);
+  bump();
+}
+
+void CapabilityPrincipal::revoke(CapabilityID capability) {
+  granted_.reset(capability);
+  bump();
+}
+
+void CapabilityPrincipal::assign(const CapabilitySet& granted) {
+  granted_ = granted;
+  bump();
+}
+
+void CapabilityPrincipal::clear() {
+  granted_.clear();
+  bump();
+}
+
+void CapabilityPrincipal::bump() {
+  epoch_ = next_epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace iris::refract
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Capability names interned to small ids, and fixed-width bitsets over them. The
+// registry interns the capabilities operations require as their definitions are
+// registered; sessions and tasks hold what they were granted as a bitset.
+namespace iris::refract {
+
+using CapabilityID = std::uint16_t;
+inline constexpr CapabilityID kNoCapability = UINT16_MAX;
+
+class CapabilitySet {
+public:
+  static constexpr std::size_t kBits = 256;
+
+  bool test(CapabilityID id) const { return id < kBits && (words_[id / 64] >> (id % 64) & 1U) != 0; }
+  void set(CapabilityID id) {
+    if (id < kBits) words_[id / 64] |= std::uint64_t{1} << (id % 64);
+  }
+  void reset(CapabilityID id) {
+    if (id < kBits) words_[id / 64] &= ~(std::uint64_t{1} << (id % 64));
+  }
+  void clear() { words_ = {}; }
+  bool empty() const { return (words_[0] | words_[1] | words_[2] | words_[3]) == 0; }
+
+  // True if every capability in `required` is in this set.
+  bool covers(const CapabilitySet& required) const {
+    return ((required.words_[0] & ~words_[0]) | (required.words_[1] & ~words_[1])
+            | (required.words_[2] & ~words_[2]) | (required.words_[3] & ~words_[3])) == 0;
+  }
+  // Lowest id in `required` missing from this set, or kNoCapability.
+  CapabilityID first_missing(const CapabilitySet& required) const;
+
+  friend bool operator==(const CapabilitySet& a, const CapabilitySet& b) { return a.words_ == b.words_; }
+
+private:
+  std::array<std::uint64_t, kBits / 64> words_{};
+};
+
+// Append-only name <-> id table; ids stay valid for the table's lifetime.
+class CapabilityTable {
+public:
+  // kNoCapability once CapabilitySet::kBits names are interned.
+  CapabilityID intern(std::string_view name);
+  CapabilityID find(std::string_view name) const;
+  const std::string& name(CapabilityID id) const { return names_[id]; }
+  std::size_t size() const { return names_.size(); }
+
+private:
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, CapabilityID> ids_;
+};
+
+// What a session or task was granted. Every change takes a new epoch from a
+// process-wide counter, so a copy and its original never share an epoch once either
+// changes; CapabilityPolicy keys its cached decisions on (id, epoch).
+class CapabilityPrincipal {
+public:
+  CapabilityPrincipal();
+
+  std::uint64_t id() const { return id_; }
+  std::uint64_t epoch() const { return epoch_; }
+  const CapabilitySet& granted() const { return granted_; }
+  bool has(CapabilityID capability) const { return granted_.test(capability); }
+
+  void grant(CapabilityID capability);
+  void revoke(CapabilityID capability);
+  void assign(const CapabilitySet& granted);
+  void clear();
+
+private:
+  void bump();
+
+  std::uint64_t id_;
+  std::uint64_t epoch_;
+  CapabilitySet granted_;
+};
+
+} // namespace iris::refract
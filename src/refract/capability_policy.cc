@@ -0,0 +1,60 @@
+#include "refract/capability_policy.h"
+
+namespace iris::refract {
+
+CapabilityDecision CapabilityPolicy::check(const BoundOperation& op, const CapabilityPrincipal& principal) {
+  // New definitions mean new operation tables; entries for the old ones would only
+  // keep them alive.
+  if (const auto generation = registry_.generation(); generation != generation_) {
+    decisions_.clear();
+    generation_ = generation;
+  }
+  if (decisions_.size() >= capacity_) decisions_.clear();
+
+  auto [it, inserted] = decisions_.try_emplace(Key{ op.table.get(), op.slot, principal.id() });
+  auto& entry = it->second;
+  if (!inserted && entry.epoch == principal.epoch()) return entry.decision;
+
+  const auto& names = op.operation().required_capabilities;
+  if (inserted) {
+    entry.table = op.table;
+    entry.required = required(op.operation());
+    // A name the table had no room for has no bit, and cannot be granted either.
+    for (const auto& name : names) entry.unrepresentable |= registry_.capabilities().find(name) == kNoCapability;
+  }
+  entry.epoch = principal.epoch();
+  entry.decision = CapabilityDecision{};
+  if (!entry.unrepresentable && principal.granted().covers(entry.required)) return entry.decision;
+  for (const auto& name : names) {
+    const auto id = registry_.capabilities().find(name);
+    if (id == kNoCapability || !principal.has(id)) {
+      entry.decision = CapabilityDecision{ false, &name };
+      break;
+    }
+  }
+  return entry.decision;
+}
+
+CapabilitySet CapabilityPolicy::required(const OperationDefinition& op) {
+  CapabilitySet out;
+  for (const auto& name : op.required_capabilities) out.set(registry_.capabilities().intern(name));
+  return out;
+}
+
+void CapabilityPolicy::forget(const CapabilityPrincipal& principal) {
+  std::erase_if(decisions_, [&](const auto& item) { return item.first.principal == principal.id(); });
+}
+
+bool CapabilityPolicy::grant(CapabilityPrincipal& principal, std::string_view name) {
+  const auto id = registry_.capabilities().intern(name);
+  if (id == kNoCapability) return false;
+  principal.grant(id);
+  return true;
+}
+
+void CapabilityPolicy::revoke(CapabilityPrincipal& principal, std::string_view name) {
+  const auto id = registry_.capabilities().find(name);
+  if (id != kNoCapability) principal.revoke(id);
+}
+
+} // namespace iris::refract
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "refract/capabilities.h"
+#include "refract/dispatch.h"
+#include "refract/schema_registry.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace iris::refract {
+
+struct CapabilityDecision {
+  bool allowed{true};
+  const std::string* missing{nullptr}; // first required name not granted
+
+  std::string message() const { return "missing capability: " + (missing ? *missing : std::string()); }
+};
+
+// Decides whether a principal may invoke a bound operation. Each operation's
+// required names become a CapabilitySet once, and each (operation, principal)
+// decision is kept until the principal's grants change, so a repeated check is one
+// lookup and an epoch compare. Decisions are dropped when the registry's definitions
+// change (their tables are rebuilt then), when the cache reaches its capacity, and
+// by forget() for a principal that is going away.
+class CapabilityPolicy {
+public:
+  explicit CapabilityPolicy(SchemaRegistry& registry) : registry_(registry) {}
+
+  CapabilityDecision check(const BoundOperation& op, const CapabilityPrincipal& principal);
+  // The required set of an unbound operation, interning its names.
+  CapabilitySet required(const OperationDefinition& op);
+
+  // Grants by name, interning unknown names. False if the table is full.
+  bool grant(CapabilityPrincipal& principal, std::string_view name);
+  void revoke(CapabilityPrincipal& principal, std::string_view name);
+
+  // Drops the decisions cached for `principal`; call when it is discarded.
+  void forget(const CapabilityPrincipal& principal);
+  // Decisions kept at most; a check that would exceed it starts the cache over.
+  void set_capacity(std::size_t entries) { capacity_ = entries; }
+
+  std::size_t cached_decisions() const { return decisions_.size(); }
+  void clear() { decisions_.clear(); }
+
+private:
+  struct Key {
+    const OperationTable* table;
+    std::uint32_t slot;
+    std::uint64_t principal;
+    friend bool operator==(const Key& a, const Key& b) = default;
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key& k) const noexcept {
+      auto h = std::hash<const void*>{}(k.table);
+      h ^= (static_cast<std::size_t>(k.slot) << 32 ^ k.principal) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+      return h;
+    }
+  };
+  struct Entry {
+    std::shared_ptr<const OperationTable> table; // keeps the key's address in use
+    CapabilitySet required;
+    bool unrepresentable{false};
+    std::uint64_t epoch{0};
+    CapabilityDecision decision;
+  };
+
+  SchemaRegistry& registry_;
+  std::unordered_map<Key, Entry, KeyHash> decisions_;
+  std::uint64_t generation_{0};
+  std::size_t capacity_{4096};
+};
+
+} // namespace iris::refract
@@ -0,0 +1,551 @@
+#include "refract/crate.h"
+
+#include "referee/cbor_path.h"
+#include "referee/cbor_writer.h"
+
+#include <algorithm>
+
+namespace iris::refract {
+
+namespace {
+
+std::uint64_t hash_item(const CrateItem& item) {
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+  for (std::uint8_t b : item) {
+    h ^= b;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+std::size_t chunk_count(std::size_t items, std::size_t chunk_size) {
+  return (items + chunk_size - 1) / chunk_size;
+}
+
+void write_items(referee::CborWriter& w, std::span<const CrateItem> items) {
+  w.array(items.size());
+  for (const auto& item : items) w.raw(item.data(), item.size());
+}
+
+// The encoded items of the array at `field`, copied out.
+referee::Result<std::vector<CrateItem>> read_items(const referee::Bytes& payload, std::string_view field) {
+  using R = referee::Result<std::vector<CrateItem>>;
+  auto item = referee::cbor_find(payload, {field});
+  if (!item) return R::err(std::string(field) + " missing");
+  auto array = referee::CborContainer::open(*item);
+  if (!array || array->is_map()) return R::err(std::string(field) + " is not an array");
+  std::vector<CrateItem> out;
+  referee::CborSlice slice;
+  while (array->next(&slice)) out.emplace_back(slice.data, slice.data + slice.size);
+  if (array->malformed()) return R::err(std::string(field) + " is malformed");
+  return R::ok(std::move(out));
+}
+
+bool layout_fits(referee::TypeID type, std::string_view layout) {
+  if (type == kCrateArrayType || type == kCrateListType || type == kCrateTupleType) return layout == "array";
+  if (type == kCrateSetType) return layout == "hash-set";
+  if (type == kCrateMapType) return layout == "hash-map" || layout == "btree-map";
+  return false;
+}
+
+referee::Bytes encode_root(std::string_view layout, CrateShape shape, std::span<const referee::ObjectRef> chunks) {
+  referee::CborWriter w;
+  w.map(4);
+  w.text("layout");
+  w.text(layout);
+  w.text("chunk_size");
+  w.uint(shape.chunk_size);
+  w.text("capacity");
+  w.uint(shape.capacity);
+  w.text("chunks");
+  w.array(chunks.size());
+  for (const auto& chunk : chunks) w.text(chunk.id.to_hex());
+  return w.take();
+}
+
+referee::Result<referee::ObjectID> definition_for(SchemaRegistry& registry, referee::TypeID type) {
+  using R = referee::Result<referee::ObjectID>;
+  auto defR = registry.get_latest_definition_by_type(type);
+  if (!defR) return R::err(defR.error->message);
+  if (!defR.value->has_value()) return R::err("Crate definitions not registered");
+  return R::ok(defR.value->value().ref.id);
+}
+
+} // namespace
+
+void CrateChunked::touch_all() {
+  for (auto key : chunk_keys()) dirty_.insert(key);
+}
+
+// -----------------------------
+// CrateArray
+// -----------------------------
+
+CrateArray::CrateArray(std::size_t chunk_size) : chunk_size_(std::max<std::size_t>(chunk_size, 1)) {}
+
+bool CrateArray::contains(const CrateItem& item) const {
+  return std::find(items_.begin(), items_.end(), item) != items_.end();
+}
+
+void CrateArray::set(std::size_t index, CrateItem item) {
+  items_[index] = std::move(item);
+  touch(index / chunk_size_);
+}
+
+void CrateArray::push_back(CrateItem item) {
+  items_.push_back(std::move(item));
+  touch((items_.size() - 1) / chunk_size_);
+}
+
+void CrateArray::pop_back() {
+  items_.pop_back();
+  if (!items_.empty()) touch((items_.size() - 1) / chunk_size_);
+}
+
+void CrateArray::insert(std::size_t index, CrateItem item) {
+  items_.insert(items_.begin() + static_cast<std::ptrdiff_t>(index), std::move(item));
+  touch_from(index);
+}
+
+void CrateArray::erase(std::size_t index) {
+  items_.erase(items_.begin() + static_cast<std::ptrdiff_t>(index));
+  touch_from(index);
+}
+
+void CrateArray::touch_from(std::size_t index) {
+  for (std::size_t c = index / chunk_size_; c < chunk_count(items_.size(), chunk_size_); ++c) touch(c);
+}
+
+std::vector<CrateChunkKey> CrateArray::chunk_keys() const {
+  std::vector<CrateChunkKey> out(chunk_count(items_.size(), chunk_size_));
+  for (std::size_t c = 0; c < out.size(); ++c) out[c] = c;
+  return out;
+}
+
+referee::Bytes CrateArray::encode_chunk(CrateChunkKey key) const {
+  const std::size_t begin = std::min(static_cast<std::size_t>(key) * chunk_size_, items_.size());
+  const std::size_t end = std::min(begin + chunk_size_, items_.size());
+  referee::CborWriter w;
+  w.map(1);
+  w.text("items");
+  write_items(w, std::span<const CrateItem>(items_.data() + begin, end - begin));
+  return w.take();
+}
+
+referee::Result<void> CrateArray::load(CrateShape shape, std::span<const referee::Bytes> chunks) {
+  using R = referee::Result<void>;
+  if (shape.chunk_size == 0) return R::err("array chunk size is zero");
+  std::vector<CrateItem> items;
+  for (std::size_t c = 0; c < chunks.size(); ++c) {
+    auto itemsR = read_items(chunks[c], "items");
+    if (!itemsR) return R::err("chunk " + std::to_string(c) + ": " + itemsR.error->message);
+    auto& chunk = itemsR.value.value();
+    const bool last = c + 1 == chunks.size();
+    if (chunk.empty() || chunk.size() > shape.chunk_size || (!last && chunk.size() != shape.chunk_size)) {
+      return R::err("chunk " + std::to_string(c) + " holds " + std::to_string(chunk.size()) + " items");
+    }
+    std::move(chunk.begin(), chunk.end(), std::back_inserter(items));
+  }
+  chunk_size_ = static_cast<std::size_t>(shape.chunk_size);
+  items_ = std::move(items);
+  dirty_.clear();
+  return R::ok();
+}
+
+// -----------------------------
+// CrateHashTable
+// -----------------------------
+
+CrateHashTable::CrateHashTable(bool with_values, std::size_t chunk_size)
+  : slots_(kMinCapacity), with_values_(with_values), chunk_size_(std::max<std::size_t>(chunk_size, 1)) {}
+
+std::size_t CrateHashTable::probe(std::uint64_t hash, const CrateItem& key) const {
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t i = hash & mask;
+  while (slots_[i].used && (slots_[i].hash != hash || slots_[i].key != key)) i = (i + 1) & mask;
+  return i;
+}
+
+const CrateHashTable::Slot* CrateHashTable::find_slot(const CrateItem& key) const {
+  const auto& slot = slots_[probe(hash_item(key), key)];
+  return slot.used ? &slot : nullptr;
+}
+
+bool CrateHashTable::put(CrateItem key, CrateItem value) {
+  if ((size_ + 1) * 4 > slots_.size() * 3) grow();
+  const std::uint64_t hash = hash_item(key);
+  const std::size_t i = probe(hash, key);
+  auto& slot = slots_[i];
+  if (slot.used) {
+    if (with_values_ && slot.value != value) {
+      slot.value = std::move(value);
+      touch_slot(i);
+    }
+    return false;
+  }
+  slot = Slot{ true, hash, std::move(key), with_values_ ? std::move(value) : CrateItem{} };
+  ++size_;
+  touch_slot(i);
+  return true;
+}
+
+bool CrateHashTable::remove(const CrateItem& key) {
+  std::size_t hole = probe(hash_item(key), key);
+  if (!slots_[hole].used) return false;
+  slots_[hole] = Slot{};
+  touch_slot(hole);
+  --size_;
+
+  // Pull later entries of the probe run back over the hole, unless that would move
+  // one before its home slot.
+  const std::size_t mask = slots_.size() - 1;
+  for (std::size_t j = (hole + 1) & mask; slots_[j].used; j = (j + 1) & mask) {
+    const std::size_t home = slots_[j].hash & mask;
+    const bool stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+    if (stays) continue;
+    slots_[hole] = std::move(slots_[j]);
+    slots_[j] = Slot{};
+    touch_slot(hole);
+    touch_slot(j);
+    hole = j;
+  }
+  return true;
+}
+
+void CrateHashTable::grow() {
+  auto old = std::move(slots_);
+  slots_.assign(old.size() * 2, Slot{});
+  for (auto& slot : old) {
+    if (slot.used) slots_[probe(slot.hash, slot.key)] = std::move(slot);
+  }
+  touch_all();
+}
+
+std::vector<CrateChunkKey> CrateHashTable::chunk_keys() const {
+  std::vector<CrateChunkKey> out(chunk_count(slots_.size(), chunk_size_));
+  for (std::size_t c = 0; c < out.size(); ++c) out[c] = c;
+  return out;
+}
+
+referee::Bytes CrateHashTable::encode_chunk(CrateChunkKey key) const {
+  const std::size_t begin = std::min(static_cast<std::size_t>(key) * chunk_size_, slots_.size());
+  const std::size_t end = std::min(begin + chunk_size_, slots_.size());
+  std::vector<std::uint64_t> used;
+  for (std::size_t i = begin; i < end; ++i) {
+    if (slots_[i].used) used.push_back(i);
+  }
+  referee::CborWriter w;
+  w.map(with_values_ ? 3 : 2);
+  w.text("slots");
+  w.array(used.size());
+  for (auto i : used) w.uint(i);
+  w.text("keys");
+  w.array(used.size());
+  for (auto i : used) w.raw(slots_[i].key.data(), slots_[i].key.size());
+  if (with_values_) {
+    w.text("values");
+    w.array(used.size());
+    for (auto i : used) w.raw(slots_[i].value.data(), slots_[i].value.size());
+  }
+  return w.take();
+}
+
+referee::Result<void> CrateHashTable::load(CrateShape shape, std::span<const referee::Bytes> chunks) {
+  using R = referee::Result<void>;
+  const std::uint64_t capacity = shape.capacity;
+  if (shape.chunk_size == 0) return R::err("hash chunk size is zero");
+  if (capacity < kMinCapacity || (capacity & (capacity - 1)) != 0) {
+    return R::err("hash capacity " + std::to_string(capacity) + " is not a power of two");
+  }
+  if (chunks.size() != chunk_count(capacity, shape.chunk_size)) return R::err("hash chunk count does not match capacity");
+
+  std::vector<Slot> slots(capacity);
+  std::size_t size = 0;
+  for (std::size_t c = 0; c < chunks.size(); ++c) {
+    const std::string where = "chunk " + std::to_string(c) + ": ";
+    auto slotsR = read_items(chunks[c], "slots");
+    if (!slotsR) return R::err(where + slotsR.error->message);
+    auto keysR = read_items(chunks[c], "keys");
+    if (!keysR) return R::err(where + keysR.error->message);
+    std::vector<CrateItem> values;
+    if (with_values_) {
+      auto valuesR = read_items(chunks[c], "values");
+      if (!valuesR) return R::err(where + valuesR.error->message);
+      values = std::move(valuesR.value.value());
+    }
+    auto& keys = keysR.value.value();
+    if (keys.size() != slotsR.value->size() || (with_values_ && values.size() != keys.size())) {
+      return R::err(where + "slots, keys and values differ in length");
+    }
+    for (std::size_t e = 0; e < keys.size(); ++e) {
+      auto index = referee::cbor_uint(referee::CborSlice{ slotsR.value->at(e).data(), slotsR.value->at(e).size() });
+      if (!index || *index / shape.chunk_size != c || *index >= capacity || slots[*index].used) {
+        return R::err(where + "bad slot index");
+      }
+      auto& slot = slots[*index];
+      slot.used = true;
+      slot.hash = hash_item(keys[e]);
+      slot.key = std::move(keys[e]);
+      if (with_values_) slot.value = std::move(values[e]);
+      ++size;
+    }
+  }
+  slots_ = std::move(slots);
+  chunk_size_ = static_cast<std::size_t>(shape.chunk_size);
+  size_ = size;
+  dirty_.clear();
+  return R::ok();
+}
+
+const CrateItem* CrateMap::find(const CrateItem& key) const {
+  const auto* slot = find_slot(key);
+  return slot ? &slot->value : nullptr;
+}
+
+// -----------------------------
+// CrateBTreeMap
+// -----------------------------
+
+CrateBTreeMap::CrateBTreeMap(std::size_t chunk_size) : chunk_size_(std::max<std::size_t>(chunk_size, 2)) {}
+
+std::size_t CrateBTreeMap::leaf_for(const CrateItem& key) const {
+  if (leaves_.size() <= 1) return 0; // the only leaf may still be empty
+  auto it = std::upper_bound(leaves_.begin(), leaves_.end(), key,
+                             [](const CrateItem& k, const Leaf& leaf) { return k < leaf.keys.front(); });
+  return it == leaves_.begin() ? 0 : static_cast<std::size_t>(it - leaves_.begin()) - 1;
+}
+
+const CrateItem* CrateBTreeMap::find(const CrateItem& key) const {
+  if (leaves_.empty()) return nullptr;
+  const auto& leaf = leaves_[leaf_for(key)];
+  auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key);
+  if (it == leaf.keys.end() || *it != key) return nullptr;
+  return &leaf.values[static_cast<std::size_t>(it - leaf.keys.begin())];
+}
+
+bool CrateBTreeMap::insert_or_assign(CrateItem key, CrateItem value) {
+  if (leaves_.empty()) leaves_.push_back(Leaf{ next_key_++, {}, {} });
+  const std::size_t index = leaf_for(key);
+  auto& leaf = leaves_[index];
+  auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key);
+  const auto pos = it - leaf.keys.begin();
+  if (it != leaf.keys.end() && *it == key) {
+    leaf.values[static_cast<std::size_t>(pos)] = std::move(value);
+    touch(leaf.key);
+    return false;
+  }
+  leaf.keys.insert(it, std::move(key));
+  leaf.values.insert(leaf.values.begin() + pos, std::move(value));
+  ++size_;
+  touch(leaf.key);
+  if (leaf.keys.size() > chunk_size_) {
+    const auto half = static_cast<std::ptrdiff_t>(leaf.keys.size() / 2);
+    Leaf right{ next_key_++, {}, {} };
+    right.keys.assign(std::make_move_iterator(leaf.keys.begin() + half), std::make_move_iterator(leaf.keys.end()));
+    right.values.assign(std::make_move_iterator(leaf.values.begin() + half),
+                        std::make_move_iterator(leaf.values.end()));
+    leaf.keys.erase(leaf.keys.begin() + half, leaf.keys.end());
+    leaf.values.erase(leaf.values.begin() + half, leaf.values.end());
+    touch(right.key);
+    leaves_.insert(leaves_.begin() + static_cast<std::ptrdiff_t>(index) + 1, std::move(right));
+  }
+  return true;
+}
+
+bool CrateBTreeMap::erase(const CrateItem& key) {
+  if (leaves_.empty()) return false;
+  const std::size_t index = leaf_for(key);
+  auto& leaf = leaves_[index];
+  auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key);
+  if (it == leaf.keys.end() || *it != key) return false;
+  leaf.values.erase(leaf.values.begin() + (it - leaf.keys.begin()));
+  leaf.keys.erase(it);
+  --size_;
+  touch(leaf.key);
+  if (leaf.keys.empty()) leaves_.erase(leaves_.begin() + static_cast<std::ptrdiff_t>(index));
+  return true;
+}
+
+std::vector<CrateChunkKey> CrateBTreeMap::chunk_keys() const {
+  std::vector<CrateChunkKey> out;
+  out.reserve(leaves_.size());
+  for (const auto& leaf : leaves_) out.push_back(leaf.key);
+  return out;
+}
+
+referee::Bytes CrateBTreeMap::encode_chunk(CrateChunkKey key) const {
+  auto it = std::find_if(leaves_.begin(), leaves_.end(), [&](const Leaf& leaf) { return leaf.key == key; });
+  referee::CborWriter w;
+  w.map(2);
+  w.text("keys");
+  write_items(w, it == leaves_.end() ? std::span<const CrateItem>() : std::span<const CrateItem>(it->keys));
+  w.text("values");
+  write_items(w, it == leaves_.end() ? std::span<const CrateItem>() : std::span<const CrateItem>(it->values));
+  return w.take();
+}
+
+referee::Result<void> CrateBTreeMap::load(CrateShape shape, std::span<const referee::Bytes> chunks) {
+  using R = referee::Result<void>;
+  if (shape.chunk_size < 2) return R::err("btree leaf size is below two");
+  std::vector<Leaf> leaves;
+  std::size_t size = 0;
+  for (std::size_t c = 0; c < chunks.size(); ++c) {
+    const std::string where = "chunk " + std::to_string(c) + ": ";
+    auto keysR = read_items(chunks[c], "keys");
+    if (!keysR) return R::err(where + keysR.error->message);
+    auto valuesR = read_items(chunks[c], "values");
+    if (!valuesR) return R::err(where + valuesR.error->message);
+    Leaf leaf{ static_cast<CrateChunkKey>(c), std::move(keysR.value.value()), std::move(valuesR.value.value()) };
+    if (leaf.keys.empty() || leaf.keys.size() != leaf.values.size()) return R::err(where + "keys and values differ");
+    const CrateItem* prior = leaves.empty() ? nullptr : &leaves.back().keys.back();
+    for (const auto& k : leaf.keys) {
+      if (prior && !(*prior < k)) return R::err(where + "keys out of order");
+      prior = &k;
+    }
+    size += leaf.keys.size();
+    leaves.push_back(std::move(leaf));
+  }
+  chunk_size_ = static_cast<std::size_t>(shape.chunk_size);
+  size_ = size;
+  next_key_ = leaves.size();
+  leaves_ = std::move(leaves);
+  dirty_.clear();
+  return R::ok();
+}
+
+// -----------------------------
+// CrateStorage
+// -----------------------------
+
+referee::Result<CrateStorage> CrateStorage::create(SchemaRegistry& registry, referee::SqliteStore& store,
+                                                   referee::TypeID type, CrateChunked& container) {
+  using R = referee::Result<CrateStorage>;
+  if (!layout_fits(type, container.layout())) {
+    return R::err("layout '" + std::string(container.layout()) + "' does not fit the collection type");
+  }
+  CrateStorage out(registry, store);
+  out.type_ = type;
+  CrateSaveResult ignored;
+  auto writeR = out.write(container, true, &ignored);
+  if (!writeR) return R::err(writeR.error->message);
+  return R::ok(std::move(out));
+}
+
+referee::Result<CrateStorage> CrateStorage::open(SchemaRegistry& registry, referee::SqliteStore& store,
+                                                 referee::ObjectID root, CrateChunked& container) {
+  using R = referee::Result<CrateStorage>;
+  auto rootR = store.get_latest(root);
+  if (!rootR) return R::err(rootR.error->message);
+  if (!rootR.value->has_value()) return R::err("collection " + root.to_hex() + " not found");
+  const auto& record = rootR.value->value();
+  const auto& payload = record.payload_cbor;
+
+  auto layout = referee::cbor_find_text(payload, {"layout"});
+  if (!layout || *layout != container.layout() || !layout_fits(record.type, *layout)) {
+    return R::err("collection " + root.to_hex() + " is not stored as '" + std::string(container.layout()) + "'");
+  }
+  CrateShape shape;
+  auto chunk_size = referee::cbor_find(payload, {"chunk_size"});
+  auto capacity = referee::cbor_find(payload, {"capacity"});
+  if (!chunk_size || !capacity || !referee::cbor_uint(*chunk_size) || !referee::cbor_uint(*capacity)) {
+    return R::err("collection " + root.to_hex() + " has no chunk shape");
+  }
+  shape.chunk_size = *referee::cbor_uint(*chunk_size);
+  shape.capacity = *referee::cbor_uint(*capacity);
+
+  auto idsR = read_items(payload, "chunks");
+  if (!idsR) return R::err("collection " + root.to_hex() + ": " + idsR.error->message);
+  std::vector<referee::ObjectRef> refs;
+  std::vector<referee::Bytes> chunks;
+  for (const auto& id : idsR.value.value()) {
+    auto hex = referee::cbor_text(referee::CborSlice{ id.data(), id.size() });
+    if (!hex) return R::err("collection " + root.to_hex() + ": chunk ids must be text");
+    auto chunkR = store.get_latest(referee::ObjectID::from_hex(*hex));
+    if (!chunkR) return R::err(chunkR.error->message);
+    if (!chunkR.value->has_value()) return R::err("chunk " + std::string(*hex) + " not found");
+    refs.push_back(chunkR.value->value().ref);
+    chunks.push_back(std::move(chunkR.value->value().payload_cbor));
+  }
+  auto loadR = container.load(shape, chunks);
+  if (!loadR) return R::err("collection " + root.to_hex() + ": " + loadR.error->message);
+
+  CrateStorage out(registry, store);
+  out.type_ = record.type;
+  out.root_ = record.ref;
+  out.shape_ = shape;
+  out.order_ = container.chunk_keys();
+  if (out.order_.size() != refs.size()) return R::err("collection " + root.to_hex() + ": chunk count mismatch");
+  for (std::size_t i = 0; i < refs.size(); ++i) out.chunks_[out.order_[i]] = refs[i];
+  container.mark_clean();
+  return R::ok(std::move(out));
+}
+
+referee::Result<CrateSaveResult> CrateStorage::save(CrateChunked& container) {
+  using R = referee::Result<CrateSaveResult>;
+  CrateSaveResult result;
+  auto writeR = write(container, false, &result);
+  if (!writeR) return R::err(writeR.error->message);
+  return R::ok(result);
+}
+
+referee::Result<void> CrateStorage::write(CrateChunked& container, bool all, CrateSaveResult* result) {
+  using R = referee::Result<void>;
+  auto chunkDefR = definition_for(*registry_, kCrateChunkType);
+  if (!chunkDefR) return R::err(chunkDefR.error->message);
+  auto rootDefR = definition_for(*registry_, type_);
+  if (!rootDefR) return R::err(rootDefR.error->message);
+
+  const auto keys = container.chunk_keys();
+  const auto shape = container.shape();
+  const auto& dirty = container.dirty_chunks();
+  std::map<CrateChunkKey, referee::ObjectRef> chunks;
+  std::vector<referee::ObjectRef> refs;
+  refs.reserve(keys.size());
+
+  auto beginR = store_->begin();
+  if (!beginR) return R::err(beginR.error->message);
+  for (auto key : keys) {
+    auto prior = chunks_.find(key);
+    if (!all && prior != chunks_.end() && !dirty.count(key)) {
+      chunks[key] = prior->second;
+      refs.push_back(prior->second);
+      continue;
+    }
+    const auto payload = container.encode_chunk(key);
+    auto writeR = prior == chunks_.end() ? store_->create_object(kCrateChunkType, chunkDefR.value.value(), payload)
+                                         : store_->create_version(prior->second, chunkDefR.value.value(), payload);
+    if (!writeR) {
+      store_->rollback();
+      return R::err("chunk " + std::to_string(key) + ": " + writeR.error->message);
+    }
+    chunks[key] = writeR.value->ref;
+    refs.push_back(writeR.value->ref);
+    ++result->chunks_written;
+  }
+
+  auto root = root_;
+  const bool layout_changed = all || keys != order_ || shape.chunk_size != shape_.chunk_size
+                              || shape.capacity != shape_.capacity;
+  if (layout_changed) {
+    const auto payload = encode_root(container.layout(), shape, refs);
+    auto writeR = root_.ver.v == 0 ? store_->create_object(type_, rootDefR.value.value(), payload)
+                                   : store_->create_version(root_, rootDefR.value.value(), payload);
+    if (!writeR) {
+      store_->rollback();
+      return R::err("collection root: " + writeR.error->message);
+    }
+    root = writeR.value->ref;
+    result->root_written = true;
+  }
+  auto commitR = store_->commit();
+  if (!commitR) return R::err(commitR.error->message);
+
+  root_ = root;
+  shape_ = shape;
+  order_ = keys;
+  chunks_ = std::move(chunks);
+  container.mark_clean();
+  return R::ok();
+}
+
+} // namespace iris::refract
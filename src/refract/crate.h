@@ -0,0 +1,259 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Native containers for Crate collections, persisted in chunks.
+//
+// Elements, keys and values are encoded CBOR items kept as opaque bytes. Every
+// container is cut into chunks, each stored as one Crate::Chunk object; the
+// collection's root object (of its Crate type) lists the chunks in order. Containers
+// remember the chunks they changed, so saving after an append or a point update
+// writes only those chunks, and the root only when the chunk list changed.
+namespace iris::refract {
+
+inline constexpr referee::TypeID kCrateArrayType{0x4352415400000001ULL};
+inline constexpr referee::TypeID kCrateListType{0x4352415400000002ULL};
+inline constexpr referee::TypeID kCrateSetType{0x4352415400000003ULL};
+inline constexpr referee::TypeID kCrateMapType{0x4352415400000004ULL};
+inline constexpr referee::TypeID kCrateTupleType{0x4352415400000005ULL};
+inline constexpr referee::TypeID kCrateChunkType{0x4352415400000006ULL};
+
+using CrateItem = referee::Bytes;
+using CrateChunkKey = std::uint64_t;
+
+// Parameters the chunk contents depend on, kept on the root.
+struct CrateShape {
+  std::uint64_t chunk_size{0}; // items, slots or entries per chunk
+  std::uint64_t capacity{0};   // hash table slots; 0 for other layouts
+};
+
+// The view CrateStorage has of a container.
+class CrateChunked {
+public:
+  virtual ~CrateChunked() = default;
+
+  virtual std::string_view layout() const = 0;
+  virtual CrateShape shape() const = 0;
+  // Keys of the current chunks in order. A key names the same chunk until it is
+  // removed, and is not handed out again afterwards.
+  virtual std::vector<CrateChunkKey> chunk_keys() const = 0;
+  virtual referee::Bytes encode_chunk(CrateChunkKey key) const = 0;
+  // Replaces the contents with `chunks`, in chunk_keys() order once loaded.
+  virtual referee::Result<void> load(CrateShape shape, std::span<const referee::Bytes> chunks) = 0;
+
+  const std::set<CrateChunkKey>& dirty_chunks() const { return dirty_; }
+  void mark_clean() { dirty_.clear(); }
+
+protected:
+  void touch(CrateChunkKey key) { dirty_.insert(key); }
+  void touch_all();
+
+  std::set<CrateChunkKey> dirty_;
+};
+
+// Crate::Array, Crate::List and Crate::Tuple: items in one contiguous vector, cut
+// into chunks of `chunk_size` items.
+class CrateArray : public CrateChunked {
+public:
+  static constexpr std::size_t kDefaultChunkItems = 256;
+
+  explicit CrateArray(std::size_t chunk_size = kDefaultChunkItems);
+
+  std::size_t size() const { return items_.size(); }
+  const CrateItem& at(std::size_t index) const { return items_[index]; }
+  const std::vector<CrateItem>& items() const { return items_; }
+  bool contains(const CrateItem& item) const;
+
+  void set(std::size_t index, CrateItem item);
+  void push_back(CrateItem item);
+  void pop_back();
+  // Shifts the items after `index`, so every chunk from there on is rewritten.
+  void insert(std::size_t index, CrateItem item);
+  void erase(std::size_t index);
+
+  std::string_view layout() const override { return "array"; }
+  CrateShape shape() const override { return CrateShape{ chunk_size_, 0 }; }
+  std::vector<CrateChunkKey> chunk_keys() const override;
+  referee::Bytes encode_chunk(CrateChunkKey key) const override;
+  referee::Result<void> load(CrateShape shape, std::span<const referee::Bytes> chunks) override;
+
+private:
+  void touch_from(std::size_t index);
+
+  std::size_t chunk_size_;
+  std::vector<CrateItem> items_;
+};
+
+// Open addressing with linear probing and backward-shift deletion, so a slot holds
+// the same entry in memory and in its stored chunk. Chunks are fixed slot ranges;
+// growing the table rehashes and rewrites all of them.
+class CrateHashTable : public CrateChunked {
+public:
+  static constexpr std::size_t kDefaultChunkSlots = 256;
+  static constexpr std::size_t kMinCapacity = 16;
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return slots_.size(); }
+
+  CrateShape shape() const override { return CrateShape{ chunk_size_, slots_.size() }; }
+  std::vector<CrateChunkKey> chunk_keys() const override;
+  referee::Bytes encode_chunk(CrateChunkKey key) const override;
+  referee::Result<void> load(CrateShape shape, std::span<const referee::Bytes> chunks) override;
+
+protected:
+  struct Slot {
+    bool used{false};
+    std::uint64_t hash{0};
+    CrateItem key;
+    CrateItem value;
+  };
+
+  CrateHashTable(bool with_values, std::size_t chunk_size);
+
+  const Slot* find_slot(const CrateItem& key) const;
+  // Inserts or replaces; false if `key` was already present.
+  bool put(CrateItem key, CrateItem value);
+  bool remove(const CrateItem& key);
+
+  std::vector<Slot> slots_;
+
+private:
+  std::size_t probe(std::uint64_t hash, const CrateItem& key) const;
+  void grow();
+  void touch_slot(std::size_t slot) { touch(slot / chunk_size_); }
+
+  bool with_values_;
+  std::size_t chunk_size_;
+  std::size_t size_{0};
+};
+
+// Crate::Set.
+class CrateSet : public CrateHashTable {
+public:
+  explicit CrateSet(std::size_t chunk_size = kDefaultChunkSlots) : CrateHashTable(false, chunk_size) {}
+
+  bool contains(const CrateItem& item) const { return find_slot(item) != nullptr; }
+  bool insert(CrateItem item) { return put(std::move(item), {}); }
+  bool erase(const CrateItem& item) { return remove(item); }
+
+  // Slot order, which is not stable across growth.
+  template <typename F> void for_each(F&& f) const {
+    for (const auto& slot : slots_) {
+      if (slot.used) f(slot.key);
+    }
+  }
+
+  std::string_view layout() const override { return "hash-set"; }
+};
+
+// Crate::Map, unordered.
+class CrateMap : public CrateHashTable {
+public:
+  explicit CrateMap(std::size_t chunk_size = kDefaultChunkSlots) : CrateHashTable(true, chunk_size) {}
+
+  bool contains(const CrateItem& key) const { return find_slot(key) != nullptr; }
+  const CrateItem* find(const CrateItem& key) const;
+  // True if `key` is new.
+  bool insert_or_assign(CrateItem key, CrateItem value) { return put(std::move(key), std::move(value)); }
+  bool erase(const CrateItem& key) { return remove(key); }
+
+  template <typename F> void for_each(F&& f) const {
+    for (const auto& slot : slots_) {
+      if (slot.used) f(slot.key, slot.value);
+    }
+  }
+
+  std::string_view layout() const override { return "hash-map"; }
+};
+
+// Crate::Map ordered by the encoded bytes of its keys: a B+ tree whose leaves are
+// the chunks, each holding up to `chunk_size` sorted entries, under an in-memory
+// index of their first keys. A full leaf splits into two; an emptied leaf is dropped.
+class CrateBTreeMap : public CrateChunked {
+public:
+  static constexpr std::size_t kDefaultLeafEntries = 128;
+
+  explicit CrateBTreeMap(std::size_t chunk_size = kDefaultLeafEntries);
+
+  std::size_t size() const { return size_; }
+  std::size_t leaves() const { return leaves_.size(); }
+  bool contains(const CrateItem& key) const { return find(key) != nullptr; }
+  const CrateItem* find(const CrateItem& key) const;
+  bool insert_or_assign(CrateItem key, CrateItem value);
+  bool erase(const CrateItem& key);
+
+  // Key order.
+  template <typename F> void for_each(F&& f) const {
+    for (const auto& leaf : leaves_) {
+      for (std::size_t i = 0; i < leaf.keys.size(); ++i) f(leaf.keys[i], leaf.values[i]);
+    }
+  }
+
+  std::string_view layout() const override { return "btree-map"; }
+  CrateShape shape() const override { return CrateShape{ chunk_size_, 0 }; }
+  std::vector<CrateChunkKey> chunk_keys() const override;
+  referee::Bytes encode_chunk(CrateChunkKey key) const override;
+  referee::Result<void> load(CrateShape shape, std::span<const referee::Bytes> chunks) override;
+
+private:
+  struct Leaf {
+    CrateChunkKey key{0};
+    std::vector<CrateItem> keys;
+    std::vector<CrateItem> values;
+  };
+
+  std::size_t leaf_for(const CrateItem& key) const;
+
+  std::size_t chunk_size_;
+  std::size_t size_{0};
+  CrateChunkKey next_key_{0};
+  std::vector<Leaf> leaves_;
+};
+
+struct CrateSaveResult {
+  std::size_t chunks_written{0};
+  bool root_written{false};
+};
+
+// A container's place in the store: its root object and the chunk objects behind
+// each chunk key.
+class CrateStorage {
+public:
+  // Writes every chunk and a new root of `type`.
+  static referee::Result<CrateStorage> create(SchemaRegistry& registry, referee::SqliteStore& store,
+                                              referee::TypeID type, CrateChunked& container);
+  // Loads the latest version of the collection at `root` into `container`, whose
+  // layout must match the stored one.
+  static referee::Result<CrateStorage> open(SchemaRegistry& registry, referee::SqliteStore& store,
+                                            referee::ObjectID root, CrateChunked& container);
+
+  // Writes the chunks `container` changed since the last create, open or save in
+  // one transaction, then marks it clean.
+  referee::Result<CrateSaveResult> save(CrateChunked& container);
+
+  const referee::ObjectRef& root() const { return root_; }
+
+private:
+  CrateStorage(SchemaRegistry& registry, referee::SqliteStore& store) : registry_(&registry), store_(&store) {}
+
+  referee::Result<void> write(CrateChunked& container, bool all, CrateSaveResult* result);
+
+  SchemaRegistry* registry_;
+  referee::SqliteStore* store_;
+  referee::TypeID type_{};
+  referee::ObjectRef root_{};
+  CrateShape shape_{};
+  std::vector<CrateChunkKey> order_;
+  std::map<CrateChunkKey, referee::ObjectRef> chunks_;
+};
+
+} // namespace iris::refract
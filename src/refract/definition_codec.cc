@@ -0,0 +1,448 @@
+#include "refract/definition_codec.h"
+
+#include <cstring>
+
+namespace iris::refract {
+
+namespace {
+
+constexpr std::uint8_t kMagic[4] = {'R', 'D', 'F', '1'};
+
+constexpr std::size_t kHeaderBytes = 136;
+constexpr std::size_t kFormatAt = 4;
+constexpr std::size_t kFlagsAt = 6;
+constexpr std::size_t kTypeIdAt = 8;
+constexpr std::size_t kVersionAt = 16;
+constexpr std::size_t kEnumValueTypeAt = 24;
+constexpr std::size_t kNameAt = 32;
+constexpr std::size_t kNamespaceAt = 40;
+constexpr std::size_t kKindAt = 48;
+constexpr std::size_t kRendererAt = 56;
+constexpr std::size_t kByteOrderAt = 64;
+constexpr std::size_t kCollectionKindAt = 72;
+constexpr std::size_t kTypeParamsAt = 80;
+constexpr std::size_t kFieldsAt = 88;
+constexpr std::size_t kEnumValuesAt = 96;
+constexpr std::size_t kPacketFieldsAt = 104;
+constexpr std::size_t kCollectionElementsAt = 112;
+constexpr std::size_t kOperationsAt = 120;
+constexpr std::size_t kRelationshipsAt = 128;
+
+constexpr std::uint16_t kHasKind = 1u << 0;
+constexpr std::uint16_t kHasRenderer = 1u << 1;
+constexpr std::uint16_t kHasByteOrder = 1u << 2;
+constexpr std::uint16_t kHasCollectionKind = 1u << 3;
+constexpr std::uint16_t kHasEnumValueType = 1u << 4;
+
+constexpr std::uint32_t kFieldRequired = 1u << 0;
+constexpr std::uint32_t kFieldHasDefault = 1u << 1;
+
+constexpr std::size_t kStrBytes = 8;
+constexpr std::size_t kFieldBytes = 32;       // name | type | default_json | flags | pad
+constexpr std::size_t kEnumValueBytes = 16;   // name | value_json
+constexpr std::size_t kPacketFieldBytes = 24; // name | type | bit_width | pad
+constexpr std::size_t kElementBytes = 16;     // role | type
+constexpr std::size_t kOperationBytes = 40;   // name | scope | pad | params | outputs | caps
+constexpr std::size_t kParamBytes = 24;       // name | type | optional | pad
+constexpr std::size_t kRelationshipBytes = 24; // role | cardinality | target
+
+std::uint16_t load_u16(const std::uint8_t* p) {
+  return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t load_u32(const std::uint8_t* p) {
+  std::uint32_t v = 0;
+  for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+  return v;
+}
+
+std::uint64_t load_u64(const std::uint8_t* p) {
+  return std::uint64_t(load_u32(p)) | (std::uint64_t(load_u32(p + 4)) << 32);
+}
+
+std::string_view load_str(const std::uint8_t* base, const std::uint8_t* at) {
+  return std::string_view(reinterpret_cast<const char*>(base + load_u32(at)), load_u32(at + 4));
+}
+
+struct Table {
+  const std::uint8_t* entries{nullptr};
+  std::size_t count{0};
+};
+
+Table load_table(const std::uint8_t* base, const std::uint8_t* at) {
+  return Table{base + load_u32(at), load_u32(at + 4)};
+}
+
+void store_u16(referee::Bytes* out, std::size_t at, std::uint16_t v) {
+  (*out)[at] = static_cast<std::uint8_t>(v & 0xFFu);
+  (*out)[at + 1] = static_cast<std::uint8_t>(v >> 8);
+}
+
+void store_u32(referee::Bytes* out, std::size_t at, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) (*out)[at + i] = static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu);
+}
+
+void store_u64(referee::Bytes* out, std::size_t at, std::uint64_t v) {
+  store_u32(out, at, static_cast<std::uint32_t>(v));
+  store_u32(out, at + 4, static_cast<std::uint32_t>(v >> 32));
+}
+
+// Appends the bytes of `s` and points the str slot at `at` to them.
+void put_str(referee::Bytes* out, std::size_t at, std::string_view s) {
+  const auto offset = out->size();
+  out->insert(out->end(), s.begin(), s.end());
+  store_u32(out, at, static_cast<std::uint32_t>(offset));
+  store_u32(out, at + 4, static_cast<std::uint32_t>(s.size()));
+}
+
+// Reserves zeroed room for `count` entries and points the table slot at `at` to it.
+std::size_t put_table(referee::Bytes* out, std::size_t at, std::size_t count, std::size_t entry) {
+  const auto offset = out->size();
+  out->resize(offset + count * entry, 0);
+  store_u32(out, at, static_cast<std::uint32_t>(offset));
+  store_u32(out, at + 4, static_cast<std::uint32_t>(count));
+  return offset;
+}
+
+void put_params(referee::Bytes* out, std::size_t at, const std::vector<ParameterDefinition>& params) {
+  auto entry = put_table(out, at, params.size(), kParamBytes);
+  for (const auto& param : params) {
+    put_str(out, entry, param.name);
+    store_u64(out, entry + 8, param.type.v);
+    store_u32(out, entry + 16, param.optional ? 1 : 0);
+    entry += kParamBytes;
+  }
+}
+
+ParameterView param_at(const std::uint8_t* base, const std::uint8_t* entry) {
+  return ParameterView{load_str(base, entry), referee::TypeID{load_u64(entry + 8)},
+                       load_u32(entry + 16) != 0};
+}
+
+class Checker {
+public:
+  Checker(const std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+  bool str(const std::uint8_t* at) const {
+    return std::uint64_t(load_u32(at)) + load_u32(at + 4) <= size_;
+  }
+
+  bool table(const std::uint8_t* at, std::size_t entry, Table* out) const {
+    const auto offset = load_u32(at);
+    const auto count = load_u32(at + 4);
+    if (std::uint64_t(offset) + std::uint64_t(count) * entry > size_) return false;
+    *out = Table{data_ + offset, count};
+    return true;
+  }
+
+  // Every str slot at `str_offsets` within each entry must be in bounds.
+  template <std::size_t N>
+  bool entries(const std::uint8_t* at, std::size_t entry, const std::size_t (&str_offsets)[N],
+               Table* out) const {
+    if (!table(at, entry, out)) return false;
+    for (std::size_t i = 0; i < out->count; ++i) {
+      for (auto offset : str_offsets) {
+        if (!str(out->entries + i * entry + offset)) return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  const std::uint8_t* data_;
+  std::size_t size_;
+};
+
+} // namespace
+
+bool is_binary_definition(const std::uint8_t* data, std::size_t size) {
+  return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+referee::Bytes encode_definition_binary(const TypeDefinition& def) {
+  referee::Bytes out(kHeaderBytes, 0);
+  std::memcpy(out.data(), kMagic, sizeof(kMagic));
+  store_u16(&out, kFormatAt, kDefinitionFormatVersion);
+
+  std::uint16_t flags = 0;
+  if (def.kind) flags |= kHasKind;
+  if (def.preferred_renderer) flags |= kHasRenderer;
+  if (def.packet_byte_order) flags |= kHasByteOrder;
+  if (def.collection_kind) flags |= kHasCollectionKind;
+  if (def.has_enum_value_type) flags |= kHasEnumValueType;
+  store_u16(&out, kFlagsAt, flags);
+  store_u64(&out, kTypeIdAt, def.type_id.v);
+  store_u64(&out, kVersionAt, def.version);
+  store_u64(&out, kEnumValueTypeAt, def.enum_value_type.v);
+
+  put_str(&out, kNameAt, def.name);
+  put_str(&out, kNamespaceAt, def.namespace_name);
+  put_str(&out, kKindAt, def.kind.value_or(""));
+  put_str(&out, kRendererAt, def.preferred_renderer.value_or(""));
+  put_str(&out, kByteOrderAt, def.packet_byte_order.value_or(""));
+  put_str(&out, kCollectionKindAt, def.collection_kind.value_or(""));
+
+  auto entry = put_table(&out, kTypeParamsAt, def.type_params.size(), kStrBytes);
+  for (const auto& param : def.type_params) {
+    put_str(&out, entry, param);
+    entry += kStrBytes;
+  }
+
+  entry = put_table(&out, kFieldsAt, def.fields.size(), kFieldBytes);
+  for (const auto& field : def.fields) {
+    put_str(&out, entry, field.name);
+    store_u64(&out, entry + 8, field.type.v);
+    put_str(&out, entry + 16, field.default_json.value_or(""));
+    std::uint32_t field_flags = field.required ? kFieldRequired : 0;
+    if (field.default_json) field_flags |= kFieldHasDefault;
+    store_u32(&out, entry + 24, field_flags);
+    entry += kFieldBytes;
+  }
+
+  entry = put_table(&out, kEnumValuesAt, def.enum_values.size(), kEnumValueBytes);
+  for (const auto& value : def.enum_values) {
+    put_str(&out, entry, value.name);
+    put_str(&out, entry + 8, value.value_json);
+    entry += kEnumValueBytes;
+  }
+
+  entry = put_table(&out, kPacketFieldsAt, def.packet_fields.size(), kPacketFieldBytes);
+  for (const auto& field : def.packet_fields) {
+    put_str(&out, entry, field.name);
+    store_u64(&out, entry + 8, field.type.v);
+    store_u32(&out, entry + 16, field.bit_width);
+    entry += kPacketFieldBytes;
+  }
+
+  entry = put_table(&out, kCollectionElementsAt, def.collection_elements.size(), kElementBytes);
+  for (const auto& element : def.collection_elements) {
+    put_str(&out, entry, element.role);
+    store_u64(&out, entry + 8, element.type.v);
+    entry += kElementBytes;
+  }
+
+  entry = put_table(&out, kOperationsAt, def.operations.size(), kOperationBytes);
+  for (const auto& op : def.operations) {
+    put_str(&out, entry, op.name);
+    store_u32(&out, entry + 8, op.scope == OperationScope::Class ? 0 : 1);
+    put_params(&out, entry + 16, op.signature.params);
+    put_params(&out, entry + 24, op.signature.outputs);
+    auto cap = put_table(&out, entry + 32, op.required_capabilities.size(), kStrBytes);
+    for (const auto& name : op.required_capabilities) {
+      put_str(&out, cap, name);
+      cap += kStrBytes;
+    }
+    entry += kOperationBytes;
+  }
+
+  entry = put_table(&out, kRelationshipsAt, def.relationships.size(), kRelationshipBytes);
+  for (const auto& rel : def.relationships) {
+    put_str(&out, entry, rel.role);
+    put_str(&out, entry + 8, rel.cardinality);
+    put_str(&out, entry + 16, rel.target);
+    entry += kRelationshipBytes;
+  }
+
+  return out;
+}
+
+referee::Result<DefinitionView> DefinitionView::open(const std::uint8_t* data, std::size_t size) {
+  using R = referee::Result<DefinitionView>;
+  if (size < kHeaderBytes || !is_binary_definition(data, size)) {
+    return R::err("not a binary type definition");
+  }
+  if (load_u16(data + kFormatAt) != kDefinitionFormatVersion) {
+    return R::err("unsupported type definition format " + std::to_string(load_u16(data + kFormatAt)));
+  }
+
+  const Checker check(data, size);
+  for (auto at : {kNameAt, kNamespaceAt, kKindAt, kRendererAt, kByteOrderAt, kCollectionKindAt}) {
+    if (!check.str(data + at)) return R::err("type definition string out of bounds");
+  }
+  Table table;
+  if (!check.entries(data + kTypeParamsAt, kStrBytes, {0}, &table)
+      || !check.entries(data + kFieldsAt, kFieldBytes, {0, 16}, &table)
+      || !check.entries(data + kEnumValuesAt, kEnumValueBytes, {0, 8}, &table)
+      || !check.entries(data + kPacketFieldsAt, kPacketFieldBytes, {0}, &table)
+      || !check.entries(data + kCollectionElementsAt, kElementBytes, {0}, &table)
+      || !check.entries(data + kRelationshipsAt, kRelationshipBytes, {0, 8, 16}, &table)) {
+    return R::err("type definition table out of bounds");
+  }
+  Table ops;
+  if (!check.entries(data + kOperationsAt, kOperationBytes, {0}, &ops)) {
+    return R::err("type definition table out of bounds");
+  }
+  for (std::size_t i = 0; i < ops.count; ++i) {
+    const auto* op = ops.entries + i * kOperationBytes;
+    if (load_u32(op + 8) > 1
+        || !check.entries(op + 16, kParamBytes, {0}, &table)
+        || !check.entries(op + 24, kParamBytes, {0}, &table)
+        || !check.entries(op + 32, kStrBytes, {0}, &table)) {
+      return R::err("type definition operation out of bounds");
+    }
+  }
+  return R::ok(DefinitionView(data));
+}
+
+referee::TypeID DefinitionView::type_id() const { return referee::TypeID{load_u64(data_ + kTypeIdAt)}; }
+std::string_view DefinitionView::name() const { return load_str(data_, data_ + kNameAt); }
+std::string_view DefinitionView::namespace_name() const { return load_str(data_, data_ + kNamespaceAt); }
+std::uint64_t DefinitionView::version() const { return load_u64(data_ + kVersionAt); }
+
+std::optional<std::string_view> DefinitionView::kind() const {
+  if (!(load_u16(data_ + kFlagsAt) & kHasKind)) return std::nullopt;
+  return load_str(data_, data_ + kKindAt);
+}
+
+std::optional<std::string_view> DefinitionView::preferred_renderer() const {
+  if (!(load_u16(data_ + kFlagsAt) & kHasRenderer)) return std::nullopt;
+  return load_str(data_, data_ + kRendererAt);
+}
+
+std::size_t DefinitionView::field_count() const { return load_u32(data_ + kFieldsAt + 4); }
+
+FieldView DefinitionView::field(std::size_t i) const {
+  const auto* entry = load_table(data_, data_ + kFieldsAt).entries + i * kFieldBytes;
+  const auto flags = load_u32(entry + 24);
+  FieldView out{load_str(data_, entry), referee::TypeID{load_u64(entry + 8)},
+                (flags & kFieldRequired) != 0, std::nullopt};
+  if (flags & kFieldHasDefault) out.default_json = load_str(data_, entry + 16);
+  return out;
+}
+
+std::size_t DefinitionView::operation_count() const { return load_u32(data_ + kOperationsAt + 4); }
+
+OperationView DefinitionView::operation(std::size_t i) const {
+  return OperationView(data_, load_table(data_, data_ + kOperationsAt).entries + i * kOperationBytes);
+}
+
+std::optional<OperationView> DefinitionView::find_operation(std::string_view name,
+                                                            OperationScope scope) const {
+  for (std::size_t i = 0; i < operation_count(); ++i) {
+    auto op = operation(i);
+    if (op.scope() == scope && op.name() == name) return op;
+  }
+  return std::nullopt;
+}
+
+std::size_t DefinitionView::relationship_count() const {
+  return load_u32(data_ + kRelationshipsAt + 4);
+}
+
+RelationshipView DefinitionView::relationship(std::size_t i) const {
+  const auto* entry = load_table(data_, data_ + kRelationshipsAt).entries + i * kRelationshipBytes;
+  return RelationshipView{load_str(data_, entry), load_str(data_, entry + 8),
+                          load_str(data_, entry + 16)};
+}
+
+std::string_view OperationView::name() const { return load_str(base_, entry_); }
+
+OperationScope OperationView::scope() const {
+  return load_u32(entry_ + 8) == 0 ? OperationScope::Class : OperationScope::Object;
+}
+
+std::size_t OperationView::param_count() const { return load_u32(entry_ + 16 + 4); }
+
+ParameterView OperationView::param(std::size_t i) const {
+  return param_at(base_, load_table(base_, entry_ + 16).entries + i * kParamBytes);
+}
+
+std::size_t OperationView::output_count() const { return load_u32(entry_ + 24 + 4); }
+
+ParameterView OperationView::output(std::size_t i) const {
+  return param_at(base_, load_table(base_, entry_ + 24).entries + i * kParamBytes);
+}
+
+std::size_t OperationView::capability_count() const { return load_u32(entry_ + 32 + 4); }
+
+std::string_view OperationView::capability(std::size_t i) const {
+  return load_str(base_, load_table(base_, entry_ + 32).entries + i * kStrBytes);
+}
+
+TypeDefinition DefinitionView::materialize() const {
+  TypeDefinition def{};
+  const auto flags = load_u16(data_ + kFlagsAt);
+  def.type_id = type_id();
+  def.name = name();
+  def.namespace_name = namespace_name();
+  def.version = version();
+  if (auto k = kind()) def.kind = std::string(*k);
+  if (auto r = preferred_renderer()) def.preferred_renderer = std::string(*r);
+  if (flags & kHasByteOrder) def.packet_byte_order = std::string(load_str(data_, data_ + kByteOrderAt));
+  if (flags & kHasCollectionKind) {
+    def.collection_kind = std::string(load_str(data_, data_ + kCollectionKindAt));
+  }
+  if (flags & kHasEnumValueType) {
+    def.has_enum_value_type = true;
+    def.enum_value_type = referee::TypeID{load_u64(data_ + kEnumValueTypeAt)};
+  }
+
+  auto table = load_table(data_, data_ + kTypeParamsAt);
+  def.type_params.reserve(table.count);
+  for (std::size_t i = 0; i < table.count; ++i) {
+    def.type_params.emplace_back(load_str(data_, table.entries + i * kStrBytes));
+  }
+
+  def.fields.reserve(field_count());
+  for (std::size_t i = 0; i < field_count(); ++i) {
+    auto view = field(i);
+    FieldDefinition f{std::string(view.name), view.type, view.required, std::nullopt};
+    if (view.default_json) f.default_json = std::string(*view.default_json);
+    def.fields.push_back(std::move(f));
+  }
+
+  table = load_table(data_, data_ + kEnumValuesAt);
+  def.enum_values.reserve(table.count);
+  for (std::size_t i = 0; i < table.count; ++i) {
+    const auto* entry = table.entries + i * kEnumValueBytes;
+    def.enum_values.push_back(EnumValueDefinition{std::string(load_str(data_, entry)),
+                                                  std::string(load_str(data_, entry + 8))});
+  }
+
+  table = load_table(data_, data_ + kPacketFieldsAt);
+  def.packet_fields.reserve(table.count);
+  for (std::size_t i = 0; i < table.count; ++i) {
+    const auto* entry = table.entries + i * kPacketFieldBytes;
+    def.packet_fields.push_back(PacketFieldDefinition{std::string(load_str(data_, entry)),
+                                                      referee::TypeID{load_u64(entry + 8)},
+                                                      load_u32(entry + 16)});
+  }
+
+  table = load_table(data_, data_ + kCollectionElementsAt);
+  def.collection_elements.reserve(table.count);
+  for (std::size_t i = 0; i < table.count; ++i) {
+    const auto* entry = table.entries + i * kElementBytes;
+    def.collection_elements.push_back(CollectionElementDefinition{
+        std::string(load_str(data_, entry)), referee::TypeID{load_u64(entry + 8)}});
+  }
+
+  auto to_param = [](const ParameterView& view) {
+    return ParameterDefinition{std::string(view.name), view.type, view.optional};
+  };
+  def.operations.reserve(operation_count());
+  for (std::size_t i = 0; i < operation_count(); ++i) {
+    auto view = operation(i);
+    OperationDefinition op;
+    op.name = view.name();
+    op.scope = view.scope();
+    for (std::size_t p = 0; p < view.param_count(); ++p) op.signature.params.push_back(to_param(view.param(p)));
+    for (std::size_t p = 0; p < view.output_count(); ++p) {
+      op.signature.outputs.push_back(to_param(view.output(p)));
+    }
+    for (std::size_t c = 0; c < view.capability_count(); ++c) {
+      op.required_capabilities.emplace_back(view.capability(c));
+    }
+    def.operations.push_back(std::move(op));
+  }
+
+  def.relationships.reserve(relationship_count());
+  for (std::size_t i = 0; i < relationship_count(); ++i) {
+    auto view = relationship(i);
+    def.relationships.push_back(RelationshipSpec{std::string(view.role), std::string(view.cardinality),
+                                                 std::string(view.target)});
+  }
+
+  return def;
+}
+
+} // namespace iris::refract
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Binary TypeDefinition layout ("RDF1"), read in place.
+//
+//   header (136 bytes): magic | u16 format | u16 flags | u64 type_id | u64 version
+//     | u64 enum_value_type | str name, namespace, kind, renderer, byte_order,
+//       collection_kind | table type_params, fields, enum_values, packet_fields,
+//       collection_elements, operations, relationships
+//   tables: fixed-size entries, so element i is at offset + i * entry size
+//   strings: UTF-8 bytes, not terminated
+//
+// A str is (u32 offset, u32 length) and a table is (u32 offset, u32 count), both
+// relative to the start of the payload. All integers are little-endian. Payloads
+// written before this layout are CBOR maps and never start with the magic.
+namespace iris::refract {
+
+constexpr std::uint16_t kDefinitionFormatVersion = 1;
+
+referee::Bytes encode_definition_binary(const TypeDefinition& def);
+bool is_binary_definition(const std::uint8_t* data, std::size_t size);
+
+class DefinitionView;
+
+struct ParameterView {
+  std::string_view name;
+  referee::TypeID type{};
+  bool optional{false};
+};
+
+class OperationView {
+public:
+  std::string_view name() const;
+  OperationScope scope() const;
+  std::size_t param_count() const;
+  ParameterView param(std::size_t i) const;
+  std::size_t output_count() const;
+  ParameterView output(std::size_t i) const;
+  std::size_t capability_count() const;
+  std::string_view capability(std::size_t i) const;
+
+private:
+  friend class DefinitionView;
+  OperationView(const std::uint8_t* base, const std::uint8_t* entry) : base_(base), entry_(entry) {}
+
+  const std::uint8_t* base_;
+  const std::uint8_t* entry_;
+};
+
+struct FieldView {
+  std::string_view name;
+  referee::TypeID type{};
+  bool required{false};
+  std::optional<std::string_view> default_json;
+};
+
+struct RelationshipView {
+  std::string_view role;
+  std::string_view cardinality;
+  std::string_view target;
+};
+
+// Borrowed view over an encoded definition; the payload must outlive it. open()
+// bounds-checks every string and table once, so accessors do no further checks.
+class DefinitionView {
+public:
+  static referee::Result<DefinitionView> open(const std::uint8_t* data, std::size_t size);
+
+  referee::TypeID type_id() const;
+  std::string_view name() const;
+  std::string_view namespace_name() const;
+  std::uint64_t version() const;
+  std::optional<std::string_view> kind() const;
+  std::optional<std::string_view> preferred_renderer() const;
+
+  std::size_t field_count() const;
+  FieldView field(std::size_t i) const;
+  std::size_t operation_count() const;
+  OperationView operation(std::size_t i) const;
+  std::optional<OperationView> find_operation(std::string_view name, OperationScope scope) const;
+  std::size_t relationship_count() const;
+  RelationshipView relationship(std::size_t i) const;
+
+  TypeDefinition materialize() const;
+
+private:
+  explicit DefinitionView(const std::uint8_t* data) : data_(data) {}
+
+  const std::uint8_t* data_;
+};
+
+} // namespace iris::refract
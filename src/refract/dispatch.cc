@@ -1,5 +1,6 @@
 #include "refract/dispatch.h"
 
+#include <algorithm>
 #include <deque>
 #include <sstream>
 #include <unordered_set>
@@ -9,34 +10,12 @@ namespace iris::refract {
 namespace {
 
 struct Candidate {
-  OperationDefinition operation;
-  referee::TypeID owner{};
-  std::size_t depth{0};
+  std::uint32_t slot{0};
+  const DispatchMatch* match{nullptr};
   std::size_t type_penalty{0};
   std::size_t optional_penalty{0};
 };
 
-bool has_base_type(referee::TypeID type,
-                   referee::TypeID base,
-                   const DispatchEngine::InheritanceResolver& resolver) {
-  if (!resolver) return false;
-  std::deque<referee::TypeID> queue;
-  std::unordered_set<std::uint64_t> visited;
-  queue.push_back(type);
-  visited.insert(type.v);
-
-  while (!queue.empty()) {
-    auto current = queue.front();
-    queue.pop_front();
-    for (const auto& parent : resolver(current)) {
-      if (parent.v == base.v) return true;
-      if (visited.insert(parent.v).second) queue.push_back(parent);
-    }
-  }
-
-  return false;
-}
-
 bool matches_arity(const OperationDefinition& op, std::size_t arg_count) {
   std::size_t required = 0;
   for (const auto& param : op.signature.params) {
@@ -47,16 +26,42 @@ bool matches_arity(const OperationDefinition& op, std::size_t arg_count) {
   return true;
 }
 
+// Above this many distinct call shapes the cache is simply dropped and refilled.
+constexpr std::size_t kMaxCachedResolutions = 4096;
+
+void put_u64(std::string* out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out->push_back(static_cast<char>((v >> (8 * i)) & 0xFFu));
+}
+
+std::string resolution_key(referee::TypeID target_type,
+                           std::string_view name,
+                           OperationScope scope,
+                           const std::vector<referee::TypeID>& arg_types,
+                           std::size_t arg_count,
+                           bool include_inherited) {
+  std::string key;
+  key.reserve(26 + arg_types.size() * 8 + name.size());
+  put_u64(&key, target_type.v);
+  key.push_back(scope == OperationScope::Class ? 'c' : 'o');
+  key.push_back(include_inherited ? 'i' : 'd');
+  put_u64(&key, arg_count);
+  put_u64(&key, arg_types.size());
+  for (const auto& type : arg_types) put_u64(&key, type.v);
+  key.append(name);
+  return key;
+}
+
 std::string format_operation(const Candidate& cand) {
   std::ostringstream os;
-  os << cand.operation.name << "(";
-  for (std::size_t i = 0; i < cand.operation.signature.params.size(); ++i) {
+  const auto& op = cand.match->operation;
+  os << op.name << "(";
+  for (std::size_t i = 0; i < op.signature.params.size(); ++i) {
     if (i > 0) os << ", ";
-    const auto& param = cand.operation.signature.params[i];
+    const auto& param = op.signature.params[i];
     os << "0x" << std::hex << param.type.v << std::dec;
     if (param.optional) os << "?";
   }
-  os << ") owner=0x" << std::hex << cand.owner.v << std::dec;
+  os << ") owner=0x" << std::hex << cand.match->owner_type.v << std::dec;
   return os.str();
 }
 
@@ -67,6 +72,57 @@ DispatchEngine::DispatchEngine(SchemaRegistry& registry,
   : registry_(registry),
     resolver_(std::move(resolver)) {}
 
+void DispatchEngine::set_resolver(InheritanceResolver resolver) {
+  resolver_ = std::move(resolver);
+  registry_hierarchy_ = false;
+  invalidate();
+}
+
+void DispatchEngine::use_registry_hierarchy() {
+  resolver_ = {};
+  registry_hierarchy_ = true;
+  invalidate();
+}
+
+void DispatchEngine::invalidate() {
+  if (!cache_.empty()) ++stats_.invalidations;
+  cache_.clear();
+  tables_[0].clear();
+  tables_[1].clear();
+  resolver_ancestors_.clear();
+}
+
+// Ancestors reachable through the resolver, walked once per type until invalidated.
+bool DispatchEngine::resolver_is_a(referee::TypeID type, referee::TypeID base) {
+  if (!resolver_) return false;
+  auto [it, inserted] = resolver_ancestors_.try_emplace(type.v);
+  if (inserted) {
+    std::deque<referee::TypeID> queue{ type };
+    while (!queue.empty()) {
+      auto current = queue.front();
+      queue.pop_front();
+      for (const auto& parent : resolver_(current)) {
+        if (parent.v != type.v && it->second.insert(parent.v).second) queue.push_back(parent);
+      }
+    }
+  }
+  return it->second.count(base.v) != 0;
+}
+
+DispatchCacheStats DispatchEngine::cache_stats() const {
+  auto out = stats_;
+  out.entries = cache_.size();
+  return out;
+}
+
+void DispatchEngine::sync_generation() {
+  const auto generation = registry_.generation();
+  if (generation != cache_generation_) {
+    invalidate();
+    cache_generation_ = generation;
+  }
+}
+
 referee::Result<DispatchMatch> DispatchEngine::resolve(
     referee::TypeID target_type,
     std::string_view name,
@@ -74,73 +130,168 @@ referee::Result<DispatchMatch> DispatchEngine::resolve(
     const std::vector<referee::TypeID>& arg_types,
     std::size_t arg_count,
     bool include_inherited) {
-  std::deque<std::pair<referee::TypeID, std::size_t>> queue;
-  std::unordered_set<std::uint64_t> visited;
-  std::vector<Candidate> matches;
+  auto boundR = bind_cached(target_type, name, scope, arg_types, arg_count, include_inherited);
+  if (!boundR) return referee::Result<DispatchMatch>::err(boundR.error->message);
+  return referee::Result<DispatchMatch>::ok(boundR.value->match());
+}
+
+referee::Result<BoundOperation> DispatchEngine::bind(
+    referee::TypeID target_type,
+    std::string_view name,
+    OperationScope scope,
+    const std::vector<referee::TypeID>& arg_types,
+    std::size_t arg_count) {
+  return bind_cached(target_type, name, scope, arg_types, arg_count, true);
+}
+
+referee::Result<BoundOperation> DispatchEngine::bind_cached(
+    referee::TypeID target_type,
+    std::string_view name,
+    OperationScope scope,
+    const std::vector<referee::TypeID>& arg_types,
+    std::size_t arg_count,
+    bool include_inherited) {
+  using R = referee::Result<BoundOperation>;
+  sync_generation();
 
-  queue.push_back({ target_type, 0 });
-  visited.insert(target_type.v);
+  auto key = resolution_key(target_type, name, scope, arg_types, arg_count, include_inherited);
+  if (auto it = cache_.find(key); it != cache_.end()) {
+    ++stats_.hits;
+    if (it->second.bound) return R::ok(*it->second.bound);
+    return R::err(it->second.error);
+  }
+  ++stats_.misses;
 
-  while (!queue.empty()) {
-    auto [current, depth] = queue.front();
-    queue.pop_front();
+  bool cacheable = true;
+  auto result = bind_uncached(target_type, name, scope, arg_types, arg_count, include_inherited, &cacheable);
+  if (cacheable) {
+    if (cache_.size() >= kMaxCachedResolutions) {
+      cache_.clear();
+      ++stats_.invalidations;
+    }
+    CachedResolution entry;
+    if (result) {
+      entry.bound = result.value.value();
+    } else {
+      entry.error = result.error->message;
+    }
+    cache_.emplace(std::move(key), std::move(entry));
+  }
+  return result;
+}
 
-    auto defR = registry_.get_latest_definition_by_type(current);
-    if (!defR) return referee::Result<DispatchMatch>::err(defR.error->message);
-    if (!defR.value->has_value()) {
-      return referee::Result<DispatchMatch>::err("definition not found");
+referee::Result<std::shared_ptr<const OperationTable>> DispatchEngine::table(referee::TypeID type,
+                                                                            OperationScope scope) {
+  sync_generation();
+  std::unordered_set<std::uint64_t> building;
+  bool cacheable = true;
+  return build_table(type, scope, true, &building, &cacheable);
+}
+
+referee::Result<std::shared_ptr<const OperationTable>> DispatchEngine::build_table(
+    referee::TypeID type,
+    OperationScope scope,
+    bool include_inherited,
+    std::unordered_set<std::uint64_t>* building,
+    bool* cacheable) {
+  using R = referee::Result<std::shared_ptr<const OperationTable>>;
+  auto& tables = tables_[scope == OperationScope::Class ? 0 : 1];
+  if (include_inherited) {
+    if (auto it = tables.find(type.v); it != tables.end()) return R::ok(it->second);
+  }
+
+  auto defR = registry_.get_latest_definition_by_type(type);
+  if (!defR) {
+    // Storage or decode failures say nothing about the definitions themselves.
+    *cacheable = false;
+    return R::err(defR.error->message);
+  }
+  if (!defR.value->has_value()) return R::err("definition not found");
+
+  std::vector<referee::TypeID> base_types;
+  if (include_inherited && registry_hierarchy_) {
+    auto indexR = registry_.subtypes();
+    if (!indexR) {
+      *cacheable = false;
+      return R::err(indexR.error->message);
     }
+    base_types = indexR.value.value()->direct_bases(type);
+  } else if (include_inherited && resolver_) {
+    base_types = resolver_(type);
+  }
 
-    const auto& def = defR.value->value().definition;
-    for (const auto& op : def.operations) {
-      if (op.scope != scope) continue;
-      if (op.name != name) continue;
-      if (!matches_arity(op, arg_count)) continue;
-
-      Candidate cand;
-      cand.operation = op;
-      cand.owner = current;
-      cand.depth = depth;
-      cand.optional_penalty = op.signature.params.size() - arg_count;
-
-      if (!arg_types.empty() && arg_types.size() == arg_count) {
-        bool ok = true;
-        for (std::size_t i = 0; i < arg_count; ++i) {
-          const auto& arg_type = arg_types[i];
-          const auto& param_type = op.signature.params[i].type;
-          if (arg_type.v == param_type.v) {
-            continue;
-          }
-          if (has_base_type(arg_type, param_type, resolver_)) {
-            cand.type_penalty += 1;
-            continue;
-          }
-          ok = false;
-          break;
-        }
-        if (!ok) continue;
-      }
+  // Bases still being built are part of an inheritance cycle and contribute nothing.
+  building->insert(type.v);
+  std::vector<std::shared_ptr<const OperationTable>> held;
+  std::vector<const OperationTable*> bases;
+  for (const auto& base : base_types) {
+    if (building->count(base.v)) continue;
+    auto baseR = build_table(base, scope, true, building, cacheable);
+    if (!baseR) return R::err(baseR.error->message);
+    if (std::find(bases.begin(), bases.end(), baseR.value->get()) != bases.end()) continue;
+    bases.push_back(baseR.value->get());
+    held.push_back(std::move(baseR.value.value()));
+  }
+  building->erase(type.v);
+
+  auto built = std::make_shared<const OperationTable>(
+      OperationTable::build(type, scope, defR.value->value().definition.operations, bases));
+  if (include_inherited) tables.emplace(type.v, built);
+  return R::ok(std::move(built));
+}
 
-      matches.push_back(std::move(cand));
+referee::Result<std::uint32_t> DispatchEngine::select(
+    const OperationTable& table,
+    std::string_view name,
+    const std::vector<referee::TypeID>& arg_types,
+    std::size_t arg_count,
+    bool* cacheable) {
+  using R = referee::Result<std::uint32_t>;
+  const SubtypeIndex* subtypes = nullptr;
+  if (registry_hierarchy_ && !arg_types.empty()) {
+    auto indexR = registry_.subtypes();
+    if (!indexR) {
+      *cacheable = false;
+      return R::err(indexR.error->message);
     }
+    subtypes = indexR.value.value();
+  }
+  auto is_a = [&](referee::TypeID type, referee::TypeID base) {
+    return subtypes ? subtypes->is_subtype(type, base) : resolver_is_a(type, base);
+  };
 
-    if (include_inherited && resolver_) {
-      for (const auto& parent : resolver_(current)) {
-        if (visited.insert(parent.v).second) {
-          queue.push_back({ parent, depth + 1 });
-        }
+  // Candidate for one implementation; the rivals of an ambiguous slot score the
+  // same as its match, so they only ever show up as ties.
+  auto consider = [&](std::uint32_t slot, const DispatchMatch& impl, std::vector<Candidate>* out) {
+    const auto& op = impl.operation;
+    if (!matches_arity(op, arg_count)) return;
+    Candidate cand;
+    cand.slot = slot;
+    cand.match = &impl;
+    cand.optional_penalty = op.signature.params.size() - arg_count;
+    if (!arg_types.empty() && arg_types.size() == arg_count) {
+      for (std::size_t i = 0; i < arg_count; ++i) {
+        const auto& arg_type = arg_types[i];
+        const auto& param_type = op.signature.params[i].type;
+        if (arg_type.v == param_type.v) continue;
+        if (!is_a(arg_type, param_type)) return;
+        cand.type_penalty += 1;
       }
     }
-  }
+    out->push_back(cand);
+  };
 
-  if (matches.empty()) {
-    return referee::Result<DispatchMatch>::err("no matching operation");
+  std::vector<Candidate> matches;
+  for (auto slot : table.named(name)) {
+    consider(slot, table.at(slot), &matches);
+    for (const auto& rival : table.rivals(slot)) consider(slot, rival, &matches);
   }
+  if (matches.empty()) return R::err("no matching operation");
 
   auto better = [](const Candidate& a, const Candidate& b) {
     if (a.type_penalty != b.type_penalty) return a.type_penalty < b.type_penalty;
     if (a.optional_penalty != b.optional_penalty) return a.optional_penalty < b.optional_penalty;
-    return a.depth < b.depth;
+    return a.match->depth < b.match->depth;
   };
 
   Candidate best = matches.front();
@@ -161,14 +312,26 @@ referee::Result<DispatchMatch> DispatchEngine::resolve(
     for (const auto& cand : ties) {
       os << " " << format_operation(cand) << ";";
     }
-    return referee::Result<DispatchMatch>::err(os.str());
+    return R::err(os.str());
   }
+  return R::ok(best.slot);
+}
 
-  DispatchMatch out;
-  out.operation = std::move(best.operation);
-  out.owner_type = best.owner;
-  out.depth = best.depth;
-  return referee::Result<DispatchMatch>::ok(std::move(out));
+referee::Result<BoundOperation> DispatchEngine::bind_uncached(
+    referee::TypeID target_type,
+    std::string_view name,
+    OperationScope scope,
+    const std::vector<referee::TypeID>& arg_types,
+    std::size_t arg_count,
+    bool include_inherited,
+    bool* cacheable) {
+  using R = referee::Result<BoundOperation>;
+  std::unordered_set<std::uint64_t> building;
+  auto tableR = build_table(target_type, scope, include_inherited, &building, cacheable);
+  if (!tableR) return R::err(tableR.error->message);
+  auto slotR = select(*tableR.value.value(), name, arg_types, arg_count, cacheable);
+  if (!slotR) return R::err(slotR.error->message);
+  return R::ok(BoundOperation{ std::move(tableR.value.value()), slotR.value.value() });
 }
 
 } // namespace iris::refract
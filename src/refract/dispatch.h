@@ -1,17 +1,39 @@
 #pragma once
 
 #include "refract/operation_registry.h"
+#include "refract/operation_table.h"
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace iris::refract {
 
-struct DispatchMatch {
-  OperationDefinition operation;
-  referee::TypeID owner_type{};
-  std::size_t depth{0};
+// A resolved operation as a slot of its type's table. The table is shared, so the
+// binding stays valid (and cheap to copy) after the engine drops its caches.
+struct BoundOperation {
+  std::shared_ptr<const OperationTable> table;
+  std::uint32_t slot{OperationTable::kNoSlot};
+
+  const DispatchMatch& match() const { return table->at(slot); }
+  const OperationDefinition& operation() const { return table->at(slot).operation; }
+};
+
+struct DispatchCacheStats {
+  std::uint64_t hits{0};
+  std::uint64_t misses{0};
+  std::uint64_t invalidations{0};
+  std::size_t entries{0};
+
+  double hit_rate() const {
+    const auto total = hits + misses;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+  }
 };
 
 class DispatchEngine {
@@ -29,9 +51,73 @@ public:
       std::size_t arg_count,
       bool include_inherited = true);
 
+  // Resolves like resolve() (always including inherited operations) to a slot of
+  // table(target_type, scope) instead of a copy of the operation. Shares resolve()'s
+  // cache, so callers may bind per call and still resolve once per call shape.
+  referee::Result<BoundOperation> bind(
+      referee::TypeID target_type,
+      std::string_view name,
+      OperationScope scope,
+      const std::vector<referee::TypeID>& arg_types,
+      std::size_t arg_count);
+  // The flattened operations of `type`, built once per type and scope from its
+  // bases' tables and kept until the registry's definitions change.
+  referee::Result<std::shared_ptr<const OperationTable>> table(referee::TypeID type, OperationScope scope);
+
+  // Resolutions and bindings (matches, ambiguity and no-match errors) are memoized per
+  // (target, name, scope, arity, arg types) until the registry's definitions change
+  // or the resolver is replaced. Call invalidate() if the resolver's answers change.
+  void set_resolver(InheritanceResolver resolver);
+  // Inherit through the registry's SubtypeIndex ("base"/"extends" relationships) in
+  // C3 order instead of a resolver; replaces any resolver.
+  void use_registry_hierarchy();
+  void invalidate();
+  DispatchCacheStats cache_stats() const;
+
 private:
+  struct CachedResolution {
+    std::optional<BoundOperation> bound;
+    std::string error;
+  };
+
+  void sync_generation();
+  referee::Result<std::shared_ptr<const OperationTable>> build_table(
+      referee::TypeID type,
+      OperationScope scope,
+      bool include_inherited,
+      std::unordered_set<std::uint64_t>* building,
+      bool* cacheable);
+  referee::Result<std::uint32_t> select(
+      const OperationTable& table,
+      std::string_view name,
+      const std::vector<referee::TypeID>& arg_types,
+      std::size_t arg_count,
+      bool* cacheable);
+  referee::Result<BoundOperation> bind_cached(
+      referee::TypeID target_type,
+      std::string_view name,
+      OperationScope scope,
+      const std::vector<referee::TypeID>& arg_types,
+      std::size_t arg_count,
+      bool include_inherited);
+  referee::Result<BoundOperation> bind_uncached(
+      referee::TypeID target_type,
+      std::string_view name,
+      OperationScope scope,
+      const std::vector<referee::TypeID>& arg_types,
+      std::size_t arg_count,
+      bool include_inherited,
+      bool* cacheable);
+  bool resolver_is_a(referee::TypeID type, referee::TypeID base);
+
   SchemaRegistry& registry_;
   InheritanceResolver resolver_;
+  bool registry_hierarchy_{false};
+  std::unordered_map<std::uint64_t, std::unordered_set<std::uint64_t>> resolver_ancestors_;
+  std::unordered_map<std::string, CachedResolution> cache_;
+  std::unordered_map<std::uint64_t, std::shared_ptr<const OperationTable>> tables_[2]; // by scope
+  std::uint64_t cache_generation_{0};
+  DispatchCacheStats stats_{};
 };
 
 } // namespace iris::refract
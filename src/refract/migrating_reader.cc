@@ -0,0 +1,150 @@
+#include "refract/migrating_reader.h"
+
+#include <cstring>
+#include <vector>
+
+namespace iris::refract {
+
+std::size_t MigratingReader::IdHash::operator()(const referee::ObjectID& id) const noexcept {
+  std::uint64_t v = 0;
+  std::memcpy(&v, id.bytes.data(), sizeof(v));
+  return static_cast<std::size_t>(v);
+}
+
+MigratingReader::MigratingReader(SchemaRegistry& registry, referee::SqliteStore& store)
+  : registry_(registry),
+    store_(store) {}
+
+void MigratingReader::register_hook(std::string name, MigrationHook hook) {
+  hooks_[std::move(name)] = std::move(hook);
+  plans_.clear();
+  upgrades_.clear();
+  pending_ = 0;
+}
+
+referee::Result<const MigrationPlan*> MigratingReader::plan_for(referee::TypeID type) {
+  using R = referee::Result<const MigrationPlan*>;
+  const auto generation = registry_.generation();
+  if (generation != generation_) {
+    // Pending upgrades may target a definition that is no longer the latest.
+    plans_.clear();
+    upgrades_.clear();
+    pending_ = 0;
+    generation_ = generation;
+  }
+  if (auto it = plans_.find(type.v); it != plans_.end()) {
+    return R::ok(it->second ? &*it->second : nullptr);
+  }
+
+  auto defR = registry_.get_latest_definition_by_type(type);
+  if (!defR) return R::err(defR.error->message);
+  if (!defR.value->has_value()) {
+    plans_.emplace(type.v, std::nullopt);
+    return R::ok(nullptr);
+  }
+  auto planR = MigrationPlan::build(registry_, defR.value->value().ref.id, hooks_);
+  if (!planR) return R::err(planR.error->message);
+  if (planR.value->empty()) {
+    plans_.emplace(type.v, std::nullopt);
+    return R::ok(nullptr);
+  }
+  auto [it, inserted] = plans_.emplace(type.v, std::move(planR.value.value()));
+  return R::ok(&*it->second);
+}
+
+referee::Result<std::optional<referee::ObjectRecord>> MigratingReader::get_latest(referee::ObjectID id) {
+  using R = referee::Result<std::optional<referee::ObjectRecord>>;
+  auto recR = store_.get_latest(id);
+  if (!recR || !recR.value->has_value()) return recR;
+  auto& rec = recR.value->value();
+
+  auto planR = plan_for(rec.type);
+  if (!planR) return R::err(planR.error->message);
+  const auto* plan = planR.value.value();
+  const auto* hooks = plan ? plan->hooks_for(rec.definition_id) : nullptr;
+  if (!hooks && plan) {
+    if (const auto* missing = plan->missing_hook(rec.definition_id)) {
+      return R::err("object " + id.to_hex() + ": migration hook '" + *missing + "' is not registered");
+    }
+  }
+  if (!hooks) {
+    ++stats_.current;
+    return recR;
+  }
+
+  auto it = upgrades_.find(id);
+  if (it != upgrades_.end() && it->second.source == rec.ref && it->second.definition_id == plan->target()) {
+    ++stats_.cached;
+    rec.payload_cbor = it->second.payload;
+    rec.definition_id = plan->target();
+    return recR;
+  }
+
+  auto payloadR = MigrationPlan::apply(*hooks, rec.payload_cbor);
+  if (!payloadR) return R::err("object " + id.to_hex() + ": " + payloadR.error->message);
+  ++stats_.upgrades;
+  if (it != upgrades_.end()) {
+    if (it->second.pending) --pending_;
+    upgrades_.erase(it);
+  }
+  make_room();
+  upgrades_.emplace(id, Upgrade{ rec.ref, plan->target(), payloadR.value.value(), write_back_enabled_ });
+  if (write_back_enabled_) ++pending_;
+
+  rec.payload_cbor = std::move(payloadR.value.value());
+  rec.definition_id = plan->target();
+  return recR;
+}
+
+void MigratingReader::make_room() {
+  if (upgrades_.size() < capacity_) return;
+  for (auto it = upgrades_.begin(); it != upgrades_.end();) {
+    it = it->second.pending ? std::next(it) : upgrades_.erase(it);
+  }
+}
+
+referee::Result<std::size_t> MigratingReader::write_back(std::size_t limit) {
+  using R = referee::Result<std::size_t>;
+  if (pending_ == 0 || limit == 0) return R::ok(0);
+
+  std::vector<referee::ObjectID> written;
+  std::vector<referee::ObjectID> stale;
+  auto beginR = store_.begin();
+  if (!beginR) return R::err(beginR.error->message);
+  for (const auto& [id, upgrade] : upgrades_) {
+    if (written.size() >= limit) break;
+    if (!upgrade.pending) continue;
+    auto latestR = store_.get_latest(id);
+    if (!latestR) {
+      store_.rollback();
+      return R::err(latestR.error->message);
+    }
+    if (!latestR.value->has_value() || latestR.value->value().ref != upgrade.source) {
+      stale.push_back(id);
+      continue;
+    }
+    auto writeR = store_.create_version(upgrade.source, upgrade.definition_id, upgrade.payload);
+    if (!writeR) {
+      store_.rollback();
+      return R::err("object " + id.to_hex() + ": " + writeR.error->message);
+    }
+    written.push_back(id);
+  }
+  auto commitR = store_.commit();
+  if (!commitR) return R::err(commitR.error->message);
+
+  // The stored versions are current now, so their entries are done with.
+  for (const auto& id : written) upgrades_.erase(id);
+  for (const auto& id : stale) upgrades_.erase(id);
+  pending_ -= written.size() + stale.size();
+  stats_.written += written.size();
+  return R::ok(written.size());
+}
+
+MigratingReaderStats MigratingReader::stats() const {
+  auto out = stats_;
+  out.entries = upgrades_.size();
+  return out;
+}
+
+} // namespace iris::refract
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "refract/migration_runner.h"
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace iris::refract {
+
+struct MigratingReaderStats {
+  std::uint64_t current{0};   // reads already on the latest definition
+  std::uint64_t upgrades{0};  // payloads run through hooks
+  std::uint64_t cached{0};    // reads served from an earlier upgrade
+  std::uint64_t written{0};   // upgrades written back as new versions
+  std::size_t entries{0};
+};
+
+// Reads objects as if they had been migrated: a latest version written against a
+// definition that has since been superseded comes back with its payload run through
+// the supersedes chain's hooks (see MigrationPlan) and the latest definition's id.
+// The stored ref is unchanged. Upgrades are cached per object until the object gets
+// a new version or the registry's definitions change; with write-back on, they are
+// also kept for write_back() to store as new versions.
+//
+// Not thread-safe, like the registry and store it reads.
+class MigratingReader {
+public:
+  MigratingReader(SchemaRegistry& registry, referee::SqliteStore& store);
+
+  void register_hook(std::string name, MigrationHook hook);
+  void set_write_back(bool enabled) { write_back_enabled_ = enabled; }
+  // Upgrades kept at most; above it, cached entries not waiting for write-back are
+  // dropped.
+  void set_capacity(std::size_t entries) { capacity_ = entries; }
+
+  referee::Result<std::optional<referee::ObjectRecord>> get_latest(referee::ObjectID id);
+
+  // Stores up to `limit` pending upgrades as new versions in one transaction; meant
+  // for when the store is otherwise idle. Upgrades whose object changed meanwhile are
+  // dropped. Returns the number written.
+  referee::Result<std::size_t> write_back(std::size_t limit = SIZE_MAX);
+  std::size_t pending_write_back() const { return pending_; }
+
+  MigratingReaderStats stats() const;
+
+private:
+  struct Upgrade {
+    referee::ObjectRef source{};
+    referee::ObjectID definition_id{};
+    referee::Bytes payload;
+    bool pending{false};
+  };
+  struct IdHash {
+    std::size_t operator()(const referee::ObjectID& id) const noexcept;
+  };
+
+  referee::Result<const MigrationPlan*> plan_for(referee::TypeID type);
+  void make_room();
+
+  SchemaRegistry& registry_;
+  referee::SqliteStore& store_;
+  MigrationHooks hooks_;
+  bool write_back_enabled_{false};
+  std::size_t capacity_{4096};
+  std::size_t pending_{0};
+  std::uint64_t generation_{0};
+  // nullopt: the type has no definition, or its latest supersedes nothing.
+  std::unordered_map<std::uint64_t, std::optional<MigrationPlan>> plans_;
+  std::unordered_map<referee::ObjectID, Upgrade, IdHash> upgrades_;
+  MigratingReaderStats stats_{};
+};
+
+} // namespace iris::refract
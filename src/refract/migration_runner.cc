@@ -0,0 +1,214 @@
+#include "refract/migration_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace iris::refract {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Item {
+  const referee::ObjectRecord* record{nullptr};
+  const MigrationPlan::HookChain* hooks{nullptr};
+  referee::Bytes payload;
+  std::optional<std::string> error;
+};
+
+void apply_hooks(Item* item) {
+  auto payloadR = MigrationPlan::apply(*item->hooks, item->record->payload_cbor);
+  if (!payloadR) {
+    item->error = payloadR.error->message;
+    return;
+  }
+  item->payload = std::move(payloadR.value.value());
+}
+
+void apply_hooks_parallel(std::vector<Item>* items, unsigned workers) {
+  const std::size_t runs = std::min<std::size_t>(workers, items->size());
+  if (runs <= 1) {
+    for (auto& item : *items) apply_hooks(&item);
+    return;
+  }
+  const std::size_t per_run = (items->size() + runs - 1) / runs;
+  auto work = [&](std::size_t run) {
+    const std::size_t begin = run * per_run;
+    const std::size_t end = std::min(items->size(), begin + per_run);
+    for (std::size_t i = begin; i < end; ++i) apply_hooks(&(*items)[i]);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(runs);
+  for (std::size_t i = 0; i < runs; ++i) threads.emplace_back(work, i);
+  for (auto& t : threads) t.join();
+}
+
+} // namespace
+
+std::size_t MigrationPlan::IdHash::operator()(const referee::ObjectID& id) const noexcept {
+  std::uint64_t v = 0;
+  std::memcpy(&v, id.bytes.data(), sizeof(v));
+  return static_cast<std::size_t>(v);
+}
+
+referee::Result<MigrationPlan> MigrationPlan::build(SchemaRegistry& registry, referee::ObjectID target,
+                                                    const MigrationHooks& hooks) {
+  using R = referee::Result<MigrationPlan>;
+  auto targetR = registry.get_definition_by_id(target);
+  if (!targetR) return R::err(targetR.error->message);
+  if (!targetR.value->has_value()) return R::err("target definition not found");
+  auto chainR = registry.list_supersedes_chain(target);
+  if (!chainR) return R::err(chainR.error->message);
+
+  MigrationPlan plan;
+  plan.target_ = target;
+  plan.type_ = targetR.value->value().definition.type_id;
+  // chain[k].prior reaches the target through the hooks of links k, k-1, ..., 0.
+  // Once a link's hook is missing, it and every older prior are unreachable; that
+  // only matters to objects still written against them.
+  HookChain suffix;
+  for (const auto& link : chainR.value.value()) {
+    if (plan.missing_.empty() && link.migration_hook) {
+      auto it = hooks.find(*link.migration_hook);
+      if (it == hooks.end()) {
+        plan.first_missing_ = *link.migration_hook;
+      } else {
+        suffix.insert(suffix.begin(), &it->second);
+      }
+    }
+    if (!plan.first_missing_.empty()) {
+      plan.missing_.emplace(link.prior.ref.id, plan.first_missing_);
+    } else {
+      plan.chains_.emplace(link.prior.ref.id, suffix);
+    }
+  }
+  return R::ok(std::move(plan));
+}
+
+const MigrationPlan::HookChain* MigrationPlan::hooks_for(referee::ObjectID definition_id) const {
+  auto it = chains_.find(definition_id);
+  return it == chains_.end() ? nullptr : &it->second;
+}
+
+const std::string* MigrationPlan::missing_hook(referee::ObjectID definition_id) const {
+  auto it = missing_.find(definition_id);
+  return it == missing_.end() ? nullptr : &it->second;
+}
+
+referee::Result<referee::Bytes> MigrationPlan::apply(const HookChain& hooks, const referee::Bytes& payload) {
+  referee::Bytes out = payload;
+  for (const auto* hook : hooks) {
+    auto nextR = (*hook)(out);
+    if (!nextR) return nextR;
+    out = std::move(nextR.value.value());
+  }
+  return referee::Result<referee::Bytes>::ok(std::move(out));
+}
+
+MigrationRunner::MigrationRunner(SchemaRegistry& registry, referee::SqliteStore& store)
+  : registry_(registry),
+    store_(store) {}
+
+void MigrationRunner::register_hook(std::string name, MigrationHook hook) {
+  hooks_[std::move(name)] = std::move(hook);
+}
+
+void MigrationRunner::request_stop() {
+  {
+    std::lock_guard<std::mutex> lk(stop_mu_);
+    stop_.store(true);
+  }
+  stop_cv_.notify_all();
+}
+
+void MigrationRunner::on_progress(std::function<void(const MigrationProgress&)> callback) {
+  progress_ = std::move(callback);
+}
+
+referee::Result<MigrationProgress> MigrationRunner::run(referee::ObjectID target_definition,
+                                                        MigrationOptions options) {
+  using R = referee::Result<MigrationProgress>;
+  struct ClearStop {
+    std::atomic<bool>& flag;
+    ~ClearStop() { flag.store(false); }
+  } clear_stop{stop_};
+
+  auto planR = MigrationPlan::build(registry_, target_definition, hooks_);
+  if (!planR) return R::err(planR.error->message);
+  const auto& plan = planR.value.value();
+  if (const auto* missing = plan.first_missing_hook()) {
+    return R::err("migration hook '" + *missing + "' is not registered");
+  }
+  const auto type = plan.type();
+
+  const unsigned workers = options.workers != 0 ? options.workers
+                                                : std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t batch_size = std::max<std::size_t>(1, options.batch_size);
+
+  MigrationProgress progress;
+  progress.total = store_.type_mark(type).count;
+  progress.position = std::min(options.start, progress.total);
+  const auto started = Clock::now();
+
+  while (progress.position < progress.total) {
+    if (stop_.load()) {
+      progress.stopped = true;
+      break;
+    }
+    const auto limit = std::min<std::uint64_t>(batch_size, progress.total - progress.position);
+    auto pageR = store_.list_by_type_from(type, progress.position, static_cast<std::size_t>(limit));
+    if (!pageR) return R::err(pageR.error->message);
+    const auto& page = pageR.value.value();
+    if (page.empty()) break;
+
+    std::vector<Item> items;
+    for (const auto& rec : page) {
+      const auto* hooks = plan.hooks_for(rec.definition_id);
+      if (!hooks) continue;
+      auto latestR = store_.get_latest(rec.ref.id);
+      if (!latestR) return R::err(latestR.error->message);
+      if (!latestR.value->has_value() || latestR.value->value().ref.ver != rec.ref.ver) continue;
+      items.push_back(Item{ &rec, hooks, {}, std::nullopt });
+    }
+
+    apply_hooks_parallel(&items, workers);
+    for (const auto& item : items) {
+      if (item.error) return R::err("object " + item.record->ref.id.to_hex() + ": " + *item.error);
+    }
+
+    if (!items.empty()) {
+      auto beginR = store_.begin();
+      if (!beginR) return R::err(beginR.error->message);
+      for (const auto& item : items) {
+        auto writeR = store_.create_version(item.record->ref, target_definition, item.payload);
+        if (!writeR) {
+          store_.rollback();
+          return R::err("object " + item.record->ref.id.to_hex() + ": " + writeR.error->message);
+        }
+      }
+      auto commitR = store_.commit();
+      if (!commitR) return R::err(commitR.error->message);
+    }
+
+    progress.position += page.size();
+    progress.migrated += items.size();
+    progress.skipped += page.size() - items.size();
+    ++progress.batches;
+    if (progress_) progress_(progress);
+
+    if (options.max_per_second != 0 && !items.empty()) {
+      const auto due = started + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(static_cast<double>(progress.migrated)
+                                        / static_cast<double>(options.max_per_second)));
+      std::unique_lock<std::mutex> lk(stop_mu_);
+      stop_cv_.wait_until(lk, due, [this]() { return stop_.load(); });
+    }
+  }
+  return R::ok(progress);
+}
+
+} // namespace iris::refract
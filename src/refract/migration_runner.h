@@ -0,0 +1,104 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Migration of stored objects onto superseding definitions.
+namespace iris::refract {
+
+// Rewrites one payload for the next definition in a supersedes chain. Called from
+// worker threads, so it must not touch the registry or store.
+using MigrationHook = std::function<referee::Result<referee::Bytes>(const referee::Bytes& payload)>;
+using MigrationHooks = std::unordered_map<std::string, MigrationHook>;
+
+// The hooks taking each earlier definition in `target`'s supersedes chain to
+// `target`, oldest first; links without a hook carry the payload over. Holds
+// pointers into the MigrationHooks it was built from.
+class MigrationPlan {
+public:
+  using HookChain = std::vector<const MigrationHook*>;
+
+  static referee::Result<MigrationPlan> build(SchemaRegistry& registry, referee::ObjectID target,
+                                              const MigrationHooks& hooks);
+
+  referee::ObjectID target() const { return target_; }
+  referee::TypeID type() const { return type_; }
+  bool empty() const { return chains_.empty() && missing_.empty(); }
+  // nullptr unless `definition_id` is an earlier definition in the chain whose
+  // hooks are all registered.
+  const HookChain* hooks_for(referee::ObjectID definition_id) const;
+  // The unregistered hook an earlier definition would need, or nullptr.
+  const std::string* missing_hook(referee::ObjectID definition_id) const;
+  const std::string* first_missing_hook() const { return missing_.empty() ? nullptr : &first_missing_; }
+
+  static referee::Result<referee::Bytes> apply(const HookChain& hooks, const referee::Bytes& payload);
+
+private:
+  struct IdHash {
+    std::size_t operator()(const referee::ObjectID& id) const noexcept;
+  };
+
+  referee::ObjectID target_{};
+  referee::TypeID type_{};
+  std::unordered_map<referee::ObjectID, HookChain, IdHash> chains_;
+  std::unordered_map<referee::ObjectID, std::string, IdHash> missing_;
+  std::string first_missing_;
+};
+
+struct MigrationOptions {
+  std::size_t batch_size{512};
+  unsigned workers{0};           // hook threads per batch; 0 = hardware concurrency
+  std::uint64_t max_per_second{0}; // migrated objects per second; 0 = unthrottled
+  std::uint64_t start{0};        // MigrationProgress::position of an earlier run
+};
+
+struct MigrationProgress {
+  std::uint64_t position{0}; // records of the type scanned so far; resume from here
+  std::uint64_t total{0};    // records of the type when the run started
+  std::uint64_t migrated{0};
+  std::uint64_t skipped{0};  // current already, superseded by a later version, or unrelated
+  std::uint64_t batches{0};
+  bool stopped{false};       // request_stop() ended the run early
+};
+
+// Moves every object whose latest version was written against an earlier definition
+// in `target`'s supersedes chain onto `target`: each batch of the type's records is
+// run through the chain's hooks, oldest first, on worker threads, then written as
+// new versions in one transaction. Links without a hook carry the payload over.
+//
+// Batches that committed stay migrated, so a failed or stopped run resumes from its
+// last position (or from the start: migrated objects are skipped).
+class MigrationRunner {
+public:
+  MigrationRunner(SchemaRegistry& registry, referee::SqliteStore& store);
+
+  void register_hook(std::string name, MigrationHook hook);
+  // Called on run()'s thread after every batch.
+  void on_progress(std::function<void(const MigrationProgress&)> callback);
+  // Safe from any thread; run() returns after the batch in flight, cutting short a
+  // throttle wait.
+  void request_stop();
+
+  referee::Result<MigrationProgress> run(referee::ObjectID target_definition, MigrationOptions options = {});
+
+private:
+  SchemaRegistry& registry_;
+  referee::SqliteStore& store_;
+  MigrationHooks hooks_;
+  std::function<void(const MigrationProgress&)> progress_;
+  std::atomic<bool> stop_{false};
+  std::mutex stop_mu_;
+  std::condition_variable stop_cv_;
+};
+
+} // namespace iris::refract
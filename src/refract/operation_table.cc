@@ -0,0 +1,102 @@
+#include "refract/operation_table.h"
+
+#include <algorithm>
+
+namespace iris::refract {
+
+namespace {
+
+void put_u64(std::string* out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out->push_back(static_cast<char>((v >> (8 * i)) & 0xFFu));
+}
+
+// Name, then the parameter types; optionality does not distinguish overrides.
+std::string slot_key(std::string_view name, const std::vector<referee::TypeID>& params) {
+  std::string key(name);
+  key.push_back('\0');
+  for (const auto& type : params) put_u64(&key, type.v);
+  return key;
+}
+
+std::string slot_key(const OperationDefinition& op) {
+  std::vector<referee::TypeID> params;
+  params.reserve(op.signature.params.size());
+  for (const auto& param : op.signature.params) params.push_back(param.type);
+  return slot_key(op.name, params);
+}
+
+bool has_owner(const std::vector<DispatchMatch>& matches, referee::TypeID owner) {
+  return std::any_of(matches.begin(), matches.end(),
+                     [&](const DispatchMatch& m) { return m.owner_type.v == owner.v; });
+}
+
+} // namespace
+
+OperationTable OperationTable::build(referee::TypeID type, OperationScope scope,
+                                     const std::vector<OperationDefinition>& operations,
+                                     const std::vector<const OperationTable*>& bases) {
+  OperationTable table;
+  table.type_ = type;
+  table.scope_ = scope;
+  for (const auto* base : bases) {
+    for (const auto& inherited : base->slots_) {
+      Slot slot = inherited;
+      ++slot.match.depth;
+      for (auto& rival : slot.rivals) ++rival.depth;
+      table.place(std::move(slot));
+    }
+  }
+  for (const auto& op : operations) {
+    if (op.scope != scope) continue;
+    Slot slot;
+    slot.match = DispatchMatch{ op, type, 0 };
+    slot.key = slot_key(op);
+    auto it = table.by_key_.find(slot.key);
+    if (it != table.by_key_.end() && table.slots_[it->second].match.depth == 0) {
+      // Declared twice by the type itself.
+      table.slots_[it->second].rivals.push_back(std::move(slot.match));
+      continue;
+    }
+    table.place(std::move(slot));
+  }
+  return table;
+}
+
+void OperationTable::place(Slot slot) {
+  auto [it, inserted] = by_key_.try_emplace(slot.key, static_cast<std::uint32_t>(slots_.size()));
+  if (inserted) {
+    by_name_[slot.match.operation.name].push_back(it->second);
+    slots_.push_back(std::move(slot));
+    return;
+  }
+  auto& existing = slots_[it->second];
+  if (slot.match.depth < existing.match.depth) {
+    existing.match = std::move(slot.match);
+    existing.rivals = std::move(slot.rivals);
+    return;
+  }
+  if (slot.match.depth > existing.match.depth) return;
+  // Equally deep: the same owner reached twice (a diamond), or a conflict.
+  if (slot.match.owner_type.v != existing.match.owner_type.v
+      && !has_owner(existing.rivals, slot.match.owner_type)) {
+    existing.rivals.push_back(std::move(slot.match));
+  }
+  for (auto& rival : slot.rivals) {
+    if (rival.owner_type.v != existing.match.owner_type.v && !has_owner(existing.rivals, rival.owner_type)) {
+      existing.rivals.push_back(std::move(rival));
+    }
+  }
+}
+
+const std::vector<std::uint32_t>& OperationTable::named(std::string_view name) const {
+  static const std::vector<std::uint32_t> kNone;
+  auto it = by_name_.find(name);
+  return it == by_name_.end() ? kNone : it->second;
+}
+
+std::uint32_t OperationTable::find(std::string_view name, const std::vector<referee::TypeID>& params) const {
+  auto it = by_key_.find(slot_key(name, params));
+  return it == by_key_.end() ? kNoSlot : it->second;
+}
+
+} // namespace iris::refract
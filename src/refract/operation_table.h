@@ -0,0 +1,70 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace iris::refract {
+
+struct DispatchMatch {
+  OperationDefinition operation;
+  referee::TypeID owner_type{};
+  std::size_t depth{0};
+};
+
+// The operations of one type and scope flattened into numbered slots, like a vtable.
+// The first base's slots keep their positions (overrides replace them in place),
+// operations new from further bases follow, then the type's own new operations.
+// Two operations are the same slot when they share a name and parameter types; the
+// shallowest owner wins, and equally deep owners leave the slot ambiguous until a
+// subtype overrides it.
+class OperationTable {
+public:
+  static constexpr std::uint32_t kNoSlot = UINT32_MAX;
+
+  // `bases` in declaration order, each built for the same scope.
+  static OperationTable build(referee::TypeID type, OperationScope scope,
+                              const std::vector<OperationDefinition>& operations,
+                              const std::vector<const OperationTable*>& bases);
+
+  referee::TypeID type() const { return type_; }
+  OperationScope scope() const { return scope_; }
+  std::size_t size() const { return slots_.size(); }
+  const DispatchMatch& at(std::uint32_t slot) const { return slots_[slot].match; }
+  // Other equally deep implementations of an ambiguous slot; empty otherwise.
+  const std::vector<DispatchMatch>& rivals(std::uint32_t slot) const { return slots_[slot].rivals; }
+  bool ambiguous(std::uint32_t slot) const { return !slots_[slot].rivals.empty(); }
+
+  // Slots named `name` in slot order.
+  const std::vector<std::uint32_t>& named(std::string_view name) const;
+  // Slot with exactly this name and parameter types, or kNoSlot.
+  std::uint32_t find(std::string_view name, const std::vector<referee::TypeID>& params) const;
+
+private:
+  struct Slot {
+    DispatchMatch match;
+    std::string key;
+    std::vector<DispatchMatch> rivals;
+  };
+  struct KeyHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+  };
+  template <typename V>
+  using KeyMap = std::unordered_map<std::string, V, KeyHash, std::equal_to<>>;
+
+  void place(Slot slot);
+
+  referee::TypeID type_{};
+  OperationScope scope_{OperationScope::Object};
+  std::vector<Slot> slots_;
+  KeyMap<std::uint32_t> by_key_;
+  KeyMap<std::vector<std::uint32_t>> by_name_;
+};
+
+} // namespace iris::refract
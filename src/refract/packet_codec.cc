@@ -0,0 +1,312 @@
+#include "refract/packet_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace iris::refract {
+
+namespace {
+
+// A window is up to 8 packet bytes read as one integer; bytes past the end of the
+// packet read as zero. Big-endian windows put the first byte in the top bits.
+std::uint64_t load_window(const std::uint8_t* p, std::size_t n, bool big) {
+  std::uint64_t w = 0;
+  if (big) {
+    for (std::size_t i = 0; i < n; ++i) w |= std::uint64_t(p[i]) << (56 - 8 * i);
+  } else {
+    for (std::size_t i = 0; i < n; ++i) w |= std::uint64_t(p[i]) << (8 * i);
+  }
+  return w;
+}
+
+void store_window(std::uint8_t* p, std::size_t n, bool big, std::uint64_t w) {
+  if (big) {
+    for (std::size_t i = 0; i < n; ++i) p[i] = static_cast<std::uint8_t>(w >> (56 - 8 * i));
+  } else {
+    for (std::size_t i = 0; i < n; ++i) p[i] = static_cast<std::uint8_t>(w >> (8 * i));
+  }
+}
+
+bool parse_byte_order(const std::optional<std::string>& order, bool* big) {
+  if (!order || order->empty() || *order == "be" || *order == "big") {
+    *big = true;
+    return true;
+  }
+  if (*order == "le" || *order == "little") {
+    *big = false;
+    return true;
+  }
+  return false;
+}
+
+#if defined(__SSE2__)
+__m128i bswap16_lanes(__m128i v) {
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+__m128i bswap32_lanes(__m128i v) {
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return bswap16_lanes(v);
+}
+
+__m128i bswap64_lanes(__m128i v) {
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  return bswap16_lanes(v);
+}
+
+// Lane shift for a 4-byte packet: big-endian windows hold the packet in the top
+// half, so the plan's shift is 32 more than the lane's.
+int lane_shift32(const PacketFieldPlan& field, bool big) {
+  return static_cast<int>(big ? field.shift - 32 : field.shift);
+}
+
+std::size_t decode_lanes32(const std::vector<PacketFieldPlan>& fields, bool big,
+                           const std::uint8_t* packets, std::size_t count, std::uint64_t* columns) {
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packets + 4 * i));
+    if (big) v = bswap32_lanes(v);
+    for (std::size_t f = 0; f < fields.size(); ++f) {
+      const auto mask = _mm_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(fields[f].mask)));
+      const auto x = _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(lane_shift32(fields[f], big))), mask);
+      auto* col = columns + f * count + i;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(col), _mm_unpacklo_epi32(x, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(col + 2), _mm_unpackhi_epi32(x, zero));
+    }
+  }
+  return i;
+}
+
+std::size_t decode_lanes64(const std::vector<PacketFieldPlan>& fields, bool big,
+                           const std::uint8_t* packets, std::size_t count, std::uint64_t* columns) {
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packets + 8 * i));
+    if (big) v = bswap64_lanes(v);
+    for (std::size_t f = 0; f < fields.size(); ++f) {
+      const auto mask = _mm_set1_epi64x(static_cast<long long>(fields[f].mask));
+      const auto x = _mm_and_si128(_mm_srl_epi64(v, _mm_cvtsi32_si128(static_cast<int>(fields[f].shift))), mask);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(columns + f * count + i), x);
+    }
+  }
+  return i;
+}
+
+std::size_t encode_lanes32(const std::vector<PacketFieldPlan>& fields, bool big,
+                           const std::uint64_t* columns, std::size_t count, std::uint8_t* out) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i acc = _mm_setzero_si128();
+    for (std::size_t f = 0; f < fields.size(); ++f) {
+      const auto* col = columns + f * count + i;
+      // Keep the low half of each 64-bit value: lanes 0, 2 of each pair.
+      const auto lo = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col)),
+                                        _MM_SHUFFLE(3, 1, 2, 0));
+      const auto hi = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col + 2)),
+                                        _MM_SHUFFLE(3, 1, 2, 0));
+      const auto x = _mm_unpacklo_epi64(lo, hi);
+      acc = _mm_or_si128(acc, _mm_sll_epi32(x, _mm_cvtsi32_si128(lane_shift32(fields[f], big))));
+    }
+    if (big) acc = bswap32_lanes(acc);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * i), acc);
+  }
+  return i;
+}
+
+std::size_t encode_lanes64(const std::vector<PacketFieldPlan>& fields, bool big,
+                           const std::uint64_t* columns, std::size_t count, std::uint8_t* out) {
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128i acc = _mm_setzero_si128();
+    for (std::size_t f = 0; f < fields.size(); ++f) {
+      const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + f * count + i));
+      acc = _mm_or_si128(acc, _mm_sll_epi64(x, _mm_cvtsi32_si128(static_cast<int>(fields[f].shift))));
+    }
+    if (big) acc = bswap64_lanes(acc);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8 * i), acc);
+  }
+  return i;
+}
+#endif
+
+} // namespace
+
+referee::Result<PacketCodec> PacketCodec::compile(const TypeDefinition& def) {
+  using R = referee::Result<PacketCodec>;
+  if (def.packet_fields.empty()) return R::err("type " + def.name + " has no packet fields");
+
+  PacketCodec codec;
+  if (!parse_byte_order(def.packet_byte_order, &codec.big_)) {
+    return R::err("unsupported packet byte order: " + *def.packet_byte_order);
+  }
+
+  std::uint32_t offset = 0;
+  for (const auto& field : def.packet_fields) {
+    if (field.bit_width == 0 || field.bit_width > 64) {
+      return R::err("packet field '" + field.name + "' has unsupported bit width " +
+                    std::to_string(field.bit_width));
+    }
+    PacketFieldPlan plan;
+    plan.name = field.name;
+    plan.type = field.type;
+    plan.bit_offset = offset;
+    plan.bit_width = field.bit_width;
+    plan.mask = field.bit_width == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << field.bit_width) - 1;
+    codec.fields_.push_back(std::move(plan));
+    offset += field.bit_width;
+  }
+  codec.packet_bytes_ = (offset + 7) / 8;
+  codec.single_word_ = codec.packet_bytes_ <= 8;
+
+  for (auto& field : codec.fields_) {
+    const std::uint32_t lead = codec.single_word_ ? field.bit_offset : field.bit_offset % 8;
+    const std::uint32_t end = lead + field.bit_width;
+    field.byte = codec.single_word_ ? 0 : field.bit_offset / 8;
+    field.spill = end > 64;
+    field.shift = codec.big_ ? (field.spill ? 0 : 64 - end) : lead;
+  }
+  return R::ok(std::move(codec));
+}
+
+bool PacketCodec::vectorized() const {
+#if defined(__SSE2__)
+  return packet_bytes_ == 4 || packet_bytes_ == 8;
+#else
+  return false;
+#endif
+}
+
+std::optional<std::size_t> PacketCodec::field_index(std::string_view name) const {
+  for (std::size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].name == name) return i;
+  }
+  return std::nullopt;
+}
+
+std::uint64_t PacketCodec::extract(const std::uint8_t* packet, const PacketFieldPlan& field) const {
+  const std::size_t n = std::min<std::size_t>(8, packet_bytes_ - field.byte);
+  const std::uint64_t window = load_window(packet + field.byte, n, big_);
+  if (!field.spill) return (window >> field.shift) & field.mask;
+
+  const std::uint32_t lead = field.bit_offset % 8;
+  const std::uint64_t next = packet[field.byte + 8];
+  if (big_) {
+    const std::uint32_t end = lead + field.bit_width;
+    return ((window << (end - 64)) | (next >> (72 - end))) & field.mask;
+  }
+  return ((window >> lead) | (next << (64 - lead))) & field.mask;
+}
+
+void PacketCodec::insert(std::uint8_t* packet, const PacketFieldPlan& field, std::uint64_t value) const {
+  const std::size_t n = std::min<std::size_t>(8, packet_bytes_ - field.byte);
+  std::uint64_t window = load_window(packet + field.byte, n, big_);
+  if (!field.spill) {
+    window |= value << field.shift;
+  } else {
+    const std::uint32_t lead = field.bit_offset % 8;
+    if (big_) {
+      const std::uint32_t end = lead + field.bit_width;
+      window |= value >> (end - 64);
+      packet[field.byte + 8] |= static_cast<std::uint8_t>(value << (72 - end));
+    } else {
+      window |= value << lead;
+      packet[field.byte + 8] |= static_cast<std::uint8_t>(value >> (64 - lead));
+    }
+  }
+  store_window(packet + field.byte, n, big_, window);
+}
+
+referee::Result<void> PacketCodec::check_range(const std::uint64_t* values, std::size_t stride,
+                                               std::size_t count) const {
+  for (std::size_t f = 0; f < fields_.size(); ++f) {
+    const std::uint64_t over = ~fields_[f].mask;
+    const std::uint64_t* col = values + f * stride;
+    std::uint64_t bad = 0;
+    for (std::size_t i = 0; i < count; ++i) bad |= col[i] & over;
+    if (bad != 0) {
+      return referee::Result<void>::err("value out of range for packet field '" + fields_[f].name +
+                                        "' (" + std::to_string(fields_[f].bit_width) + " bits)");
+    }
+  }
+  return referee::Result<void>::ok();
+}
+
+referee::Result<void> PacketCodec::encode(const std::uint64_t* values, std::uint8_t* out) const {
+  auto range = check_range(values, 1, 1);
+  if (!range) return range;
+  if (single_word_) {
+    std::uint64_t window = 0;
+    for (std::size_t f = 0; f < fields_.size(); ++f) window |= values[f] << fields_[f].shift;
+    store_window(out, packet_bytes_, big_, window);
+    return referee::Result<void>::ok();
+  }
+  std::memset(out, 0, packet_bytes_);
+  for (std::size_t f = 0; f < fields_.size(); ++f) insert(out, fields_[f], values[f]);
+  return referee::Result<void>::ok();
+}
+
+void PacketCodec::decode(const std::uint8_t* packet, std::uint64_t* values) const {
+  if (single_word_) {
+    const std::uint64_t window = load_window(packet, packet_bytes_, big_);
+    for (std::size_t f = 0; f < fields_.size(); ++f) {
+      values[f] = (window >> fields_[f].shift) & fields_[f].mask;
+    }
+    return;
+  }
+  for (std::size_t f = 0; f < fields_.size(); ++f) values[f] = extract(packet, fields_[f]);
+}
+
+referee::Result<void> PacketCodec::encode_batch(const std::uint64_t* columns, std::size_t count,
+                                                std::uint8_t* out) const {
+  auto range = check_range(columns, count, count);
+  if (!range) return range;
+
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  if (packet_bytes_ == 4) i = encode_lanes32(fields_, big_, columns, count, out);
+  if (packet_bytes_ == 8) i = encode_lanes64(fields_, big_, columns, count, out);
+#endif
+  std::vector<std::uint64_t> values(fields_.size());
+  for (; i < count; ++i) {
+    for (std::size_t f = 0; f < fields_.size(); ++f) values[f] = columns[f * count + i];
+    if (single_word_) {
+      std::uint64_t window = 0;
+      for (std::size_t f = 0; f < fields_.size(); ++f) window |= values[f] << fields_[f].shift;
+      store_window(out + i * packet_bytes_, packet_bytes_, big_, window);
+    } else {
+      std::uint8_t* packet = out + i * packet_bytes_;
+      std::memset(packet, 0, packet_bytes_);
+      for (std::size_t f = 0; f < fields_.size(); ++f) insert(packet, fields_[f], values[f]);
+    }
+  }
+  return referee::Result<void>::ok();
+}
+
+void PacketCodec::decode_batch(const std::uint8_t* packets, std::size_t count,
+                               std::uint64_t* columns) const {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  if (packet_bytes_ == 4) i = decode_lanes32(fields_, big_, packets, count, columns);
+  if (packet_bytes_ == 8) i = decode_lanes64(fields_, big_, packets, count, columns);
+#endif
+  for (; i < count; ++i) {
+    const std::uint8_t* packet = packets + i * packet_bytes_;
+    if (single_word_) {
+      const std::uint64_t window = load_window(packet, packet_bytes_, big_);
+      for (std::size_t f = 0; f < fields_.size(); ++f) {
+        columns[f * count + i] = (window >> fields_[f].shift) & fields_[f].mask;
+      }
+    } else {
+      for (std::size_t f = 0; f < fields_.size(); ++f) columns[f * count + i] = extract(packet, fields_[f]);
+    }
+  }
+}
+
+} // namespace iris::refract
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Packing and unpacking of packet types (TypeDefinition::packet_fields).
+//
+// Fields are laid out in declaration order with no padding between them; the
+// packet is the smallest whole number of bytes that holds them, and trailing bits
+// are zero. With byte order "be" (the default) the first field takes the most
+// significant bits of the first byte; with "le" it takes the least significant.
+// Every field is an unsigned integer of 1 to 64 bits.
+namespace iris::refract {
+
+struct PacketFieldPlan {
+  std::string name;
+  referee::TypeID type{};
+  std::uint32_t bit_offset{0};
+  std::uint32_t bit_width{0};
+  std::uint32_t byte{0};  // start of the 64-bit window holding the field
+  std::uint32_t shift{0}; // right shift of the field within its window
+  std::uint64_t mask{0};
+  bool spill{false};      // the field runs one byte past its window
+};
+
+// Shift/mask plan compiled once from a packet definition. Batch calls take and
+// produce field-major columns (value of field f for packet i at f * count + i),
+// and use SIMD lanes when the whole packet is 4 or 8 bytes.
+class PacketCodec {
+public:
+  static referee::Result<PacketCodec> compile(const TypeDefinition& def);
+
+  std::size_t packet_bytes() const { return packet_bytes_; }
+  bool big_endian() const { return big_; }
+  bool vectorized() const;
+  const std::vector<PacketFieldPlan>& fields() const { return fields_; }
+  std::optional<std::size_t> field_index(std::string_view name) const;
+
+  // `values` holds one value per field, in declaration order.
+  referee::Result<void> encode(const std::uint64_t* values, std::uint8_t* out) const;
+  void decode(const std::uint8_t* packet, std::uint64_t* values) const;
+
+  referee::Result<void> encode_batch(const std::uint64_t* columns, std::size_t count,
+                                     std::uint8_t* out) const;
+  void decode_batch(const std::uint8_t* packets, std::size_t count, std::uint64_t* columns) const;
+
+private:
+  std::uint64_t extract(const std::uint8_t* packet, const PacketFieldPlan& field) const;
+  void insert(std::uint8_t* packet, const PacketFieldPlan& field, std::uint64_t value) const;
+  referee::Result<void> check_range(const std::uint64_t* values, std::size_t stride,
+                                    std::size_t count) const;
+
+  std::vector<PacketFieldPlan> fields_;
+  std::size_t packet_bytes_{0};
+  bool big_{true};
+  bool single_word_{false}; // the whole packet fits one window at byte 0
+};
+
+} // namespace iris::refract
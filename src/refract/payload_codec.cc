@@ -0,0 +1,415 @@
+#include "refract/payload_codec.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+namespace iris::refract {
+
+namespace {
+
+constexpr referee::TypeID kTypeString{0x1001ULL};
+constexpr referee::TypeID kTypeU64{0x1002ULL};
+constexpr referee::TypeID kTypeBool{0x1003ULL};
+constexpr referee::TypeID kTypeObjectID{0x1004ULL};
+constexpr referee::TypeID kTypeTypeID{0x1005ULL};
+constexpr referee::TypeID kTypeVersion{0x1006ULL};
+constexpr referee::TypeID kTypeF64{0x1008ULL};
+
+bool is_object_id_hex(std::string_view text) {
+  if (text.size() != 32) return false;
+  return std::all_of(text.begin(), text.end(), [](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+  });
+}
+
+std::string type_error(std::string_view name, PayloadKind kind) {
+  return "field '" + std::string(name) + "' expects " + payload_kind_name(kind);
+}
+
+// Digits only: strtoull/strtoll would also take leading spaces and signs, and a
+// second "0x" after the first.
+bool all_digits(std::string_view text, int base) {
+  return !text.empty() && std::all_of(text.begin(), text.end(), [base](char c) {
+    if (c >= '0' && c <= '9') return true;
+    return base == 16 && ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'));
+  });
+}
+
+bool parse_u64_text(std::string_view text, std::uint64_t* out) {
+  int base = 10;
+  if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+    base = 16;
+    text.remove_prefix(2);
+  }
+  if (!all_digits(text, base)) return false;
+  std::string tmp(text);
+  errno = 0;
+  const auto v = std::strtoull(tmp.c_str(), nullptr, base);
+  if (errno == ERANGE) return false;
+  *out = static_cast<std::uint64_t>(v);
+  return true;
+}
+
+bool parse_i64_text(std::string_view text, std::int64_t* out) {
+  const auto digits = !text.empty() && text[0] == '-' ? text.substr(1) : text;
+  if (!all_digits(digits, 10)) return false;
+  std::string tmp(text);
+  errno = 0;
+  const auto v = std::strtoll(tmp.c_str(), nullptr, 10);
+  if (errno == ERANGE) return false;
+  *out = static_cast<std::int64_t>(v);
+  return true;
+}
+
+bool parse_double_text(std::string_view text, double* out) {
+  if (text.empty()) return false;
+  std::string tmp(text);
+  char* end = nullptr;
+  const auto v = std::strtod(tmp.c_str(), &end);
+  if (!end || *end != '\0') return false;
+  *out = v;
+  return true;
+}
+
+} // namespace
+
+PayloadKind payload_kind(referee::TypeID type) {
+  if (type == kTypeString) return PayloadKind::Text;
+  if (type == kTypeU64 || type == kTypeTypeID || type == kTypeVersion) return PayloadKind::Unsigned;
+  if (type == kTypeBool) return PayloadKind::Bool;
+  if (type == kTypeF64) return PayloadKind::Number;
+  if (type == kTypeObjectID) return PayloadKind::ObjectId;
+  return PayloadKind::Any;
+}
+
+bool payload_matches(PayloadKind kind, referee::CborSlice item) {
+  switch (kind) {
+    case PayloadKind::Any:
+      return true;
+    case PayloadKind::Text:
+      return referee::cbor_text(item).has_value();
+    case PayloadKind::Unsigned:
+      return referee::cbor_uint(item).has_value();
+    case PayloadKind::Bool:
+      return referee::cbor_bool(item).has_value();
+    case PayloadKind::Number:
+      return referee::cbor_double(item).has_value();
+    case PayloadKind::ObjectId: {
+      auto text = referee::cbor_text(item);
+      return text && is_object_id_hex(*text);
+    }
+  }
+  return false;
+}
+
+const char* payload_kind_name(PayloadKind kind) {
+  switch (kind) {
+    case PayloadKind::Any: return "any value";
+    case PayloadKind::Text: return "text";
+    case PayloadKind::Unsigned: return "an unsigned integer";
+    case PayloadKind::Bool: return "a bool";
+    case PayloadKind::Number: return "a number";
+    case PayloadKind::ObjectId: return "a 32-digit hex object id";
+  }
+  return "any value";
+}
+
+std::optional<referee::CborSlice> PayloadFields::get(std::size_t field) const {
+  if (field >= values_.size() || !values_[field].data) return std::nullopt;
+  return values_[field];
+}
+
+std::optional<std::string_view> PayloadFields::text(std::size_t field) const {
+  auto item = get(field);
+  return item ? referee::cbor_text(*item) : std::nullopt;
+}
+
+std::optional<std::uint64_t> PayloadFields::uint(std::size_t field) const {
+  auto item = get(field);
+  return item ? referee::cbor_uint(*item) : std::nullopt;
+}
+
+std::optional<double> PayloadFields::number(std::size_t field) const {
+  auto item = get(field);
+  return item ? referee::cbor_double(*item) : std::nullopt;
+}
+
+std::optional<bool> PayloadFields::boolean(std::size_t field) const {
+  auto item = get(field);
+  return item ? referee::cbor_bool(*item) : std::nullopt;
+}
+
+std::optional<referee::ObjectID> PayloadFields::object_id(std::size_t field) const {
+  auto hex = text(field);
+  if (!hex || !is_object_id_hex(*hex)) return std::nullopt;
+  return referee::ObjectID::from_hex(*hex);
+}
+
+PayloadCodec PayloadCodec::compile(const TypeDefinition& def) {
+  PayloadCodec codec;
+  codec.fields_.reserve(def.fields.size());
+  for (const auto& field : def.fields) {
+    // Same rule as PayloadValidator: a default makes a required field optional.
+    const bool required = field.required && !field.default_json.has_value();
+    codec.fields_.push_back(PayloadField{field.name, payload_kind(field.type), required});
+  }
+  // Stable, so a repeated name keeps its first declaration ahead of later ones.
+  std::stable_sort(codec.fields_.begin(), codec.fields_.end(),
+                   [](const auto& a, const auto& b) { return a.name < b.name; });
+  codec.fields_.erase(std::unique(codec.fields_.begin(), codec.fields_.end(),
+                                  [](const auto& a, const auto& b) { return a.name == b.name; }),
+                      codec.fields_.end());
+  return codec;
+}
+
+std::optional<std::size_t> PayloadCodec::field_index(std::string_view name) const {
+  auto it = std::lower_bound(fields_.begin(), fields_.end(), name,
+                             [](const PayloadField& f, std::string_view n) { return f.name < n; });
+  if (it == fields_.end() || it->name != name) return std::nullopt;
+  return static_cast<std::size_t>(it - fields_.begin());
+}
+
+referee::Result<PayloadFields> PayloadCodec::decode(const referee::Bytes& payload) const {
+  return decode(payload.data(), payload.size());
+}
+
+referee::Result<PayloadFields> PayloadCodec::decode(const std::uint8_t* data, std::size_t size) const {
+  using R = referee::Result<PayloadFields>;
+  auto map = referee::CborContainer::open(referee::CborSlice{data, size});
+  if (!map || !map->is_map()) return R::err("payload is not a map");
+
+  PayloadFields out;
+  out.values_.resize(fields_.size());
+  std::size_t cursor = 0; // payloads are usually written in key order
+  referee::CborSlice key;
+  referee::CborSlice item;
+  while (map->next(&key)) {
+    if (!map->next(&item)) break;
+    auto name = referee::cbor_text(key);
+    if (!name) continue;
+    std::optional<std::size_t> index;
+    if (cursor < fields_.size() && fields_[cursor].name == *name) {
+      index = cursor;
+    } else {
+      index = field_index(*name);
+    }
+    if (!index) continue;
+    cursor = *index + 1;
+    const auto& field = fields_[*index];
+    if (!payload_matches(field.kind, item)) return R::err(type_error(field.name, field.kind));
+    out.values_[*index] = item;
+  }
+  if (map->malformed()) return R::err("payload is malformed");
+
+  for (std::size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].required && !out.values_[i].data) {
+      return R::err("missing required field '" + fields_[i].name + "'");
+    }
+  }
+  return R::ok(std::move(out));
+}
+
+PayloadEncoder PayloadCodec::encoder() const { return PayloadEncoder(*this); }
+
+PayloadEncoder::PayloadEncoder(const PayloadCodec& codec)
+    : codec_(codec), entries_(codec.fields().size()) {}
+
+void PayloadEncoder::fail(std::string message) {
+  if (!error_) error_ = std::move(message);
+}
+
+// Records the item written since `start` under `name`; declared fields check its kind.
+void PayloadEncoder::commit(std::string_view name, std::size_t start) {
+  const auto size = values_.buffer().size() - start;
+  if (auto index = codec_.field_index(name)) {
+    entries_[*index] = Entry{{}, start, size, true};
+    const auto& field = codec_.fields()[*index];
+    if (!payload_matches(field.kind, referee::CborSlice{values_.buffer().data() + start, size})) {
+      fail(type_error(field.name, field.kind));
+    }
+    return;
+  }
+  for (auto& entry : extra_) {
+    if (entry.name == name) {
+      entry = Entry{entry.name, start, size, true};
+      return;
+    }
+  }
+  extra_.push_back(Entry{std::string(name), start, size, true});
+}
+
+PayloadEncoder& PayloadEncoder::reject(std::string_view name, std::string_view text, PayloadKind kind) {
+  fail("field '" + std::string(name) + "': '" + std::string(text) + "' is not "
+       + payload_kind_name(kind));
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_text(std::string_view name, std::string_view v) {
+  const auto start = values_.buffer().size();
+  values_.text(v);
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_uint(std::string_view name, std::uint64_t v) {
+  const auto start = values_.buffer().size();
+  values_.uint(v);
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_int(std::string_view name, std::int64_t v) {
+  const auto start = values_.buffer().size();
+  values_.integer(v);
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_number(std::string_view name, double v) {
+  const auto start = values_.buffer().size();
+  values_.number(v);
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_bool(std::string_view name, bool v) {
+  const auto start = values_.buffer().size();
+  values_.boolean(v);
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_object_id(std::string_view name, const referee::ObjectID& v) {
+  const auto start = values_.buffer().size();
+  values_.text(v.to_hex());
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::set_encoded(std::string_view name, const referee::Bytes& item) {
+  referee::CborSlice whole;
+  if (referee::cbor_lookup(item.data(), item.size(), {}, &whole) != referee::CborLookup::Found
+      || whole.size != item.size()) {
+    fail("field '" + std::string(name) + "' is not a single CBOR item");
+    return *this;
+  }
+  const auto start = values_.buffer().size();
+  values_.raw(item.data(), item.size());
+  commit(name, start);
+  return *this;
+}
+
+PayloadEncoder& PayloadEncoder::parse(std::string_view name, std::string_view text) {
+  const auto index = codec_.field_index(name);
+  const auto kind = index ? codec_.fields()[*index].kind : PayloadKind::Any;
+  switch (kind) {
+    case PayloadKind::Text:
+    case PayloadKind::ObjectId:
+      return set_text(name, text);
+    case PayloadKind::Unsigned: {
+      std::uint64_t v = 0;
+      if (!parse_u64_text(text, &v)) return reject(name, text, kind);
+      return set_uint(name, v);
+    }
+    case PayloadKind::Number: {
+      double v = 0.0;
+      if (!parse_double_text(text, &v)) return reject(name, text, kind);
+      return set_number(name, v);
+    }
+    case PayloadKind::Bool:
+      if (text == "true") return set_bool(name, true);
+      if (text == "false") return set_bool(name, false);
+      return reject(name, text, kind);
+    case PayloadKind::Any:
+      break;
+  }
+  if (text == "true") return set_bool(name, true);
+  if (text == "false") return set_bool(name, false);
+  std::int64_t v = 0;
+  if (parse_i64_text(text, &v)) return set_int(name, v);
+  return set_text(name, text);
+}
+
+referee::Result<referee::Bytes> PayloadEncoder::finish() {
+  using R = referee::Result<referee::Bytes>;
+  if (error_) return R::err(*error_);
+  const auto& fields = codec_.fields();
+  for (std::size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].required && !entries_[i].set) {
+      return R::err("missing required field '" + fields[i].name + "'");
+    }
+  }
+
+  std::sort(extra_.begin(), extra_.end(), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+  std::size_t count = extra_.size();
+  for (const auto& entry : entries_) count += entry.set ? 1 : 0;
+
+  referee::CborWriter out;
+  out.map(count);
+  const auto* values = values_.buffer().data();
+  auto put = [&](std::string_view name, const Entry& entry) {
+    out.text(name);
+    out.raw(values + entry.offset, entry.size);
+  };
+  // Merge declared fields and extras, both in key order.
+  std::size_t e = 0;
+  for (std::size_t i = 0; i < fields.size(); ++i) {
+    if (!entries_[i].set) continue;
+    while (e < extra_.size() && extra_[e].name < fields[i].name) {
+      put(extra_[e].name, extra_[e]);
+      ++e;
+    }
+    put(fields[i].name, entries_[i]);
+  }
+  for (; e < extra_.size(); ++e) put(extra_[e].name, extra_[e]);
+  return R::ok(out.take());
+}
+
+namespace payload_detail {
+
+bool read(referee::CborSlice item, std::string* out) {
+  auto v = referee::cbor_text(item);
+  if (!v) return false;
+  out->assign(*v);
+  return true;
+}
+
+bool read(referee::CborSlice item, std::uint64_t* out) {
+  auto v = referee::cbor_uint(item);
+  if (!v) return false;
+  *out = *v;
+  return true;
+}
+
+bool read(referee::CborSlice item, std::int64_t* out) {
+  auto v = referee::cbor_int(item);
+  if (!v) return false;
+  *out = *v;
+  return true;
+}
+
+bool read(referee::CborSlice item, double* out) {
+  auto v = referee::cbor_double(item);
+  if (!v) return false;
+  *out = *v;
+  return true;
+}
+
+bool read(referee::CborSlice item, bool* out) {
+  auto v = referee::cbor_bool(item);
+  if (!v) return false;
+  *out = *v;
+  return true;
+}
+
+bool read(referee::CborSlice item, referee::ObjectID* out) {
+  auto v = referee::cbor_text(item);
+  if (!v || !is_object_id_hex(*v)) return false;
+  *out = referee::ObjectID::from_hex(*v);
+  return true;
+}
+
+} // namespace payload_detail
+
+} // namespace iris::refract
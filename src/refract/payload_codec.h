@@ -0,0 +1,252 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/cbor_path.h"
+#include "referee/cbor_writer.h"
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Typed payload encoding and decoding without the nlohmann::json DOM.
+//
+// PayloadCodec is compiled at runtime from a TypeDefinition's fields, for types only
+// known through the registry. encode_payload/decode_payload are the compile-time
+// form for C++ structs whose layout is fixed, described by a list of members.
+// Both write CBOR directly and check field types and required fields in the same
+// single pass that reads the payload.
+namespace iris::refract {
+
+// Wire form of a field's declared type. Bytes and every non-core type accept any
+// well-formed item, since payloads use them for nested arrays and maps.
+enum class PayloadKind : std::uint8_t {
+  Any,
+  Text,     // String
+  Unsigned, // U64, TypeID, Version
+  Bool,
+  Number,   // F64; integers are accepted
+  ObjectId  // ObjectID as 32 hex digits
+};
+
+PayloadKind payload_kind(referee::TypeID type);
+const char* payload_kind_name(PayloadKind kind);
+bool payload_matches(PayloadKind kind, referee::CborSlice item);
+
+struct PayloadField {
+  std::string name;
+  PayloadKind kind{PayloadKind::Any};
+  bool required{false}; // marked required and has no default
+};
+
+// Values of one decoded payload, indexed like PayloadCodec::fields(). Slices point
+// into the payload, which must outlive this.
+class PayloadFields {
+public:
+  std::optional<referee::CborSlice> get(std::size_t field) const;
+  std::optional<std::string_view> text(std::size_t field) const;
+  std::optional<std::uint64_t> uint(std::size_t field) const;
+  std::optional<double> number(std::size_t field) const;
+  std::optional<bool> boolean(std::size_t field) const;
+  std::optional<referee::ObjectID> object_id(std::size_t field) const;
+
+private:
+  friend class PayloadCodec;
+  std::vector<referee::CborSlice> values_; // data == nullptr when absent
+};
+
+class PayloadEncoder;
+
+// Encoder/decoder program for one definition. Fields are kept in key order so an
+// encoded map is byte-identical to the DOM encoding of the same object.
+class PayloadCodec {
+public:
+  static PayloadCodec compile(const TypeDefinition& def);
+
+  const std::vector<PayloadField>& fields() const { return fields_; }
+  std::optional<std::size_t> field_index(std::string_view name) const;
+
+  // Unknown keys are skipped; the first type error or missing required field fails.
+  referee::Result<PayloadFields> decode(const std::uint8_t* data, std::size_t size) const;
+  referee::Result<PayloadFields> decode(const referee::Bytes& payload) const;
+
+  PayloadEncoder encoder() const;
+
+private:
+  std::vector<PayloadField> fields_;
+};
+
+// Collects field values, checking each against its declared kind, and writes them
+// as one map. Keys that are not declared are kept and checked only for form.
+class PayloadEncoder {
+public:
+  explicit PayloadEncoder(const PayloadCodec& codec);
+
+  PayloadEncoder& set_text(std::string_view name, std::string_view v);
+  PayloadEncoder& set_uint(std::string_view name, std::uint64_t v);
+  PayloadEncoder& set_int(std::string_view name, std::int64_t v);
+  PayloadEncoder& set_number(std::string_view name, double v);
+  PayloadEncoder& set_bool(std::string_view name, bool v);
+  PayloadEncoder& set_object_id(std::string_view name, const referee::ObjectID& v);
+  // One already-encoded CBOR item.
+  PayloadEncoder& set_encoded(std::string_view name, const referee::Bytes& item);
+
+  // Converts `text` by the field's kind: decimal or 0x integers, numbers, true/false,
+  // 32-digit hex ids. Undeclared and Any fields try bool, then integer, then text.
+  PayloadEncoder& parse(std::string_view name, std::string_view text);
+
+  // The encoded map, or the first conversion, type or missing-field error.
+  referee::Result<referee::Bytes> finish();
+
+private:
+  struct Entry {
+    std::string name; // extras only
+    std::size_t offset{0};
+    std::size_t size{0};
+    bool set{false};
+  };
+
+  void fail(std::string message);
+  void commit(std::string_view name, std::size_t start);
+  PayloadEncoder& reject(std::string_view name, std::string_view text, PayloadKind kind);
+
+  const PayloadCodec& codec_;
+  std::vector<Entry> entries_; // declared fields first, in codec order
+  std::vector<Entry> extra_;
+  referee::CborWriter values_;
+  std::optional<std::string> error_;
+};
+
+// -----------------------------
+// Native structs
+// -----------------------------
+// A member of T stored under `name`. Supported member types: std::string,
+// std::uint64_t, std::int64_t, double, bool, referee::ObjectID (as hex text),
+// std::vector and std::optional of those; an empty optional is omitted.
+template <typename T, typename M>
+struct PayloadMember {
+  std::string_view name;
+  M T::*member;
+  bool required;
+};
+
+template <typename T, typename M>
+constexpr PayloadMember<T, M> payload_member(std::string_view name, M T::*member,
+                                             bool required = false) {
+  return PayloadMember<T, M>{name, member, required};
+}
+
+namespace payload_detail {
+
+inline void write(referee::CborWriter& w, const std::string& v) { w.text(v); }
+inline void write(referee::CborWriter& w, std::uint64_t v) { w.uint(v); }
+inline void write(referee::CborWriter& w, std::int64_t v) { w.integer(v); }
+inline void write(referee::CborWriter& w, double v) { w.number(v); }
+inline void write(referee::CborWriter& w, bool v) { w.boolean(v); }
+inline void write(referee::CborWriter& w, const referee::ObjectID& v) { w.text(v.to_hex()); }
+
+template <typename V>
+void write(referee::CborWriter& w, const std::vector<V>& v) {
+  w.array(v.size());
+  for (const auto& item : v) write(w, item);
+}
+
+bool read(referee::CborSlice item, std::string* out);
+bool read(referee::CborSlice item, std::uint64_t* out);
+bool read(referee::CborSlice item, std::int64_t* out);
+bool read(referee::CborSlice item, double* out);
+bool read(referee::CborSlice item, bool* out);
+bool read(referee::CborSlice item, referee::ObjectID* out);
+
+template <typename V>
+bool read(referee::CborSlice item, std::vector<V>* out) {
+  auto items = referee::CborContainer::open(item);
+  if (!items || items->is_map()) return false;
+  out->clear();
+  referee::CborSlice element;
+  while (items->next(&element)) {
+    if (!read(element, &out->emplace_back())) return false;
+  }
+  return !items->malformed();
+}
+
+template <typename V>
+bool present(const V&) { return true; }
+template <typename V>
+bool present(const std::optional<V>& v) { return v.has_value(); }
+
+template <typename V>
+void write_member(referee::CborWriter& w, const V& v) { write(w, v); }
+template <typename V>
+void write_member(referee::CborWriter& w, const std::optional<V>& v) { write(w, *v); }
+
+template <typename V>
+bool read_member(referee::CborSlice item, V* out) { return read(item, out); }
+template <typename V>
+bool read_member(referee::CborSlice item, std::optional<V>* out) { return read(item, &out->emplace()); }
+
+} // namespace payload_detail
+
+// Writes the members in the order given; list them in key order to match the DOM
+// encoding byte for byte.
+template <typename T, typename... Ms>
+referee::Bytes encode_payload(const T& value, const PayloadMember<T, Ms>&... members) {
+  referee::CborWriter w;
+  const std::size_t count = (std::size_t{0} + ... + (payload_detail::present(value.*members.member) ? 1 : 0));
+  w.map(count);
+  auto put = [&](const auto& m) {
+    if (!payload_detail::present(value.*m.member)) return;
+    w.text(m.name);
+    payload_detail::write_member(w, value.*m.member);
+  };
+  (put(members), ...);
+  return w.take();
+}
+
+// One pass over the map: every known key is read and type-checked as it is met,
+// unknown keys are skipped, then required members are checked.
+template <typename T, typename... Ms>
+referee::Result<T> decode_payload(const referee::Bytes& payload, const PayloadMember<T, Ms>&... members) {
+  static_assert(sizeof...(Ms) <= 64, "too many payload members");
+  using R = referee::Result<T>;
+  auto map = referee::CborContainer::open(referee::CborSlice{payload.data(), payload.size()});
+  if (!map || !map->is_map()) return R::err("payload is not a map");
+
+  T out{};
+  std::uint64_t seen = 0;
+  std::optional<std::string> error;
+  referee::CborSlice key;
+  referee::CborSlice item;
+  while (!error && map->next(&key)) {
+    if (!map->next(&item)) break;
+    auto name = referee::cbor_text(key);
+    if (!name) continue;
+    std::size_t index = 0;
+    auto take = [&](const auto& m) {
+      const auto bit = std::uint64_t{1} << index++;
+      if (error || (seen & bit) || m.name != *name) return;
+      seen |= bit;
+      if (!payload_detail::read_member(item, &(out.*m.member))) {
+        error = "field '" + std::string(m.name) + "' has the wrong type";
+      }
+    };
+    (take(members), ...);
+  }
+  if (error) return R::err(*error);
+  if (map->malformed()) return R::err("payload is malformed");
+
+  std::size_t index = 0;
+  auto check = [&](const auto& m) {
+    const auto bit = std::uint64_t{1} << index++;
+    if (!error && m.required && !(seen & bit)) {
+      error = "missing required field '" + std::string(m.name) + "'";
+    }
+  };
+  (check(members), ...);
+  if (error) return R::err(*error);
+  return R::ok(std::move(out));
+}
+
+} // namespace iris::refract
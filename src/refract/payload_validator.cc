@@ -0,0 +1,233 @@
+#include "refract/payload_validator.h"
+
+#include "referee/cbor_path.h"
+#include "referee/cbor_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <sstream>
+
+namespace iris::refract {
+
+namespace {
+
+bool is_null(const referee::ObjectID& id) {
+  return std::all_of(id.bytes.begin(), id.bytes.end(), [](std::uint8_t b) { return b == 0; });
+}
+
+bool same_bytes(referee::CborSlice item, const referee::Bytes& encoded) {
+  return item.size == encoded.size() && std::memcmp(item.data, encoded.data(), item.size) == 0;
+}
+
+std::string type_hex(referee::TypeID type) {
+  std::ostringstream os;
+  os << "0x" << std::hex << type.v;
+  return os.str();
+}
+
+} // namespace
+
+std::size_t PayloadValidator::IdHash::operator()(const referee::ObjectID& id) const noexcept {
+  std::uint64_t v = 0;
+  std::memcpy(&v, id.bytes.data(), sizeof(v));
+  return static_cast<std::size_t>(v);
+}
+
+PayloadValidator::PayloadValidator(SchemaRegistry& registry) : registry_(registry) {}
+
+void PayloadValidator::install(referee::SqliteStore& store) {
+  store.set_object_validator([this](referee::TypeID type, referee::ObjectID definition_id,
+                                    const referee::Bytes& payload) {
+    return validate(type, definition_id, payload);
+  });
+}
+
+referee::Result<void> PayloadValidator::validate(referee::TypeID type, referee::ObjectID definition_id,
+                                                 const referee::Bytes& payload) {
+  if (type == kTypeDefinitionType || type == kTypeGenericInstanceType) return referee::Result<void>::ok();
+  auto programR = program_for(type, definition_id);
+  if (!programR) return referee::Result<void>::err(programR.error->message);
+  if (!programR.value.value()) return referee::Result<void>::ok();
+  return run(*programR.value.value(), payload);
+}
+
+referee::Result<const PayloadValidator::Program*> PayloadValidator::program_for(
+    referee::TypeID type, referee::ObjectID definition_id) {
+  using R = referee::Result<const Program*>;
+  const auto generation = registry_.generation();
+  if (generation != generation_) {
+    by_definition_.clear();
+    by_type_.clear();
+    generation_ = generation;
+  }
+
+  if (is_null(definition_id)) {
+    if (auto it = by_type_.find(type.v); it != by_type_.end()) return R::ok(it->second);
+    auto defR = registry_.get_latest_definition_by_type(type);
+    if (!defR) return R::err(defR.error->message);
+    if (!defR.value->has_value()) {
+      by_type_.emplace(type.v, nullptr);
+      return R::ok(nullptr);
+    }
+    definition_id = defR.value->value().ref.id;
+    if (!by_definition_.count(definition_id)) {
+      auto programR = compile(defR.value->value().definition);
+      if (!programR) return R::err(programR.error->message);
+      by_definition_.emplace(definition_id, std::move(programR.value.value()));
+    }
+    const Program* program = by_definition_.at(definition_id).get();
+    by_type_.emplace(type.v, program);
+    return R::ok(program);
+  }
+
+  if (auto it = by_definition_.find(definition_id); it != by_definition_.end()) {
+    return R::ok(it->second.get());
+  }
+  auto defR = registry_.get_definition_by_id(definition_id);
+  if (!defR) return R::err(defR.error->message);
+  if (!defR.value->has_value()) {
+    // Not registered (yet): nothing to check against.
+    by_definition_.emplace(definition_id, nullptr);
+    return R::ok(nullptr);
+  }
+  const auto& def = defR.value->value().definition;
+  if (def.type_id != type) {
+    return R::err("definition " + definition_id.to_hex() + " describes " + def.name + " (" +
+                  type_hex(def.type_id) + "), not type " + type_hex(type));
+  }
+  auto programR = compile(def);
+  if (!programR) return R::err(programR.error->message);
+  const Program* program = programR.value->get();
+  by_definition_.emplace(definition_id, std::move(programR.value.value()));
+  return R::ok(program);
+}
+
+referee::Result<std::unique_ptr<PayloadValidator::Program>> PayloadValidator::compile(
+    const TypeDefinition& def) {
+  using R = referee::Result<std::unique_ptr<Program>>;
+  auto program = std::make_unique<Program>();
+  for (const auto& field : def.fields) {
+    Check check;
+    check.name = field.name;
+    check.kind = payload_kind(field.type);
+    check.required = field.required && !field.default_json.has_value();
+
+    if (check.kind == PayloadKind::Any) {
+      auto typeR = registry_.get_latest_definition_by_type(field.type);
+      if (!typeR) return R::err(typeR.error->message);
+      if (typeR.value->has_value()) {
+        const auto& target = typeR.value->value().definition;
+        check.type_name = target.name;
+        for (const auto& value : target.enum_values) {
+          try {
+            check.allowed.push_back(referee::cbor_from_json_string(value.value_json));
+          } catch (const std::exception&) {
+            return R::err("enum " + target.name + " value '" + value.name + "' is not valid JSON");
+          }
+          referee::CborWriter tag;
+          tag.text(value.name);
+          check.allowed.push_back(tag.take());
+        }
+        if (target.collection_kind.has_value()) {
+          check.shape = *target.collection_kind == "map" ? Check::Shape::Map : Check::Shape::Array;
+          if (check.shape == Check::Shape::Array && target.collection_elements.size() == 1) {
+            check.item_kind = payload_kind(target.collection_elements.front().type);
+          }
+        }
+      }
+    }
+    program->checks.push_back(std::move(check));
+  }
+  std::stable_sort(program->checks.begin(), program->checks.end(),
+                   [](const Check& a, const Check& b) { return a.name < b.name; });
+  program->checks.erase(std::unique(program->checks.begin(), program->checks.end(),
+                                    [](const Check& a, const Check& b) { return a.name == b.name; }),
+                        program->checks.end());
+  program->required = static_cast<std::size_t>(
+      std::count_if(program->checks.begin(), program->checks.end(), [](const Check& c) { return c.required; }));
+  ++compiled_;
+  return R::ok(std::move(program));
+}
+
+referee::Result<void> PayloadValidator::run(const Program& program, const referee::Bytes& payload) {
+  using R = referee::Result<void>;
+  // A definition without fields demands no structure; packed payloads such as Astra
+  // arrays are bare byte strings.
+  if (program.checks.empty()) return R::ok();
+  auto map = referee::CborContainer::open(referee::CborSlice{payload.data(), payload.size()});
+  if (!map || !map->is_map()) return R::err("payload is not a map");
+
+  const auto& checks = program.checks;
+  // Required fields seen so far: a bitmask, spilling to a vector for wide types.
+  std::uint64_t seen_bits = 0;
+  std::vector<bool> seen_wide(checks.size() > 64 ? checks.size() : 0);
+  std::size_t seen_required = 0;
+
+  std::size_t cursor = 0; // payloads are usually written in key order
+  referee::CborSlice key;
+  referee::CborSlice item;
+  while (map->next(&key)) {
+    if (!map->next(&item)) break;
+    auto name = referee::cbor_text(key);
+    if (!name) continue;
+    std::size_t index = cursor;
+    if (index >= checks.size() || checks[index].name != *name) {
+      auto it = std::lower_bound(checks.begin(), checks.end(), *name,
+                                 [](const Check& c, std::string_view n) { return c.name < n; });
+      if (it == checks.end() || it->name != *name) continue;
+      index = static_cast<std::size_t>(it - checks.begin());
+    }
+    cursor = index + 1;
+    const auto& check = checks[index];
+
+    if (!payload_matches(check.kind, item)) {
+      return R::err("field '" + check.name + "' expects " + payload_kind_name(check.kind));
+    }
+    if (check.shape != Check::Shape::Value) {
+      auto items = referee::CborContainer::open(item);
+      const bool want_map = check.shape == Check::Shape::Map;
+      if (!items || items->is_map() != want_map) {
+        return R::err("field '" + check.name + "' expects " + (want_map ? "a map" : "an array") +
+                      " for " + check.type_name);
+      }
+      if (check.item_kind != PayloadKind::Any) {
+        referee::CborSlice element;
+        while (items->next(&element)) {
+          if (!payload_matches(check.item_kind, element)) {
+            return R::err("field '" + check.name + "' items expect " + payload_kind_name(check.item_kind));
+          }
+        }
+      }
+    }
+    if (!check.allowed.empty()
+        && std::none_of(check.allowed.begin(), check.allowed.end(),
+                        [&](const referee::Bytes& v) { return same_bytes(item, v); })) {
+      return R::err("field '" + check.name + "' is not a value of enum " + check.type_name);
+    }
+
+    if (check.required) {
+      bool first = false;
+      if (index < 64) {
+        first = !(seen_bits & (std::uint64_t{1} << index));
+        seen_bits |= std::uint64_t{1} << index;
+      } else {
+        first = !seen_wide[index];
+        seen_wide[index] = true;
+      }
+      if (first) ++seen_required;
+    }
+  }
+  if (map->malformed()) return R::err("payload is malformed");
+
+  if (seen_required < program.required) {
+    for (std::size_t i = 0; i < checks.size(); ++i) {
+      if (!checks[i].required) continue;
+      const bool seen = i < 64 ? (seen_bits & (std::uint64_t{1} << i)) != 0 : bool(seen_wide[i]);
+      if (!seen) return R::err("missing required field '" + checks[i].name + "'");
+    }
+  }
+  return R::ok();
+}
+
+} // namespace iris::refract
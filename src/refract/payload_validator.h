@@ -0,0 +1,76 @@
+#pragma once
+
+#include "refract/payload_codec.h"
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Payload checks compiled from type definitions and run before objects are written.
+namespace iris::refract {
+
+// Validates payloads against the definition named by an object's definition_id, or
+// the latest definition of its type when the id is null. Each definition compiles
+// once into a key-ordered field program:
+//   - a field is required when the definition marks it required and gives no default;
+//   - core-typed fields are checked by PayloadKind;
+//   - enum-typed fields take one of the enum's values or tag names;
+//   - collection-typed fields take an array ("map" collections: a map), whose items
+//     are checked when the collection declares one core element type.
+// Types with no definition, and definitions and generic instances themselves, pass.
+//
+// Programs are dropped when the registry's generation moves. Not thread-safe, like
+// the registry it reads.
+class PayloadValidator {
+public:
+  explicit PayloadValidator(SchemaRegistry& registry);
+
+  referee::Result<void> validate(referee::TypeID type, referee::ObjectID definition_id,
+                                 const referee::Bytes& payload);
+
+  // Routes the store's create_object* through validate(); this must outlive the store
+  // or be uninstalled with store.set_object_validator({}).
+  void install(referee::SqliteStore& store);
+
+  std::uint64_t programs_compiled() const { return compiled_; }
+
+private:
+  struct Check {
+    enum class Shape : std::uint8_t { Value, Array, Map };
+
+    std::string name;
+    PayloadKind kind{PayloadKind::Any};
+    bool required{false};
+    Shape shape{Shape::Value};
+    PayloadKind item_kind{PayloadKind::Any};
+    std::string type_name;              // enum or collection name, for messages
+    std::vector<referee::Bytes> allowed; // encoded enum values and tag names
+  };
+
+  struct Program {
+    std::vector<Check> checks; // sorted by name
+    std::size_t required{0};
+  };
+
+  struct IdHash {
+    std::size_t operator()(const referee::ObjectID& id) const noexcept;
+  };
+
+  referee::Result<const Program*> program_for(referee::TypeID type, referee::ObjectID definition_id);
+  referee::Result<std::unique_ptr<Program>> compile(const TypeDefinition& def);
+  static referee::Result<void> run(const Program& program, const referee::Bytes& payload);
+
+  SchemaRegistry& registry_;
+  std::uint64_t generation_{0};
+  std::uint64_t compiled_{0};
+  // nullptr: no definition to check against.
+  std::unordered_map<referee::ObjectID, std::unique_ptr<Program>, IdHash> by_definition_;
+  std::unordered_map<std::uint64_t, const Program*> by_type_;
+};
+
+} // namespace iris::refract
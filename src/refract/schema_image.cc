@@ -0,0 +1,128 @@
+#include "refract/schema_image.h"
+
+#include "refract/definition_codec.h"
+
+#include <unordered_set>
+
+namespace iris::refract {
+
+namespace {
+
+constexpr std::uint32_t kImageTag = 0x31495352; // "RSI1"
+constexpr std::uint32_t kImageFormat = 1;
+constexpr std::size_t kHeaderBytes = 16;
+constexpr std::size_t kEntryBytes = 24;
+
+std::uint64_t fnv1a(const std::uint8_t* data, std::size_t size) {
+  std::uint64_t h = 1469598103934665603ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    h ^= data[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+void put_u32(referee::Bytes* out, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+
+void put_u64(referee::Bytes* out, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) out->push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+
+void store_u64(referee::Bytes* out, std::size_t at, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) (*out)[at + i] = static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu);
+}
+
+std::uint32_t load_u32(const std::uint8_t* p) {
+  return (std::uint32_t)p[0]
+       | (std::uint32_t(p[1]) << 8)
+       | (std::uint32_t(p[2]) << 16)
+       | (std::uint32_t(p[3]) << 24);
+}
+
+std::uint64_t load_u64(const std::uint8_t* p) {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+  return v;
+}
+
+} // namespace
+
+SchemaImage SchemaImage::build(const std::vector<TypeDefinition>& defs) {
+  std::vector<const TypeDefinition*> unique;
+  std::unordered_set<std::uint64_t> seen;
+  for (const auto& def : defs) {
+    if (seen.insert(def.type_id.v).second) unique.push_back(&def);
+  }
+
+  SchemaImage image;
+  auto& out = image.bytes_;
+  put_u32(&out, kImageTag);
+  put_u32(&out, kImageFormat);
+  put_u64(&out, unique.size());
+  const std::size_t table = out.size();
+  out.resize(table + unique.size() * kEntryBytes);
+  for (std::size_t i = 0; i < unique.size(); ++i) {
+    const auto payload = encode_definition_binary(*unique[i]);
+    const std::size_t at = table + i * kEntryBytes;
+    store_u64(&out, at, unique[i]->type_id.v);
+    store_u64(&out, at + 8, out.size());
+    store_u64(&out, at + 16, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+  }
+  image.fingerprint_ = fnv1a(out.data(), out.size());
+  put_u64(&out, image.fingerprint_);
+  image.index();
+  return image;
+}
+
+referee::Result<SchemaImage> SchemaImage::open(referee::Bytes bytes) {
+  using R = referee::Result<SchemaImage>;
+  if (bytes.size() < kHeaderBytes + 8) return R::err("schema image truncated");
+  const auto body = bytes.size() - 8;
+  const auto checksum = load_u64(bytes.data() + body);
+  if (fnv1a(bytes.data(), body) != checksum) return R::err("schema image checksum mismatch");
+  if (load_u32(bytes.data()) != kImageTag) return R::err("not a schema image");
+  if (load_u32(bytes.data() + 4) != kImageFormat) return R::err("unsupported schema image format");
+
+  const auto count = load_u64(bytes.data() + 8);
+  if (count > (body - kHeaderBytes) / kEntryBytes) return R::err("schema image table out of bounds");
+  for (std::uint64_t i = 0; i < count; ++i) {
+    const auto* at = bytes.data() + kHeaderBytes + i * kEntryBytes;
+    const auto offset = load_u64(at + 8);
+    const auto size = load_u64(at + 16);
+    if (offset < kHeaderBytes + count * kEntryBytes || offset > body || size > body - offset) {
+      return R::err("schema image entry out of bounds");
+    }
+  }
+
+  SchemaImage image;
+  image.bytes_ = std::move(bytes);
+  image.fingerprint_ = checksum;
+  image.index();
+  return R::ok(std::move(image));
+}
+
+void SchemaImage::index() {
+  const auto count = load_u64(bytes_.data() + 8);
+  slots_.clear();
+  slots_.reserve(count);
+  for (std::uint64_t i = 0; i < count; ++i) {
+    const auto* at = bytes_.data() + kHeaderBytes + i * kEntryBytes;
+    slots_.push_back(Slot{referee::TypeID{load_u64(at)}, static_cast<std::size_t>(load_u64(at + 8)),
+                          static_cast<std::size_t>(load_u64(at + 16))});
+  }
+}
+
+SchemaImage::Entry SchemaImage::entry(std::size_t i) const {
+  const auto& slot = slots_[i];
+  return Entry{slot.type_id, bytes_.data() + slot.offset, slot.size};
+}
+
+referee::Bytes SchemaImage::payload(std::size_t i) const {
+  const auto e = entry(i);
+  return referee::Bytes(e.payload, e.payload + e.size);
+}
+
+} // namespace iris::refract
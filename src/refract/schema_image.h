@@ -0,0 +1,53 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <vector>
+
+// A set of definitions packed into one checksummed image ("RSI1").
+//
+//   u32 tag | u32 format | u64 count
+//   count x (u64 type_id | u64 offset | u64 size)   offsets from the image start
+//   definition payloads, in the binary layout of definition_codec.h
+//   u64 FNV-1a of everything before it
+//
+// The checksum doubles as the image's fingerprint: two images with the same
+// fingerprint hold the same definitions, byte for byte.
+namespace iris::refract {
+
+class SchemaImage {
+public:
+  struct Entry {
+    referee::TypeID type_id{};
+    const std::uint8_t* payload{nullptr};
+    std::size_t size{0};
+  };
+
+  // One entry per type; a later definition of the same type is dropped.
+  static SchemaImage build(const std::vector<TypeDefinition>& defs);
+  // Checks the tag, bounds and checksum.
+  static referee::Result<SchemaImage> open(referee::Bytes bytes);
+
+  const referee::Bytes& bytes() const { return bytes_; }
+  std::uint64_t fingerprint() const { return fingerprint_; }
+  std::size_t size() const { return slots_.size(); }
+  Entry entry(std::size_t i) const;
+  referee::Bytes payload(std::size_t i) const;
+
+private:
+  struct Slot {
+    referee::TypeID type_id{};
+    std::size_t offset{0};
+    std::size_t size{0};
+  };
+
+  void index();
+
+  referee::Bytes bytes_;
+  std::vector<Slot> slots_;
+  std::uint64_t fingerprint_{0};
+};
+
+} // namespace iris::refract
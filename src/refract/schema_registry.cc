@@ -1,7 +1,11 @@
 #include "refract/schema_registry.h"
 
+#include "refract/definition_codec.h"
+#include "referee/cbor_path.h"
+
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cstdio>
 #include <string_view>
@@ -324,42 +328,112 @@ static std::string hex_u64(std::uint64_t v) {
   return std::string(buf.data());
 }
 
-static referee::Result<std::string> encode_generic_arg_key(const GenericArg& arg) {
+// The instance key is produced piece by piece into a sink: KeyText collects it for
+// storage, KeyHash FNV-1a hashes it in place so deriving a type id builds no string.
+struct KeyText {
+  std::string text;
+  void append(std::string_view piece) { text += piece; }
+};
+
+struct KeyHash {
+  std::uint64_t hash{14695981039346656037ULL};
+  void append(std::string_view piece) {
+    for (unsigned char c : piece) {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+  }
+};
+
+template <typename Sink>
+static void append_hex_u64(Sink& sink, std::uint64_t v) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  char buf[16];
+  for (int i = 15; i >= 0; --i, v >>= 4) buf[i] = kDigits[v & 0xFu];
+  sink.append(std::string_view(buf, sizeof(buf)));
+}
+
+template <typename Sink>
+static referee::Result<void> append_generic_arg_key(Sink& sink, const GenericArg& arg) {
   switch (arg.kind) {
     case GenericArgKind::Type:
-      return referee::Result<std::string>::ok("type:0x" + hex_u64(arg.type_id.v));
+      sink.append("type:0x");
+      append_hex_u64(sink, arg.type_id.v);
+      return referee::Result<void>::ok();
     case GenericArgKind::Value: {
       auto canonR = canonicalize_value_json(arg.value_json);
-      if (!canonR) return canonR;
-      std::string key = "value:0x" + hex_u64(arg.value_type.v) + "=" + canonR.value.value();
-      return referee::Result<std::string>::ok(std::move(key));
+      if (!canonR) return referee::Result<void>::err(canonR.error->message);
+      sink.append("value:0x");
+      append_hex_u64(sink, arg.value_type.v);
+      sink.append("=");
+      sink.append(canonR.value.value());
+      return referee::Result<void>::ok();
     }
     case GenericArgKind::Variadic: {
-      std::string key = "variadic[";
+      sink.append("variadic[");
       bool first = true;
       for (const auto& item : arg.items) {
-        auto itemR = encode_generic_arg_key(item);
+        if (!first) sink.append(",");
+        auto itemR = append_generic_arg_key(sink, item);
         if (!itemR) return itemR;
-        if (!first) key += ",";
-        key += itemR.value.value();
         first = false;
       }
-      key += "]";
-      return referee::Result<std::string>::ok(std::move(key));
+      sink.append("]");
+      return referee::Result<void>::ok();
+    }
+  }
+  return referee::Result<void>::err("unknown generic arg kind");
+}
+
+template <typename Sink>
+static referee::Result<void> append_generic_instance_key(Sink& sink, const GenericInstance& instance) {
+  if (instance.base_type.v == 0) {
+    return referee::Result<void>::err("generic instance base type is zero");
+  }
+  sink.append("base=0x");
+  append_hex_u64(sink, instance.base_type.v);
+  sink.append(";args=[");
+  bool first = true;
+  for (const auto& arg : instance.args) {
+    if (!first) sink.append(",");
+    auto argR = append_generic_arg_key(sink, arg);
+    if (!argR) return argR;
+    first = false;
+  }
+  sink.append("]");
+  return referee::Result<void>::ok();
+}
+
+// Structural equality under the key's canonicalization; value JSON is only
+// reparsed when the texts differ.
+static bool same_generic_arg(const GenericArg& a, const GenericArg& b) {
+  if (a.kind != b.kind) return false;
+  switch (a.kind) {
+    case GenericArgKind::Type:
+      return a.type_id == b.type_id;
+    case GenericArgKind::Value: {
+      if (a.value_type != b.value_type) return false;
+      if (a.value_json == b.value_json) return true;
+      auto canonA = canonicalize_value_json(a.value_json);
+      auto canonB = canonicalize_value_json(b.value_json);
+      return canonA && canonB && canonA.value.value() == canonB.value.value();
     }
+    case GenericArgKind::Variadic:
+      if (a.items.size() != b.items.size()) return false;
+      for (std::size_t i = 0; i < a.items.size(); ++i) {
+        if (!same_generic_arg(a.items[i], b.items[i])) return false;
+      }
+      return true;
   }
-  return referee::Result<std::string>::err("unknown generic arg kind");
+  return false;
 }
 
-static std::uint64_t fnv1a_64(std::string_view input) {
-  constexpr std::uint64_t kOffset = 14695981039346656037ULL;
-  constexpr std::uint64_t kPrime = 1099511628211ULL;
-  std::uint64_t hash = kOffset;
-  for (unsigned char c : input) {
-    hash ^= c;
-    hash *= kPrime;
+static bool same_generic_instance(const GenericInstance& a, const GenericInstance& b) {
+  if (a.base_type != b.base_type || a.args.size() != b.args.size()) return false;
+  for (std::size_t i = 0; i < a.args.size(); ++i) {
+    if (!same_generic_arg(a.args[i], b.args[i])) return false;
   }
-  return hash;
+  return true;
 }
 
 static referee::Result<GenericInstance> generic_instance_from_json(const nlohmann::json& j) {
@@ -398,7 +472,14 @@ static nlohmann::json generic_instance_to_json(const GenericInstance& instance,
   return j;
 }
 
+// Definitions are written in the binary layout; stores created before it hold CBOR
+// payloads, which are still read as-is.
 static referee::Result<TypeDefinition> decode_definition(const referee::Bytes& payload) {
+  if (is_binary_definition(payload.data(), payload.size())) {
+    auto viewR = DefinitionView::open(payload.data(), payload.size());
+    if (!viewR) return referee::Result<TypeDefinition>::err(viewR.error->message);
+    return referee::Result<TypeDefinition>::ok(viewR.value->materialize());
+  }
   try {
     nlohmann::json j = nlohmann::json::from_cbor(payload);
     return referee::Result<TypeDefinition>::ok(definition_from_json(j));
@@ -408,7 +489,11 @@ static referee::Result<TypeDefinition> decode_definition(const referee::Bytes& p
 }
 
 static referee::Bytes encode_definition(const TypeDefinition& def) {
-  return nlohmann::json::to_cbor(to_json(def));
+  return encode_definition_binary(def);
+}
+
+static std::string id_key(const referee::ObjectID& id) {
+  return std::string(reinterpret_cast<const char*>(id.bytes.data()), id.bytes.size());
 }
 
 static referee::Result<DefinitionRecord> record_from_object(const referee::ObjectRecord& rec) {
@@ -424,40 +509,49 @@ static referee::Result<DefinitionRecord> record_from_object(const referee::Objec
 static referee::Result<std::optional<std::string>> migration_hook_from_props(
     const referee::Bytes& props_cbor) {
   if (props_cbor.empty()) return referee::Result<std::optional<std::string>>::ok(std::nullopt);
-  try {
-    auto j = nlohmann::json::from_cbor(props_cbor);
-    if (!j.contains("hook")) {
+  const std::string_view path[] = {"hook"};
+  referee::CborSlice item;
+  switch (referee::cbor_lookup(props_cbor.data(), props_cbor.size(), path, &item)) {
+    case referee::CborLookup::Missing:
       return referee::Result<std::optional<std::string>>::err("migration_hook missing hook");
-    }
-    return referee::Result<std::optional<std::string>>::ok(j.at("hook").get<std::string>());
-  } catch (const std::exception& ex) {
-    return referee::Result<std::optional<std::string>>::err(ex.what());
+    case referee::CborLookup::Malformed:
+      return referee::Result<std::optional<std::string>>::err("migration_hook props are not valid CBOR");
+    case referee::CborLookup::Found:
+      break;
+  }
+  auto hook = referee::cbor_text(item);
+  if (!hook.has_value()) {
+    return referee::Result<std::optional<std::string>>::err("migration_hook hook is not a string");
   }
+  return referee::Result<std::optional<std::string>>::ok(std::string(*hook));
 }
 
 } // namespace
 
+referee::Bytes definition_to_cbor(const TypeDefinition& def) {
+  return nlohmann::json::to_cbor(to_json(def));
+}
+
+std::string definition_to_json(const TypeDefinition& def) {
+  return to_json(def).dump();
+}
+
+referee::Result<TypeDefinition> decode_definition_payload(const referee::Bytes& payload) {
+  return decode_definition(payload);
+}
+
 referee::Result<std::string> encode_generic_instance_key(const GenericInstance& instance) {
-  if (instance.base_type.v == 0) {
-    return referee::Result<std::string>::err("generic instance base type is zero");
-  }
-  std::string key = "base=0x" + hex_u64(instance.base_type.v) + ";args=[";
-  bool first = true;
-  for (const auto& arg : instance.args) {
-    auto argR = encode_generic_arg_key(arg);
-    if (!argR) return argR;
-    if (!first) key += ",";
-    key += argR.value.value();
-    first = false;
-  }
-  key += "]";
-  return referee::Result<std::string>::ok(std::move(key));
+  KeyText key;
+  auto appendR = append_generic_instance_key(key, instance);
+  if (!appendR) return referee::Result<std::string>::err(appendR.error->message);
+  return referee::Result<std::string>::ok(std::move(key.text));
 }
 
 referee::Result<referee::TypeID> derive_generic_type_id(const GenericInstance& instance) {
-  auto keyR = encode_generic_instance_key(instance);
-  if (!keyR) return referee::Result<referee::TypeID>::err(keyR.error->message);
-  return referee::Result<referee::TypeID>::ok(referee::TypeID{fnv1a_64(keyR.value.value())});
+  KeyHash key;
+  auto appendR = append_generic_instance_key(key, instance);
+  if (!appendR) return referee::Result<referee::TypeID>::err(appendR.error->message);
+  return referee::Result<referee::TypeID>::ok(referee::TypeID{key.hash});
 }
 
 SchemaRegistry::SchemaRegistry(referee::SqliteStore& store) : store_(store) {}
@@ -466,11 +560,23 @@ referee::Result<DefinitionRecord> SchemaRegistry::register_definition(const Type
   if (def.name.empty()) return referee::Result<DefinitionRecord>::err("definition name is empty");
   if (def.type_id.v == 0) return referee::Result<DefinitionRecord>::err("type_id is zero");
 
+  const bool cache_in_sync =
+      cache_.valid && cache_.mark == store_.type_mark(kTypeDefinitionType);
   auto payload = encode_definition(def);
   auto definition_id = referee::ObjectID::random();
   auto createR = store_.create_object_with_id(definition_id, kTypeDefinitionType, definition_id,
                                               payload);
   if (!createR) return referee::Result<DefinitionRecord>::err(createR.error->message);
+  auto recordR = record_from_object(createR.value.value());
+  if (!recordR) return recordR;
+  intern_capabilities(def);
+  if (cache_in_sync) {
+    cache_definition(recordR.value.value());
+    cache_.mark = store_.type_mark(kTypeDefinitionType);
+  } else {
+    cache_.valid = false;
+  }
+  ++generation_;
 
   if (def.supersedes_definition_id.has_value()) {
     auto priorR = store_.get_latest(def.supersedes_definition_id.value());
@@ -491,7 +597,7 @@ referee::Result<DefinitionRecord> SchemaRegistry::register_definition(const Type
     return referee::Result<DefinitionRecord>::err("migration_hook requires supersedes_definition_id");
   }
 
-  return record_from_object(createR.value.value());
+  return recordR;
 }
 
 referee::Result<DefinitionRecord> SchemaRegistry::register_definition_with_id(
@@ -499,10 +605,22 @@ referee::Result<DefinitionRecord> SchemaRegistry::register_definition_with_id(
   if (def.name.empty()) return referee::Result<DefinitionRecord>::err("definition name is empty");
   if (def.type_id.v == 0) return referee::Result<DefinitionRecord>::err("type_id is zero");
 
+  const bool cache_in_sync =
+      cache_.valid && cache_.mark == store_.type_mark(kTypeDefinitionType);
   auto payload = encode_definition(def);
   auto createR = store_.create_object_with_id(definition_id, kTypeDefinitionType, definition_id,
                                               payload);
   if (!createR) return referee::Result<DefinitionRecord>::err(createR.error->message);
+  auto recordR = record_from_object(createR.value.value());
+  if (!recordR) return recordR;
+  intern_capabilities(def);
+  if (cache_in_sync) {
+    cache_definition(recordR.value.value());
+    cache_.mark = store_.type_mark(kTypeDefinitionType);
+  } else {
+    cache_.valid = false;
+  }
+  ++generation_;
 
   if (def.supersedes_definition_id.has_value()) {
     auto priorR = store_.get_latest(def.supersedes_definition_id.value());
@@ -523,10 +641,96 @@ referee::Result<DefinitionRecord> SchemaRegistry::register_definition_with_id(
     return referee::Result<DefinitionRecord>::err("migration_hook requires supersedes_definition_id");
   }
 
-  return record_from_object(createR.value.value());
+  return recordR;
+}
+
+referee::Result<const SchemaRegistry::DefinitionCache*> SchemaRegistry::definitions() {
+  using R = referee::Result<const DefinitionCache*>;
+  const auto mark = store_.type_mark(kTypeDefinitionType);
+  if (cache_.valid && cache_.mark == mark) return R::ok(&cache_);
+
+  auto listR = store_.list_by_type(kTypeDefinitionType);
+  if (!listR) return R::err(listR.error->message);
+
+  cache_ = DefinitionCache{};
+  cache_.records.reserve(listR.value->size());
+  for (const auto& rec : listR.value.value()) {
+    auto defR = record_from_object(rec);
+    if (!defR) {
+      cache_ = DefinitionCache{};
+      return R::err(defR.error->message);
+    }
+    cache_definition(std::move(defR.value.value()));
+  }
+  cache_.mark = mark;
+  cache_.valid = true;
+  ++generation_;
+  return R::ok(&cache_);
+}
+
+void SchemaRegistry::intern_capabilities(const TypeDefinition& def) {
+  for (const auto& op : def.operations) {
+    for (const auto& capability : op.required_capabilities) capabilities_.intern(capability);
+  }
+}
+
+void SchemaRegistry::cache_definition(DefinitionRecord record) {
+  const auto index = cache_.records.size();
+  const auto type = record.definition.type_id.v;
+  cache_.first_by_type.emplace(type, index);
+  auto [latest, inserted] = cache_.latest_by_type.emplace(type, index);
+  if (!inserted
+      && record.definition.version > cache_.records[latest->second].definition.version) {
+    latest->second = index;
+    inserted = true;
+  }
+  if (inserted) {
+    cache_.subtypes.update(record.definition);
+    cache_.names.update(TypeSummary{ record.definition.type_id, record.ref.id, record.definition.name,
+                                     record.definition.namespace_name,
+                                     record.definition.preferred_renderer });
+  }
+  intern_capabilities(record.definition);
+  cache_.by_id[id_key(record.ref.id)] = index;
+  cache_.records.push_back(std::move(record));
+}
+
+referee::Result<const SubtypeIndex*> SchemaRegistry::subtypes() {
+  auto cacheR = definitions();
+  if (!cacheR) return referee::Result<const SubtypeIndex*>::err(cacheR.error->message);
+  return referee::Result<const SubtypeIndex*>::ok(&cacheR.value.value()->subtypes);
+}
+
+referee::Result<const TypeNameIndex*> SchemaRegistry::type_names() {
+  auto cacheR = definitions();
+  if (!cacheR) return referee::Result<const TypeNameIndex*>::err(cacheR.error->message);
+  return referee::Result<const TypeNameIndex*>::ok(&cacheR.value.value()->names);
+}
+
+referee::Result<std::optional<TypeSummary>> SchemaRegistry::find_type(std::string_view namespace_name,
+                                                                      std::string_view name) {
+  using R = referee::Result<std::optional<TypeSummary>>;
+  auto namesR = type_names();
+  if (!namesR) return R::err(namesR.error->message);
+  const auto* summary = namesR.value.value()->find(namespace_name, name);
+  return R::ok(summary ? std::optional<TypeSummary>(*summary) : std::nullopt);
+}
+
+std::uint64_t SchemaRegistry::generation() {
+  // A failed rebuild leaves the cache invalid; still move so callers do not trust
+  // results computed before the failure.
+  if (!definitions()) ++generation_;
+  return generation_;
 }
 
 referee::Result<std::optional<DefinitionRecord>> SchemaRegistry::get_definition_by_id(referee::ObjectID id) {
+  auto cacheR = definitions();
+  if (!cacheR) return referee::Result<std::optional<DefinitionRecord>>::err(cacheR.error->message);
+  const auto* cache = cacheR.value.value();
+  if (auto it = cache->by_id.find(id_key(id)); it != cache->by_id.end()) {
+    return referee::Result<std::optional<DefinitionRecord>>::ok(cache->records[it->second]);
+  }
+
   auto recR = store_.get_latest(id);
   if (!recR) return referee::Result<std::optional<DefinitionRecord>>::err(recR.error->message);
   if (!recR.value->has_value()) {
@@ -545,57 +749,43 @@ referee::Result<std::optional<DefinitionRecord>> SchemaRegistry::get_definition_
 }
 
 referee::Result<std::optional<DefinitionRecord>> SchemaRegistry::get_definition_by_type(referee::TypeID type) {
-  auto listR = store_.list_by_type(kTypeDefinitionType);
-  if (!listR) return referee::Result<std::optional<DefinitionRecord>>::err(listR.error->message);
-
-  for (const auto& rec : listR.value.value()) {
-    auto defR = record_from_object(rec);
-    if (!defR) return referee::Result<std::optional<DefinitionRecord>>::err(defR.error->message);
-    if (defR.value->definition.type_id == type) {
-      return referee::Result<std::optional<DefinitionRecord>>::ok(defR.value.value());
-    }
+  auto cacheR = definitions();
+  if (!cacheR) return referee::Result<std::optional<DefinitionRecord>>::err(cacheR.error->message);
+  const auto* cache = cacheR.value.value();
+  auto it = cache->first_by_type.find(type.v);
+  if (it == cache->first_by_type.end()) {
+    return referee::Result<std::optional<DefinitionRecord>>::ok(std::optional<DefinitionRecord>{});
   }
-
-  return referee::Result<std::optional<DefinitionRecord>>::ok(std::optional<DefinitionRecord>{});
+  return referee::Result<std::optional<DefinitionRecord>>::ok(cache->records[it->second]);
 }
 
 referee::Result<std::optional<DefinitionRecord>> SchemaRegistry::get_latest_definition_by_type(
     referee::TypeID type) {
-  auto listR = store_.list_by_type(kTypeDefinitionType);
-  if (!listR) return referee::Result<std::optional<DefinitionRecord>>::err(listR.error->message);
-
-  std::optional<DefinitionRecord> latest;
-  for (const auto& rec : listR.value.value()) {
-    auto defR = record_from_object(rec);
-    if (!defR) return referee::Result<std::optional<DefinitionRecord>>::err(defR.error->message);
-    if (defR.value->definition.type_id != type) continue;
-
-    if (!latest.has_value()
-        || defR.value->definition.version > latest->definition.version) {
-      latest = defR.value.value();
-    }
+  auto cacheR = definitions();
+  if (!cacheR) return referee::Result<std::optional<DefinitionRecord>>::err(cacheR.error->message);
+  const auto* cache = cacheR.value.value();
+  auto it = cache->latest_by_type.find(type.v);
+  if (it == cache->latest_by_type.end()) {
+    return referee::Result<std::optional<DefinitionRecord>>::ok(std::optional<DefinitionRecord>{});
   }
-
-  return referee::Result<std::optional<DefinitionRecord>>::ok(std::move(latest));
+  return referee::Result<std::optional<DefinitionRecord>>::ok(cache->records[it->second]);
 }
 
 referee::Result<std::vector<TypeSummary>> SchemaRegistry::list_types() {
-  auto listR = store_.list_by_type(kTypeDefinitionType);
-  if (!listR) return referee::Result<std::vector<TypeSummary>>::err(listR.error->message);
+  auto cacheR = definitions();
+  if (!cacheR) return referee::Result<std::vector<TypeSummary>>::err(cacheR.error->message);
+  const auto* cache = cacheR.value.value();
 
   std::vector<TypeSummary> out;
-  out.reserve(listR.value->size());
-
-  for (const auto& rec : listR.value.value()) {
-    auto defR = record_from_object(rec);
-    if (!defR) return referee::Result<std::vector<TypeSummary>>::err(defR.error->message);
+  out.reserve(cache->records.size());
 
+  for (const auto& record : cache->records) {
     TypeSummary summary;
-    summary.type_id = defR.value->definition.type_id;
-    summary.definition_id = defR.value->ref.id;
-    summary.name = defR.value->definition.name;
-    summary.namespace_name = defR.value->definition.namespace_name;
-    summary.preferred_renderer = defR.value->definition.preferred_renderer;
+    summary.type_id = record.definition.type_id;
+    summary.definition_id = record.ref.id;
+    summary.name = record.definition.name;
+    summary.namespace_name = record.definition.namespace_name;
+    summary.preferred_renderer = record.definition.preferred_renderer;
 
     out.push_back(std::move(summary));
   }
@@ -666,51 +856,78 @@ GenericRegistry::GenericRegistry(SchemaRegistry& schema, referee::SqliteStore& s
 
 referee::Result<GenericInstanceRecord> GenericRegistry::register_instance(
     const GenericInstance& instance) {
-  auto defR = schema_.get_definition_by_type(kTypeGenericInstanceType);
-  if (!defR) return referee::Result<GenericInstanceRecord>::err(defR.error->message);
-  if (!defR.value->has_value()) {
-    return referee::Result<GenericInstanceRecord>::err("generic instance definition missing");
+  using R = referee::Result<GenericInstanceRecord>;
+  auto typeR = derive_generic_type_id(instance);
+  if (!typeR) return R::err(typeR.error->message);
+  const auto type_id = typeR.value.value();
+
+  auto indexR = instances();
+  if (!indexR) return R::err(indexR.error->message);
+  if (auto it = index_.by_type.find(type_id.v); it != index_.by_type.end()) {
+    if (!same_generic_instance(it->second.instance, instance)) {
+      return R::err("generic instance type id collision");
+    }
+    return R::ok(it->second);
   }
 
+  auto defR = schema_.get_definition_by_type(kTypeGenericInstanceType);
+  if (!defR) return R::err(defR.error->message);
+  if (!defR.value->has_value()) return R::err("generic instance definition missing");
+
   auto keyR = encode_generic_instance_key(instance);
-  if (!keyR) return referee::Result<GenericInstanceRecord>::err(keyR.error->message);
-  auto typeR = derive_generic_type_id(instance);
-  if (!typeR) return referee::Result<GenericInstanceRecord>::err(typeR.error->message);
+  if (!keyR) return R::err(keyR.error->message);
 
   GenericInstance stored = instance;
-  stored.instance_type = typeR.value.value();
+  stored.instance_type = type_id;
   auto payload = nlohmann::json::to_cbor(generic_instance_to_json(stored, keyR.value.value()));
 
   auto createR = store_.create_object(kTypeGenericInstanceType, defR.value->value().ref.id, payload);
-  if (!createR) return referee::Result<GenericInstanceRecord>::err(createR.error->message);
+  if (!createR) return R::err(createR.error->message);
 
   GenericInstanceRecord record{};
   record.ref = createR.value->ref;
   record.instance = std::move(stored);
-  return referee::Result<GenericInstanceRecord>::ok(std::move(record));
+  index_.by_type.emplace(type_id.v, record);
+  index_.mark = store_.type_mark(kTypeGenericInstanceType);
+  return R::ok(std::move(record));
 }
 
 referee::Result<std::optional<GenericInstanceRecord>> GenericRegistry::get_instance_by_type(
     referee::TypeID type_id) {
+  using R = referee::Result<std::optional<GenericInstanceRecord>>;
+  auto indexR = instances();
+  if (!indexR) return R::err(indexR.error->message);
+  auto it = index_.by_type.find(type_id.v);
+  if (it == index_.by_type.end()) return R::ok(std::optional<GenericInstanceRecord>{});
+  return R::ok(it->second);
+}
+
+referee::Result<void> GenericRegistry::instances() {
+  const auto mark = store_.type_mark(kTypeGenericInstanceType);
+  if (index_.valid && index_.mark == mark) return referee::Result<void>::ok();
+
   auto listR = store_.list_by_type(kTypeGenericInstanceType);
-  if (!listR) return referee::Result<std::optional<GenericInstanceRecord>>::err(listR.error->message);
+  if (!listR) return referee::Result<void>::err(listR.error->message);
+
+  index_ = InstanceIndex{};
   for (const auto& rec : listR.value.value()) {
     try {
-      auto j = nlohmann::json::from_cbor(rec.payload_cbor);
-      auto instR = generic_instance_from_json(j);
-      if (!instR) return referee::Result<std::optional<GenericInstanceRecord>>::err(instR.error->message);
-      if (instR.value->instance_type == type_id) {
-        GenericInstanceRecord record{};
-        record.ref = rec.ref;
-        record.instance = instR.value.value();
-        return referee::Result<std::optional<GenericInstanceRecord>>::ok(record);
+      auto instR = generic_instance_from_json(nlohmann::json::from_cbor(rec.payload_cbor));
+      if (!instR) {
+        index_ = InstanceIndex{};
+        return referee::Result<void>::err(instR.error->message);
       }
+      // Stores written before hash-consing may repeat an instance; the first wins.
+      const auto type = instR.value->instance_type.v;
+      index_.by_type.emplace(type, GenericInstanceRecord{rec.ref, std::move(instR.value.value())});
     } catch (const std::exception& ex) {
-      return referee::Result<std::optional<GenericInstanceRecord>>::err(ex.what());
+      index_ = InstanceIndex{};
+      return referee::Result<void>::err(ex.what());
     }
   }
-  return referee::Result<std::optional<GenericInstanceRecord>>::ok(
-      std::optional<GenericInstanceRecord>{});
+  index_.mark = mark;
+  index_.valid = true;
+  return referee::Result<void>::ok();
 }
 
 ScopedTypeRegistry::ScopedTypeRegistry(Scope scope,
@@ -766,13 +983,49 @@ referee::Result<std::optional<GenericInstanceRecord>> ScopedTypeRegistry::find(
 }
 
 std::optional<GenericInstanceRecord> ScopedTypeRegistry::find_local(referee::TypeID type_id) const {
-  auto it = cache_.find(type_id);
-  if (it == cache_.end()) return std::nullopt;
-  return it->second;
+  if (const auto* record = cache_.find(type_id)) return *record;
+  return std::nullopt;
 }
 
 void ScopedTypeRegistry::cache_instance(const GenericInstanceRecord& record) {
-  cache_[record.instance.instance_type] = record;
+  cache_.insert_or_assign(record);
+}
+
+// Instance type ids are already FNV-1a hashes, so their low bits index the slots
+// directly. Returns the slot holding `type_id`, or the empty slot that would.
+std::size_t ScopedTypeRegistry::InstanceTable::slot_of(referee::TypeID type_id) const {
+  const auto mask = slots_.size() - 1;
+  auto i = type_id.v & mask;
+  while (slots_[i] != 0 && records_[slots_[i] - 1].instance.instance_type != type_id) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+const GenericInstanceRecord* ScopedTypeRegistry::InstanceTable::find(referee::TypeID type_id) const {
+  if (slots_.empty()) return nullptr;
+  const auto slot = slots_[slot_of(type_id)];
+  return slot == 0 ? nullptr : &records_[slot - 1];
+}
+
+void ScopedTypeRegistry::InstanceTable::insert_or_assign(const GenericInstanceRecord& record) {
+  if (!slots_.empty()) {
+    const auto slot = slots_[slot_of(record.instance.instance_type)];
+    if (slot != 0) {
+      records_[slot - 1] = record;
+      return;
+    }
+  }
+  records_.push_back(record);
+  // Keep the load factor at or below one half.
+  if (records_.size() * 2 > slots_.size()) {
+    slots_.assign(std::max<std::size_t>(16, slots_.size() * 2), 0);
+    for (std::size_t i = 0; i < records_.size(); ++i) {
+      slots_[slot_of(records_[i].instance.instance_type)] = static_cast<std::uint32_t>(i + 1);
+    }
+  } else {
+    slots_[slot_of(record.instance.instance_type)] = static_cast<std::uint32_t>(records_.size());
+  }
 }
 
 ScopedTypeRegistry* ScopedTypeRegistry::root() {
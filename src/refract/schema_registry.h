@@ -1,13 +1,17 @@
 #pragma once
 
+#include "refract/capabilities.h"
+#include "refract/subtype_index.h"
+#include "refract/type_name_index.h"
 #include "referee/referee.h"
 #include "referee_sqlite/sqlite_store.h"
 
 #include <cstdint>
 #include <functional>
-#include <map>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace iris::refract {
@@ -107,14 +111,6 @@ struct TypeDefinition {
   std::optional<std::string> preferred_renderer{};
 };
 
-struct TypeSummary {
-  referee::TypeID type_id{};
-  referee::ObjectID definition_id{};
-  std::string name;
-  std::string namespace_name;
-  std::optional<std::string> preferred_renderer;
-};
-
 struct DefinitionRecord {
   referee::ObjectRef ref{};
   TypeDefinition definition{};
@@ -128,6 +124,12 @@ struct SupersedesLink {
 constexpr referee::TypeID kTypeDefinitionType{0x5246524354450001ULL};
 constexpr referee::TypeID kTypeGenericInstanceType{0x5246524347000001ULL};
 
+// Export forms of a definition. Stored payloads use the binary layout in
+// definition_codec.h; decode_definition_payload() also accepts legacy CBOR payloads.
+referee::Bytes definition_to_cbor(const TypeDefinition& def);
+std::string definition_to_json(const TypeDefinition& def);
+referee::Result<TypeDefinition> decode_definition_payload(const referee::Bytes& payload);
+
 referee::Result<std::string> encode_generic_instance_key(const GenericInstance& instance);
 referee::Result<referee::TypeID> derive_generic_type_id(const GenericInstance& instance);
 
@@ -144,8 +146,48 @@ public:
   referee::Result<std::vector<TypeSummary>> list_types();
   referee::Result<std::vector<SupersedesLink>> list_supersedes_chain(referee::ObjectID definition_id);
 
+  // Advances whenever the set of definitions changes; lets callers key their own
+  // caches on it. Cheap when nothing changed.
+  std::uint64_t generation();
+
+  // Inheritance closure over the latest definition of every type, kept current as
+  // definitions are registered.
+  referee::Result<const SubtypeIndex*> subtypes();
+
+  // Names of the latest definition of every type, kept current the same way. Use it
+  // instead of scanning list_types(), which has a summary per stored definition.
+  referee::Result<const TypeNameIndex*> type_names();
+  referee::Result<std::optional<TypeSummary>> find_type(std::string_view namespace_name, std::string_view name);
+
+  // Capability names, interned from the operations of each definition as it is
+  // registered or loaded, and from grants. Ids are never reassigned, even when the cache rebuilds.
+  CapabilityTable& capabilities() { return capabilities_; }
+
+  referee::SqliteStore& store() { return store_; }
+
 private:
+  // Decoded definitions in list_by_type() order, indexed by type_id and definition id.
+  // register_definition* appends to it; any other movement of the store's TypeMark
+  // for definitions (another registry, rollback, refresh) rebuilds it.
+  struct DefinitionCache {
+    bool valid{false};
+    referee::TypeMark mark{};
+    std::vector<DefinitionRecord> records;
+    std::unordered_map<std::uint64_t, std::size_t> first_by_type;
+    std::unordered_map<std::uint64_t, std::size_t> latest_by_type;
+    std::unordered_map<std::string, std::size_t> by_id; // ObjectID bytes
+    SubtypeIndex subtypes;
+    TypeNameIndex names;
+  };
+
+  referee::Result<const DefinitionCache*> definitions();
+  void cache_definition(DefinitionRecord record);
+  void intern_capabilities(const TypeDefinition& def);
+
   referee::SqliteStore& store_;
+  DefinitionCache cache_;
+  CapabilityTable capabilities_;
+  std::uint64_t generation_{0};
 };
 
 struct GenericInstanceRecord {
@@ -161,8 +203,19 @@ public:
   referee::Result<std::optional<GenericInstanceRecord>> get_instance_by_type(referee::TypeID type_id);
 
 private:
+  // Every stored instance by instance_type, rebuilt when the store's TypeMark for
+  // instances moves other than through register_instance().
+  struct InstanceIndex {
+    bool valid{false};
+    referee::TypeMark mark{};
+    std::unordered_map<std::uint64_t, GenericInstanceRecord> by_type;
+  };
+
+  referee::Result<void> instances();
+
   SchemaRegistry& schema_;
   referee::SqliteStore& store_;
+  InstanceIndex index_;
 };
 
 class ScopedTypeRegistry {
@@ -195,14 +248,23 @@ public:
   void cache_instance(const GenericInstanceRecord& record);
 
 private:
-  struct TypeIDLess {
-    bool operator()(referee::TypeID a, referee::TypeID b) const { return a.v < b.v; }
+  // Open-addressing table over a dense record array; records are never removed.
+  class InstanceTable {
+  public:
+    const GenericInstanceRecord* find(referee::TypeID type_id) const;
+    void insert_or_assign(const GenericInstanceRecord& record);
+
+  private:
+    std::size_t slot_of(referee::TypeID type_id) const;
+
+    std::vector<GenericInstanceRecord> records_;
+    std::vector<std::uint32_t> slots_; // index into records_ + 1; 0 is empty
   };
 
   Scope scope_;
   GenericRegistry& registry_;
   ScopedTypeRegistry* parent_{nullptr};
-  std::map<referee::TypeID, GenericInstanceRecord, TypeIDLess> cache_;
+  InstanceTable cache_;
   std::function<void(const std::string&)> logger_;
 
   ScopedTypeRegistry* root();
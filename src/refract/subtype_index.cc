@@ -0,0 +1,255 @@
+#include "refract/subtype_index.h"
+
+#include "refract/schema_registry.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+
+namespace iris::refract {
+
+namespace {
+
+bool is_base_role(std::string_view role) {
+  return role == "base" || role == "extends";
+}
+
+constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+
+} // namespace
+
+void SubtypeIndex::clear() {
+  nodes_.clear();
+  slots_.clear();
+  by_name_.clear();
+}
+
+std::size_t SubtypeIndex::slot_for(referee::TypeID type) {
+  auto [it, inserted] = slots_.emplace(type.v, nodes_.size());
+  if (inserted) {
+    Node node;
+    node.type = type;
+    node.mro.push_back(TypeAncestor{type, 0});
+    nodes_.push_back(std::move(node));
+    auto& self = nodes_.back();
+    self.ancestors.assign(it->second / 64 + 1, 0);
+    self.ancestors[it->second / 64] |= std::uint64_t{1} << (it->second % 64);
+  }
+  return it->second;
+}
+
+bool SubtypeIndex::has_bit(const Node& node, std::size_t slot) const {
+  const auto word = slot / 64;
+  if (word >= node.ancestors.size()) return false;
+  return (node.ancestors[word] >> (slot % 64)) & 1u;
+}
+
+void SubtypeIndex::update(const TypeDefinition& def) {
+  const auto slot = slot_for(def.type_id);
+
+  std::vector<std::string> names{def.name};
+  if (!def.namespace_name.empty()) names.push_back(def.namespace_name + "::" + def.name);
+  std::vector<std::string> base_names;
+  for (const auto& rel : def.relationships) {
+    if (is_base_role(rel.role)) base_names.push_back(rel.target);
+  }
+
+  std::vector<std::size_t> dirty{slot};
+  auto& node = nodes_[slot];
+  if (node.names != names) {
+    // Other types may name this one (or its old name) as a base: re-resolve them.
+    std::unordered_set<std::string> touched(node.names.begin(), node.names.end());
+    touched.insert(names.begin(), names.end());
+    for (const auto& name : node.names) {
+      auto& owners = by_name_[name];
+      owners.erase(std::remove(owners.begin(), owners.end(), slot), owners.end());
+    }
+    for (const auto& name : names) by_name_[name].push_back(slot);
+    node.names = std::move(names);
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+      if (i == slot) continue;
+      for (const auto& base : nodes_[i].base_names) {
+        if (touched.count(base)) {
+          dirty.push_back(i);
+          break;
+        }
+      }
+    }
+  } else if (node.base_names == base_names) {
+    return;
+  }
+  nodes_[slot].base_names = std::move(base_names);
+  recompute(std::move(dirty));
+}
+
+void SubtypeIndex::resolve_bases(std::size_t slot) {
+  auto& node = nodes_[slot];
+  node.bases.clear();
+  for (const auto& name : node.base_names) {
+    auto it = by_name_.find(name);
+    if (it == by_name_.end() || it->second.size() != 1) continue; // unknown or ambiguous
+    const auto base = it->second.front();
+    if (base == slot) continue;
+    if (std::find(node.bases.begin(), node.bases.end(), base) == node.bases.end()) {
+      node.bases.push_back(base);
+    }
+  }
+}
+
+void SubtypeIndex::recompute(std::vector<std::size_t> dirty) {
+  for (auto slot : dirty) resolve_bases(slot);
+
+  // Everything that had a dirty type as an ancestor may gain or lose ancestors.
+  std::vector<char> marked(nodes_.size(), 0);
+  for (auto slot : dirty) marked[slot] = 1;
+  for (std::size_t i = 0; i < nodes_.size(); ++i) {
+    if (marked[i]) continue;
+    for (auto slot : dirty) {
+      if (has_bit(nodes_[i], slot)) {
+        marked[i] = 1;
+        break;
+      }
+    }
+  }
+
+  // Bases before derived types (post-order), so one pass settles acyclic hierarchies.
+  std::vector<std::size_t> order;
+  std::vector<char> state(nodes_.size(), 0);
+  std::vector<std::pair<std::size_t, std::size_t>> stack;
+  for (std::size_t root = 0; root < nodes_.size(); ++root) {
+    if (!marked[root] || state[root]) continue;
+    stack.push_back({root, 0});
+    state[root] = 1;
+    while (!stack.empty()) {
+      auto& [slot, next] = stack.back();
+      if (next < nodes_[slot].bases.size()) {
+        const auto base = nodes_[slot].bases[next++];
+        if (marked[base] && !state[base]) {
+          state[base] = 1;
+          stack.push_back({base, 0});
+        }
+        continue;
+      }
+      order.push_back(slot);
+      stack.pop_back();
+    }
+  }
+
+  const std::size_t words = nodes_.size() / 64 + 1;
+  for (auto slot : order) {
+    auto& bits = nodes_[slot].ancestors;
+    bits.assign(words, 0);
+    bits[slot / 64] |= std::uint64_t{1} << (slot % 64);
+  }
+  // Cycles need more than one pass; the closure only grows, so this terminates.
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto slot : order) {
+      auto& bits = nodes_[slot].ancestors;
+      for (auto base : nodes_[slot].bases) {
+        const auto& base_bits = nodes_[base].ancestors;
+        for (std::size_t w = 0; w < base_bits.size(); ++w) {
+          const auto merged = bits[w] | base_bits[w];
+          if (merged != bits[w]) {
+            bits[w] = merged;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  for (auto slot : order) linearize(slot);
+}
+
+// C3 merge of the bases' linearizations and the base list itself. Inconsistent
+// hierarchies and cycles fall back to breadth-first order.
+void SubtypeIndex::linearize(std::size_t slot) {
+  std::vector<std::size_t> depth(nodes_.size(), kNone);
+  std::vector<std::size_t> bfs;
+  std::deque<std::size_t> queue{slot};
+  depth[slot] = 0;
+  while (!queue.empty()) {
+    const auto current = queue.front();
+    queue.pop_front();
+    bfs.push_back(current);
+    for (auto base : nodes_[current].bases) {
+      if (depth[base] != kNone) continue;
+      depth[base] = depth[current] + 1;
+      queue.push_back(base);
+    }
+  }
+
+  std::vector<std::vector<std::size_t>> seqs;
+  bool consistent = true;
+  for (auto base : nodes_[slot].bases) {
+    std::vector<std::size_t> seq;
+    for (const auto& ancestor : nodes_[base].mro) {
+      const auto s = slots_.at(ancestor.type.v);
+      if (s == slot) consistent = false;
+      seq.push_back(s);
+    }
+    seqs.push_back(std::move(seq));
+  }
+  seqs.push_back(nodes_[slot].bases);
+
+  std::vector<std::size_t> merged{slot};
+  while (consistent) {
+    seqs.erase(std::remove_if(seqs.begin(), seqs.end(), [](const auto& s) { return s.empty(); }),
+               seqs.end());
+    if (seqs.empty()) break;
+    std::size_t pick = kNone;
+    for (const auto& seq : seqs) {
+      const auto head = seq.front();
+      bool in_tail = false;
+      for (const auto& other : seqs) {
+        if (std::find(other.begin() + 1, other.end(), head) != other.end()) {
+          in_tail = true;
+          break;
+        }
+      }
+      if (!in_tail) {
+        pick = head;
+        break;
+      }
+    }
+    if (pick == kNone) {
+      consistent = false;
+      break;
+    }
+    merged.push_back(pick);
+    for (auto& seq : seqs) {
+      if (seq.front() == pick) seq.erase(seq.begin());
+    }
+  }
+  // A base whose own linearization is stale (mid-cycle) can disagree with the walk.
+  if (consistent && merged.size() != bfs.size()) consistent = false;
+
+  auto& mro = nodes_[slot].mro;
+  mro.clear();
+  for (auto s : consistent ? merged : bfs) mro.push_back(TypeAncestor{nodes_[s].type, depth[s]});
+}
+
+bool SubtypeIndex::is_subtype(referee::TypeID type, referee::TypeID base) const {
+  if (type == base) return true;
+  auto t = slots_.find(type.v);
+  auto b = slots_.find(base.v);
+  if (t == slots_.end() || b == slots_.end()) return false;
+  return has_bit(nodes_[t->second], b->second);
+}
+
+std::vector<TypeAncestor> SubtypeIndex::linearization(referee::TypeID type) const {
+  auto it = slots_.find(type.v);
+  if (it == slots_.end()) return {TypeAncestor{type, 0}};
+  return nodes_[it->second].mro;
+}
+
+std::vector<referee::TypeID> SubtypeIndex::direct_bases(referee::TypeID type) const {
+  std::vector<referee::TypeID> out;
+  auto it = slots_.find(type.v);
+  if (it == slots_.end()) return out;
+  for (auto base : nodes_[it->second].bases) out.push_back(nodes_[base].type);
+  return out;
+}
+
+} // namespace iris::refract
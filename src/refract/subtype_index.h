@@ -0,0 +1,61 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace iris::refract {
+
+struct TypeDefinition;
+
+struct TypeAncestor {
+  referee::TypeID type{};
+  std::size_t depth{0}; // shortest inheritance distance; 0 for the type itself
+};
+
+// Transitive closure of the "base"/"extends" relationships of the latest definition
+// of each type. Targets are resolved by name or "Namespace::Name" and may be defined
+// after the types that reference them. Each type keeps an ancestor bitset for O(1)
+// is-a tests and a C3 linearization (BFS order if the hierarchy is not C3-consistent).
+// Updates only recompute the changed type, its descendants and types whose base
+// names it now satisfies.
+class SubtypeIndex {
+public:
+  // Record the latest definition of `def.type_id`, replacing any earlier one.
+  void update(const TypeDefinition& def);
+  void clear();
+
+  // Reflexive: a type is a subtype of itself.
+  bool is_subtype(referee::TypeID type, referee::TypeID base) const;
+
+  // The type followed by its ancestors in method resolution order; {type} for types
+  // the index has not seen.
+  std::vector<TypeAncestor> linearization(referee::TypeID type) const;
+
+  std::vector<referee::TypeID> direct_bases(referee::TypeID type) const;
+
+private:
+  struct Node {
+    referee::TypeID type{};
+    std::vector<std::string> names;      // "Name" and "Namespace::Name"
+    std::vector<std::string> base_names; // relationship targets, in declaration order
+    std::vector<std::size_t> bases;      // resolved slots
+    std::vector<std::uint64_t> ancestors; // bitset over slots, includes self
+    std::vector<TypeAncestor> mro;
+  };
+
+  std::size_t slot_for(referee::TypeID type);
+  bool has_bit(const Node& node, std::size_t slot) const;
+  void resolve_bases(std::size_t slot);
+  void recompute(std::vector<std::size_t> dirty);
+  void linearize(std::size_t slot);
+
+  std::vector<Node> nodes_;
+  std::unordered_map<std::uint64_t, std::size_t> slots_;
+  std::unordered_map<std::string, std::vector<std::size_t>> by_name_;
+};
+
+} // namespace iris::refract
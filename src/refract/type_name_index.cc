@@ -0,0 +1,137 @@
+#include "refract/type_name_index.h"
+
+#include <algorithm>
+
+namespace iris::refract {
+
+std::string qualified_type_name(const TypeSummary& summary) {
+  if (summary.namespace_name.empty()) return summary.name;
+  return summary.namespace_name + "::" + summary.name;
+}
+
+bool glob_match(std::string_view text, std::string_view pattern) {
+  // Greedy with backtracking to the most recent '*'.
+  std::size_t t = 0;
+  std::size_t p = 0;
+  std::size_t star = std::string_view::npos;
+  std::size_t resume = 0;
+  while (t < text.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+      ++t;
+      ++p;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      resume = t;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      t = ++resume;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') ++p;
+  return p == pattern.size();
+}
+
+void TypeNameIndex::clear() {
+  types_.clear();
+  slots_.clear();
+  qualified_.clear();
+  by_name_.clear();
+  namespaces_.clear();
+}
+
+void TypeNameIndex::update(const TypeSummary& summary) {
+  auto [it, inserted] = slots_.emplace(summary.type_id.v, types_.size());
+  const auto slot = it->second;
+  if (inserted) {
+    types_.push_back(summary);
+  } else {
+    auto& old = types_[slot];
+    if (old.name == summary.name && old.namespace_name == summary.namespace_name) {
+      old = summary;
+      return;
+    }
+    qualified_.erase({qualified_type_name(old), slot});
+    auto& named = by_name_[old.name];
+    named.erase(std::remove(named.begin(), named.end(), slot), named.end());
+    if (named.empty()) by_name_.erase(old.name);
+    if (auto ns = namespaces_.find(old.namespace_name); ns != namespaces_.end() && --ns->second == 0) {
+      namespaces_.erase(ns);
+    }
+    old = summary;
+  }
+
+  qualified_.emplace(qualified_type_name(summary), slot);
+  auto& named = by_name_[summary.name];
+  named.insert(std::upper_bound(named.begin(), named.end(), slot), slot);
+  ++namespaces_[summary.namespace_name];
+}
+
+const TypeSummary* TypeNameIndex::by_type(referee::TypeID type) const {
+  auto it = slots_.find(type.v);
+  return it == slots_.end() ? nullptr : &types_[it->second];
+}
+
+const TypeSummary* TypeNameIndex::find(std::string_view namespace_name, std::string_view name) const {
+  std::string key;
+  if (!namespace_name.empty()) {
+    key.append(namespace_name);
+    key.append("::");
+  }
+  key.append(name);
+  // A bare name can equal another type's qualified one ("A::B" with no namespace).
+  for (auto it = qualified_.lower_bound({key, 0}); it != qualified_.end() && it->first == key; ++it) {
+    const auto& t = types_[it->second];
+    if (t.namespace_name == namespace_name && t.name == name) return &t;
+  }
+  return nullptr;
+}
+
+std::vector<const TypeSummary*> TypeNameIndex::lookup(std::string_view name) const {
+  std::vector<std::size_t> slots;
+  const std::string key(name);
+  if (auto it = by_name_.find(key); it != by_name_.end()) slots = it->second;
+  for (auto it = qualified_.lower_bound({key, 0}); it != qualified_.end() && it->first == key; ++it) {
+    slots.push_back(it->second);
+  }
+  return collect(std::move(slots));
+}
+
+std::vector<const TypeSummary*> TypeNameIndex::with_prefix(std::string_view prefix) const {
+  std::vector<std::size_t> slots;
+  for (auto it = qualified_.lower_bound({std::string(prefix), 0});
+       it != qualified_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+    slots.push_back(it->second);
+  }
+  return collect(std::move(slots));
+}
+
+std::vector<const TypeSummary*> TypeNameIndex::matching(std::string_view pattern) const {
+  const auto literal = pattern.substr(0, pattern.find_first_of("*?"));
+  std::vector<std::size_t> slots;
+  for (auto it = qualified_.lower_bound({std::string(literal), 0});
+       it != qualified_.end() && it->first.compare(0, literal.size(), literal) == 0; ++it) {
+    if (glob_match(it->first, pattern)) slots.push_back(it->second);
+  }
+  return collect(std::move(slots));
+}
+
+std::vector<std::string> TypeNameIndex::namespaces() const {
+  std::vector<std::string> out;
+  for (const auto& [ns, count] : namespaces_) {
+    if (!ns.empty()) out.push_back(ns);
+  }
+  return out;
+}
+
+std::vector<const TypeSummary*> TypeNameIndex::collect(std::vector<std::size_t> slots) const {
+  std::sort(slots.begin(), slots.end());
+  slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+  std::vector<const TypeSummary*> out;
+  out.reserve(slots.size());
+  for (auto slot : slots) out.push_back(&types_[slot]);
+  return out;
+}
+
+} // namespace iris::refract
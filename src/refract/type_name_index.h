@@ -0,0 +1,65 @@
+#pragma once
+
+#include "referee/referee.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace iris::refract {
+
+struct TypeSummary {
+  referee::TypeID type_id{};
+  referee::ObjectID definition_id{};
+  std::string name;
+  std::string namespace_name;
+  std::optional<std::string> preferred_renderer;
+};
+
+// "Namespace::Name", or just the name for types outside a namespace.
+std::string qualified_type_name(const TypeSummary& summary);
+
+// Summary of the latest definition of each type, by qualified name (kept sorted, so
+// prefix and glob lookups only walk the range sharing their literal prefix) and by
+// bare name. Results come back in the order types were first seen; pointers stay
+// valid until the next update().
+class TypeNameIndex {
+public:
+  // Record the latest definition of `summary.type_id`, replacing any earlier one.
+  void update(const TypeSummary& summary);
+  void clear();
+
+  std::size_t size() const { return types_.size(); }
+  const std::vector<TypeSummary>& types() const { return types_; }
+
+  const TypeSummary* by_type(referee::TypeID type) const;
+  // The first type seen under that name if several share it.
+  const TypeSummary* find(std::string_view namespace_name, std::string_view name) const;
+  // Types whose bare or qualified name is `name`; more than one means it is ambiguous.
+  std::vector<const TypeSummary*> lookup(std::string_view name) const;
+  // Qualified names starting with `prefix`.
+  std::vector<const TypeSummary*> with_prefix(std::string_view prefix) const;
+  // Qualified names matching `pattern`, where '*' matches any run and '?' one character.
+  std::vector<const TypeSummary*> matching(std::string_view pattern) const;
+  // Sorted, without the empty namespace.
+  std::vector<std::string> namespaces() const;
+
+private:
+  std::vector<const TypeSummary*> collect(std::vector<std::size_t> slots) const;
+
+  std::vector<TypeSummary> types_;
+  std::unordered_map<std::uint64_t, std::size_t> slots_;
+  std::set<std::pair<std::string, std::size_t>> qualified_; // (qualified name, slot)
+  std::unordered_map<std::string, std::vector<std::size_t>> by_name_;
+  std::map<std::string, std::size_t, std::less<>> namespaces_; // types per namespace
+};
+
+bool glob_match(std::string_view text, std::string_view pattern);
+
+} // namespace iris::refract
@@ -0,0 +1,236 @@
+#include "refract/unit_converter.h"
+
+#include "referee/cbor_path.h"
+
+#include <cstring>
+#include <map>
+#include <optional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace iris::refract {
+
+namespace {
+
+struct DimensionRecord {
+  std::string name;
+  std::uint32_t signature{0};
+};
+
+struct UnitRecord {
+  CaliperUnit unit;
+  std::string dimension_id;
+  std::optional<std::string> base_unit_id;
+};
+
+// Latest version of each object of `type`, in creation order.
+referee::Result<std::vector<referee::ObjectRecord>> latest_objects(referee::SqliteStore& store,
+                                                                   referee::TypeID type) {
+  using R = referee::Result<std::vector<referee::ObjectRecord>>;
+  auto listR = store.list_by_type(type);
+  if (!listR) return R::err(listR.error->message);
+  std::vector<referee::ObjectRecord> out;
+  std::unordered_map<std::string, std::size_t> slots;
+  for (auto& rec : listR.value.value()) {
+    auto [it, inserted] = slots.emplace(rec.ref.id.to_hex(), out.size());
+    if (inserted) {
+      out.push_back(std::move(rec));
+    } else if (rec.ref.ver.v > out[it->second].ref.ver.v) {
+      out[it->second] = std::move(rec);
+    }
+  }
+  return R::ok(std::move(out));
+}
+
+// "Length^1*Time^-1": the non-zero exponents, by component name.
+referee::Result<std::string> components_key(const referee::Bytes& payload) {
+  using R = referee::Result<std::string>;
+  auto item = referee::cbor_find(payload, {"components"});
+  if (!item) return R::ok(std::string());
+  auto map = referee::CborContainer::open(*item);
+  if (!map || !map->is_map()) return R::err("components is not a map");
+
+  std::map<std::string, std::int64_t> exponents;
+  referee::CborSlice key;
+  referee::CborSlice value;
+  while (map->next(&key)) {
+    if (!map->next(&value)) return R::err("components is malformed");
+    auto name = referee::cbor_text(key);
+    auto power = referee::cbor_int(value);
+    if (!name || !power) return R::err("components must map names to integers");
+    exponents[std::string(*name)] += *power;
+  }
+  if (map->malformed()) return R::err("components is malformed");
+
+  std::string out;
+  for (const auto& [name, power] : exponents) {
+    if (power == 0) continue;
+    if (!out.empty()) out.push_back('*');
+    out += name + "^" + std::to_string(power);
+  }
+  return R::ok(std::move(out));
+}
+
+double number_or(const referee::Bytes& payload, std::string_view field, double fallback) {
+  auto item = referee::cbor_find(payload, {field});
+  if (!item) return fallback;
+  return referee::cbor_double(*item).value_or(fallback);
+}
+
+template <bool kScale, bool kOffset>
+void affine(double scale, double offset, const double* in, double* out, std::size_t count) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128d s = _mm_set1_pd(scale);
+  const __m128d o = _mm_set1_pd(offset);
+  auto lane = [&](__m128d x) {
+    if constexpr (kScale) x = _mm_mul_pd(x, s);
+    if constexpr (kOffset) x = _mm_add_pd(x, o);
+    return x;
+  };
+  for (; i + 8 <= count; i += 8) {
+    const __m128d x0 = _mm_loadu_pd(in + i);
+    const __m128d x1 = _mm_loadu_pd(in + i + 2);
+    const __m128d x2 = _mm_loadu_pd(in + i + 4);
+    const __m128d x3 = _mm_loadu_pd(in + i + 6);
+    _mm_storeu_pd(out + i, lane(x0));
+    _mm_storeu_pd(out + i + 2, lane(x1));
+    _mm_storeu_pd(out + i + 4, lane(x2));
+    _mm_storeu_pd(out + i + 6, lane(x3));
+  }
+#endif
+  for (; i < count; ++i) {
+    double x = in[i];
+    if constexpr (kScale) x *= scale;
+    if constexpr (kOffset) x += offset;
+    out[i] = x;
+  }
+}
+
+} // namespace
+
+referee::Result<UnitConverter> UnitConverter::load(SchemaRegistry& registry, referee::SqliteStore& store) {
+  using R = referee::Result<UnitConverter>;
+  auto dimTypeR = registry.find_type("Caliper", "Dimension");
+  if (!dimTypeR) return R::err(dimTypeR.error->message);
+  auto unitTypeR = registry.find_type("Caliper", "Unit");
+  if (!unitTypeR) return R::err(unitTypeR.error->message);
+  if (!dimTypeR.value->has_value() || !unitTypeR.value->has_value()) {
+    return R::err("Caliper types not registered");
+  }
+
+  auto dimsR = latest_objects(store, dimTypeR.value->value().type_id);
+  if (!dimsR) return R::err(dimsR.error->message);
+  std::unordered_map<std::string, std::uint32_t> signatures;
+  std::unordered_map<std::string, DimensionRecord> dimensions;
+  for (const auto& rec : dimsR.value.value()) {
+    auto name = referee::cbor_find_text(rec.payload_cbor, {"name"});
+    auto keyR = components_key(rec.payload_cbor);
+    if (!keyR) return R::err("dimension " + rec.ref.id.to_hex() + ": " + keyR.error->message);
+    auto sig = signatures.emplace(keyR.value.value(), static_cast<std::uint32_t>(signatures.size())).first;
+    dimensions[rec.ref.id.to_hex()] = DimensionRecord{ std::string(name.value_or("")), sig->second };
+  }
+
+  auto unitsR = latest_objects(store, unitTypeR.value->value().type_id);
+  if (!unitsR) return R::err(unitsR.error->message);
+  std::vector<UnitRecord> records;
+  std::unordered_map<std::string, std::size_t> by_id;
+  for (const auto& rec : unitsR.value.value()) {
+    UnitRecord unit;
+    unit.unit.name = std::string(referee::cbor_find_text(rec.payload_cbor, {"name"}).value_or(""));
+    unit.unit.symbol = std::string(referee::cbor_find_text(rec.payload_cbor, {"symbol"}).value_or(""));
+    if (unit.unit.symbol.empty()) return R::err("unit " + rec.ref.id.to_hex() + " has no symbol");
+    unit.unit.scale = number_or(rec.payload_cbor, "scale", 1.0);
+    unit.unit.offset = number_or(rec.payload_cbor, "offset", 0.0);
+    if (unit.unit.scale == 0.0) return R::err("unit '" + unit.unit.symbol + "' has zero scale");
+    unit.dimension_id = std::string(referee::cbor_find_text(rec.payload_cbor, {"dimension_id"}).value_or(""));
+    auto dim = dimensions.find(unit.dimension_id);
+    if (dim == dimensions.end()) return R::err("unit '" + unit.unit.symbol + "': dimension not found");
+    unit.unit.dimension = dim->second.name;
+    unit.unit.signature = dim->second.signature;
+    if (auto base = referee::cbor_find_text(rec.payload_cbor, {"base_unit_id"}); base && !base->empty()) {
+      unit.base_unit_id = std::string(*base);
+    }
+    by_id[rec.ref.id.to_hex()] = records.size();
+    records.push_back(std::move(unit));
+  }
+
+  // Fold each base chain into one scale and offset onto the coherent unit.
+  UnitConverter out;
+  out.units_.reserve(records.size());
+  for (const auto& rec : records) {
+    auto unit = rec.unit;
+    const auto* link = &rec;
+    for (std::size_t hops = 0; link->base_unit_id; ++hops) {
+      auto it = by_id.find(*link->base_unit_id);
+      if (it == by_id.end()) return R::err("unit '" + unit.symbol + "': base unit not found");
+      if (hops == records.size()) return R::err("unit '" + unit.symbol + "': base units form a cycle");
+      link = &records[it->second];
+      if (link->unit.signature != unit.signature) {
+        return R::err("unit '" + unit.symbol + "': base unit '" + link->unit.symbol + "' has another dimension");
+      }
+      unit.scale *= link->unit.scale;
+      unit.offset = unit.offset * link->unit.scale + link->unit.offset;
+    }
+    out.by_symbol_[unit.symbol] = static_cast<UnitIndex>(out.units_.size());
+    out.units_.push_back(std::move(unit));
+  }
+  return R::ok(std::move(out));
+}
+
+UnitIndex UnitConverter::find(std::string_view symbol) const {
+  auto it = by_symbol_.find(std::string(symbol));
+  return it == by_symbol_.end() ? kNoUnit : it->second;
+}
+
+bool UnitConverter::compatible(UnitIndex from, UnitIndex to) const {
+  return from < units_.size() && to < units_.size() && units_[from].signature == units_[to].signature;
+}
+
+referee::Result<UnitConversion> UnitConverter::conversion(UnitIndex from, UnitIndex to) const {
+  using R = referee::Result<UnitConversion>;
+  if (from >= units_.size() || to >= units_.size()) return R::err("unknown unit");
+  const auto& a = units_[from];
+  const auto& b = units_[to];
+  if (a.signature != b.signature) {
+    return R::err("incompatible units: '" + a.symbol + "' (" + a.dimension + ") and '" + b.symbol + "' ("
+                  + b.dimension + ")");
+  }
+  if (from == to) return R::ok(UnitConversion{});
+  return R::ok(UnitConversion{ a.scale / b.scale, (a.offset - b.offset) / b.scale });
+}
+
+referee::Result<UnitConversion> UnitConverter::conversion(std::string_view from, std::string_view to) const {
+  using R = referee::Result<UnitConversion>;
+  const auto a = find(from);
+  if (a == kNoUnit) return R::err("unknown unit '" + std::string(from) + "'");
+  const auto b = find(to);
+  if (b == kNoUnit) return R::err("unknown unit '" + std::string(to) + "'");
+  return conversion(a, b);
+}
+
+void UnitConverter::apply(const UnitConversion& conversion, const double* in, double* out, std::size_t count) {
+  const bool scale = conversion.scale != 1.0;
+  const bool offset = conversion.offset != 0.0;
+  if (scale && offset) {
+    affine<true, true>(conversion.scale, conversion.offset, in, out, count);
+  } else if (scale) {
+    affine<true, false>(conversion.scale, conversion.offset, in, out, count);
+  } else if (offset) {
+    affine<false, true>(conversion.scale, conversion.offset, in, out, count);
+  } else if (in != out && count != 0) {
+    std::memmove(out, in, count * sizeof(double));
+  }
+}
+
+referee::Result<void> UnitConverter::convert(std::string_view from, std::string_view to,
+                                             const double* in, double* out, std::size_t count) const {
+  auto conversionR = conversion(from, to);
+  if (!conversionR) return referee::Result<void>::err(conversionR.error->message);
+  apply(conversionR.value.value(), in, out, count);
+  return referee::Result<void>::ok();
+}
+
+} // namespace iris::refract
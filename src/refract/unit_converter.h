@@ -0,0 +1,68 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Conversion between Caliper::Unit objects.
+//
+// A unit's value in its base unit is `value * scale + offset`; base units chain until
+// a unit without one, which is taken as the coherent unit of its dimension. Two units
+// are compatible when their dimensions have the same `components` exponents, so a
+// catalog may define a dimension twice under different names.
+namespace iris::refract {
+
+using UnitIndex = std::uint32_t;
+
+struct CaliperUnit {
+  std::string name;
+  std::string symbol;
+  std::string dimension;  // Caliper::Dimension name
+  std::uint32_t signature{0}; // equal for units with equal dimension exponents
+  double scale{1.0};      // to the coherent unit, through every base unit
+  double offset{0.0};
+};
+
+// to = from * scale + offset
+struct UnitConversion {
+  double scale{1.0};
+  double offset{0.0};
+
+  bool identity() const { return scale == 1.0 && offset == 0.0; }
+  double apply(double value) const { return value * scale + offset; }
+};
+
+// The unit catalog decoded once into a dense table; lookups and conversions do not
+// touch the store. Load again to see units added later.
+class UnitConverter {
+public:
+  static constexpr UnitIndex kNoUnit = static_cast<UnitIndex>(-1);
+
+  static referee::Result<UnitConverter> load(SchemaRegistry& registry, referee::SqliteStore& store);
+
+  std::size_t size() const { return units_.size(); }
+  const CaliperUnit& unit(UnitIndex index) const { return units_[index]; }
+  UnitIndex find(std::string_view symbol) const;
+
+  bool compatible(UnitIndex from, UnitIndex to) const;
+  referee::Result<UnitConversion> conversion(UnitIndex from, UnitIndex to) const;
+  referee::Result<UnitConversion> conversion(std::string_view from, std::string_view to) const;
+
+  // Converts `count` values; `in` and `out` may be the same array. Uses SIMD lanes
+  // where available and skips the multiply or add when they are no-ops.
+  static void apply(const UnitConversion& conversion, const double* in, double* out, std::size_t count);
+  referee::Result<void> convert(std::string_view from, std::string_view to,
+                                const double* in, double* out, std::size_t count) const;
+
+private:
+  std::vector<CaliperUnit> units_;
+  std::unordered_map<std::string, UnitIndex> by_symbol_;
+};
+
+} // namespace iris::refract
@@ -0,0 +1,104 @@
+#include "viz/store_stats.h"
+
+#include "viz/artifacts.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace iris::viz {
+
+namespace {
+
+std::string hex_type(referee::TypeID type) {
+  std::ostringstream os;
+  os << "0x" << std::hex << type.v;
+  return os.str();
+}
+
+std::string fixed(double v, int precision) {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(precision) << v;
+  return os.str();
+}
+
+Table type_table(const referee::StoreStats& stats) {
+  Table table;
+  table.columns = {"type_id", "objects", "payload_bytes"};
+  for (const auto& usage : stats.objects_by_type) {
+    table.rows.push_back({hex_type(usage.type), std::to_string(usage.objects),
+                          std::to_string(usage.payload_bytes)});
+  }
+  for (const auto& usage : stats.edges_by_name) {
+    table.rows.push_back({"edge:" + usage.name, std::to_string(usage.edges),
+                          std::to_string(usage.props_bytes)});
+  }
+  return table;
+}
+
+Table segment_table(const referee::StoreStats& stats) {
+  Table table;
+  table.columns = {"segment", "records", "bytes"};
+  for (const auto& seg : stats.segments) {
+    table.rows.push_back({seg.name, std::to_string(seg.records), std::to_string(seg.bytes)});
+  }
+  return table;
+}
+
+Table index_table(const referee::StoreStats& stats) {
+  Table table;
+  table.columns = {"index", "entries", "bytes", "bytes_per_record"};
+  for (const auto& index : stats.indexes) {
+    table.rows.push_back({index.name, std::to_string(index.entries), std::to_string(index.bytes),
+                          fixed(index.bytes_per_record(), 1)});
+  }
+  return table;
+}
+
+Table latency_table(const referee::StoreStats& stats) {
+  Table table;
+  table.columns = {"op", "count", "mean_ns", "p50_ns", "p99_ns", "max_ns"};
+  auto row = [](const std::string& name, const referee::LatencyHistogram& h) {
+    return std::vector<std::string>{name, std::to_string(h.count), fixed(h.mean_ns(), 0),
+                                    std::to_string(h.percentile_ns(0.50)),
+                                    std::to_string(h.percentile_ns(0.99)),
+                                    std::to_string(h.max_ns)};
+  };
+  table.rows.push_back(row("object_append", stats.object_appends));
+  table.rows.push_back(row("edge_append", stats.edge_appends));
+  return table;
+}
+
+} // namespace
+
+referee::Result<StoreStatsArtifacts> create_store_stats_artifacts(
+    iris::refract::SchemaRegistry& registry,
+    referee::SqliteStore& store,
+    const referee::StoreStats& stats) {
+  StoreStatsArtifacts out;
+
+  for (const auto& table : {type_table(stats), segment_table(stats), index_table(stats),
+                            latency_table(stats)}) {
+    auto idR = create_table(registry, store, table);
+    if (!idR) return referee::Result<StoreStatsArtifacts>::err(idR.error->message);
+    out.tables.push_back(idR.value.value());
+  }
+
+  const std::vector<Metric> metrics = {
+    {"store.objects", static_cast<double>(stats.object_count)},
+    {"store.edges", static_cast<double>(stats.edge_count)},
+    {"store.index_bytes", static_cast<double>(stats.index_bytes())},
+    {"store.open_ms", static_cast<double>(stats.timings.open_us) / 1000.0},
+    {"store.object_lookup_hit_rate", stats.object_lookups.hit_rate()},
+    {"store.latest_lookup_hit_rate", stats.latest_lookups.hit_rate()},
+  };
+  for (const auto& metric : metrics) {
+    auto idR = create_metric(registry, store, metric);
+    if (!idR) return referee::Result<StoreStatsArtifacts>::err(idR.error->message);
+    out.metrics.push_back(idR.value.value());
+  }
+
+  return referee::Result<StoreStatsArtifacts>::ok(std::move(out));
+}
+
+} // namespace iris::viz
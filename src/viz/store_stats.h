@@ -0,0 +1,23 @@
+#pragma once
+
+#include "refract/schema_registry.h"
+#include "referee/referee.h"
+#include "referee_sqlite/sqlite_store.h"
+
+#include <vector>
+
+namespace iris::viz {
+
+struct StoreStatsArtifacts {
+  std::vector<referee::ObjectID> tables;
+  std::vector<referee::ObjectID> metrics;
+};
+
+// Renders a StoreStats snapshot as Viz::Table (per-type, segments, indexes, latency)
+// and Viz::Metric (headline figures) artifacts.
+referee::Result<StoreStatsArtifacts> create_store_stats_artifacts(
+    iris::refract::SchemaRegistry& registry,
+    referee::SqliteStore& store,
+    const referee::StoreStats& stats);
+
+} // namespace iris::viz
@@ -4,16 +4,11 @@
 
 namespace iris::vizier {
 
-static std::string display_name(const iris::refract::TypeSummary& summary) {
-  if (summary.namespace_name.empty()) return summary.name;
-  return summary.namespace_name + "::" + summary.name;
-}
-
 std::optional<Route> route_for_type(const iris::refract::TypeSummary& summary) {
   if (summary.preferred_renderer.has_value() && !summary.preferred_renderer->empty()) {
     return Route{summary.preferred_renderer.value()};
   }
-  auto full = display_name(summary);
+  auto full = iris::refract::qualified_type_name(summary);
   if (full == "Viz::TextLog") return Route{"Log"};
   if (full == "Viz::Metric") return Route{"Metric"};
   if (full == "Viz::Table") return Route{"Table"};
@@ -23,13 +18,11 @@ std::optional<Route> route_for_type(const iris::refract::TypeSummary& summary) {
 
 std::optional<Route> route_for_type_id(iris::refract::SchemaRegistry& registry,
                                        referee::TypeID type_id) {
-  auto listR = registry.list_types();
-  if (!listR) return std::nullopt;
-
-  for (const auto& summary : listR.value.value()) {
-    if (summary.type_id == type_id) return route_for_type(summary);
-  }
-  return std::nullopt;
+  auto namesR = registry.type_names();
+  if (!namesR) return std::nullopt;
+  const auto* summary = namesR.value.value()->by_type(type_id);
+  if (!summary) return std::nullopt;
+  return route_for_type(*summary);
 }
 
 referee::Result<std::optional<referee::ObjectID>> spawn_concho_for_artifact(
@@ -48,17 +41,11 @@ referee::Result<std::optional<referee::ObjectID>> spawn_concho_for_artifact(
         std::optional<referee::ObjectID>{});
   }
 
-  auto typesR = registry.list_types();
-  if (!typesR) {
-    return referee::Result<std::optional<referee::ObjectID>>::err(typesR.error->message);
-  }
-  std::optional<iris::refract::TypeSummary> concho_type;
-  for (const auto& summary : typesR.value.value()) {
-    if (summary.namespace_name == "Conch" && summary.name == "Concho") {
-      concho_type = summary;
-      break;
-    }
+  auto conchoR = registry.find_type("Conch", "Concho");
+  if (!conchoR) {
+    return referee::Result<std::optional<referee::ObjectID>>::err(conchoR.error->message);
   }
+  const auto& concho_type = conchoR.value.value();
   if (!concho_type.has_value()) {
     return referee::Result<std::optional<referee::ObjectID>>::err("Conch::Concho type not registered");
   }
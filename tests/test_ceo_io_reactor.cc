@@ -120,15 +120,15 @@ START_TEST(test_conduit_channel_flow)
   ck_assert_msg(task_b, "spawn task_b failed");
 
   DispatchEngine engine(schema);
-  auto open_match = engine.resolve(kTypeKernelIo, "open_channel", OperationScope::Class,
-                                   {kTypeU64, kTypeU64}, 2, true);
-  ck_assert_msg(open_match, "open_channel resolve failed: %s", result_message(open_match));
+  auto open_match = engine.bind(kTypeKernelIo, "open_channel", OperationScope::Class,
+                                {kTypeU64, kTypeU64}, 2);
+  ck_assert_msg(open_match, "open_channel bind failed: %s", result_message(open_match));
   auto openR = executor.open_channel(open_match.value.value(), task_a.value->id, task_b.value->id);
   ck_assert_msg(openR, "open_channel failed: %s", result_message(openR));
 
-  auto await_match = engine.resolve(kTypeKernelIoChannel, "await_readable", OperationScope::Object,
-                                    {kTypeU64}, 1, true);
-  ck_assert_msg(await_match, "await_readable resolve failed: %s", result_message(await_match));
+  auto await_match = engine.bind(kTypeKernelIoChannel, "await_readable", OperationScope::Object,
+                                 {kTypeU64}, 1);
+  ck_assert_msg(await_match, "await_readable bind failed: %s", result_message(await_match));
   auto waitR = executor.await_channel(await_match.value.value(), openR.value->second, task_b.value->id);
   ck_assert_msg(waitR, "await_readable failed: %s", result_message(waitR));
   ck_assert_msg(!waitR.value->ready, "expected initial wait to block");
@@ -138,9 +138,9 @@ START_TEST(test_conduit_channel_flow)
   ck_assert_msg(task_waiting.value->has_value(), "expected task record");
   ck_assert_int_eq((int)task_waiting.value->value().state, (int)TaskState::Waiting);
 
-  auto send_match = engine.resolve(kTypeKernelIoChannel, "send", OperationScope::Object,
-                                   {kTypeBytes}, 1, true);
-  ck_assert_msg(send_match, "send resolve failed: %s", result_message(send_match));
+  auto send_match = engine.bind(kTypeKernelIoChannel, "send", OperationScope::Object,
+                                {kTypeBytes}, 1);
+  ck_assert_msg(send_match, "send bind failed: %s", result_message(send_match));
   Bytes payload = {0x01, 0x02, 0x03};
   auto sendR = executor.send_channel(send_match.value.value(), openR.value->first, payload);
   ck_assert_msg(sendR, "send failed: %s", result_message(sendR));
@@ -148,15 +148,15 @@ START_TEST(test_conduit_channel_flow)
   ck_assert_uint_eq((unsigned int)sendR.value->outcome.resumed.size(), 1U);
   ck_assert_uint_eq((unsigned int)sendR.value->outcome.resumed[0], (unsigned int)task_b.value->id);
 
-  auto recv_match = engine.resolve(kTypeKernelIoChannel, "recv", OperationScope::Object,
-                                   {kTypeU64}, 1, true);
-  ck_assert_msg(recv_match, "recv resolve failed: %s", result_message(recv_match));
+  auto recv_match = engine.bind(kTypeKernelIoChannel, "recv", OperationScope::Object,
+                                {kTypeU64}, 1);
+  ck_assert_msg(recv_match, "recv bind failed: %s", result_message(recv_match));
   auto recvR = executor.recv_channel(recv_match.value.value(), openR.value->second, 8);
   ck_assert_msg(recvR, "recv failed: %s", result_message(recvR));
   ck_assert_uint_eq((unsigned int)recvR.value->size(), 3U);
 
-  auto close_match = engine.resolve(kTypeKernelIoChannel, "close", OperationScope::Object, {}, 0, true);
-  ck_assert_msg(close_match, "close resolve failed: %s", result_message(close_match));
+  auto close_match = engine.bind(kTypeKernelIoChannel, "close", OperationScope::Object, {}, 0);
+  ck_assert_msg(close_match, "close bind failed: %s", result_message(close_match));
   ck_assert_msg(executor.close_channel(close_match.value.value(), openR.value->second),
                 "close failed");
 
@@ -190,29 +190,29 @@ START_TEST(test_conduit_datagram_flow)
   ck_assert_msg(task_b, "spawn task_b failed");
 
   DispatchEngine engine(schema);
-  auto open_match = engine.resolve(kTypeKernelIo, "open_datagram", OperationScope::Class,
-                                   {kTypeU64, kTypeU64}, 2, true);
-  ck_assert_msg(open_match, "open_datagram resolve failed: %s", result_message(open_match));
+  auto open_match = engine.bind(kTypeKernelIo, "open_datagram", OperationScope::Class,
+                                {kTypeU64, kTypeU64}, 2);
+  ck_assert_msg(open_match, "open_datagram bind failed: %s", result_message(open_match));
   auto openR = executor.open_datagram(open_match.value.value(), task_a.value->id, task_b.value->id);
   ck_assert_msg(openR, "open_datagram failed: %s", result_message(openR));
 
-  auto await_match = engine.resolve(kTypeKernelIoDatagram, "await_readable", OperationScope::Object,
-                                    {kTypeU64}, 1, true);
-  ck_assert_msg(await_match, "await_readable resolve failed: %s", result_message(await_match));
+  auto await_match = engine.bind(kTypeKernelIoDatagram, "await_readable", OperationScope::Object,
+                                 {kTypeU64}, 1);
+  ck_assert_msg(await_match, "await_readable bind failed: %s", result_message(await_match));
   auto waitR = executor.await_datagram(await_match.value.value(), openR.value->second, task_b.value->id);
   ck_assert_msg(waitR, "await_readable failed: %s", result_message(waitR));
   ck_assert_msg(!waitR.value->ready, "expected initial wait to block");
 
-  auto send_match = engine.resolve(kTypeKernelIoDatagram, "send", OperationScope::Object,
-                                   {kTypeBytes}, 1, true);
-  ck_assert_msg(send_match, "send resolve failed: %s", result_message(send_match));
+  auto send_match = engine.bind(kTypeKernelIoDatagram, "send", OperationScope::Object,
+                                {kTypeBytes}, 1);
+  ck_assert_msg(send_match, "send bind failed: %s", result_message(send_match));
   Bytes payload = {0x10, 0x20};
   auto sendR = executor.send_datagram(send_match.value.value(), openR.value->first, payload);
   ck_assert_msg(sendR, "send failed: %s", result_message(sendR));
   ck_assert_msg(sendR.value->ready, "expected send ready");
 
-  auto recv_match = engine.resolve(kTypeKernelIoDatagram, "recv", OperationScope::Object, {}, 0, true);
-  ck_assert_msg(recv_match, "recv resolve failed: %s", result_message(recv_match));
+  auto recv_match = engine.bind(kTypeKernelIoDatagram, "recv", OperationScope::Object, {}, 0);
+  ck_assert_msg(recv_match, "recv bind failed: %s", result_message(recv_match));
   auto recvR = executor.recv_datagram(recv_match.value.value(), openR.value->second);
   ck_assert_msg(recvR, "recv failed: %s", result_message(recvR));
   ck_assert_msg(recvR.value->has_value(), "expected datagram payload");
@@ -239,15 +239,20 @@ START_TEST(test_conduit_invalid_handle)
   iris::conduit::IoExecutor executor(registry, comms, reactor, handles);
 
   DispatchEngine engine(schema);
-  auto send_match = engine.resolve(kTypeKernelIoChannel, "send", OperationScope::Object,
-                                   {kTypeBytes}, 1, true);
-  ck_assert_msg(send_match, "send resolve failed: %s", result_message(send_match));
+  auto send_match = engine.bind(kTypeKernelIoChannel, "send", OperationScope::Object,
+                                {kTypeBytes}, 1);
+  ck_assert_msg(send_match, "send bind failed: %s", result_message(send_match));
 
   iris::conduit::IoHandle bad_handle{iris::conduit::IoHandleKind::Channel, 999};
   Bytes payload = {0x01};
   auto sendR = executor.send_channel(send_match.value.value(), bad_handle, payload);
   ck_assert_msg(!sendR, "expected invalid handle to fail");
 
+  // A binding is checked against the operation the executor is asked to run.
+  auto closeR = executor.close_channel(send_match.value.value(), bad_handle);
+  ck_assert_msg(!closeR && closeR.error->message == "unexpected operation name",
+                "expected a send binding to be refused for close");
+
   ck_assert_msg(store.close(), "close failed");
 }
 END_TEST
@@ -274,17 +279,17 @@ START_TEST(test_conduit_await_cancel)
   ck_assert_msg(task_b, "spawn task_b failed");
 
   DispatchEngine engine(schema);
-  auto open_match = engine.resolve(kTypeKernelIo, "open_channel", OperationScope::Class,
-                                   {kTypeU64, kTypeU64}, 2, true);
-  ck_assert_msg(open_match, "open_channel resolve failed: %s", result_message(open_match));
+  auto open_match = engine.bind(kTypeKernelIo, "open_channel", OperationScope::Class,
+                                {kTypeU64, kTypeU64}, 2);
+  ck_assert_msg(open_match, "open_channel bind failed: %s", result_message(open_match));
   auto openR = executor.open_channel(open_match.value.value(), task_a.value->id, task_b.value->id);
   ck_assert_msg(openR, "open_channel failed: %s", result_message(openR));
 
   ck_assert_msg(registry.cancel_task(task_b.value->id), "cancel failed");
 
-  auto await_match = engine.resolve(kTypeKernelIoChannel, "await_readable", OperationScope::Object,
-                                    {kTypeU64}, 1, true);
-  ck_assert_msg(await_match, "await_readable resolve failed: %s", result_message(await_match));
+  auto await_match = engine.bind(kTypeKernelIoChannel, "await_readable", OperationScope::Object,
+                                 {kTypeU64}, 1);
+  ck_assert_msg(await_match, "await_readable bind failed: %s", result_message(await_match));
   auto waitR = executor.await_channel(await_match.value.value(), openR.value->second, task_b.value->id);
   ck_assert_msg(waitR, "await_readable failed: %s", result_message(waitR));
   ck_assert_msg(waitR.value->ready, "expected await to be ready due to cancel");
@@ -319,14 +324,14 @@ START_TEST(test_conduit_channel_close_errors)
   ck_assert_msg(task_b, "spawn task_b failed");
 
   DispatchEngine engine(schema);
-  auto open_match = engine.resolve(kTypeKernelIo, "open_channel", OperationScope::Class,
-                                   {kTypeU64, kTypeU64}, 2, true);
-  ck_assert_msg(open_match, "open_channel resolve failed: %s", result_message(open_match));
+  auto open_match = engine.bind(kTypeKernelIo, "open_channel", OperationScope::Class,
+                                {kTypeU64, kTypeU64}, 2);
+  ck_assert_msg(open_match, "open_channel bind failed: %s", result_message(open_match));
   auto openR = executor.open_channel(open_match.value.value(), task_a.value->id, task_b.value->id);
   ck_assert_msg(openR, "open_channel failed: %s", result_message(openR));
 
-  auto close_match = engine.resolve(kTypeKernelIoChannel, "close", OperationScope::Object, {}, 0, true);
-  ck_assert_msg(close_match, "close resolve failed: %s", result_message(close_match));
+  auto close_match = engine.bind(kTypeKernelIoChannel, "close", OperationScope::Object, {}, 0);
+  ck_assert_msg(close_match, "close bind failed: %s", result_message(close_match));
 
   ck_assert_msg(executor.close_channel(close_match.value.value(), openR.value->first),
                 "close failed");
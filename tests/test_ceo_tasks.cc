@@ -26,6 +26,16 @@ START_TEST(test_spawn_and_parent_child)
   ck_assert_msg(root_lookup, "get_task failed");
   ck_assert(root_lookup.value->has_value());
   ck_assert_int_eq((int)root_lookup.value->value().children.size(), 1);
+
+  // Children start with their parent's grants.
+  iris::refract::CapabilitySet granted;
+  granted.set(3);
+  ck_assert_msg(registry.set_capabilities(root.value->id, granted), "set_capabilities failed");
+  auto grandchild = registry.spawn_task(referee::ObjectID::random(), root.value->id, "grandchild");
+  ck_assert_msg(grandchild, "spawn grandchild failed");
+  ck_assert_msg(grandchild.value->capabilities.has(3), "grant not inherited");
+  ck_assert_msg(!child.value->capabilities.has(3), "earlier child changed");
+  ck_assert_msg(!registry.set_capabilities(999, granted), "unknown task accepted");
 }
 END_TEST
 
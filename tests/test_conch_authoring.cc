@@ -12,6 +12,7 @@ extern "C" {
 
 #include <cstdio>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <sstream>
@@ -28,13 +29,7 @@ const char* result_message(const Result<T>& r) {
   return r.error.has_value() ? r.error->message.c_str() : "ok";
 }
 
-std::string run_conch_script(const std::string& script) {
-  char db_template[] = "/tmp/iris-conch-db-XXXXXX";
-  int db_fd = ::mkstemp(db_template);
-  if (db_fd >= 0) {
-    ::close(db_fd);
-  }
-
+std::string run_conch_on(const std::string& db_path, const std::string& args, const std::string& script) {
   char script_template[] = "/tmp/iris-conch-script-XXXXXX";
   int script_fd = ::mkstemp(script_template);
   if (script_fd >= 0) {
@@ -47,7 +42,7 @@ std::string run_conch_script(const std::string& script) {
   }
 
   std::ostringstream cmd;
-  cmd << "../bin/conch --db " << db_template << " < " << script_template;
+  cmd << "../bin/conch --db " << db_path << args << " < " << script_template;
 
   std::string output;
   FILE* pipe = ::popen(cmd.str().c_str(), "r");
@@ -60,6 +55,16 @@ std::string run_conch_script(const std::string& script) {
   }
 
   ::unlink(script_template);
+  return output;
+}
+
+std::string run_conch_script(const std::string& script) {
+  char db_template[] = "/tmp/iris-conch-db-XXXXXX";
+  int db_fd = ::mkstemp(db_template);
+  if (db_fd >= 0) {
+    ::close(db_fd);
+  }
+  auto output = run_conch_on(db_template, "", script);
   ::unlink(db_template);
   return output;
 }
@@ -213,6 +218,33 @@ START_TEST(test_conch_io_alias)
 }
 END_TEST
 
+START_TEST(test_conch_read_only_skips_catalog)
+{
+  char db_template[] = "/tmp/iris-conch-db-XXXXXX";
+  int db_fd = ::mkstemp(db_template);
+  ck_assert_msg(db_fd >= 0, "mkstemp failed");
+  ::close(db_fd);
+
+  // A store with the core schema but no seeded catalog, as an older writer leaves it.
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_template });
+    ck_assert_msg(store.open(), "open failed");
+    SchemaRegistry registry(store);
+    auto bootstrapR = bootstrap_core_schema(registry);
+    ck_assert_msg(bootstrapR, "bootstrap failed: %s", result_message(bootstrapR));
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  auto output = run_conch_on(db_template, " --read-only", "stats\nexit\n");
+  ck_assert_msg(output.find("error:") == std::string::npos, "read-only conch failed: %s", output.c_str());
+  ck_assert_msg(!output.empty(), "expected stats output");
+
+  std::error_code ec;
+  std::filesystem::remove_all(std::string(db_template) + ".segments", ec);
+  ::unlink(db_template);
+}
+END_TEST
+
 Suite* conch_authoring_suite(void) {
   Suite* s = suite_create("ConchAuthoring");
   TCase* tc = tcase_create("core");
@@ -222,6 +254,7 @@ Suite* conch_authoring_suite(void) {
   tcase_add_test(tc, test_conch_io_requires_caps);
   tcase_add_test(tc, test_conch_io_datagram);
   tcase_add_test(tc, test_conch_io_alias);
+  tcase_add_test(tc, test_conch_read_only_skips_catalog);
 
   suite_add_tcase(s, tc);
   return s;
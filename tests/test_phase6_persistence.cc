@@ -5,15 +5,23 @@ extern "C" {
 #undef fail
 #endif
 
+#include "exec/waitables.h"
 #include "refract/bootstrap.h"
 #include "refract/schema_registry.h"
 #include "referee/referee.h"
+#include "referee_sqlite/replication.h"
+#include "referee_sqlite/sharded_store.h"
 #include "referee_sqlite/sqlite_store.h"
 
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <vector>
+#include <sys/wait.h>
 #include <unistd.h>
 
 using namespace referee;
@@ -244,6 +252,640 @@ START_TEST(test_phase6_definition_migration)
 }
 END_TEST
 
+START_TEST(test_phase6_bulk_reopen_truncated_tail)
+{
+  std::string db_path = make_temp_db_path();
+  constexpr int kObjects = 3000;
+  std::vector<ObjectRef> refs;
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path });
+    ck_assert_msg(store.open(), "open failed");
+    for (int i = 0; i < kObjects; ++i) {
+      Bytes payload{static_cast<std::uint8_t>(i & 0xFF), static_cast<std::uint8_t>(i >> 8)};
+      auto r = store.create_object(TypeID{0x100ULL + (i % 7)}, ObjectID::random(), payload);
+      ck_assert_msg(r, "create failed: %s", result_message(r));
+      refs.push_back(r.value->ref);
+    }
+    for (int i = 0; i + 1 < kObjects; ++i) {
+      auto r = store.add_edge(refs[i], refs[i + 1], "next", "chain", Bytes{});
+      ck_assert_msg(r, "add_edge failed: %s", result_message(r));
+    }
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  // Simulate a crash mid-append: a frame header with no body.
+  const auto seg_dir = std::filesystem::path(db_path + ".segments") / "segments";
+  {
+    std::ofstream obj(seg_dir / "objects.seg", std::ios::binary | std::ios::app);
+    obj.write("OBJ1\x40\x00\x00\x00", 8);
+    std::ofstream edge(seg_dir / "edges.seg", std::ios::binary | std::ios::app);
+    edge.write("EDG1", 4);
+  }
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path });
+    ck_assert_msg(store.open(), "reopen failed");
+    auto statsR = store.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    ck_assert_uint_eq(statsR.value->object_count, (std::uint64_t)kObjects);
+    ck_assert_uint_eq(statsR.value->edge_count, (std::uint64_t)(kObjects - 1));
+
+    auto rec = store.get_object(refs[1234]);
+    ck_assert_msg(rec && rec.value->has_value(), "expected object to reload");
+    ck_assert_uint_eq(rec.value->value().payload_cbor[0], 1234 & 0xFF);
+    auto edges = store.edges_to(refs[kObjects - 1]);
+    ck_assert_msg(edges, "edges_to failed: %s", result_message(edges));
+    ck_assert_uint_eq(edges.value->size(), 1U);
+
+    // The torn tail is trimmed, so later appends stay frame-aligned.
+    auto extra = store.create_object(TypeID{0x100ULL}, ObjectID::random(), Bytes{0x09});
+    ck_assert_msg(extra, "create after reopen failed: %s", result_message(extra));
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path });
+    ck_assert_msg(store.open(), "second reopen failed");
+    auto statsR = store.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    ck_assert_uint_eq(statsR.value->object_count, (std::uint64_t)kObjects + 1);
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(db_path + ".segments", ec);
+  cleanup_db_files(db_path);
+}
+END_TEST
+
+START_TEST(test_phase6_checkpoint_tail_replay)
+{
+  std::string db_path = make_temp_db_path();
+  const std::string store_dir = db_path + ".segments";
+  std::vector<ObjectRef> refs;
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path, .checkpoint_interval_bytes=0 });
+    ck_assert_msg(store.open(), "open failed");
+    for (int i = 0; i < 200; ++i) {
+      auto r = store.create_object(TypeID{0x200ULL}, ObjectID::random(), Bytes{0x01});
+      ck_assert_msg(r, "create failed: %s", result_message(r));
+      refs.push_back(r.value->ref);
+    }
+    ck_assert_msg(store.add_edge(refs[0], refs[1], "pre", "ckpt", Bytes{}), "add_edge failed");
+    auto ckR = store.checkpoint();
+    ck_assert_msg(ckR, "checkpoint failed: %s", result_message(ckR));
+
+    for (int i = 0; i < 50; ++i) {
+      auto r = store.create_object(TypeID{0x201ULL}, ObjectID::random(), Bytes{0x02});
+      ck_assert_msg(r, "create failed: %s", result_message(r));
+      refs.push_back(r.value->ref);
+    }
+    ck_assert_msg(store.add_edge(refs[200], refs[0], "post", "ckpt", Bytes{}), "add_edge failed");
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path, .checkpoint_interval_bytes=0 });
+    ck_assert_msg(store.open(), "reopen failed");
+    auto statsR = store.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    const auto& stats = statsR.value.value();
+    ck_assert_msg(stats.checkpoint.loaded, "expected checkpoint to be used");
+    ck_assert_msg(stats.checkpoint.covered_bytes > 0, "expected checkpoint coverage");
+    ck_assert_msg(stats.checkpoint.replayed_bytes > 0, "expected tail replay");
+    ck_assert_uint_eq(stats.object_count, 250U);
+    ck_assert_uint_eq(stats.edge_count, 2U);
+
+    auto pre = store.list_by_type(TypeID{0x200ULL});
+    ck_assert_msg(pre && pre.value->size() == 200U, "expected checkpointed objects");
+    auto post = store.list_by_type(TypeID{0x201ULL});
+    ck_assert_msg(post && post.value->size() == 50U, "expected replayed objects");
+    auto into = store.edges_to(refs[0]);
+    ck_assert_msg(into && into.value->size() == 1U, "expected replayed edge");
+    ck_assert_str_eq(into.value->front().name.c_str(), "post");
+
+    // Payloads are read back from the segment on lookup.
+    auto head = store.get_object(refs[0]);
+    ck_assert_msg(head && head.value->has_value(), "expected checkpointed object");
+    ck_assert_msg(head.value->value().payload_cbor == Bytes{0x01}, "unexpected checkpointed payload");
+    auto tail = store.get_object(refs[249]);
+    ck_assert_msg(tail && tail.value->has_value(), "expected replayed object");
+    ck_assert_msg(tail.value->value().payload_cbor == Bytes{0x02}, "unexpected replayed payload");
+    auto fresh = store.create_object(TypeID{0x201ULL}, ObjectID::random(), Bytes{0x03});
+    ck_assert_msg(fresh, "create failed: %s", result_message(fresh));
+    auto freshGet = store.get_object(fresh.value->ref);
+    ck_assert_msg(freshGet && freshGet.value->has_value(), "expected object appended after open");
+    ck_assert_msg(freshGet.value->value().payload_cbor == Bytes{0x03}, "unexpected appended payload");
+    refs.push_back(fresh.value->ref);
+
+    // A later checkpoint appends only the keys of the new frames: offset + frame header.
+    auto ckR = store.checkpoint();
+    ck_assert_msg(ckR, "checkpoint failed: %s", result_message(ckR));
+    ck_assert_uint_eq(std::filesystem::file_size(store_dir + "/checkpoints/objects.keys"), 251U * (8U + 64U));
+    ck_assert_uint_eq(std::filesystem::file_size(store_dir + "/checkpoints/edges.keys"), 2U * (8U + 72U));
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  // Open indexes the covered prefix from the checkpoint without reading its frames:
+  // a clobbered frame tag only surfaces when that record is looked up.
+  {
+    std::fstream seg(store_dir + "/segments/objects.seg", std::ios::binary | std::ios::in | std::ios::out);
+    seg.put('X');
+  }
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path, .checkpoint_interval_bytes=0 });
+    ck_assert_msg(store.open(), "reopen over a damaged covered frame failed");
+    auto statsR = store.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    ck_assert_msg(statsR.value->checkpoint.loaded, "expected checkpoint to be used");
+    ck_assert_uint_eq(statsR.value->checkpoint.replayed_bytes, 0U);
+    ck_assert_uint_eq(statsR.value->object_count, 251U);
+    ck_assert_msg(!store.get_object(refs[0]), "expected the damaged frame to fail on lookup");
+    auto other = store.get_object(refs[1]);
+    ck_assert_msg(other && other.value->has_value(), "expected undamaged frames to read back");
+    ck_assert_msg(store.close(), "close failed");
+  }
+  {
+    std::fstream seg(store_dir + "/segments/objects.seg", std::ios::binary | std::ios::in | std::ios::out);
+    seg.put('O');
+  }
+
+  // The rebuilt .idx files hold one line per record whether or not a checkpoint was used.
+  {
+    std::ifstream idx(store_dir + "/indexes/objects_by_id.idx");
+    std::string line;
+    std::size_t lines = 0;
+    while (std::getline(idx, line)) ++lines;
+    ck_assert_uint_eq(lines, 251U);
+  }
+
+  // A damaged checkpoint is ignored and the full history is replayed.
+  {
+    std::fstream ckpt(store_dir + "/checkpoints/index.ckpt",
+                      std::ios::binary | std::ios::in | std::ios::out);
+    ckpt.seekp(16);
+    ckpt.put('\x7f');
+  }
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path, .checkpoint_interval_bytes=0 });
+    ck_assert_msg(store.open(), "reopen after damage failed");
+    auto statsR = store.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    ck_assert_msg(!statsR.value->checkpoint.loaded, "expected damaged checkpoint to be ignored");
+    ck_assert_uint_eq(statsR.value->object_count, 251U);
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(store_dir, ec);
+  cleanup_db_files(db_path);
+}
+END_TEST
+
+START_TEST(test_phase6_background_checkpoint)
+{
+  std::string db_path = make_temp_db_path();
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path, .checkpoint_interval_bytes=4096 });
+    ck_assert_msg(store.open(), "open failed");
+    Bytes payload(100, 0x5A);
+    for (int i = 0; i < 400; ++i) {
+      auto r = store.create_object(TypeID{0x300ULL}, ObjectID::random(), payload);
+      ck_assert_msg(r, "create failed: %s", result_message(r));
+    }
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path, .checkpoint_interval_bytes=0 });
+    ck_assert_msg(store.open(), "reopen failed");
+    auto statsR = store.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    ck_assert_msg(statsR.value->checkpoint.loaded, "expected a background checkpoint");
+    ck_assert_msg(statsR.value->checkpoint.covered_bytes > 0, "expected checkpoint coverage");
+    ck_assert_uint_eq(statsR.value->object_count, 400U);
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(db_path + ".segments", ec);
+  cleanup_db_files(db_path);
+}
+END_TEST
+
+START_TEST(test_phase6_single_writer_shared_readers)
+{
+  std::string db_path = make_temp_db_path();
+
+  SqliteStore writer(SqliteConfig{ .filename=db_path });
+  ck_assert_msg(writer.open(), "writer open failed");
+  auto first = writer.create_object(TypeID{0x400ULL}, ObjectID::random(), Bytes{0x01});
+  ck_assert_msg(first, "create failed: %s", result_message(first));
+
+  SqliteStore second(SqliteConfig{ .filename=db_path });
+  auto secondR = second.open();
+  ck_assert_msg(!secondR, "expected a second writer to be refused");
+
+  // Another process is refused the same way.
+  pid_t pid = fork();
+  ck_assert_msg(pid >= 0, "fork failed");
+  if (pid == 0) {
+    SqliteStore child(SqliteConfig{ .filename=db_path });
+    _exit(child.open() ? 1 : 0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ck_assert_msg(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                "expected writer lock to exclude another process");
+
+  SqliteStore reader(SqliteConfig{ .filename=db_path, .read_only=true });
+  auto readerR = reader.open();
+  ck_assert_msg(readerR, "reader open failed: %s", result_message(readerR));
+  ck_assert_msg(reader.read_only(), "expected read-only handle");
+  auto seen = reader.get_object(first.value->ref);
+  ck_assert_msg(seen && seen.value->has_value(), "reader should see existing object");
+  ck_assert_msg(!reader.create_object(TypeID{0x400ULL}, ObjectID::random(), Bytes{}),
+                "reader must refuse writes");
+
+  auto next = writer.create_object(TypeID{0x400ULL}, ObjectID::random(), Bytes{0x02});
+  ck_assert_msg(next, "create failed: %s", result_message(next));
+  ck_assert_msg(writer.add_edge(first.value->ref, next.value->ref, "follows", "", Bytes{}),
+                "add_edge failed");
+  auto missing = reader.get_object(next.value->ref);
+  ck_assert_msg(missing && !missing.value->has_value(), "reader sees appends only after refresh");
+
+  auto refreshR = reader.refresh();
+  ck_assert_msg(refreshR, "refresh failed: %s", result_message(refreshR));
+  ck_assert_uint_eq(refreshR.value.value(), 2U);
+  auto found = reader.get_object(next.value->ref);
+  ck_assert_msg(found && found.value->has_value(), "reader should see appended object");
+  auto edges = reader.edges_from(first.value->ref);
+  ck_assert_msg(edges && edges.value->size() == 1U, "reader should see appended edge");
+
+  // A half-written frame stays invisible until it is complete.
+  {
+    std::ofstream obj(db_path + ".segments/segments/objects.seg", std::ios::binary | std::ios::app);
+    obj.write("OBJ1", 4);
+  }
+  refreshR = reader.refresh();
+  ck_assert_msg(refreshR, "refresh failed: %s", result_message(refreshR));
+  ck_assert_uint_eq(refreshR.value.value(), 0U);
+
+  ck_assert_msg(reader.close(), "reader close failed");
+  ck_assert_msg(writer.close(), "writer close failed");
+
+  SqliteStore reopened(SqliteConfig{ .filename=db_path });
+  ck_assert_msg(reopened.open(), "writer lock should be released on close");
+  ck_assert_msg(reopened.close(), "close failed");
+
+  std::error_code ec;
+  std::filesystem::remove_all(db_path + ".segments", ec);
+  cleanup_db_files(db_path);
+}
+END_TEST
+
+START_TEST(test_phase6_change_feed)
+{
+  std::string db_path = make_temp_db_path();
+  ChangeCursor resume{};
+  ObjectRef first_ref{};
+
+  {
+    SqliteStore store(SqliteConfig{ .filename=db_path });
+    ck_assert_msg(store.open(), "open failed");
+
+    std::vector<ObjectRef> created;
+    std::vector<ChangeCursor> commits;
+    ChangeFilter gauges;
+    gauges.type = TypeID{0x500ULL};
+    gauges.edges = false;
+    store.subscribe(gauges, [&](const ChangeEvent& event) {
+      if (event.kind == ChangeKind::ObjectCreated) created.push_back(event.object->ref);
+      if (event.kind == ChangeKind::Commit) commits.push_back(event.cursor);
+    });
+    // A CEO waitable woken by the feed.
+    iris::exec::Event linked;
+    ChangeFilter follows;
+    follows.objects = false;
+    follows.commits = false;
+    follows.edge_name = "follows";
+    const auto follows_id = store.subscribe(follows, [&](const ChangeEvent&) { linked.signal(); });
+
+    auto a = store.create_object(TypeID{0x500ULL}, ObjectID::random(), Bytes{0x01});
+    ck_assert_msg(a, "create failed: %s", result_message(a));
+    first_ref = a.value->ref;
+    ck_assert_msg(store.create_object(TypeID{0x501ULL}, ObjectID::random(), Bytes{0x02}), "create failed");
+    ck_assert_uint_eq(created.size(), 1U);
+    ck_assert_uint_eq(commits.size(), 2U);
+
+    // Transactions deliver on commit, and nothing on rollback.
+    ck_assert_msg(store.begin(), "begin failed");
+    auto b = store.create_object(TypeID{0x500ULL}, ObjectID::random(), Bytes{0x03});
+    ck_assert_msg(b, "create failed: %s", result_message(b));
+    ck_assert_msg(store.add_edge(a.value->ref, b.value->ref, "follows", "", Bytes{}), "add_edge failed");
+    ck_assert_msg(store.add_edge(a.value->ref, b.value->ref, "other", "", Bytes{}), "add_edge failed");
+    ck_assert_uint_eq(created.size(), 1U);
+    ck_assert_msg(!linked.is_set(), "edge delivered before commit");
+    ck_assert_msg(store.commit(), "commit failed");
+    ck_assert_uint_eq(created.size(), 2U);
+    ck_assert_uint_eq(commits.size(), 3U);
+    ck_assert_msg(linked.is_set(), "expected the follows edge to signal");
+    ck_assert_msg(commits.back() == store.change_cursor(), "commit should carry the store's cursor");
+    resume = commits.back();
+
+    ck_assert_msg(store.begin(), "begin failed");
+    ck_assert_msg(store.create_object(TypeID{0x500ULL}, ObjectID::random(), Bytes{0x04}), "create failed");
+    ck_assert_msg(store.rollback(), "rollback failed");
+    ck_assert_uint_eq(created.size(), 2U);
+
+    store.unsubscribe(follows_id);
+    linked.reset();
+    ck_assert_msg(store.add_edge(a.value->ref, b.value->ref, "follows", "", Bytes{}), "add_edge failed");
+    ck_assert_msg(!linked.is_set(), "unsubscribed listener was called");
+
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  {
+    // Written while no one listened.
+    SqliteStore store(SqliteConfig{ .filename=db_path });
+    ck_assert_msg(store.open(), "reopen failed");
+    auto c = store.create_object(TypeID{0x500ULL}, ObjectID::random(), Bytes{0x05});
+    ck_assert_msg(c, "create failed: %s", result_message(c));
+
+    // A shared reader hears about the writer's appends when it refreshes.
+    SqliteStore reader(SqliteConfig{ .filename=db_path, .read_only=true });
+    ck_assert_msg(reader.open(), "reader open failed");
+    std::size_t refreshed = 0;
+    reader.subscribe(ChangeFilter{}, [&](const ChangeEvent& event) {
+      if (event.kind == ChangeKind::ObjectCreated) ++refreshed;
+    });
+    ck_assert_msg(store.create_object(TypeID{0x501ULL}, ObjectID::random(), Bytes{0x06}), "create failed");
+    ck_assert_msg(reader.refresh(), "refresh failed");
+    ck_assert_uint_eq(refreshed, 1U);
+    ck_assert_msg(reader.close(), "reader close failed");
+
+    // Catch-up from a saved cursor: the objects written since (c and the 0x501 one),
+    // then the edge added after it.
+    std::vector<ObjectRef> missed;
+    std::size_t missed_edges = 0;
+    ChangeFilter all;
+    auto caughtR = store.read_changes(resume, all, [&](const ChangeEvent& event) {
+      if (event.kind == ChangeKind::ObjectCreated) missed.push_back(event.object->ref);
+      if (event.kind == ChangeKind::EdgeAdded) ++missed_edges;
+    });
+    ck_assert_msg(caughtR, "read_changes failed: %s", result_message(caughtR));
+    ck_assert_uint_eq(missed.size(), 2U);
+    ck_assert_msg(missed[0] == c.value->ref, "expected c first");
+    ck_assert_uint_eq(missed_edges, 1U);
+    ck_assert_msg(caughtR.value.value() == store.change_cursor(), "catch-up should reach the end");
+
+    std::size_t from_start = 0;
+    all.type = TypeID{0x500ULL};
+    ck_assert_msg(store.read_changes(ChangeCursor{}, all, [&](const ChangeEvent& event) {
+      if (event.kind == ChangeKind::ObjectCreated) ++from_start;
+    }), "read_changes from the start failed");
+    ck_assert_uint_eq(from_start, 3U);
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  SqliteStore memory(SqliteConfig{ .filename=":memory:" });
+  ck_assert_msg(memory.open(), "open failed");
+  ck_assert_msg(!memory.read_changes(ChangeCursor{}, ChangeFilter{}, [](const ChangeEvent&) {}),
+                "in-memory stores have no history to replay");
+
+  std::error_code ec;
+  std::filesystem::remove_all(db_path + ".segments", ec);
+  cleanup_db_files(db_path);
+}
+END_TEST
+
+START_TEST(test_phase6_follower_replication)
+{
+  std::string leader_path = make_temp_db_path();
+  std::string replica_path = make_temp_db_path();
+  constexpr int kObjects = 300;
+
+  // The leader is a separate process appending while the follower tails it.
+  pid_t pid = fork();
+  ck_assert_msg(pid >= 0, "fork failed");
+  if (pid == 0) {
+    SqliteStore leader(SqliteConfig{ .filename=leader_path });
+    if (!leader.open()) _exit(1);
+    std::optional<ObjectRef> prev;
+    for (int i = 0; i < kObjects; ++i) {
+      auto r = leader.create_object(TypeID{0x500ULL}, ObjectID::random(), Bytes{0x07});
+      if (!r) _exit(1);
+      if (prev && !leader.add_edge(*prev, r.value->ref, "next", "", Bytes{})) _exit(1);
+      prev = r.value->ref;
+      if (i % 50 == 0) usleep(2000);
+    }
+    _exit(leader.close() ? 0 : 1);
+  }
+
+  {
+    SqliteStore replica(SqliteConfig{ .filename=replica_path, .replica=true });
+    ck_assert_msg(replica.open(), "replica open failed");
+    ck_assert_msg(!replica.create_object(TypeID{0x500ULL}, ObjectID::random(), Bytes{}),
+                  "replica must refuse local writes");
+
+    SegmentFollower follower(replica, leader_path);
+    int status = 0;
+    bool leader_done = false;
+    for (int spins = 0; spins < 5000 && !leader_done; ++spins) {
+      auto pollR = follower.poll(4096);
+      ck_assert_msg(pollR, "poll failed: %s", result_message(pollR));
+      leader_done = waitpid(pid, &status, WNOHANG) == pid;
+      usleep(500);
+    }
+    ck_assert_msg(leader_done && WIFEXITED(status) && WEXITSTATUS(status) == 0, "leader failed");
+
+    // Drain whatever the leader wrote after the last poll.
+    ReplicationStatus repl;
+    do {
+      auto pollR = follower.poll(4096);
+      ck_assert_msg(pollR, "poll failed: %s", result_message(pollR));
+      repl = pollR.value.value();
+    } while (repl.applied_records > 0);
+    ck_assert_uint_eq(repl.lag_bytes, 0U);
+    ck_assert_uint_eq(repl.total_applied, (std::uint64_t)(2 * kObjects - 1));
+    ck_assert_msg(repl.last_record_unix_ms > 0, "expected apply timestamp");
+
+    auto statsR = replica.stats();
+    ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+    ck_assert_uint_eq(statsR.value->object_count, (std::uint64_t)kObjects);
+    ck_assert_uint_eq(statsR.value->edge_count, (std::uint64_t)(kObjects - 1));
+    ck_assert_msg(replica.close(), "replica close failed");
+  }
+
+  // Replica segments are byte-identical prefixes of the leader's.
+  for (const char* seg : {"objects.seg", "edges.seg"}) {
+    std::ifstream a(leader_path + ".segments/segments/" + seg, std::ios::binary);
+    std::ifstream b(replica_path + ".segments/segments/" + seg, std::ios::binary);
+    std::string da((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+    std::string db((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+    ck_assert_msg(da == db, "replica %s differs from leader", seg);
+  }
+
+  // A restarted follower resumes from its own segment lengths.
+  {
+    SqliteStore leader(SqliteConfig{ .filename=leader_path });
+    ck_assert_msg(leader.open(), "leader reopen failed");
+    ck_assert_msg(leader.create_object(TypeID{0x501ULL}, ObjectID::random(), Bytes{}), "create failed");
+
+    SqliteStore replica(SqliteConfig{ .filename=replica_path, .replica=true });
+    ck_assert_msg(replica.open(), "replica reopen failed");
+    SegmentFollower follower(replica, leader_path);
+    auto pollR = follower.poll();
+    ck_assert_msg(pollR, "poll failed: %s", result_message(pollR));
+    ck_assert_uint_eq(pollR.value->applied_records, 1U);
+    auto listR = replica.list_by_type(TypeID{0x501ULL});
+    ck_assert_msg(listR && listR.value->size() == 1U, "expected resumed record");
+
+    // A frame bigger than the per-poll limit is applied whole rather than stalling.
+    ck_assert_msg(leader.create_object(TypeID{0x502ULL}, ObjectID::random(), Bytes(8192, 0x5A)), "create failed");
+    pollR = follower.poll(4096);
+    ck_assert_msg(pollR, "poll failed: %s", result_message(pollR));
+    ck_assert_uint_eq(pollR.value->applied_records, 1U);
+    ck_assert_uint_eq(pollR.value->lag_bytes, 0U);
+    ck_assert_msg(replica.close(), "close failed");
+    ck_assert_msg(leader.close(), "close failed");
+  }
+
+  std::error_code ec;
+  std::filesystem::remove_all(leader_path + ".segments", ec);
+  std::filesystem::remove_all(replica_path + ".segments", ec);
+  cleanup_db_files(leader_path);
+  cleanup_db_files(replica_path);
+}
+END_TEST
+
+START_TEST(test_phase6_sharded_store)
+{
+  std::string db_path = make_temp_db_path();
+  constexpr std::size_t kShards = 4;
+  constexpr int kObjects = 400;
+  std::vector<ObjectRef> refs;
+  std::string intent;
+
+  {
+    ShardedStore store(ShardedConfig{ .filename=db_path, .shards=kShards });
+    ck_assert_msg(store.open(), "open failed");
+
+    std::vector<NewObject> batch;
+    for (int i = 0; i < kObjects; ++i) {
+      batch.push_back(NewObject{TypeID{0x200ULL + (i % 3)}, ObjectID::random(),
+                                Bytes{static_cast<std::uint8_t>(i & 0xFF)}});
+    }
+    auto createdR = store.create_objects(batch);
+    ck_assert_msg(createdR, "create_objects failed: %s", result_message(createdR));
+    ck_assert_uint_eq(createdR.value->size(), (std::size_t)kObjects);
+    for (const auto& rec : createdR.value.value()) refs.push_back(rec.ref);
+    ck_assert_uint_eq(createdR.value->at(17).payload_cbor[0], 17U);
+
+    // A cross-shard transaction: edges land on the shard owning `from`.
+    ck_assert_msg(store.begin(), "begin failed");
+    for (int i = 0; i + 1 < kObjects; ++i) {
+      auto r = store.add_edge(refs[i], refs[i + 1], "next", "chain", Bytes{});
+      ck_assert_msg(r, "add_edge failed: %s", result_message(r));
+    }
+    ck_assert_msg(store.commit(), "commit failed");
+    ck_assert_msg(!std::filesystem::exists(db_path + ".txn"), "intent left after commit");
+
+    // Capture the shard lengths as a commit would, then append past them.
+    auto statsR = store.shard_stats();
+    ck_assert_msg(statsR, "shard_stats failed: %s", result_message(statsR));
+    ck_assert_uint_eq(statsR.value->size(), kShards);
+    std::uint64_t objects = 0;
+    for (const auto& st : statsR.value.value()) {
+      ck_assert_msg(st.object_count > 0, "expected every shard to receive objects");
+      objects += st.object_count;
+      intent += std::to_string(st.segments[0].bytes) + " " + std::to_string(st.segments[1].bytes) + "\n";
+    }
+    ck_assert_uint_eq(objects, (std::uint64_t)kObjects);
+    for (int i = 0; i < 50; ++i) {
+      auto r = store.create_object(TypeID{0x200ULL}, ObjectID::random(), Bytes{0x01});
+      ck_assert_msg(r, "create failed: %s", result_message(r));
+    }
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  {
+    ShardedStore store(ShardedConfig{ .filename=db_path, .shards=kShards + 1 });
+    auto r = store.open();
+    ck_assert_msg(!r, "expected shard count mismatch to fail");
+  }
+
+  // A commit interrupted after its committed mark is kept, not rolled back.
+  {
+    std::ofstream out(db_path + ".txn");
+    out << intent << "committed\n";
+  }
+  {
+    ShardedStore store(ShardedConfig{ .filename=db_path, .shards=kShards });
+    ck_assert_msg(store.open(), "reopen failed");
+    ck_assert_msg(!std::filesystem::exists(db_path + ".txn"), "intent left after recovery");
+    auto listR = store.list_by_type(TypeID{0x200ULL});
+    ck_assert_msg(listR, "list_by_type failed: %s", result_message(listR));
+    ck_assert_uint_eq(listR.value->size(), (std::size_t)(kObjects + 2) / 3 + 50);
+    // Shard results are merged in creation order.
+    const auto& listed = listR.value.value();
+    for (std::size_t i = 1; i < listed.size(); ++i) {
+      ck_assert_msg(listed[i - 1].created_at_unix_ms <= listed[i].created_at_unix_ms, "list_by_type out of order");
+    }
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  // An interrupted commit: reopening cuts every shard back to the recorded lengths.
+  {
+    std::ofstream out(db_path + ".txn");
+    out << intent;
+  }
+  {
+    ShardedStore store(ShardedConfig{ .filename=db_path, .shards=kShards });
+    ck_assert_msg(store.open(), "reopen failed");
+    ck_assert_msg(!std::filesystem::exists(db_path + ".txn"), "intent left after recovery");
+
+    std::size_t typed = 0;
+    for (std::uint64_t t = 0; t < 3; ++t) {
+      auto listR = store.list_by_type(TypeID{0x200ULL + t});
+      ck_assert_msg(listR, "list_by_type failed: %s", result_message(listR));
+      typed += listR.value->size();
+    }
+    ck_assert_uint_eq(typed, (std::size_t)kObjects);
+
+    auto rec = store.get_object(refs[123]);
+    ck_assert_msg(rec && rec.value->has_value(), "expected object to reload");
+    ck_assert_uint_eq(rec.value->value().payload_cbor[0], 123U);
+    auto from = store.edges_from(refs[10]);
+    ck_assert_msg(from, "edges_from failed: %s", result_message(from));
+    ck_assert_uint_eq(from.value->size(), 1U);
+    auto to = store.edges_to(refs[kObjects - 1]);
+    ck_assert_msg(to, "edges_to failed: %s", result_message(to));
+    ck_assert_uint_eq(to.value->size(), 1U);
+    ck_assert_msg(to.value->at(0).from == refs[kObjects - 2], "wrong edge source");
+
+    ck_assert_msg(store.begin(), "begin failed");
+    auto pending = store.create_object(TypeID{0x201ULL}, ObjectID::random(), Bytes{});
+    ck_assert_msg(pending, "create in txn failed: %s", result_message(pending));
+    ck_assert_msg(store.rollback(), "rollback failed");
+    auto gone = store.get_object(pending.value->ref);
+    ck_assert_msg(gone && !gone.value->has_value(), "rolled back object is visible");
+    ck_assert_msg(store.close(), "close failed");
+  }
+
+  std::error_code ec;
+  for (std::size_t i = 0; i < kShards; ++i) {
+    std::filesystem::remove_all(db_path + ".shard" + std::to_string(i) + ".segments", ec);
+  }
+  std::filesystem::remove(db_path + ".shards", ec);
+  cleanup_db_files(db_path);
+}
+END_TEST
+
 Suite* phase6_persistence_suite(void) {
   Suite* s = suite_create("Phase6Persistence");
   TCase* tc = tcase_create("core");
@@ -251,6 +893,13 @@ Suite* phase6_persistence_suite(void) {
   tcase_add_test(tc, test_phase6_persistence_roundtrip);
   tcase_add_test(tc, test_phase6_definition_migration);
   tcase_add_test(tc, test_phase6_demo_persistence);
+  tcase_add_test(tc, test_phase6_bulk_reopen_truncated_tail);
+  tcase_add_test(tc, test_phase6_checkpoint_tail_replay);
+  tcase_add_test(tc, test_phase6_background_checkpoint);
+  tcase_add_test(tc, test_phase6_single_writer_shared_readers);
+  tcase_add_test(tc, test_phase6_change_feed);
+  tcase_add_test(tc, test_phase6_follower_replication);
+  tcase_add_test(tc, test_phase6_sharded_store);
 
   suite_add_tcase(s, tc);
   return s;
@@ -2,10 +2,14 @@ extern "C" {
 #include <check.h>
 }
 
+#include "referee/cbor_path.h"
+#include "referee/cbor_writer.h"
 #include "referee/referee.h"
 #include "referee_sqlite/sqlite_store.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <optional>
 #include <string>
 
 using namespace referee;
@@ -99,12 +103,175 @@ START_TEST(test_edges_from_and_to)
 }
 END_TEST
 
+START_TEST(test_store_stats_accounting)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+
+  TypeID typeA{0x10}, typeB{0x20};
+  ObjectID def = ObjectID::random();
+  auto aR = store.create_object(typeA, def, Bytes{0x01, 0x02, 0x03});
+  auto bR = store.create_object(typeA, def, Bytes{0x04});
+  auto cR = store.create_object(typeB, def, Bytes{});
+  ck_assert(aR);
+  ck_assert(bR);
+  ck_assert(cR);
+  ck_assert(store.add_edge(aR.value->ref, cR.value->ref, "link", "test", {}));
+
+  auto hit = store.get_object(aR.value->ref);
+  ck_assert(hit);
+  auto miss = store.get_latest(ObjectID::random());
+  ck_assert(miss);
+
+  auto statsR = store.stats();
+  ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+  const auto& stats = statsR.value.value();
+
+  ck_assert_uint_eq(stats.object_count, 3);
+  ck_assert_uint_eq(stats.edge_count, 1);
+  ck_assert_int_eq((int)stats.objects_by_type.size(), 2);
+  ck_assert_uint_eq(stats.objects_by_type[0].type.v, typeA.v);
+  ck_assert_uint_eq(stats.objects_by_type[0].objects, 2);
+  ck_assert_uint_eq(stats.objects_by_type[0].payload_bytes, 4);
+  ck_assert_int_eq((int)stats.edges_by_name.size(), 1);
+  ck_assert_str_eq(stats.edges_by_name[0].name.c_str(), "link");
+
+  ck_assert_uint_eq(stats.object_appends.count, 3);
+  ck_assert_uint_eq(stats.edge_appends.count, 1);
+  ck_assert_uint_eq(stats.object_lookups.hits, 1);
+  ck_assert_uint_eq(stats.latest_lookups.misses, 1);
+  ck_assert_msg(stats.index_bytes() > 0, "expected index footprint");
+  for (const auto& index : stats.indexes) {
+    if (index.name == "objects_by_ref") ck_assert_uint_eq(index.entries, 3);
+  }
+
+  ck_assert_msg(store.close(), "close failed");
+}
+END_TEST
+
+START_TEST(test_latency_histogram_percentiles)
+{
+  LatencyHistogram h;
+  ck_assert_uint_eq(h.percentile_ns(0.5), 0);
+  for (int i = 0; i < 99; ++i) h.record(100);
+  h.record(100000);
+  ck_assert_uint_eq(h.count, 100);
+  ck_assert_uint_eq(h.max_ns, 100000);
+  ck_assert_uint_eq(h.percentile_ns(0.50), 127);
+  ck_assert_uint_eq(h.percentile_ns(1.0), 100000);
+}
+END_TEST
+
+START_TEST(test_cbor_path_projection)
+{
+  auto cbor = cbor_from_json_string(
+      R"({"a":1,"name":"alpha","nested":{"list":[10,{"x":true}],"pi":1.5},"neg":-5})");
+
+  ck_assert_msg(cbor_find_text(cbor, {"name"}) == std::string_view("alpha"), "expected name");
+  auto x = cbor_find(cbor, {"nested", "list", "1", "x"});
+  ck_assert_msg(x.has_value(), "expected nested array lookup");
+  ck_assert_msg(cbor_bool(*x) == true, "expected true");
+  auto first = cbor_find(cbor, {"nested", "list", "0"});
+  ck_assert_msg(first && cbor_uint(*first) == 10U, "expected list[0] == 10");
+  auto pi = cbor_find(cbor, {"nested", "pi"});
+  ck_assert_msg(pi && cbor_double(*pi) == 1.5, "expected pi");
+  auto neg = cbor_find(cbor, {"neg"});
+  ck_assert_msg(neg && cbor_int(*neg) == -5 && !cbor_uint(*neg), "expected negative int");
+
+  ck_assert_msg(!cbor_find(cbor, {"missing"}), "missing key");
+  ck_assert_msg(!cbor_find(cbor, {"name", "deeper"}), "text is not a container");
+  ck_assert_msg(!cbor_find(cbor, {"nested", "list", "2"}), "index past end");
+  ck_assert_msg(!cbor_uint(*cbor_find(cbor, {"name"})), "text is not an integer");
+
+  // Sub-slices round-trip through the full decoder.
+  auto nested = cbor_find(cbor, {"nested"});
+  ck_assert_msg(nested.has_value(), "expected nested slice");
+  Bytes nested_bytes(nested->data, nested->data + nested->size);
+  const auto nested_json = json_string_from_cbor(nested_bytes);
+  ck_assert_str_eq(nested_json.c_str(), R"({"list":[10,{"x":true}],"pi":1.5})");
+
+  // Truncated payloads are reported as malformed, not missing.
+  Bytes truncated(cbor.begin(), cbor.begin() + 12);
+  const std::string_view neg_path[] = {"neg"};
+  ck_assert_int_eq(static_cast<int>(cbor_lookup(truncated.data(), truncated.size(), neg_path, nullptr)),
+                   static_cast<int>(CborLookup::Malformed));
+
+  // Indefinite-length map with a half-precision float value.
+  Bytes indefinite{0xBF, 0x61, 'k', 0xF9, 0x3C, 0x00, 0xFF};
+  auto k = cbor_find(indefinite, {"k"});
+  ck_assert_msg(k && cbor_double(*k) == 1.0, "expected half float 1.0");
+  ck_assert_msg(!cbor_find(indefinite, {"z"}), "missing key in indefinite map");
+}
+END_TEST
+
+START_TEST(test_cbor_writer_matches_dom)
+{
+  const std::string long_text(300, 'x');
+  CborWriter w;
+  w.map(7);
+  w.text("big");
+  w.uint(4294967296ULL);
+  w.text("f32");
+  w.number(1.5);
+  w.text("f64");
+  w.number(0.1);
+  w.text("list");
+  w.array(3);
+  w.integer(-1);
+  w.integer(-500);
+  w.uint(24);
+  w.text("long");
+  w.text(long_text);
+  w.text("none");
+  w.null();
+  w.text("yes");
+  w.boolean(true);
+  auto written = w.take();
+
+  auto dom = cbor_from_json_string(R"({"big":4294967296,"f32":1.5,"f64":0.1,"list":[-1,-500,24],"long":")"
+                                   + long_text + R"(","none":null,"yes":true})");
+  ck_assert_msg(written == dom, "writer output differs from the DOM encoding");
+
+  // Maps yield keys and values alternately; arrays their items.
+  auto map = CborContainer::open(CborSlice{written.data(), written.size()});
+  ck_assert_msg(map && map->is_map(), "expected a map");
+  CborSlice key;
+  CborSlice item;
+  int pairs = 0;
+  std::optional<CborSlice> list;
+  while (map->next(&key) && map->next(&item)) {
+    if (cbor_text(key) == std::optional<std::string_view>("list")) list = item;
+    ++pairs;
+  }
+  ck_assert_int_eq(pairs, 7);
+  ck_assert_msg(!map->malformed(), "map walk reported malformed input");
+  ck_assert_msg(list.has_value(), "expected the list value");
+  auto array = CborContainer::open(*list);
+  ck_assert_msg(array && !array->is_map(), "expected an array");
+  std::int64_t sum = 0;
+  while (array->next(&item)) sum += cbor_int(item).value_or(0);
+  ck_assert_int_eq((int)sum, -477);
+
+  ck_assert_msg(!CborContainer::open(*cbor_find(written, {"yes"})), "bool is not a container");
+  Bytes truncated(written.begin(), written.begin() + 20);
+  auto cut = CborContainer::open(CborSlice{truncated.data(), truncated.size()});
+  ck_assert_msg(cut.has_value(), "truncated map still opens");
+  while (cut->next(&item)) {
+  }
+  ck_assert_msg(cut->malformed(), "truncated map not reported malformed");
+}
+END_TEST
+
 Suite* referee_suite(void) {
   Suite* s = suite_create("RefereeCore");
   TCase* tc = tcase_create("core");
 
   tcase_add_test(tc, test_create_and_get_object_roundtrip);
   tcase_add_test(tc, test_edges_from_and_to);
+  tcase_add_test(tc, test_store_stats_accounting);
+  tcase_add_test(tc, test_latency_histogram_percentiles);
+  tcase_add_test(tc, test_cbor_path_projection);
+  tcase_add_test(tc, test_cbor_writer_matches_dom);
 
   suite_add_tcase(s, tc);
   return s;
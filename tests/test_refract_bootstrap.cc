@@ -5,12 +5,19 @@ extern "C" {
 #undef fail
 #endif
 
+#include "refract/astra.h"
 #include "refract/bootstrap.h"
+#include "refract/crate.h"
+#include "refract/dispatch.h"
+#include "refract/payload_validator.h"
 #include "refract/schema_registry.h"
+#include "refract/unit_converter.h"
+#include "referee/cbor_writer.h"
 #include "referee/referee.h"
 #include "referee_sqlite/sqlite_store.h"
 
 #include <nlohmann/json.hpp>
+#include <cmath>
 #include <optional>
 #include <string>
 #include <vector>
@@ -87,6 +94,50 @@ START_TEST(test_bootstrap_idempotent)
 }
 END_TEST
 
+START_TEST(test_bootstrap_schema_image)
+{
+  const auto& image = core_schema_image();
+  ck_assert_int_gt((int)image.size(), 0);
+  auto rebuilt = SchemaImage::build(core_schema_definitions());
+  ck_assert_msg(rebuilt.fingerprint() == image.fingerprint(), "image build is not deterministic");
+
+  auto opened = SchemaImage::open(image.bytes());
+  ck_assert_msg(opened, "open failed: %s", result_message(opened));
+  ck_assert_int_eq((int)opened.value->size(), (int)image.size());
+  auto corrupt = image.bytes();
+  corrupt[corrupt.size() / 2] ^= 0x01;
+  ck_assert_msg(!SchemaImage::open(corrupt), "corrupt image accepted");
+
+  const TypeID marker_type{0x5246524349000001ULL};
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+  auto first = bootstrap_core_schema(registry);
+  ck_assert_msg(first, "bootstrap failed: %s", result_message(first));
+  ck_assert_int_eq((int)first.value->inserted, (int)image.size());
+  auto types = registry.list_types();
+  ck_assert_int_eq((int)types.value->size(), (int)image.size());
+  ck_assert_int_eq((int)store.list_by_type(marker_type).value->size(), 1);
+
+  auto second = bootstrap_core_schema(registry);
+  ck_assert_int_eq((int)second.value->inserted, 0);
+  ck_assert_int_eq((int)second.value->existing, (int)image.size());
+
+  // A store seeded one definition at a time, before the marker existed.
+  SqliteStore legacy(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(legacy.open(), "open failed");
+  SchemaRegistry legacy_registry(legacy);
+  for (const auto& summary : types.value.value()) {
+    auto def = registry.get_definition_by_id(summary.definition_id);
+    ck_assert(legacy_registry.register_definition_with_id(def.value->value().definition, summary.definition_id));
+  }
+  auto upgraded = bootstrap_core_schema(legacy_registry);
+  ck_assert_msg(upgraded, "bootstrap failed: %s", result_message(upgraded));
+  ck_assert_int_eq((int)upgraded.value->inserted, 0);
+  ck_assert_int_eq((int)legacy.list_by_type(marker_type).value->size(), 1);
+}
+END_TEST
+
 START_TEST(test_bootstrap_crate_collections)
 {
   SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
@@ -280,6 +331,261 @@ START_TEST(test_bootstrap_caliper_units)
 }
 END_TEST
 
+START_TEST(test_unit_converter_catalog)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  ck_assert_msg(store.ensure_schema(), "ensure_schema failed");
+
+  SchemaRegistry registry(store);
+  auto boot = bootstrap_core_schema(registry);
+  ck_assert_msg(boot, "bootstrap failed: %s", result_message(boot));
+  auto catalog = bootstrap_core_catalog(registry, store);
+  ck_assert_msg(catalog, "catalog bootstrap failed: %s", result_message(catalog));
+
+  auto convR = UnitConverter::load(registry, store);
+  ck_assert_msg(convR, "load failed: %s", result_message(convR));
+  const auto& conv = convR.value.value();
+  ck_assert_msg(conv.find("m") != UnitConverter::kNoUnit, "meter missing");
+  ck_assert_msg(conv.find("parsec") == UnitConverter::kNoUnit, "unexpected unit");
+  ck_assert_msg(conv.compatible(conv.find("km"), conv.find("mi")), "km and mi are both lengths");
+  ck_assert_msg(!conv.compatible(conv.find("m"), conv.find("s")), "m and s are not");
+
+  auto miR = conv.conversion("mi", "km");
+  ck_assert_msg(miR, "mi->km failed: %s", result_message(miR));
+  ck_assert_double_eq_tol(miR.value->apply(1.0), 1.609344, 1e-12);
+  auto tempR = conv.conversion("F", "C");
+  ck_assert_msg(tempR, "F->C failed: %s", result_message(tempR));
+  ck_assert_double_eq_tol(tempR.value->apply(212.0), 100.0, 1e-9);
+  ck_assert_double_eq_tol(tempR.value->apply(-40.0), -40.0, 1e-9);
+  auto same = conv.conversion("kJ", "kJ");
+  ck_assert_msg(same && same.value->identity(), "same unit should be identity");
+
+  auto badR = conv.conversion("m", "s");
+  ck_assert_msg(!badR, "converted length to time");
+  ck_assert_msg(badR.error->message.find("incompatible") != std::string::npos, "unexpected error: %s",
+                badR.error->message.c_str());
+  ck_assert_msg(!conv.conversion("m", "parsec"), "converted to an unknown unit");
+
+  // Batches longer than a SIMD block, with a ragged tail, agree with the scalar form.
+  std::vector<double> in(37);
+  for (std::size_t i = 0; i < in.size(); ++i) in[i] = static_cast<double>(i) * 1.5 - 20.0;
+  std::vector<double> out(in.size());
+  for (const auto& [from, to] : std::vector<std::pair<std::string, std::string>>{
+           { "F", "K" }, { "ft", "m" }, { "C", "K" }, { "m", "m" } }) {
+    auto c = conv.conversion(from, to);
+    ck_assert_msg(c, "%s->%s failed: %s", from.c_str(), to.c_str(), result_message(c));
+    ck_assert_msg(conv.convert(from, to, in.data(), out.data(), in.size()), "convert failed");
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      ck_assert_double_eq_tol(out[i], c.value->apply(in[i]), 1e-12);
+    }
+  }
+  auto inplace = in;
+  UnitConverter::apply(tempR.value.value(), inplace.data(), inplace.data(), inplace.size());
+  ck_assert_double_eq_tol(inplace[36], tempR.value->apply(in[36]), 1e-12);
+  ck_assert_msg(!conv.convert("m", "kg", in.data(), out.data(), in.size()), "converted length to mass");
+
+  ck_assert_msg(store.close(), "close failed");
+}
+END_TEST
+
+START_TEST(test_astra_packed_kernels)
+{
+  // Payload round trip, including a size that needs a multi-byte CBOR head.
+  std::vector<double> xs(37);
+  std::vector<double> ys(37);
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    xs[i] = static_cast<double>(i) * 0.5 - 3.0;
+    ys[i] = 2.0 - static_cast<double>(i % 7);
+  }
+  auto packed = pack_astra(AstraArray::vector(xs));
+  auto unpacked = unpack_astra(packed);
+  ck_assert_msg(unpacked, "unpack failed: %s", result_message(unpacked));
+  ck_assert_uint_eq(unpacked.value->rank(), 1U);
+  ck_assert_uint_eq(unpacked.value->shape[0], 37U);
+  ck_assert_msg(unpacked.value->values == xs, "values changed in the round trip");
+  auto truncated = packed;
+  truncated.pop_back();
+  ck_assert_msg(!unpack_astra(truncated), "accepted a truncated payload");
+  auto bad_magic = packed;
+  bad_magic[bad_magic.size() - 8 * 38 - 8] = 'X';
+  ck_assert_msg(!unpack_astra(bad_magic), "accepted a payload without the header");
+
+  double dot = 0.0;
+  for (std::size_t i = 0; i < xs.size(); ++i) dot += xs[i] * ys[i];
+  ck_assert_double_eq_tol(astra_dot(xs.data(), ys.data(), xs.size()), dot, 1e-9);
+
+  auto y = ys;
+  astra_axpy(2.5, xs.data(), y.data(), y.size());
+  for (std::size_t i = 0; i < y.size(); ++i) ck_assert_double_eq_tol(y[i], 2.5 * xs[i] + ys[i], 1e-12);
+  std::vector<double> out(xs.size());
+  astra_elementwise(AstraElementwise::Sub, xs.data(), ys.data(), out.data(), out.size());
+  for (std::size_t i = 0; i < out.size(); ++i) ck_assert_double_eq_tol(out[i], xs[i] - ys[i], 0.0);
+
+  // 3x5 * 5x4 against the textbook loop.
+  std::vector<double> a(15);
+  std::vector<double> b(20);
+  for (std::size_t i = 0; i < a.size(); ++i) a[i] = static_cast<double>(i) - 7.0;
+  for (std::size_t i = 0; i < b.size(); ++i) b[i] = 0.25 * static_cast<double>(i);
+  std::vector<double> c(12);
+  astra_matmul(a.data(), b.data(), c.data(), 3, 5, 4);
+  for (std::size_t i = 0; i < 3; ++i) {
+    for (std::size_t j = 0; j < 4; ++j) {
+      double want = 0.0;
+      for (std::size_t p = 0; p < 5; ++p) want += a[i * 5 + p] * b[p * 4 + j];
+      ck_assert_double_eq_tol(c[i * 4 + j], want, 1e-9);
+    }
+  }
+
+  // Native implementations are found through dispatch bindings.
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+  auto boot = bootstrap_core_schema(registry);
+  ck_assert_msg(boot, "bootstrap failed: %s", result_message(boot));
+  DispatchEngine engine(registry);
+
+  auto dotR = engine.bind(kAstraVectorType, "dot", OperationScope::Object, {}, 1);
+  ck_assert_msg(dotR, "bind dot failed: %s", result_message(dotR));
+  auto dot_native = astra_native(dotR.value.value());
+  ck_assert_msg(dot_native != nullptr, "dot has no native implementation");
+  std::vector<AstraValue> args(1);
+  args[0].array = AstraArray::vector(ys);
+  auto dotResult = dot_native(AstraArray::vector(xs), args);
+  ck_assert_msg(dotResult, "dot failed: %s", result_message(dotResult));
+  ck_assert_double_eq_tol(dotResult.value->scalar, dot, 1e-9);
+  args[0].array = AstraArray::vector({ 1.0, 2.0 });
+  ck_assert_msg(!dot_native(AstraArray::vector(xs), args), "dot accepted mismatched shapes");
+
+  auto matmulR = engine.bind(kAstraMatrixType, "matmul", OperationScope::Object, {}, 1);
+  ck_assert_msg(matmulR, "bind matmul failed: %s", result_message(matmulR));
+  auto matmul_native = astra_native(matmulR.value.value());
+  ck_assert_msg(matmul_native != nullptr, "matmul has no native implementation");
+  args[0].array = AstraArray::matrix(5, 4, b);
+  auto product = matmul_native(AstraArray::matrix(3, 5, a), args);
+  ck_assert_msg(product && product.value->array.has_value(), "matmul failed: %s", result_message(product));
+  ck_assert_msg(product.value->array->shape == std::vector<std::uint64_t>({ 3, 4 }), "unexpected product shape");
+  ck_assert_double_eq_tol(product.value->array->values[11], c[11], 1e-9);
+
+  auto axpyR = engine.bind(kAstraTensorType, "axpy", OperationScope::Object, {}, 2);
+  ck_assert_msg(axpyR && astra_native(axpyR.value.value()) != nullptr, "tensor axpy not bound natively");
+  auto sizeR = engine.bind(kAstraVectorType, "size", OperationScope::Object, {}, 0);
+  ck_assert_msg(sizeR && astra_native(sizeR.value.value()) == nullptr, "size should not be native");
+
+  // Results are stored as packed byte strings, which the payload validator must let
+  // through: the Astra definitions have no fields to check.
+  PayloadValidator validator(registry);
+  validator.install(store);
+  auto sum = store.create_object(kAstraVectorType, ObjectID{}, pack_astra(AstraArray::vector(xs)));
+  ck_assert_msg(sum, "packed vector refused: %s", result_message(sum));
+  auto stored = store.get_object(sum.value->ref);
+  ck_assert_msg(stored && stored.value->has_value(), "packed vector not stored");
+  ck_assert_msg(unpack_astra(stored.value->value().payload_cbor), "stored vector does not unpack");
+  auto matrix = store.create_object(kAstraMatrixType, ObjectID{}, pack_astra(AstraArray::matrix(3, 4, c)));
+  ck_assert_msg(matrix, "packed matrix refused: %s", result_message(matrix));
+  store.set_object_validator({});
+}
+END_TEST
+
+START_TEST(test_crate_chunked_containers)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  ck_assert_msg(store.ensure_schema(), "ensure_schema failed");
+  SchemaRegistry registry(store);
+  auto boot = bootstrap_core_schema(registry);
+  ck_assert_msg(boot, "bootstrap failed: %s", result_message(boot));
+
+  auto item = [](std::uint64_t v) {
+    referee::CborWriter w;
+    w.uint(v);
+    return w.take();
+  };
+
+  // Arrays: point updates and appends within the last chunk write one chunk only.
+  CrateArray array(4);
+  for (std::uint64_t i = 0; i < 10; ++i) array.push_back(item(i));
+  auto arrayR = CrateStorage::create(registry, store, kCrateListType, array);
+  ck_assert_msg(arrayR, "create failed: %s", result_message(arrayR));
+  auto& array_store = arrayR.value.value();
+  array.set(5, item(50));
+  auto saveR = array_store.save(array);
+  ck_assert_msg(saveR, "save failed: %s", result_message(saveR));
+  ck_assert_uint_eq(saveR.value->chunks_written, 1U);
+  ck_assert_msg(!saveR.value->root_written, "point update rewrote the root");
+  array.push_back(item(10));
+  saveR = array_store.save(array);
+  ck_assert_msg(saveR && saveR.value->chunks_written == 1 && !saveR.value->root_written, "append in last chunk");
+  array.push_back(item(11));
+  array.push_back(item(12));
+  saveR = array_store.save(array);
+  ck_assert_msg(saveR && saveR.value->chunks_written == 2 && saveR.value->root_written, "append into a new chunk");
+
+  CrateArray array_back;
+  auto openR = CrateStorage::open(registry, store, array_store.root().id, array_back);
+  ck_assert_msg(openR, "open failed: %s", result_message(openR));
+  ck_assert_msg(array_back.items() == array.items(), "array changed in the round trip");
+  CrateMap wrong_layout;
+  ck_assert_msg(!CrateStorage::open(registry, store, array_store.root().id, wrong_layout), "opened with another layout");
+  ck_assert_msg(!CrateStorage::create(registry, store, kCrateSetType, array), "array stored as a set");
+
+  // Hash map: growth rehashes, deletes shift entries back, updates touch one chunk.
+  CrateMap map(16);
+  for (std::uint64_t i = 0; i < 200; ++i) map.insert_or_assign(item(i), item(i * 3));
+  for (std::uint64_t i = 0; i < 200; i += 7) ck_assert_msg(map.erase(item(i)), "erase %llu", (unsigned long long)i);
+  ck_assert_uint_eq(map.size(), 200U - 29U);
+  for (std::uint64_t i = 0; i < 200; ++i) {
+    const auto* v = map.find(item(i));
+    ck_assert_msg((v != nullptr) == (i % 7 != 0), "lookup %llu after erase", (unsigned long long)i);
+    if (v) ck_assert_msg(*v == item(i * 3), "value %llu", (unsigned long long)i);
+  }
+  auto mapR = CrateStorage::create(registry, store, kCrateMapType, map);
+  ck_assert_msg(mapR, "create failed: %s", result_message(mapR));
+  map.insert_or_assign(item(1), item(1000));
+  saveR = mapR.value->save(map);
+  ck_assert_msg(saveR && saveR.value->chunks_written == 1 && !saveR.value->root_written, "map point update");
+  CrateMap map_back;
+  openR = CrateStorage::open(registry, store, mapR.value->root().id, map_back);
+  ck_assert_msg(openR, "open failed: %s", result_message(openR));
+  ck_assert_uint_eq(map_back.size(), map.size());
+  map.for_each([&](const CrateItem& k, const CrateItem& v) {
+    const auto* found = map_back.find(k);
+    ck_assert_msg(found && *found == v, "map entry lost in the round trip");
+  });
+
+  CrateSet set;
+  for (std::uint64_t i = 0; i < 50; ++i) set.insert(item(i % 20));
+  ck_assert_uint_eq(set.size(), 20U);
+  ck_assert_msg(set.erase(item(3)) && !set.contains(item(3)) && set.contains(item(4)), "set erase");
+
+  // Ordered map: leaves split as they fill and keep their keys sorted.
+  CrateBTreeMap tree(8);
+  for (std::uint64_t i = 0; i < 100; ++i) tree.insert_or_assign(item((i * 37) % 100), item(i));
+  ck_assert_uint_eq(tree.size(), 100U);
+  ck_assert_msg(tree.leaves() > 12, "leaves did not split");
+  CrateItem last;
+  tree.for_each([&](const CrateItem& k, const CrateItem&) {
+    ck_assert_msg(last.empty() || last < k, "keys out of order");
+    last = k;
+  });
+  auto treeR = CrateStorage::create(registry, store, kCrateMapType, tree);
+  ck_assert_msg(treeR, "create failed: %s", result_message(treeR));
+  tree.insert_or_assign(item(42), item(4242));
+  saveR = treeR.value->save(tree);
+  ck_assert_msg(saveR && saveR.value->chunks_written == 1 && !saveR.value->root_written, "tree point update");
+  for (std::uint64_t i = 0; i < 100; i += 2) tree.erase(item(i));
+  saveR = treeR.value->save(tree);
+  ck_assert_msg(saveR, "save failed: %s", result_message(saveR));
+  CrateBTreeMap tree_back;
+  openR = CrateStorage::open(registry, store, treeR.value->root().id, tree_back);
+  ck_assert_msg(openR, "open failed: %s", result_message(openR));
+  ck_assert_uint_eq(tree_back.size(), 50U);
+  ck_assert_msg(tree_back.find(item(42)) == nullptr, "erased key came back");
+  const auto* v43 = tree_back.find(item(43));
+  ck_assert_msg(v43 && *v43 == item((43 * 73) % 100), "value for 43");
+}
+END_TEST
+
 START_TEST(test_bootstrap_kernel_io_ops)
 {
   SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
@@ -342,10 +648,14 @@ Suite* refract_bootstrap_suite(void) {
 
   tcase_add_test(tc, test_bootstrap_idempotent);
   tcase_add_test(tc, test_bootstrap_crate_collections);
+  tcase_add_test(tc, test_bootstrap_schema_image);
   tcase_add_test(tc, test_bootstrap_core_ops_on_primitives);
   tcase_add_test(tc, test_bootstrap_conch_types);
   tcase_add_test(tc, test_bootstrap_astra_math_types);
   tcase_add_test(tc, test_bootstrap_caliper_units);
+  tcase_add_test(tc, test_unit_converter_catalog);
+  tcase_add_test(tc, test_astra_packed_kernels);
+  tcase_add_test(tc, test_crate_chunked_containers);
   tcase_add_test(tc, test_bootstrap_kernel_io_ops);
 
   suite_add_tcase(s, tc);
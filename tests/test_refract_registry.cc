@@ -6,13 +6,29 @@ extern "C" {
 #endif
 
 #include "refract/bootstrap.h"
+#include "refract/capability_policy.h"
+#include "refract/definition_codec.h"
 #include "refract/dispatch.h"
+#include "refract/migrating_reader.h"
+#include "refract/migration_runner.h"
 #include "refract/operation_registry.h"
+#include "refract/packet_codec.h"
+#include "refract/payload_codec.h"
+#include "refract/payload_validator.h"
 #include "refract/schema_registry.h"
+#include "referee/cbor_path.h"
+#include "referee/cbor_writer.h"
 #include "referee/referee.h"
 #include "referee_sqlite/sqlite_store.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 using namespace referee;
 using namespace iris::refract;
@@ -96,6 +112,203 @@ START_TEST(test_schema_registry_roundtrip)
 }
 END_TEST
 
+START_TEST(test_schema_registry_definition_cache_coherence)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+
+  SchemaRegistry writer(store);
+  SchemaRegistry reader(store);
+
+  auto v1 = make_definition(TypeID{0xC3ULL}, "Sprocket", "Demo");
+  auto regV1 = writer.register_definition(v1);
+  ck_assert_msg(regV1, "register v1 failed: %s", result_message(regV1));
+
+  auto latest = reader.get_latest_definition_by_type(v1.type_id);
+  ck_assert_msg(latest && latest.value->has_value(), "expected v1");
+  ck_assert_uint_eq(latest.value->value().definition.version, 1U);
+
+  // Written through another registry: the reader's cache must notice.
+  auto v2 = v1;
+  v2.version = 2;
+  v2.supersedes_definition_id = regV1.value->ref.id;
+  auto regV2 = writer.register_definition(v2);
+  ck_assert_msg(regV2, "register v2 failed: %s", result_message(regV2));
+  latest = reader.get_latest_definition_by_type(v1.type_id);
+  ck_assert_msg(latest && latest.value->has_value(), "expected v2");
+  ck_assert_uint_eq(latest.value->value().definition.version, 2U);
+  auto first = reader.get_definition_by_type(v1.type_id);
+  ck_assert_msg(first && first.value->has_value(), "expected first definition");
+  ck_assert_uint_eq(first.value->value().definition.version, 1U);
+
+  // Uncommitted definitions are visible until rolled back.
+  ck_assert_msg(store.begin(), "begin failed");
+  auto regTmp = writer.register_definition(make_definition(TypeID{0xD4ULL}, "Cog", "Demo"));
+  ck_assert_msg(regTmp, "register in txn failed: %s", result_message(regTmp));
+  auto tmp = reader.get_definition_by_type(TypeID{0xD4ULL});
+  ck_assert_msg(tmp && tmp.value->has_value(), "expected pending definition");
+  ck_assert_msg(store.rollback(), "rollback failed");
+  tmp = reader.get_definition_by_type(TypeID{0xD4ULL});
+  ck_assert_msg(tmp && !tmp.value->has_value(), "rolled back definition still cached");
+  auto byId = reader.get_definition_by_id(regTmp.value->ref.id);
+  ck_assert_msg(byId && !byId.value->has_value(), "rolled back definition found by id");
+
+  auto listR = reader.list_types();
+  ck_assert_msg(listR, "list_types failed: %s", result_message(listR));
+  ck_assert_int_eq((int)listR.value->size(), 2);
+}
+END_TEST
+
+START_TEST(test_definition_binary_layout)
+{
+  auto def = make_definition(TypeID{0xC1ULL}, "Sensor", "Demo");
+  def.kind = "record";
+  def.preferred_renderer = "table";
+  def.type_params.push_back("T");
+  def.fields[0].default_json = "\"unnamed\"";
+  def.operations[0].required_capabilities.push_back("read");
+  def.operations.push_back(OperationDefinition{ "create", OperationScope::Class, {}, {} });
+  def.packet_byte_order = "le";
+  def.packet_fields.push_back(PacketFieldDefinition{ "flags", TypeID{0x1002ULL}, 4 });
+  def.collection_kind = "list";
+  def.collection_elements.push_back(CollectionElementDefinition{ "item", TypeID{0x1001ULL} });
+
+  auto bytes = encode_definition_binary(def);
+  ck_assert_msg(is_binary_definition(bytes.data(), bytes.size()), "missing magic");
+
+  auto viewR = DefinitionView::open(bytes.data(), bytes.size());
+  ck_assert_msg(viewR, "open failed: %s", result_message(viewR));
+  const auto& view = viewR.value.value();
+  ck_assert_uint_eq(view.type_id().v, 0xC1ULL);
+  ck_assert_msg(view.name() == "Sensor" && view.namespace_name() == "Demo", "names differ");
+  ck_assert_msg(view.kind() && *view.kind() == "record", "kind differs");
+  ck_assert_int_eq((int)view.field_count(), 1);
+  ck_assert_msg(view.field(0).default_json && *view.field(0).default_json == "\"unnamed\"",
+                "field default differs");
+  ck_assert_int_eq((int)view.operation_count(), 2);
+  auto lookup = view.find_operation("lookup", OperationScope::Object);
+  ck_assert_msg(lookup.has_value(), "lookup operation missing");
+  ck_assert_int_eq((int)lookup->param_count(), 1);
+  ck_assert_msg(lookup->param(0).name == "id" && lookup->param(0).type.v == 0x1002ULL,
+                "lookup param differs");
+  ck_assert_msg(lookup->output(0).name == "result", "lookup output differs");
+  ck_assert_msg(lookup->capability(0) == "read", "lookup capability differs");
+  ck_assert_msg(!view.find_operation("lookup", OperationScope::Class), "scope ignored");
+  ck_assert_msg(view.relationship(0).target == "Container", "relationship differs");
+
+  // Materializing and exporting gives the same JSON as the original definition.
+  ck_assert_str_eq(definition_to_json(view.materialize()).c_str(), definition_to_json(def).c_str());
+
+  for (std::size_t cut : { std::size_t{0}, std::size_t{8}, bytes.size() - 1 }) {
+    ck_assert_msg(!DefinitionView::open(bytes.data(), cut), "truncated payload accepted");
+  }
+  auto corrupt = bytes;
+  corrupt[88] = 0xFF; // fields table offset
+  ck_assert_msg(!DefinitionView::open(corrupt.data(), corrupt.size()), "bad table accepted");
+
+  // Stores written before the binary layout hold CBOR definitions; they still load.
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  ck_assert_msg(store.ensure_schema(), "ensure_schema failed");
+  auto legacy = make_definition(TypeID{0xC2ULL}, "Legacy", "Demo");
+  auto legacyId = ObjectID::random();
+  auto legacyR = store.create_object_with_id(legacyId, kTypeDefinitionType, legacyId,
+                                             definition_to_cbor(legacy));
+  ck_assert_msg(legacyR, "create legacy failed: %s", result_message(legacyR));
+
+  SchemaRegistry registry(store);
+  auto regR = registry.register_definition(def);
+  ck_assert_msg(regR, "register failed: %s", result_message(regR));
+  auto storedR = store.get_latest(regR.value->ref.id);
+  ck_assert_msg(storedR && storedR.value->has_value(), "stored definition missing");
+  const auto& payload = storedR.value->value().payload_cbor;
+  ck_assert_msg(is_binary_definition(payload.data(), payload.size()), "stored payload not binary");
+
+  auto legacyBack = registry.get_definition_by_type(legacy.type_id);
+  ck_assert_msg(legacyBack && legacyBack.value->has_value(), "legacy definition missing");
+  ck_assert_str_eq(legacyBack.value->value().definition.name.c_str(), "Legacy");
+  auto decodedR = decode_definition_payload(definition_to_cbor(legacy));
+  ck_assert_msg(decodedR, "decode legacy failed: %s", result_message(decodedR));
+  ck_assert_str_eq(definition_to_json(decodedR.value.value()).c_str(),
+                   definition_to_json(legacy).c_str());
+}
+END_TEST
+
+START_TEST(test_schema_registry_type_name_index)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+
+  SchemaRegistry registry(store);
+  auto regWidget = registry.register_definition(make_definition(TypeID{0xA1ULL}, "Widget", "Demo"));
+  ck_assert_msg(regWidget, "register Widget failed: %s", result_message(regWidget));
+  ck_assert_msg(registry.register_definition(make_definition(TypeID{0xB2ULL}, "Gadget", "Demo")), "register Gadget failed");
+  ck_assert_msg(registry.register_definition(make_definition(TypeID{0xC3ULL}, "Widget", "Shop")), "register Shop::Widget failed");
+  ck_assert_msg(registry.register_definition(make_definition(TypeID{0xD4ULL}, "Loose", "")), "register Loose failed");
+
+  auto namesR = registry.type_names();
+  ck_assert_msg(namesR, "type_names failed: %s", result_message(namesR));
+  const auto* names = namesR.value.value();
+  ck_assert_uint_eq(names->size(), 4U);
+
+  const auto* widget = names->find("Demo", "Widget");
+  ck_assert_msg(widget != nullptr, "Demo::Widget not found");
+  ck_assert_uint_eq(widget->type_id.v, 0xA1ULL);
+  ck_assert_msg(names->find("Demo", "Loose") == nullptr, "Loose is outside Demo");
+  ck_assert_msg(names->find("", "Loose") != nullptr, "Loose not found");
+
+  ck_assert_uint_eq(names->lookup("Widget").size(), 2U);
+  ck_assert_uint_eq(names->lookup("Shop::Widget").size(), 1U);
+  ck_assert_uint_eq(names->lookup("Gadget").size(), 1U);
+  ck_assert_uint_eq(names->lookup("Demo::Nothing").size(), 0U);
+
+  auto demo = names->with_prefix("Demo::");
+  ck_assert_uint_eq(demo.size(), 2U);
+  ck_assert_uint_eq(demo[0]->type_id.v, 0xA1ULL); // registration order
+  ck_assert_uint_eq(demo[1]->type_id.v, 0xB2ULL);
+
+  ck_assert_uint_eq(names->matching("*::Widget").size(), 2U);
+  ck_assert_uint_eq(names->matching("Demo::?adget").size(), 1U);
+  ck_assert_uint_eq(names->matching("*").size(), 4U);
+  ck_assert_uint_eq(names->matching("Demo::W*t").size(), 1U);
+  ck_assert_uint_eq(names->matching("Demo::W*x").size(), 0U);
+
+  auto namespaces = names->namespaces();
+  ck_assert_uint_eq(namespaces.size(), 2U);
+  ck_assert_str_eq(namespaces[0].c_str(), "Demo");
+  ck_assert_str_eq(namespaces[1].c_str(), "Shop");
+
+  // A superseding definition replaces the entry, renamed or not.
+  auto v2 = make_definition(TypeID{0xA1ULL}, "Gizmo", "Demo");
+  v2.version = 2;
+  v2.supersedes_definition_id = regWidget.value->ref.id;
+  auto regV2 = registry.register_definition(v2);
+  ck_assert_msg(regV2, "register v2 failed: %s", result_message(regV2));
+  namesR = registry.type_names();
+  ck_assert_msg(namesR, "type_names failed: %s", result_message(namesR));
+  names = namesR.value.value();
+  ck_assert_uint_eq(names->size(), 4U);
+  ck_assert_msg(names->find("Demo", "Widget") == nullptr, "old name still indexed");
+  auto gizmo = registry.find_type("Demo", "Gizmo");
+  ck_assert_msg(gizmo && gizmo.value->has_value(), "Demo::Gizmo not found");
+  ck_assert_msg(gizmo.value->value().definition_id == regV2.value->ref.id, "expected latest definition");
+  ck_assert_uint_eq(names->lookup("Widget").size(), 1U);
+
+  // Rolled back definitions drop out with the rest of the cache.
+  ck_assert_msg(store.begin(), "begin failed");
+  ck_assert_msg(registry.register_definition(make_definition(TypeID{0xE5ULL}, "Temp", "Demo")), "register Temp failed");
+  auto temp = registry.find_type("Demo", "Temp");
+  ck_assert_msg(temp && temp.value->has_value(), "pending definition not indexed");
+  ck_assert_msg(store.rollback(), "rollback failed");
+  temp = registry.find_type("Demo", "Temp");
+  ck_assert_msg(temp && !temp.value->has_value(), "rolled back definition still indexed");
+
+  ck_assert_msg(glob_match("Conch::IoHandleAlias", "Conch::*Alias"), "glob * failed");
+  ck_assert_msg(glob_match("abcbd", "a*b?"), "glob backtracking failed");
+  ck_assert_msg(!glob_match("abc", "a?"), "glob ? matched two characters");
+}
+END_TEST
+
 START_TEST(test_schema_registry_supersedes_chain)
 {
   SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
@@ -131,6 +344,185 @@ START_TEST(test_schema_registry_supersedes_chain)
 }
 END_TEST
 
+START_TEST(test_migration_runner_resumes)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+
+  auto v1 = make_definition(TypeID{0xA7ULL}, "Gauge", "Demo");
+  auto reg1 = registry.register_definition(v1);
+  ck_assert_msg(reg1, "register v1 failed: %s", result_message(reg1));
+  auto v2 = v1;
+  v2.version = 2;
+  v2.supersedes_definition_id = reg1.value->ref.id;
+  v2.migration_hook = "add_unit";
+  auto reg2 = registry.register_definition(v2);
+  ck_assert_msg(reg2, "register v2 failed: %s", result_message(reg2));
+  auto v3 = v2;
+  v3.version = 3;
+  v3.supersedes_definition_id = reg2.value->ref.id;
+  v3.migration_hook.reset();
+  auto reg3 = registry.register_definition(v3);
+  ck_assert_msg(reg3, "register v3 failed: %s", result_message(reg3));
+
+  std::vector<ObjectRef> old_refs;
+  for (int i = 0; i < 250; ++i) {
+    auto r = store.create_object(v1.type_id, reg1.value->ref.id,
+                                 cbor_from_json_string("{\"n\":" + std::to_string(i) + "}"));
+    ck_assert_msg(r, "create failed: %s", result_message(r));
+    old_refs.push_back(r.value->ref);
+  }
+  auto mid = store.create_object(v1.type_id, reg2.value->ref.id, cbor_from_json_string("{\"n\":7}"));
+  ck_assert_msg(mid, "create failed: %s", result_message(mid));
+
+  MigrationRunner runner(registry, store);
+  ck_assert_msg(!runner.run(reg3.value->ref.id), "the v1 -> v2 hook is not registered yet");
+  runner.register_hook("add_unit", [](const Bytes& payload) {
+    auto n = cbor_uint(*cbor_find(payload, { "n" }));
+    CborWriter out;
+    out.map(2);
+    out.text("n");
+    out.uint(*n);
+    out.text("unit");
+    out.text("kPa");
+    return Result<Bytes>::ok(out.take());
+  });
+
+  std::vector<std::uint64_t> positions;
+  runner.on_progress([&](const MigrationProgress& p) {
+    positions.push_back(p.position);
+    if (positions.size() == 2) runner.request_stop();
+  });
+  MigrationOptions options;
+  options.batch_size = 100;
+  options.workers = 3;
+  auto firstR = runner.run(reg3.value->ref.id, options);
+  ck_assert_msg(firstR, "run failed: %s", result_message(firstR));
+  ck_assert_msg(firstR.value->stopped, "expected the run to stop early");
+  ck_assert_uint_eq(firstR.value->position, 200U);
+  ck_assert_uint_eq(firstR.value->migrated, 200U);
+  ck_assert_uint_eq(positions.size(), 2U);
+
+  options.start = firstR.value->position;
+  auto restR = runner.run(reg3.value->ref.id, options);
+  ck_assert_msg(restR, "resume failed: %s", result_message(restR));
+  ck_assert_msg(!restR.value->stopped, "resume should run to the end");
+  ck_assert_uint_eq(restR.value->total, 451U); // includes the 200 new versions
+  ck_assert_uint_eq(restR.value->migrated, 51U);
+  ck_assert_uint_eq(positions.back(), 451U);
+
+  auto latestR = store.get_latest(old_refs[42].id);
+  ck_assert_msg(latestR && latestR.value->has_value(), "expected latest version");
+  const auto& latest = latestR.value->value();
+  ck_assert_uint_eq(latest.ref.ver.v, 2U);
+  ck_assert_msg(latest.definition_id == reg3.value->ref.id, "expected the v3 definition");
+  ck_assert_uint_eq(*cbor_uint(*cbor_find(latest.payload_cbor, { "n" })), 42U);
+  ck_assert_str_eq(std::string(*cbor_find_text(latest.payload_cbor, { "unit" })).c_str(), "kPa");
+  // v2 -> v3 has no hook: the payload carries over.
+  auto midR = store.get_latest(mid.value->ref.id);
+  ck_assert_msg(!cbor_find(midR.value->value().payload_cbor, { "unit" }), "v2 object gained a unit");
+  ck_assert_msg(!store.create_version(old_refs[0], reg3.value->ref.id, Bytes{}), "stale version accepted");
+
+  // Everything is current: a rerun from the start only skips.
+  options.start = 0;
+  auto againR = runner.run(reg3.value->ref.id, options);
+  ck_assert_msg(againR, "rerun failed: %s", result_message(againR));
+  ck_assert_uint_eq(againR.value->migrated, 0U);
+  ck_assert_uint_eq(againR.value->skipped, 502U);
+
+  // request_stop() cuts a throttle wait short instead of waiting out the rate.
+  for (int i = 0; i < 5; ++i) {
+    ck_assert_msg(store.create_object(v1.type_id, reg1.value->ref.id, cbor_from_json_string("{\"n\":1}")),
+                  "create failed");
+  }
+  runner.on_progress({});
+  options.start = 502;
+  options.batch_size = 4; // the first batch owes a 4 s wait
+  options.max_per_second = 1;
+  const auto started = std::chrono::steady_clock::now();
+  std::thread stopper([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    runner.request_stop();
+  });
+  auto throttledR = runner.run(reg3.value->ref.id, options);
+  stopper.join();
+  ck_assert_msg(throttledR, "throttled run failed: %s", result_message(throttledR));
+  ck_assert_msg(throttledR.value->stopped, "expected the throttled run to stop");
+  ck_assert_uint_eq(throttledR.value->migrated, 4U);
+  ck_assert_msg(std::chrono::steady_clock::now() - started < std::chrono::seconds(2),
+                "request_stop() waited out the throttle");
+}
+END_TEST
+
+START_TEST(test_migrating_reader_upgrades_on_read)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+
+  auto v1 = make_definition(TypeID{0xA8ULL}, "Meter", "Demo");
+  auto reg1 = registry.register_definition(v1);
+  ck_assert_msg(reg1, "register v1 failed: %s", result_message(reg1));
+  auto old = store.create_object(v1.type_id, reg1.value->ref.id, cbor_from_json_string("{\"n\":5}"));
+  ck_assert_msg(old, "create failed: %s", result_message(old));
+  auto v2 = v1;
+  v2.version = 2;
+  v2.supersedes_definition_id = reg1.value->ref.id;
+  v2.migration_hook = "double_n";
+  auto reg2 = registry.register_definition(v2);
+  ck_assert_msg(reg2, "register v2 failed: %s", result_message(reg2));
+  auto fresh = store.create_object(v1.type_id, reg2.value->ref.id, cbor_from_json_string("{\"n\":1}"));
+  ck_assert_msg(fresh, "create failed: %s", result_message(fresh));
+
+  MigratingReader reader(registry, store);
+  ck_assert_msg(!reader.get_latest(old.value->ref.id), "the hook is not registered yet");
+  // Only objects that need the missing hook fail; current ones read unchanged.
+  auto currentR = reader.get_latest(fresh.value->ref.id);
+  ck_assert_msg(currentR && currentR.value->has_value(), "read failed: %s", result_message(currentR));
+  ck_assert_msg(currentR.value->value().payload_cbor == fresh.value->payload_cbor, "expected the stored payload");
+  int calls = 0;
+  reader.register_hook("double_n", [&](const Bytes& payload) {
+    ++calls;
+    CborWriter out;
+    out.map(1);
+    out.text("n");
+    out.uint(*cbor_uint(*cbor_find(payload, { "n" })) * 2);
+    return Result<Bytes>::ok(out.take());
+  });
+  reader.set_write_back(true);
+
+  for (int i = 0; i < 3; ++i) {
+    auto readR = reader.get_latest(old.value->ref.id);
+    ck_assert_msg(readR && readR.value->has_value(), "read failed: %s", result_message(readR));
+    const auto& rec = readR.value->value();
+    ck_assert_uint_eq(*cbor_uint(*cbor_find(rec.payload_cbor, { "n" })), 10U);
+    ck_assert_msg(rec.definition_id == reg2.value->ref.id, "expected the upgraded definition");
+    ck_assert_uint_eq(rec.ref.ver.v, 1U);
+  }
+  ck_assert_int_eq(calls, 1);
+  auto freshR = reader.get_latest(fresh.value->ref.id);
+  ck_assert_uint_eq(*cbor_uint(*cbor_find(freshR.value->value().payload_cbor, { "n" })), 1U);
+  auto stats = reader.stats();
+  ck_assert_uint_eq(stats.upgrades, 1U);
+  ck_assert_uint_eq(stats.cached, 2U);
+  ck_assert_uint_eq(stats.current, 2U);
+
+  // Write-back stores the upgrade; later reads are current and skip the hook.
+  ck_assert_uint_eq(reader.pending_write_back(), 1U);
+  auto wroteR = reader.write_back();
+  ck_assert_msg(wroteR, "write_back failed: %s", result_message(wroteR));
+  ck_assert_uint_eq(wroteR.value.value(), 1U);
+  auto storedR = store.get_latest(old.value->ref.id);
+  ck_assert_uint_eq(storedR.value->value().ref.ver.v, 2U);
+  ck_assert_uint_eq(*cbor_uint(*cbor_find(storedR.value->value().payload_cbor, { "n" })), 10U);
+  ck_assert_msg(reader.get_latest(old.value->ref.id), "read after write-back failed");
+  ck_assert_int_eq(calls, 1);
+  ck_assert_uint_eq(reader.stats().current, 3U);
+  ck_assert_uint_eq(reader.stats().entries, 0U);
+}
+END_TEST
+
 START_TEST(test_schema_registry_structured_metadata_roundtrip)
 {
   SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
@@ -287,6 +679,326 @@ START_TEST(test_generic_instance_registry_roundtrip)
 }
 END_TEST
 
+START_TEST(test_generic_instance_hash_consing)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  ck_assert_msg(store.ensure_schema(), "ensure_schema failed");
+
+  SchemaRegistry registry(store);
+  auto boot = bootstrap_core_schema(registry);
+  ck_assert_msg(boot, "bootstrap failed: %s", result_message(boot));
+
+  GenericInstance instance{};
+  instance.base_type = TypeID{0x4352415400000001ULL};
+  instance.args.push_back(GenericArg{ GenericArgKind::Value, {}, TypeID{0x1002ULL}, "4", {} });
+
+  // The derived id is the FNV-1a hash of the canonical key, computed without it.
+  auto keyR = encode_generic_instance_key(instance);
+  ck_assert_msg(keyR, "encode key failed: %s", result_message(keyR));
+  std::uint64_t expected = 14695981039346656037ULL;
+  for (unsigned char c : keyR.value.value()) {
+    expected ^= c;
+    expected *= 1099511628211ULL;
+  }
+  auto typeR = derive_generic_type_id(instance);
+  ck_assert_msg(typeR, "derive type id failed: %s", result_message(typeR));
+  ck_assert_uint_eq(typeR.value->v, expected);
+
+  GenericRegistry generics(registry, store);
+  auto firstR = generics.register_instance(instance);
+  ck_assert_msg(firstR, "register failed: %s", result_message(firstR));
+
+  GenericInstance respelled = instance;
+  respelled.args[0].value_json = " 4 ";
+  auto againR = generics.register_instance(respelled);
+  ck_assert_msg(againR, "register again failed: %s", result_message(againR));
+  ck_assert_msg(againR.value->ref == firstR.value->ref, "identical instance not shared");
+
+  auto listR = store.list_by_type(kTypeGenericInstanceType);
+  ck_assert_msg(listR, "list failed: %s", result_message(listR));
+  ck_assert_int_eq((int)listR.value->size(), 1);
+
+  // A second registry over the same store indexes what the first one wrote.
+  GenericRegistry other(registry, store);
+  auto otherR = other.register_instance(instance);
+  ck_assert_msg(otherR, "register via other failed: %s", result_message(otherR));
+  ck_assert_msg(otherR.value->ref == firstR.value->ref, "other registry duplicated instance");
+
+  ScopedTypeRegistry scope(ScopedTypeRegistry::Scope::Application, generics);
+  std::vector<TypeID> types;
+  for (std::uint64_t i = 0; i < 100; ++i) {
+    GenericInstance item{};
+    item.base_type = TypeID{0x4352415400000001ULL};
+    item.args.push_back(GenericArg{ GenericArgKind::Type, TypeID{0x2000ULL + i}, {}, "", {} });
+    auto regR = scope.resolve_or_register(item, ScopedTypeRegistry::PromotionPolicy::LocalOnly);
+    ck_assert_msg(regR, "resolve_or_register failed: %s", result_message(regR));
+    types.push_back(regR.value->instance.instance_type);
+  }
+  for (auto type : types) {
+    ck_assert_msg(scope.find_local(type).has_value(), "scope lost an instance");
+  }
+  ck_assert_msg(!scope.find_local(typeR.value.value()).has_value(), "unexpected local instance");
+  auto foundR = scope.find(typeR.value.value());
+  ck_assert_msg(foundR && foundR.value->has_value(), "registry lookup failed");
+}
+END_TEST
+
+START_TEST(test_payload_codec_compiled)
+{
+  auto def = make_definition(TypeID{0xE1ULL}, "Gauge", "Demo");
+  def.fields.push_back(FieldDefinition{ "scale", TypeID{0x1008ULL}, false, std::nullopt });
+  def.fields.push_back(FieldDefinition{ "count", TypeID{0x1002ULL}, true, std::nullopt });
+  def.fields.push_back(FieldDefinition{ "owner", TypeID{0x1004ULL}, false, std::nullopt });
+  def.fields.push_back(FieldDefinition{ "layout", TypeID{0x1007ULL}, false, std::nullopt });
+  auto codec = PayloadCodec::compile(def);
+  ck_assert_int_eq((int)codec.fields().size(), 5);
+  ck_assert_str_eq(codec.fields()[0].name.c_str(), "count");
+
+  const auto owner = ObjectID::from_hex("00112233445566778899aabbccddeeff");
+  auto encoded = codec.encoder()
+                     .parse("scale", "2.5")
+                     .set_text("display_name", "Pressure")
+                     .set_object_id("owner", owner)
+                     .set_encoded("layout", cbor_from_json_string(R"([1,{"w":2}])"))
+                     .parse("zeta", "true")
+                     .set_uint("count", 3)
+                     .finish();
+  ck_assert_msg(!encoded.error, "encode failed: %s", result_message(encoded));
+  auto expected = cbor_from_json_string(
+      R"({"count":3,"display_name":"Pressure","layout":[1,{"w":2}],)"
+      R"("owner":"00112233445566778899aabbccddeeff","scale":2.5,"zeta":true})");
+  ck_assert_msg(encoded.value.value() == expected, "codec output differs from the DOM encoding");
+
+  auto decoded = codec.decode(encoded.value.value());
+  ck_assert_msg(!decoded.error, "decode failed: %s", result_message(decoded));
+  const auto& fields = decoded.value.value();
+  ck_assert_int_eq((int)fields.uint(*codec.field_index("count")).value_or(0), 3);
+  ck_assert(fields.number(*codec.field_index("scale")).value_or(0) == 2.5);
+  ck_assert(fields.object_id(*codec.field_index("owner")) == owner);
+  ck_assert(fields.text(*codec.field_index("display_name")) == std::optional<std::string_view>("Pressure"));
+
+  auto wrong = codec.encoder().set_text("display_name", "x").set_text("count", "three").finish();
+  ck_assert_msg(wrong.error.has_value(), "text accepted for a U64 field");
+  auto unparsable = codec.encoder().set_text("display_name", "x").parse("count", "three").finish();
+  ck_assert_msg(unparsable.error.has_value(), "'three' parsed as U64");
+  for (const char* text : { " 3", "+3", "-3", "0x0x3", "0x", "18446744073709551616" }) {
+    auto strict = codec.encoder().set_text("display_name", "x").parse("count", text).finish();
+    ck_assert_msg(strict.error.has_value(), "'%s' parsed as U64", text);
+  }
+  auto hex = codec.encoder().set_text("display_name", "x").parse("count", "0x1F").finish();
+  ck_assert_msg(!hex.error, "hex U64 rejected: %s", result_message(hex));
+  // Untyped fields fall back to text when the integer is malformed or out of range.
+  auto untyped = codec.encoder()
+                     .set_uint("count", 1)
+                     .set_text("display_name", "x")
+                     .parse("big", "99999999999999999999")
+                     .parse("neg", "-7")
+                     .parse("spaced", " 7")
+                     .finish();
+  ck_assert_msg(!untyped.error, "encode failed: %s", result_message(untyped));
+  ck_assert_msg(untyped.value.value()
+                    == cbor_from_json_string(
+                        R"({"big":"99999999999999999999","count":1,"display_name":"x","neg":-7,"spaced":" 7"})"),
+                "untyped fields parsed loosely");
+  auto missing = codec.encoder().set_uint("count", 1).finish();
+  ck_assert_msg(missing.error.has_value(), "missing required field not reported");
+  ck_assert_msg(missing.error->message.find("display_name") != std::string::npos, "%s", missing.error->message.c_str());
+
+  auto bad = codec.decode(cbor_from_json_string(R"({"count":"3","display_name":"x"})"));
+  ck_assert_msg(bad.error.has_value(), "decode accepted text for a U64 field");
+  auto absent = codec.decode(cbor_from_json_string(R"({"count":3})"));
+  ck_assert_msg(absent.error.has_value(), "decode accepted a missing required field");
+}
+END_TEST
+
+struct Reading {
+  std::string label;
+  std::uint64_t samples{0};
+  std::vector<double> values;
+  std::optional<ObjectID> source;
+};
+
+START_TEST(test_payload_native_members)
+{
+  const auto members = std::make_tuple(payload_member("label", &Reading::label, true),
+                                       payload_member("samples", &Reading::samples, true),
+                                       payload_member("source", &Reading::source),
+                                       payload_member("values", &Reading::values));
+  auto encode = [&](const Reading& r) {
+    return std::apply([&](const auto&... m) { return encode_payload(r, m...); }, members);
+  };
+  auto decode = [&](const Bytes& b) {
+    return std::apply([&](const auto&... m) { return decode_payload<Reading>(b, m...); }, members);
+  };
+
+  Reading in{ "probe", 2, { 0.5, 1.25 }, std::nullopt };
+  auto bytes = encode(in);
+  ck_assert_msg(bytes == cbor_from_json_string(R"({"label":"probe","samples":2,"values":[0.5,1.25]})"),
+                "native encoding differs from the DOM encoding");
+  auto out = decode(bytes);
+  ck_assert_msg(!out.error, "decode failed: %s", result_message(out));
+  ck_assert_str_eq(out.value->label.c_str(), "probe");
+  ck_assert_int_eq((int)out.value->samples, 2);
+  ck_assert_int_eq((int)out.value->values.size(), 2);
+  ck_assert_msg(!out.value->source.has_value(), "absent optional decoded as present");
+
+  in.source = ObjectID::from_hex("ffeeddccbbaa99887766554433221100");
+  auto with_source = decode(encode(in));
+  ck_assert_msg(with_source.value->source == in.source, "optional id lost");
+
+  ck_assert_msg(decode(cbor_from_json_string(R"({"label":"x"})")).error.has_value(),
+                "missing required member not reported");
+  ck_assert_msg(decode(cbor_from_json_string(R"({"label":"x","samples":-1})")).error.has_value(),
+                "negative value accepted for an unsigned member");
+}
+END_TEST
+
+START_TEST(test_payload_validator_store_hook)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+  PayloadValidator validator(registry);
+  validator.install(store);
+
+  TypeDefinition mode{};
+  mode.type_id = TypeID{0xE10ULL};
+  mode.name = "Mode";
+  mode.namespace_name = "Demo";
+  mode.has_enum_value_type = true;
+  mode.enum_value_type = TypeID{0x1002ULL};
+  mode.enum_values = { EnumValueDefinition{ "Off", "0" }, EnumValueDefinition{ "On", "1" } };
+  TypeDefinition tags{};
+  tags.type_id = TypeID{0xE11ULL};
+  tags.name = "Tags";
+  tags.namespace_name = "Demo";
+  tags.collection_kind = "list";
+  tags.collection_elements.push_back(CollectionElementDefinition{ "item", TypeID{0x1001ULL} });
+  ck_assert(registry.register_definition(mode));
+  ck_assert(registry.register_definition(tags));
+
+  auto sensor = make_definition(TypeID{0xE12ULL}, "Sensor", "Demo");
+  sensor.fields.push_back(FieldDefinition{ "rate", TypeID{0x1008ULL}, true, std::string("1.0") });
+  sensor.fields.push_back(FieldDefinition{ "mode", mode.type_id, false, std::nullopt });
+  sensor.fields.push_back(FieldDefinition{ "tags", tags.type_id, false, std::nullopt });
+  auto reg = registry.register_definition(sensor);
+  ck_assert_msg(reg, "register failed: %s", result_message(reg));
+  const auto def_id = reg.value->ref.id;
+
+  auto create = [&](const char* json, ObjectID definition_id) {
+    return store.create_object(sensor.type_id, definition_id, cbor_from_json_string(json));
+  };
+  auto create_with_payload = [&](const Bytes& payload) {
+    return store.create_object(sensor.type_id, def_id, payload);
+  };
+  auto ok = create(R"({"display_name":"a","mode":"On","tags":["x","y"]})", def_id);
+  ck_assert_msg(ok, "valid payload refused: %s", result_message(ok));
+  ck_assert_msg(create(R"({"display_name":"b","mode":0,"rate":2.5})", def_id), "enum value refused");
+  ck_assert_msg(create(R"({"display_name":"c"})", ObjectID{}), "null definition id not resolved by type");
+  ck_assert_int_eq((int)validator.programs_compiled(), 1);
+
+  // The codec agrees: "rate" is required but has a default, so it may be left out.
+  auto codec = PayloadCodec::compile(sensor);
+  auto encoded = codec.encoder().set_text("display_name", "e").finish();
+  ck_assert_msg(!encoded.error, "defaulted required field demanded: %s", result_message(encoded));
+  ck_assert_msg(create_with_payload(encoded.value.value()), "codec output refused by the validator");
+  ck_assert_msg(!codec.decode(encoded.value.value()).error, "decode demanded a defaulted field");
+
+  auto missing = create(R"({"rate":1})", def_id);
+  ck_assert_msg(!missing && missing.error->message.find("display_name") != std::string::npos,
+                "missing required field accepted");
+  ck_assert_msg(!create(R"({"display_name":"d","mode":2})", def_id), "non-member enum value accepted");
+  ck_assert_msg(!create(R"({"display_name":"d","tags":[1]})", def_id), "wrong collection item accepted");
+  ck_assert_msg(!create(R"({"display_name":"d","tags":{"x":1}})", def_id), "map accepted for a list");
+  ck_assert_msg(!create(R"({"display_name":"d","rate":"fast"})", def_id), "text accepted for F64");
+  ck_assert_msg(!create(R"(["display_name"])", def_id), "array payload accepted");
+  auto mismatch = store.create_object(TypeID{0xE13ULL}, def_id, cbor_from_json_string(R"({})"));
+  ck_assert_msg(!mismatch, "definition of another type accepted");
+
+  // Undefined types pass; a new definition recompiles on next use.
+  ck_assert_msg(store.create_object(TypeID{0xE14ULL}, ObjectID{}, cbor_from_json_string("[1]")),
+                "undefined type refused");
+  auto gauge = make_definition(TypeID{0xE15ULL}, "Gauge", "Demo");
+  ck_assert(registry.register_definition(gauge));
+  ck_assert_msg(create(R"({"display_name":"e"})", def_id), "valid payload refused after new definition");
+  ck_assert_int_eq((int)validator.programs_compiled(), 2);
+
+  store.set_object_validator({});
+  ck_assert_msg(create(R"({"rate":"fast"})", def_id), "validator still installed");
+}
+END_TEST
+
+static TypeDefinition make_packet(std::string order, std::vector<std::uint32_t> widths) {
+  TypeDefinition def = make_definition(TypeID{0xF1ULL}, "Frame", "Demo");
+  def.packet_byte_order = std::move(order);
+  for (std::size_t i = 0; i < widths.size(); ++i) {
+    def.packet_fields.push_back(PacketFieldDefinition{ "f" + std::to_string(i), TypeID{0x1002ULL}, widths[i] });
+  }
+  return def;
+}
+
+// Batch output must match packet-at-a-time output, including the scalar tail.
+static void check_packet_roundtrip(const PacketCodec& codec, std::size_t count) {
+  const std::size_t nf = codec.fields().size();
+  std::vector<std::uint64_t> columns(nf * count);
+  for (std::size_t f = 0; f < nf; ++f) {
+    for (std::size_t i = 0; i < count; ++i) {
+      columns[f * count + i] = (0x9E3779B97F4A7C15ULL * (i + 1) + f * 0x1234567ULL) & codec.fields()[f].mask;
+    }
+  }
+  std::vector<std::uint8_t> packed(count * codec.packet_bytes());
+  auto encoded = codec.encode_batch(columns.data(), count, packed.data());
+  ck_assert_msg(encoded, "encode_batch failed: %s", result_message(encoded));
+
+  std::vector<std::uint64_t> values(nf);
+  std::vector<std::uint8_t> single(codec.packet_bytes());
+  for (std::size_t i = 0; i < count; ++i) {
+    for (std::size_t f = 0; f < nf; ++f) values[f] = columns[f * count + i];
+    ck_assert(codec.encode(values.data(), single.data()));
+    ck_assert_msg(std::equal(single.begin(), single.end(), packed.begin() + i * codec.packet_bytes()),
+                  "batch packet %zu differs from single encode", i);
+    codec.decode(single.data(), values.data());
+    for (std::size_t f = 0; f < nf; ++f) ck_assert(values[f] == columns[f * count + i]);
+  }
+
+  std::vector<std::uint64_t> decoded(nf * count);
+  codec.decode_batch(packed.data(), count, decoded.data());
+  ck_assert_msg(decoded == columns, "decode_batch differs from the encoded columns");
+}
+
+START_TEST(test_packet_codec_layouts)
+{
+  auto be = PacketCodec::compile(make_packet("be", { 3, 5, 16, 8 }));
+  ck_assert_msg(be, "compile failed: %s", result_message(be));
+  ck_assert_int_eq((int)be.value->packet_bytes(), 4);
+  const std::uint64_t header[] = { 5, 0x11, 0x1234, 0xAB };
+  std::uint8_t out[4];
+  ck_assert(be.value->encode(header, out));
+  ck_assert(out[0] == 0xB1 && out[1] == 0x12 && out[2] == 0x34 && out[3] == 0xAB);
+
+  auto le = PacketCodec::compile(make_packet("le", { 3, 5, 16, 8 }));
+  ck_assert(le.value->encode(header, out));
+  ck_assert(out[0] == 0x8D && out[1] == 0x34 && out[2] == 0x12 && out[3] == 0xAB);
+  ck_assert(le.value->field_index("f2") == std::optional<std::size_t>(2));
+
+  for (const char* order : { "be", "le" }) {
+    check_packet_roundtrip(*PacketCodec::compile(make_packet(order, { 3, 5, 16, 8 })).value, 7);
+    check_packet_roundtrip(*PacketCodec::compile(make_packet(order, { 1, 12, 20, 31 })).value, 5);
+    check_packet_roundtrip(*PacketCodec::compile(make_packet(order, { 4, 7 })).value, 3);
+    // 13 bytes: the 64-bit field starts mid-byte and spills past its window.
+    check_packet_roundtrip(*PacketCodec::compile(make_packet(order, { 3, 64, 37 })).value, 6);
+  }
+
+  const std::uint64_t too_wide[] = { 8, 0, 0, 0 };
+  auto range = be.value->encode(too_wide, out);
+  ck_assert_msg(!range && range.error->message.find("f0") != std::string::npos, "out-of-range value accepted");
+  ck_assert_msg(!PacketCodec::compile(make_packet("be", { 0, 8 })), "zero-width field accepted");
+  ck_assert_msg(!PacketCodec::compile(make_packet("middle", { 8 })), "unknown byte order accepted");
+  ck_assert_msg(!PacketCodec::compile(make_definition(TypeID{0xF2ULL}, "Plain", "Demo")), "non-packet type accepted");
+}
+END_TEST
+
 START_TEST(test_scoped_type_registry_promotion)
 {
   SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
@@ -447,6 +1159,284 @@ START_TEST(test_dispatch_resolution)
   ck_assert_msg(ambigR.error.has_value(), "expected error for ambiguous dispatch");
   ck_assert_msg(ambigR.error->message.find("ambiguous") != std::string::npos,
                 "expected ambiguous error, got: %s", ambigR.error->message.c_str());
+
+  // Repeats are served from the resolution cache, errors included.
+  auto before = engine.cache_stats();
+  ck_assert_uint_eq(before.hits, 0U);
+  ck_assert_uint_eq(before.entries, 3U);
+  auto againR = engine.resolve(TypeID{0xC2ULL}, "ping", OperationScope::Object,
+                               { TypeID{0x1001ULL} }, 1, true);
+  ck_assert_msg(againR, "cached dispatch failed: %s", result_message(againR));
+  ck_assert_int_eq(againR.value->owner_type.v, 0xC2ULL);
+  ambigR = engine.resolve(TypeID{0xD1ULL}, "op", OperationScope::Object, {}, 1, false);
+  ck_assert_msg(!ambigR && ambigR.error->message.find("ambiguous") != std::string::npos,
+                "expected cached ambiguity");
+  ck_assert_uint_eq(engine.cache_stats().hits, 2U);
+
+  // Registering a definition invalidates: Derived v2 drops its override.
+  auto derived_v2 = derived;
+  derived_v2.version = 2;
+  derived_v2.operations.clear();
+  ck_assert_msg(registry.register_definition(derived_v2), "register derived v2 failed");
+  auto inheritedR = engine.resolve(TypeID{0xC2ULL}, "ping", OperationScope::Object,
+                                   { TypeID{0x1001ULL} }, 1, true);
+  ck_assert_msg(inheritedR, "dispatch after register failed: %s", result_message(inheritedR));
+  ck_assert_int_eq(inheritedR.value->owner_type.v, 0xC1ULL);
+  ck_assert_uint_eq(engine.cache_stats().invalidations, 1U);
+  ck_assert_uint_eq(engine.cache_stats().entries, 1U);
+
+  // So does replacing the resolver.
+  engine.set_resolver({});
+  auto uninheritedR = engine.resolve(TypeID{0xC2ULL}, "ping", OperationScope::Object,
+                                     { TypeID{0x1001ULL} }, 1, true);
+  ck_assert_msg(!uninheritedR, "expected no match without the resolver");
+  ck_assert_uint_eq(engine.cache_stats().invalidations, 2U);
+}
+END_TEST
+
+START_TEST(test_subtype_index_closure)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+
+  auto make_node = [](std::uint64_t id, const char* name, std::vector<std::string> bases) {
+    TypeDefinition def{};
+    def.type_id = TypeID{id};
+    def.name = name;
+    def.namespace_name = "Shapes";
+    for (auto& base : bases) def.relationships.push_back(RelationshipSpec{ "base", "one", base });
+    return def;
+  };
+
+  // Diamond registered bottom-up: bases are resolved once they appear.
+  ck_assert_msg(registry.register_definition(make_node(0xE4, "Square", { "Rect", "Rhombus" })),
+                "register Square failed");
+  ck_assert_msg(registry.register_definition(make_node(0xE2, "Rect", { "Shapes::Quad" })),
+                "register Rect failed");
+  ck_assert_msg(registry.register_definition(make_node(0xE3, "Rhombus", { "Quad" })),
+                "register Rhombus failed");
+  auto indexR = registry.subtypes();
+  ck_assert_msg(indexR, "subtypes failed: %s", result_message(indexR));
+  ck_assert_msg(!indexR.value.value()->is_subtype(TypeID{0xE4}, TypeID{0xE1}),
+                "Quad is not defined yet");
+
+  auto quad = make_node(0xE1, "Quad", {});
+  OperationDefinition area;
+  area.name = "area";
+  area.scope = OperationScope::Object;
+  area.signature.params.push_back(ParameterDefinition{ "of", TypeID{0xE1}, false });
+  quad.operations.push_back(area);
+  ck_assert_msg(registry.register_definition(quad), "register Quad failed");
+
+  indexR = registry.subtypes();
+  ck_assert_msg(indexR, "subtypes failed: %s", result_message(indexR));
+  const auto* index = indexR.value.value();
+  ck_assert_msg(index->is_subtype(TypeID{0xE4}, TypeID{0xE1}), "Square should be a Quad");
+  ck_assert_msg(index->is_subtype(TypeID{0xE4}, TypeID{0xE3}), "Square should be a Rhombus");
+  ck_assert_msg(!index->is_subtype(TypeID{0xE2}, TypeID{0xE3}), "Rect is not a Rhombus");
+
+  auto mro = index->linearization(TypeID{0xE4});
+  ck_assert_uint_eq(mro.size(), 4U);
+  ck_assert_uint_eq(mro[0].type.v, 0xE4U);
+  ck_assert_uint_eq(mro[1].type.v, 0xE2U);
+  ck_assert_uint_eq(mro[2].type.v, 0xE3U);
+  ck_assert_uint_eq(mro[3].type.v, 0xE1U);
+  ck_assert_uint_eq(mro[3].depth, 2U);
+
+  // Dispatch through the registry hierarchy: inherited op, subtype argument.
+  DispatchEngine engine(registry);
+  engine.use_registry_hierarchy();
+  auto matchR = engine.resolve(TypeID{0xE4}, "area", OperationScope::Object, { TypeID{0xE2} }, 1);
+  ck_assert_msg(matchR, "dispatch failed: %s", result_message(matchR));
+  ck_assert_uint_eq(matchR.value->owner_type.v, 0xE1U);
+  ck_assert_uint_eq(matchR.value->depth, 2U);
+
+  // A new version that drops a base shrinks the closure of its descendants.
+  auto rhombus_v2 = make_node(0xE3, "Rhombus", {});
+  rhombus_v2.version = 2;
+  ck_assert_msg(registry.register_definition(rhombus_v2), "register Rhombus v2 failed");
+  index = registry.subtypes().value.value();
+  ck_assert_msg(!index->is_subtype(TypeID{0xE3}, TypeID{0xE1}), "Rhombus v2 has no base");
+  ck_assert_msg(index->is_subtype(TypeID{0xE4}, TypeID{0xE1}), "Square is still a Quad via Rect");
+  ck_assert_uint_eq(index->linearization(TypeID{0xE4}).size(), 4U);
+}
+END_TEST
+
+START_TEST(test_operation_table_slots)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+
+  auto make_node = [](std::uint64_t id, const char* name, std::vector<std::string> bases,
+                      std::vector<const char*> ops) {
+    TypeDefinition def{};
+    def.type_id = TypeID{id};
+    def.name = name;
+    def.namespace_name = "Zoo";
+    for (auto& base : bases) def.relationships.push_back(RelationshipSpec{ "base", "one", base });
+    for (const char* op_name : ops) {
+      OperationDefinition op;
+      op.name = op_name;
+      op.scope = OperationScope::Object;
+      def.operations.push_back(op);
+    }
+    return def;
+  };
+  auto animal = make_node(0xF1, "Animal", {}, { "speak", "eat" });
+  animal.operations[1].signature.params.push_back(ParameterDefinition{ "grams", TypeID{0x1002ULL}, false });
+  ck_assert_msg(registry.register_definition(animal), "register Animal failed");
+  ck_assert_msg(registry.register_definition(make_node(0xF2, "Pet", {}, { "name", "speak" })),
+                "register Pet failed");
+  ck_assert_msg(registry.register_definition(make_node(0xF3, "Dog", { "Animal", "Pet" }, { "fetch", "speak" })),
+                "register Dog failed");
+  ck_assert_msg(registry.register_definition(make_node(0xF4, "Cat", { "Animal", "Pet" }, {})),
+                "register Cat failed");
+
+  DispatchEngine engine(registry);
+  engine.use_registry_hierarchy();
+
+  // The first base's slots keep their positions; overrides replace them in place.
+  auto dogR = engine.table(TypeID{0xF3}, OperationScope::Object);
+  ck_assert_msg(dogR, "table failed: %s", result_message(dogR));
+  const auto& dog = *dogR.value.value();
+  ck_assert_uint_eq(dog.size(), 4U);
+  ck_assert_str_eq(dog.at(0).operation.name.c_str(), "speak");
+  ck_assert_uint_eq(dog.at(0).owner_type.v, 0xF3U);
+  ck_assert_str_eq(dog.at(1).operation.name.c_str(), "eat");
+  ck_assert_uint_eq(dog.at(1).owner_type.v, 0xF1U);
+  ck_assert_uint_eq(dog.at(1).depth, 1U);
+  ck_assert_str_eq(dog.at(2).operation.name.c_str(), "name");
+  ck_assert_str_eq(dog.at(3).operation.name.c_str(), "fetch");
+  ck_assert_msg(!dog.ambiguous(0), "Dog overrides speak");
+  ck_assert_uint_eq(dog.find("eat", { TypeID{0x1002ULL} }), 1U);
+  ck_assert_uint_eq(dog.find("eat", {}), OperationTable::kNoSlot);
+
+  auto animalR = engine.table(TypeID{0xF1}, OperationScope::Object);
+  ck_assert_msg(animalR, "table failed: %s", result_message(animalR));
+  ck_assert_str_eq(animalR.value.value()->at(1).operation.name.c_str(), "eat");
+  ck_assert_msg(engine.table(TypeID{0xF3}, OperationScope::Object).value.value() == dogR.value.value(),
+                "tables are shared until the registry changes");
+
+  // Binding resolves once; dispatch is by slot.
+  auto speakR = engine.bind(TypeID{0xF3}, "speak", OperationScope::Object, {}, 0);
+  ck_assert_msg(speakR, "bind failed: %s", result_message(speakR));
+  ck_assert_uint_eq(speakR.value->slot, 0U);
+  ck_assert_uint_eq(speakR.value->match().owner_type.v, 0xF3U);
+  auto eatR = engine.bind(TypeID{0xF3}, "eat", OperationScope::Object, { TypeID{0x1002ULL} }, 1);
+  ck_assert_msg(eatR, "bind failed: %s", result_message(eatR));
+  ck_assert_uint_eq(eatR.value->slot, 1U);
+  ck_assert_msg(!engine.bind(TypeID{0xF3}, "eat", OperationScope::Object, {}, 0), "eat needs an argument");
+
+  // Rebinding the same shape is served from the resolution cache.
+  const auto hits = engine.cache_stats().hits;
+  auto speakAgainR = engine.bind(TypeID{0xF3}, "speak", OperationScope::Object, {}, 0);
+  ck_assert_msg(speakAgainR, "cached bind failed: %s", result_message(speakAgainR));
+  ck_assert_msg(speakAgainR.value->table == speakR.value->table, "expected the cached table");
+  ck_assert_uint_eq(speakAgainR.value->slot, speakR.value->slot);
+  ck_assert_uint_eq(engine.cache_stats().hits, hits + 1);
+
+  // Equally deep implementations from two bases stay ambiguous, as with resolve().
+  auto catR = engine.bind(TypeID{0xF4}, "speak", OperationScope::Object, {}, 0);
+  ck_assert_msg(!catR && catR.error->message.find("ambiguous") != std::string::npos,
+                "expected ambiguous speak on Cat");
+  auto catResolveR = engine.resolve(TypeID{0xF4}, "speak", OperationScope::Object, {}, 0);
+  ck_assert_msg(!catResolveR && catResolveR.error->message.find("ambiguous") != std::string::npos,
+                "expected ambiguous resolve on Cat");
+  auto catNameR = engine.resolve(TypeID{0xF4}, "name", OperationScope::Object, {}, 0);
+  ck_assert_msg(catNameR, "resolve failed: %s", result_message(catNameR));
+  ck_assert_uint_eq(catNameR.value->owner_type.v, 0xF2U);
+
+  // A binding outlives the table it came from.
+  auto dog_v2 = make_node(0xF3, "Dog", { "Animal", "Pet" }, {});
+  dog_v2.version = 2;
+  ck_assert_msg(registry.register_definition(dog_v2), "register Dog v2 failed");
+  ck_assert_uint_eq(speakR.value->match().owner_type.v, 0xF3U);
+  auto dog2R = engine.table(TypeID{0xF3}, OperationScope::Object);
+  ck_assert_msg(dog2R, "table failed: %s", result_message(dog2R));
+  ck_assert_uint_eq(dog2R.value.value()->size(), 3U);
+  ck_assert_msg(dog2R.value.value()->ambiguous(0), "Dog v2 no longer overrides speak");
+}
+END_TEST
+
+START_TEST(test_capability_policy_decisions)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  SchemaRegistry registry(store);
+
+  TypeDefinition def{};
+  def.type_id = TypeID{0xF8};
+  def.name = "Vault";
+  def.namespace_name = "Caps";
+  for (const char* name : { "peek", "open" }) {
+    OperationDefinition op;
+    op.name = name;
+    op.scope = OperationScope::Object;
+    op.required_capabilities.push_back("vault.read");
+    def.operations.push_back(op);
+  }
+  def.operations[1].required_capabilities.push_back("vault.write");
+  ck_assert_msg(registry.register_definition(def), "register Vault failed");
+
+  // Registration interns the required names.
+  auto& table = registry.capabilities();
+  const auto read = table.find("vault.read");
+  const auto write = table.find("vault.write");
+  ck_assert_msg(read != kNoCapability && write != kNoCapability && read != write, "capabilities not interned");
+  ck_assert_str_eq(table.name(write).c_str(), "vault.write");
+  ck_assert_uint_eq(table.intern("vault.read"), read);
+
+  CapabilitySet need;
+  need.set(read);
+  need.set(write);
+  CapabilitySet have;
+  have.set(read);
+  ck_assert_msg(!have.covers(need), "write is missing");
+  ck_assert_uint_eq(have.first_missing(need), write);
+  have.set(write);
+  ck_assert_msg(have.covers(need) && have.first_missing(need) == kNoCapability, "all granted");
+
+  DispatchEngine engine(registry);
+  auto openR = engine.bind(TypeID{0xF8}, "open", OperationScope::Object, {}, 0);
+  ck_assert_msg(openR, "bind failed: %s", result_message(openR));
+  auto peekR = engine.bind(TypeID{0xF8}, "peek", OperationScope::Object, {}, 0);
+  ck_assert_msg(peekR, "bind failed: %s", result_message(peekR));
+
+  CapabilityPolicy policy(registry);
+  CapabilityPrincipal session;
+  auto decision = policy.check(openR.value.value(), session);
+  ck_assert_msg(!decision.allowed, "nothing granted yet");
+  ck_assert_msg(decision.message() == "missing capability: vault.read", "unexpected message");
+
+  ck_assert_msg(policy.grant(session, "vault.read"), "grant failed");
+  ck_assert_msg(policy.check(peekR.value.value(), session).allowed, "read is enough to peek");
+  decision = policy.check(openR.value.value(), session);
+  ck_assert_msg(decision.message() == "missing capability: vault.write", "unexpected message");
+  ck_assert_msg(policy.grant(session, "vault.write"), "grant failed");
+  ck_assert_msg(policy.check(openR.value.value(), session).allowed, "both granted");
+  ck_assert_uint_eq(policy.cached_decisions(), 2U);
+
+  // A copy keeps its decisions until either side changes.
+  CapabilityPrincipal snapshot = session;
+  policy.revoke(session, "vault.read");
+  ck_assert_msg(!policy.check(peekR.value.value(), session).allowed, "revoked");
+  ck_assert_msg(policy.check(peekR.value.value(), snapshot).allowed, "the copy still holds read");
+  ck_assert_msg(!policy.check(openR.value.value(), CapabilityPrincipal{}).allowed, "a new principal has nothing");
+
+  // The cache is trimmed: forget() drops a principal's decisions, new definitions
+  // drop every decision, and the capacity bounds what is kept.
+  ck_assert_uint_eq(policy.cached_decisions(), 3U); // the copy shares the session's entries
+  policy.forget(session);
+  ck_assert_uint_eq(policy.cached_decisions(), 1U);
+  auto other = make_definition(TypeID{0xF9}, "Safe", "Caps");
+  ck_assert_msg(registry.register_definition(other), "register Safe failed");
+  ck_assert_msg(!policy.check(peekR.value.value(), session).allowed, "still revoked");
+  ck_assert_uint_eq(policy.cached_decisions(), 1U);
+  policy.set_capacity(2);
+  for (int i = 0; i < 5; ++i) ck_assert_msg(!policy.check(openR.value.value(), CapabilityPrincipal{}).allowed, "denied");
+  ck_assert_msg(policy.cached_decisions() <= 2U, "capacity exceeded");
 }
 END_TEST
 
@@ -456,13 +1446,26 @@ Suite* refract_registry_suite(void) {
 
   tcase_add_test(tc, test_schema_registry_roundtrip);
   tcase_add_test(tc, test_schema_registry_supersedes_chain);
+  tcase_add_test(tc, test_migration_runner_resumes);
+  tcase_add_test(tc, test_migrating_reader_upgrades_on_read);
+  tcase_add_test(tc, test_schema_registry_definition_cache_coherence);
+  tcase_add_test(tc, test_schema_registry_type_name_index);
   tcase_add_test(tc, test_schema_registry_structured_metadata_roundtrip);
+  tcase_add_test(tc, test_definition_binary_layout);
   tcase_add_test(tc, test_schema_registry_collection_metadata_roundtrip);
   tcase_add_test(tc, test_generic_instance_type_id_deterministic);
   tcase_add_test(tc, test_generic_instance_registry_roundtrip);
+  tcase_add_test(tc, test_generic_instance_hash_consing);
+  tcase_add_test(tc, test_payload_codec_compiled);
+  tcase_add_test(tc, test_payload_native_members);
+  tcase_add_test(tc, test_payload_validator_store_hook);
+  tcase_add_test(tc, test_packet_codec_layouts);
   tcase_add_test(tc, test_scoped_type_registry_promotion);
   tcase_add_test(tc, test_operation_registry_scope_and_inheritance);
   tcase_add_test(tc, test_dispatch_resolution);
+  tcase_add_test(tc, test_subtype_index_closure);
+  tcase_add_test(tc, test_operation_table_slots);
+  tcase_add_test(tc, test_capability_policy_decisions);
 
   suite_add_tcase(s, tc);
   return s;
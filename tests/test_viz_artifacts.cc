@@ -10,6 +10,7 @@ extern "C" {
 #include "referee/referee.h"
 #include "referee_sqlite/sqlite_store.h"
 #include "viz/artifacts.h"
+#include "viz/store_stats.h"
 
 using namespace referee;
 using namespace iris::refract;
@@ -100,6 +101,39 @@ START_TEST(test_viz_schema_definitions)
 }
 END_TEST
 
+START_TEST(test_viz_store_stats_artifacts)
+{
+  SqliteStore store(SqliteConfig{ .filename=":memory:", .enable_wal=false });
+  ck_assert_msg(store.open(), "open failed");
+  ck_assert_msg(store.ensure_schema(), "ensure_schema failed");
+
+  SchemaRegistry registry(store);
+  auto boot = bootstrap_core_schema(registry);
+  ck_assert_msg(boot, "bootstrap failed: %s", result_message(boot));
+
+  auto statsR = store.stats();
+  ck_assert_msg(statsR, "stats failed: %s", result_message(statsR));
+  ck_assert_msg(statsR.value->object_count > 0, "expected bootstrap objects");
+
+  auto artifactsR = create_store_stats_artifacts(registry, store, statsR.value.value());
+  ck_assert_msg(artifactsR, "create_store_stats_artifacts failed: %s", result_message(artifactsR));
+  ck_assert_msg(!artifactsR.value->tables.empty(), "expected tables");
+  ck_assert_msg(!artifactsR.value->metrics.empty(), "expected metrics");
+
+  auto tableR = store.get_latest(artifactsR.value->tables.front());
+  ck_assert_msg(tableR, "get_latest failed: %s", result_message(tableR));
+  ck_assert_msg(tableR.value->has_value(), "expected table present");
+  ck_assert_uint_eq(tableR.value->value().type.v, kTypeVizTable.v);
+
+  auto metricR = store.get_latest(artifactsR.value->metrics.front());
+  ck_assert_msg(metricR, "get_latest failed: %s", result_message(metricR));
+  ck_assert_msg(metricR.value->has_value(), "expected metric present");
+  ck_assert_uint_eq(metricR.value->value().type.v, kTypeVizMetric.v);
+
+  ck_assert_msg(store.close(), "close failed");
+}
+END_TEST
+
 Suite* viz_artifact_suite(void) {
   Suite* s = suite_create("VizArtifacts");
   TCase* tc = tcase_create("core");
@@ -107,6 +141,7 @@ Suite* viz_artifact_suite(void) {
   tcase_add_test(tc, test_viz_artifact_create);
   tcase_add_test(tc, test_viz_metric_create);
   tcase_add_test(tc, test_viz_schema_definitions);
+  tcase_add_test(tc, test_viz_store_stats_artifacts);
 
   suite_add_tcase(s, tc);
   return s;